@@ -0,0 +1,112 @@
+﻿// <copyright file="benchmark.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <iostream>
+#include <string>
+
+#include "dataverse/api.h"
+
+
+/// <summary>
+/// The signature of a benchmark, which receives the command line arguments
+/// following the name of the benchmark.
+/// </summary>
+typedef int (*benchmark_type)(_In_ const int argc, _In_reads_(argc) char **argv);
+
+
+/// <summary>
+/// Measures the throughput of computing the checksum of a file in GB/s for
+/// all algorithms supported by Dataverse.
+/// </summary>
+int checksum_benchmark(_In_ const int argc, _In_reads_(argc) char **argv);
+
+
+/// <summary>
+/// Measures the number of small files whose checksums can be computed per
+/// second, which is dominated by the overhead per file rather than by the
+/// hash itself.
+/// </summary>
+int checksum_files_benchmark(_In_ const int argc,
+    _In_reads_(argc) char **argv);
+
+
+/// <summary>
+/// Compares the time for retrieving a large response with and without
+/// negotiating a compressed content encoding.
+/// </summary>
+int compression_benchmark(_In_ const int argc, _In_reads_(argc) char **argv);
+
+
+/// <summary>
+/// Measures the throughput of direct uploads of a large file with different
+/// numbers of parts in flight.
+/// </summary>
+int direct_upload_benchmark(_In_ const int argc,
+    _In_reads_(argc) char **argv);
+
+
+/// <summary>
+/// Reports the peak memory required for sending a large in-memory field
+/// that is either copied into the form or referenced by it.
+/// </summary>
+int form_data_benchmark(_In_ const int argc, _In_reads_(argc) char **argv);
+
+
+/// <summary>
+/// Compares the lazy <see cref="visus::dataverse::json_view" /> with a
+/// <c>nlohmann::json</c> DOM on a synthetic listing of the files in a data
+/// set.
+/// </summary>
+int json_view_benchmark(_In_ const int argc, _In_reads_(argc) char **argv);
+
+
+/// <summary>
+/// Compares uploading many small files one by one with uploading them as a
+/// single ZIP archive that is built while it is being sent.
+/// </summary>
+int upload_archive_benchmark(_In_ const int argc,
+    _In_reads_(argc) char **argv);
+
+
+/// <summary>
+/// Measures the average wall-clock time of <paramref name="iterations" />
+/// invocations of <paramref name="operation" /> and prints it along with the
+/// resulting throughput for a workload of <paramref name="bytes" /> bytes.
+/// </summary>
+template<class TOperation>
+double measure(_In_z_ const char *name,
+        _In_ const std::size_t iterations,
+        _In_ const std::size_t bytes,
+        TOperation&& operation) {
+    typedef std::chrono::duration<double, std::milli> millis_type;
+
+    // Warm up caches and allocators such that we do not measure first-time
+    // effects.
+    operation();
+
+    const auto begin = std::chrono::high_resolution_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        operation();
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const auto retval = std::chrono::duration_cast<millis_type>(end - begin)
+        .count() / iterations;
+    const auto throughput = (retval > 0.0)
+        ? (static_cast<double>(bytes) / (1024.0 * 1024.0)) / (retval / 1000.0)
+        : 0.0;
+
+    std::cout << name << ": " << retval << " ms";
+    if (bytes > 0) {
+        std::cout << " (" << throughput << " MB/s)";
+    }
+    std::cout << std::endl;
+
+    return retval;
+}
@@ -0,0 +1,179 @@
+﻿// <copyright file="checksum.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "dataverse/checksum.h"
+
+#include "benchmark.h"
+
+
+/*
+ * ::checksum_benchmark
+ */
+int checksum_benchmark(_In_ const int argc, _In_reads_(argc) char **argv) {
+    using namespace visus::dataverse;
+
+    if (argc < 1) {
+        std::cerr << "Usage: checksum <file> [iterations] [size in MB] "
+            "[algorithms...]" << std::endl << std::endl
+            << "The benchmark computes the checksum of the given file. If "
+            "a size is given, the" << std::endl
+            << "file is (over)written with that many megabytes first. "
+            "Drop the page cache" << std::endl
+            << "between runs for measuring the throughput of the storage "
+            "rather than the" << std::endl
+            << "hash, e.g." << std::endl
+            << "    sync; echo 3 > /proc/sys/vm/drop_caches" << std::endl;
+        return -1;
+    }
+
+    const auto path = make_narrow_string(argv[0], dataversepp_code_page);
+    const std::size_t iterations = (argc > 1)
+        ? std::strtoull(argv[1], nullptr, 10)
+        : 5;
+    const std::size_t megabytes = (argc > 2)
+        ? std::strtoull(argv[2], nullptr, 10)
+        : 0;
+
+    std::vector<std::string> algorithms;
+    for (int i = 3; i < argc; ++i) {
+        algorithms.push_back(argv[i]);
+    }
+    if (algorithms.empty()) {
+        algorithms = { "MD5", "SHA-1", "SHA-256", "SHA-512" };
+    }
+
+    if (megabytes > 0) {
+        std::vector<char> block(1024 * 1024);
+        for (std::size_t i = 0; i < block.size(); ++i) {
+            block[i] = static_cast<char>(i * 7 + (i >> 11));
+        }
+
+        std::ofstream file(argv[0], std::ios::binary | std::ios::trunc);
+        for (std::size_t i = 0; i < megabytes; ++i) {
+            file.write(block.data(), block.size());
+        }
+    }
+
+    std::size_t size = 0;
+    {
+        std::ifstream file(argv[0], std::ios::binary | std::ios::ate);
+        if (!file) {
+            std::cerr << "The file \"" << argv[0] << "\" could not be opened."
+                << std::endl;
+            return -1;
+        }
+        size = static_cast<std::size_t>(file.tellg());
+    }
+
+    std::cout << "File of " << size << " bytes, " << iterations
+        << " iterations" << std::endl;
+
+    for (auto& a : algorithms) {
+        std::string checksum;
+        const auto millis = measure(a.c_str(), iterations, size, [&]() {
+            checksum = file_checksum(path, a.c_str());
+        });
+
+        const auto gbs = (millis > 0.0)
+            ? (static_cast<double>(size) / 1e9) / (millis / 1000.0)
+            : 0.0;
+        std::cout << "    " << gbs << " GB/s, " << checksum << std::endl;
+    }
+
+    return 0;
+}
+
+
+/*
+ * ::checksum_files_benchmark
+ */
+int checksum_files_benchmark(_In_ const int argc,
+        _In_reads_(argc) char **argv) {
+    using namespace visus::dataverse;
+
+    if (argc < 1) {
+        std::cerr << "Usage: checksum_files <directory> [files] [size in KB] "
+            "[iterations] [algorithms...]" << std::endl << std::endl
+            << "The benchmark creates the given number of files of the given "
+            "size in an existing" << std::endl
+            << "directory and computes the checksums of all of them one "
+            "after the other, which" << std::endl
+            << "shows the overhead per file when uploading batches of small "
+            "files." << std::endl;
+        return -1;
+    }
+
+    const std::string directory(argv[0]);
+    const std::size_t cnt = (argc > 1)
+        ? std::strtoull(argv[1], nullptr, 10)
+        : 1000;
+    const std::size_t kilobytes = (argc > 2)
+        ? std::strtoull(argv[2], nullptr, 10)
+        : 64;
+    const std::size_t iterations = (argc > 3)
+        ? std::strtoull(argv[3], nullptr, 10)
+        : 5;
+
+    std::vector<std::string> algorithms;
+    for (int i = 4; i < argc; ++i) {
+        algorithms.push_back(argv[i]);
+    }
+    if (algorithms.empty()) {
+        algorithms = { "MD5", "SHA-1", "SHA-256", "SHA-512" };
+    }
+
+    std::vector<std::string> paths;
+    {
+        std::vector<char> block(kilobytes * 1024);
+        for (std::size_t i = 0; i < block.size(); ++i) {
+            block[i] = static_cast<char>(i * 7 + (i >> 11));
+        }
+
+        paths.reserve(cnt);
+        for (std::size_t i = 0; i < cnt; ++i) {
+            paths.push_back(directory + "/checksum_files_" + std::to_string(i)
+                + ".bin");
+            std::ofstream file(paths.back(), std::ios::binary
+                | std::ios::trunc);
+            if (!file) {
+                std::cerr << "The file \"" << paths.back() << "\" could not "
+                    "be created." << std::endl;
+                return -1;
+            }
+            file.write(block.data(), block.size());
+        }
+    }
+
+    const auto size = cnt * kilobytes * 1024;
+    std::cout << cnt << " files of " << kilobytes << " KB, " << iterations
+        << " iterations" << std::endl;
+
+    for (auto& a : algorithms) {
+        const auto millis = measure(a.c_str(), iterations, size, [&]() {
+            for (auto& p : paths) {
+                file_checksum(make_narrow_string(p, dataversepp_code_page),
+                    a.c_str());
+            }
+        });
+
+        const auto fps = (millis > 0.0)
+            ? static_cast<double>(cnt) / (millis / 1000.0)
+            : 0.0;
+        std::cout << "    " << fps << " files/s" << std::endl;
+    }
+
+    for (auto& p : paths) {
+        std::remove(p.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+﻿// <copyright file="compression.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "dataverse/dataverse_connection.h"
+
+#include "benchmark.h"
+
+
+/*
+ * ::compression_benchmark
+ */
+int compression_benchmark(_In_ const int argc, _In_reads_(argc) char **argv) {
+    using namespace visus::dataverse;
+
+    if (argc < 2) {
+        std::cerr << "Usage: compression <base path> <resource> [iterations] "
+            "[encodings]" << std::endl << std::endl
+            << "The benchmark retrieves the resource, e.g. the file listing "
+            "of a large data" << std::endl
+            << "set, with and without negotiating a content encoding. In "
+            "order to simulate a" << std::endl
+            << "slow link to a local server, limit the bandwidth of the "
+            "loopback device, e.g." << std::endl
+            << "    tc qdisc add dev lo root tbf rate 100mbit burst 32kbit "
+            "latency 10ms" << std::endl;
+        return -1;
+    }
+
+    const auto base_path = convert<wchar_t>(std::string(argv[0]),
+        dataversepp_code_page);
+    const auto resource = convert<wchar_t>(std::string(argv[1]),
+        dataversepp_code_page);
+    const std::size_t iterations = (argc > 2)
+        ? std::strtoull(argv[2], nullptr, 10)
+        : 10;
+    const auto encodings = (argc > 3) ? argv[3] : "";
+
+    dataverse_connection dataverse;
+    dataverse.base_path(base_path.c_str());
+
+    // Retrieve the resource once to determine the size of the payload, which
+    // is what the user gets independently from the encoding on the wire.
+    const auto size = dataverse.get(resource).get().size();
+    std::cout << "Response of " << size << " bytes, " << iterations
+        << " iterations" << std::endl;
+
+    dataverse.accept_encoding(nullptr);
+    const auto identity = measure("identity", iterations, size, [&]() {
+        dataverse.get(resource).get();
+    });
+
+    dataverse.accept_encoding(make_narrow_string(encodings,
+        dataversepp_code_page));
+    const auto encoded = measure("encoded", iterations, size, [&]() {
+        dataverse.get(resource).get();
+    });
+
+    if (encoded > 0.0) {
+        std::cout << "Speedup: " << (identity / encoded) << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+﻿// <copyright file="direct_upload.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "dataverse/dataverse_connection.h"
+
+#include "benchmark.h"
+
+
+/*
+ * ::direct_upload_benchmark
+ */
+int direct_upload_benchmark(_In_ const int argc,
+        _In_reads_(argc) char **argv) {
+    using namespace visus::dataverse;
+
+    if (argc < 3) {
+        std::cerr << "Usage: direct_upload <base path> <persistent ID> <file> "
+            "[iterations] [part size]" << std::endl
+            << "    [parallelism...]" << std::endl << std::endl
+            << "The benchmark uploads the file directly to the S3 store of "
+            "the data set with" << std::endl
+            << "every given number of parts in flight. Whether the file is "
+            "uploaded in parts is" << std::endl
+            << "decided by the server, so the file must be larger than the "
+            "limit of the store." << std::endl
+            << "In order to benchmark against a local S3 stand-in like MinIO, "
+            "limit the" << std::endl
+            << "bandwidth and add latency to the loopback device, e.g."
+            << std::endl
+            << "    tc qdisc add dev lo root netem rate 1gbit delay 20ms"
+            << std::endl;
+        return -1;
+    }
+
+    const auto base_path = convert<wchar_t>(std::string(argv[0]),
+        dataversepp_code_page);
+    const auto persistent_id = convert<wchar_t>(std::string(argv[1]),
+        dataversepp_code_page);
+    const auto path = convert<wchar_t>(std::string(argv[2]),
+        dataversepp_code_page);
+    const std::size_t iterations = (argc > 3)
+        ? std::strtoull(argv[3], nullptr, 10)
+        : 3;
+    const std::uint64_t part_size = (argc > 4)
+        ? std::strtoull(argv[4], nullptr, 10)
+        : 0;
+
+    std::vector<std::size_t> parallelism;
+    for (int i = 5; i < argc; ++i) {
+        parallelism.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (parallelism.empty()) {
+        parallelism = { 1, 2, 4, 8 };
+    }
+
+    const auto size = static_cast<std::size_t>(std::ifstream(argv[2],
+        std::ios::binary | std::ios::ate).tellg());
+    std::cout << "Uploading " << size << " bytes, " << iterations
+        << " iterations" << std::endl;
+
+    dataverse_connection dataverse;
+    dataverse.base_path(base_path.c_str());
+    dataverse.direct_upload_part_size(part_size);
+
+    double sequential = 0.0;
+    for (auto p : parallelism) {
+        dataverse.direct_upload_parallelism(p);
+        const auto name = std::to_string(p) + " in flight";
+        const auto time = measure(name.c_str(), iterations, size, [&]() {
+            dataverse.direct_upload(persistent_id, path,
+                std::wstring(L"application/octet-stream"),
+                std::wstring(L"Benchmark"), std::wstring(L""),
+                std::vector<std::wstring>(), false).get();
+        });
+
+        if (sequential <= 0.0) {
+            sequential = time;
+        } else if (time > 0.0) {
+            std::cout << "Speedup: " << (sequential / time) << std::endl;
+        }
+    }
+
+    return 0;
+}
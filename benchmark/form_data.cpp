@@ -0,0 +1,99 @@
+﻿// <copyright file="form_data.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <Psapi.h>
+#else /* defined(_WIN32) */
+#include <sys/resource.h>
+#endif /* defined(_WIN32) */
+
+#include "dataverse/dataverse_connection.h"
+
+#include "benchmark.h"
+
+
+/// <summary>
+/// Answer the peak resident memory of the process in bytes.
+/// </summary>
+static std::size_t peak_memory(void) {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!::GetProcessMemoryInfo(::GetCurrentProcess(), &counters,
+            sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else /* defined(_WIN32) */
+    struct rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    // Linux reports the maximum resident set size in kilobytes.
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * ::form_data_benchmark
+ */
+int form_data_benchmark(_In_ const int argc, _In_reads_(argc) char **argv) {
+    using namespace visus::dataverse;
+
+    if (argc < 2) {
+        std::cerr << "Usage: form_data <size in MB> <copy|reference> [URL]"
+            << std::endl << std::endl
+            << "The benchmark adds a field of the given size to a form, "
+            "either by copying the" << std::endl
+            << "data or by referencing them, and reports the peak memory "
+            "of the process. If a" << std::endl
+            << "URL is given, the form is also posted to it. As the peak "
+            "only grows, every" << std::endl
+            << "mode must be measured in its own process." << std::endl;
+        return -1;
+    }
+
+    const std::size_t size = std::strtoull(argv[0], nullptr, 10)
+        * 1024 * 1024;
+    const auto copy = (::strcmp(argv[1], "copy") == 0);
+    const auto url = (argc > 2)
+        ? convert<wchar_t>(std::string(argv[2]), dataversepp_code_page)
+        : std::wstring();
+
+    // Touch all of the data such that they are actually resident.
+    std::unique_ptr<form_data::byte_type[]> data(
+        new form_data::byte_type[size]);
+    ::memset(data.get(), 'x', size);
+    const auto baseline = peak_memory();
+
+    dataverse_connection connection;
+
+    measure(copy ? "copy" : "reference", 1, size, [&](void) {
+        auto form = connection.make_form();
+        if (copy) {
+            form.add_field(L"file", data.get(), size);
+        } else {
+            form.add_field(L"file", data.get(), size, nullptr);
+        }
+
+        if (!url.empty()) {
+            connection.post(url.c_str(), std::move(form)).get();
+        }
+    });
+
+    const auto peak = peak_memory();
+    std::cout << "Peak memory: " << (peak / (1024 * 1024)) << " MB ("
+        << ((peak - baseline) / (1024 * 1024)) << " MB above the "
+        << (size / (1024 * 1024)) << " MB of data)" << std::endl;
+
+    return 0;
+}
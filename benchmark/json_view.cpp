@@ -0,0 +1,119 @@
+﻿// <copyright file="json_view.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "dataverse/json_view.h"
+
+#include "benchmark.h"
+
+
+/// <summary>
+/// Creates a response of the &quot;files&quot; end point listing
+/// <paramref name="cnt" /> files.
+/// </summary>
+static std::string make_files_listing(_In_ const std::size_t cnt) {
+    auto data = nlohmann::json::array();
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        const auto name = "file" + std::to_string(i) + ".dat";
+        data.push_back({
+            { "label", name },
+            { "restricted", false },
+            { "directoryLabel", "data/set" + std::to_string(i % 16) },
+            { "version", 1 },
+            { "datasetVersionId", 42 },
+            { "categories", { "Data" } },
+            { "dataFile", {
+                { "id", 1000 + i },
+                { "persistentId", "" },
+                { "filename", name },
+                { "contentType", "application/octet-stream" },
+                { "filesize", 1024 * i },
+                { "description", "A file with a \"quoted\" description." },
+                { "storageIdentifier", "s3://bucket:18b" + std::to_string(i) },
+                { "rootDataFileId", -1 },
+                { "md5", "d41d8cd98f00b204e9800998ecf8427e" },
+                { "checksum", {
+                    { "type", "MD5" },
+                    { "value", "d41d8cd98f00b204e9800998ecf8427e" }
+                } },
+                { "creationDate", "2023-06-01" }
+            } }
+        });
+    }
+
+    return nlohmann::json({
+        { "status", "OK" },
+        { "data", data }
+    }).dump();
+}
+
+
+/*
+ * ::json_view_benchmark
+ */
+int json_view_benchmark(_In_ const int argc, _In_reads_(argc) char **argv) {
+    const std::size_t files = (argc > 0) ? std::strtoull(argv[0], nullptr, 10)
+        : 20000;
+    const std::size_t iterations = (argc > 1)
+        ? std::strtoull(argv[1], nullptr, 10)
+        : 10;
+
+    const auto listing = make_files_listing(files);
+    visus::dataverse::blob response(listing.size());
+    ::memcpy(response.data(), listing.data(), listing.size());
+    std::cout << "Listing of " << files << " files (" << response.size()
+        << " bytes), " << iterations << " iterations" << std::endl;
+
+    // Reference: build a DOM like translate_api_reponse does and extract the
+    // ID of each file.
+    std::uint64_t dom_sum = 0;
+    measure("DOM, all IDs", iterations, response.size(), [&]() {
+        const auto r = std::string(response.as<char>(), response.size());
+        const auto json = nlohmann::json::parse(r);
+        dom_sum = 0;
+        for (auto& f : json["data"]) {
+            dom_sum += f["dataFile"]["id"].get<std::uint64_t>();
+        }
+    });
+
+    std::uint64_t view_sum = 0;
+    measure("json_view, all IDs", iterations, response.size(), [&]() {
+        const visus::dataverse::json_view json(response);
+        view_sum = 0;
+        for (auto f = json.at("/data").first(); f; f = f.next()) {
+            view_sum += f.at("/dataFile/id").to_uint64();
+        }
+    });
+
+    // The typical case of an API call where we only need the status and a
+    // single property.
+    std::string dom_status;
+    measure("DOM, status only", iterations, response.size(), [&]() {
+        const auto r = std::string(response.as<char>(), response.size());
+        const auto json = nlohmann::json::parse(r);
+        dom_status = json["status"].get<std::string>();
+    });
+
+    bool view_status = false;
+    measure("json_view, status only", iterations, response.size(), [&]() {
+        const visus::dataverse::json_view json(response);
+        view_status = json.at("/status").equals("OK");
+    });
+
+    if ((dom_sum != view_sum) || (dom_status != "OK") || !view_status) {
+        std::cerr << "The results of the DOM and the view do not match."
+            << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+﻿// <copyright file="main.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include <cstring>
+#include <iostream>
+
+#include "dataverse/api.h"
+
+#include "benchmark.h"
+
+
+/// <summary>
+/// The known benchmarks.
+/// </summary>
+static const struct {
+    const char *name;
+    benchmark_type benchmark;
+} benchmarks[] = {
+    { "checksum", ::checksum_benchmark },
+    { "checksum_files", ::checksum_files_benchmark },
+    { "compression", ::compression_benchmark },
+    { "direct_upload", ::direct_upload_benchmark },
+    { "form_data", ::form_data_benchmark },
+    { "json_view", ::json_view_benchmark },
+    { "upload_archive", ::upload_archive_benchmark },
+};
+
+
+/// <summary>
+/// Entry point of the benchmark driver, which runs the benchmark named in the
+/// first argument.
+/// </summary>
+/// <param name="argc">The size of the argument list.</param>
+/// <param name="argv">The command line arguments.</param>
+/// <returns>Zero in case of success, -1 in case of an error.</returns>
+int main(_In_ const int argc, _In_reads_(argc) char **argv) {
+    if (argc > 1) {
+        for (auto& b : benchmarks) {
+            if (::strcmp(b.name, argv[1]) == 0) {
+                try {
+                    return b.benchmark(argc - 2, argv + 2);
+                } catch (std::exception& ex) {
+                    std::cerr << ex.what() << std::endl;
+                    return -1;
+                }
+            }
+        }
+    }
+
+    std::cerr << "Usage: " << argv[0] << " <benchmark> [arguments]"
+        << std::endl << std::endl << "Available benchmarks:" << std::endl;
+    for (auto& b : benchmarks) {
+        std::cerr << "    " << b.name << std::endl;
+    }
+
+    return -1;
+}
@@ -0,0 +1,158 @@
+﻿// <copyright file="upload_archive.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "dataverse/dataverse_connection.h"
+
+#include "benchmark.h"
+
+
+/*
+ * ::upload_archive_benchmark
+ */
+int upload_archive_benchmark(_In_ const int argc,
+        _In_reads_(argc) char **argv) {
+    using namespace visus::dataverse;
+
+    if (argc < 4) {
+        std::cerr << "Usage: upload_archive <base path> <persistent ID> "
+            "<API key> <directory> [files]" << std::endl
+            << "    [size in KB] [iterations]" << std::endl << std::endl
+            << "The benchmark creates the given number of small CSV files in "
+            "an existing" << std::endl
+            << "directory and adds them to the data set, first one by one and "
+            "then bundled into" << std::endl
+            << "a stored and a deflated ZIP archive. Note that every run adds "
+            "all files to the" << std::endl
+            << "data set, including the warm-up run of each variant."
+            << std::endl;
+        return -1;
+    }
+
+    const auto base_path = convert<wchar_t>(std::string(argv[0]),
+        dataversepp_code_page);
+    const auto persistent_id = convert<wchar_t>(std::string(argv[1]),
+        dataversepp_code_page);
+    const auto api_key = convert<wchar_t>(std::string(argv[2]),
+        dataversepp_code_page);
+    const std::string directory(argv[3]);
+    const std::size_t cnt = (argc > 4)
+        ? std::strtoull(argv[4], nullptr, 10)
+        : 100;
+    const std::size_t kilobytes = (argc > 5)
+        ? std::strtoull(argv[5], nullptr, 10)
+        : 4;
+    const std::size_t iterations = (argc > 6)
+        ? std::strtoull(argv[6], nullptr, 10)
+        : 1;
+
+    if (cnt == 0) {
+        std::cerr << "At least one file must be uploaded." << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> paths;
+    std::vector<std::wstring> wide_paths;
+    {
+        // Fill the files with lines of a CSV table, which is what the
+        // archive is meant for and what deflate can compress well.
+        std::string block;
+        for (std::size_t i = 0; block.size() < kilobytes * 1024; ++i) {
+            block += std::to_string(i) + "," + std::to_string(i * 0.25)
+                + "," + std::to_string(i % 17) + "\n";
+        }
+        block.resize(kilobytes * 1024);
+
+        paths.reserve(cnt);
+        wide_paths.reserve(cnt);
+        for (std::size_t i = 0; i < cnt; ++i) {
+            paths.push_back(directory + "/upload_archive_" + std::to_string(i)
+                + ".csv");
+            std::ofstream file(paths.back(), std::ios::binary
+                | std::ios::trunc);
+            if (!file) {
+                std::cerr << "The file \"" << paths.back() << "\" could not "
+                    "be created." << std::endl;
+                return -1;
+            }
+            file.write(block.data(), block.size());
+            wide_paths.push_back(convert<wchar_t>(paths.back(),
+                dataversepp_code_page));
+        }
+    }
+
+    std::vector<const wchar_t *> path_ptrs;
+    path_ptrs.reserve(wide_paths.size());
+    for (auto& p : wide_paths) {
+        path_ptrs.push_back(p.c_str());
+    }
+
+    const auto size = cnt * kilobytes * 1024;
+    std::cout << cnt << " files of " << kilobytes << " KB, " << iterations
+        << " iterations" << std::endl;
+
+    dataverse_connection dataverse;
+    dataverse.base_path(base_path.c_str());
+    dataverse.api_key(api_key.c_str());
+
+    const auto report = [cnt](const double millis, const double baseline) {
+        const auto fps = (millis > 0.0)
+            ? static_cast<double>(cnt) / (millis / 1000.0)
+            : 0.0;
+        std::cout << "    " << fps << " files/s";
+        if ((baseline > 0.0) && (millis > 0.0)) {
+            std::cout << ", speedup " << (baseline / millis);
+        }
+        std::cout << std::endl;
+    };
+
+    const auto description = nlohmann::json::object({
+        { "description", "Benchmark" },
+        { "directoryLabel", "" },
+        { "restrict", false },
+        { "categories", nlohmann::json::array() }
+    });
+
+    const auto per_file = measure("Per file", iterations, size, [&]() {
+        for (auto& p : wide_paths) {
+            dataverse.upload(persistent_id, p, description).get();
+        }
+    });
+    report(per_file, 0.0);
+
+    const auto stored = measure("Stored archive", iterations, size, [&]() {
+        dataverse.upload_archive(persistent_id.c_str(), path_ptrs.data(),
+            nullptr, path_ptrs.size(), archive_compression::store,
+            L"Benchmark", nullptr, 0, false).get();
+    });
+    report(stored, per_file);
+
+    try {
+        const auto deflated = measure("Deflated archive", iterations, size,
+                [&]() {
+            dataverse.upload_archive(persistent_id.c_str(), path_ptrs.data(),
+                nullptr, path_ptrs.size(), archive_compression::deflate,
+                L"Benchmark", nullptr, 0, false).get();
+        });
+        report(deflated, per_file);
+    } catch (std::invalid_argument&) {
+        std::cout << "Deflated archive: not supported without zlib"
+            << std::endl;
+    }
+
+    for (auto& p : paths) {
+        std::remove(p.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,31 @@
+﻿// <copyright file="archive_compression.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+
+namespace visus {
+namespace dataverse {
+
+    /// <summary>
+    /// Possible ways of storing the files in a ZIP archive that is built
+    /// while it is being uploaded.
+    /// </summary>
+    enum class archive_compression {
+        /// <summary>
+        /// The files are stored as they are, which is the cheapest option for
+        /// data that are already compressed.
+        /// </summary>
+        store,
+
+        /// <summary>
+        /// The files are compressed using the deflate algorithm, which is
+        /// only available if the library has been built with zlib.
+        /// </summary>
+        deflate
+    };
+
+} /* namespace dataverse */
+} /* namespace visus */
@@ -30,7 +30,8 @@ namespace dataverse {
         /// <summary>
           /// Initialises a new and empty instance.
           /// </summary>
-        inline blob(void) noexcept : _data(nullptr), _size(0) { }
+        inline blob(void) noexcept
+            : _capacity(0), _data(nullptr), _size(0) { }
 
         /// <summary>
         /// Initialises a new instance.
@@ -39,7 +40,7 @@ namespace dataverse {
         /// <exception cref="std::bad_alloc">If the required memory could not
         /// be allocated.</exception>
         explicit inline blob(_In_ const std::size_t size)
-            : _data(new byte_type[size]), _size(size) { }
+            : _capacity(size), _data(new byte_type[size]), _size(size) { }
 
         /// <summary>
         /// Initialises a new blob from existing data.
@@ -193,6 +194,21 @@ namespace dataverse {
             return this->as<byte_type>();
         }
 
+        /// <summary>
+        /// Answer the number of bytes the blob can hold without being
+        /// reallocated.
+        /// </summary>
+        /// <remarks>
+        /// The capacity is always at least <see cref="blob::size" />. Shrinking
+        /// the blob retains the allocation, such that the memory can be reused
+        /// if the blob grows again later. Only <see cref="blob::clear" />
+        /// releases the memory.
+        /// </remarks>
+        /// <returns>The allocated size of the blob in bytes.</returns>
+        inline std::size_t capacity(void) const noexcept {
+            return this->_capacity;
+        }
+
         /// <summary>
         /// Deallocate all data.
         /// </summary>
@@ -321,8 +337,9 @@ namespace dataverse {
         /// <paramref name="size" /> in bytes.
         /// </summary>
         /// <remarks>
-        /// <para>If the buffer does not already have the requested size, any
-        /// existing data will be lost.</para>
+        /// <para>If the <see cref="blob::capacity" /> of the buffer is not
+        /// sufficient for the requested size, any existing data will be lost.
+        /// </para>
         /// <para>You can achieve the same effect by calling
         /// <see cref="blob::truncate" />, but preserve any exisiting content
         /// during the operation.</para>
@@ -351,6 +368,9 @@ namespace dataverse {
         /// <para>Although this method is called <see cref="blob::truncate" />,
         /// it can also increase the capacity of the blob. Any new data behind
         /// the existing range of content will remain uninitialised.</para>
+        /// <para>If the blob needs to be reallocated, its capacity grows
+        /// geometrically, which makes appending data piece by piece cheap.
+        /// Reducing the size never reallocates.</para>
         /// </remarks>
         /// <param name="size">The requested size in bytes.</param>
         /// <exception cref="std::bad_alloc">If the required memory could not
@@ -404,14 +424,32 @@ namespace dataverse {
         /// <summary>
         /// Answer whether the blob is non-empty.
         /// </summary>
-        /// <returns><c>true</c> if the blob has at least one byte allocated,
-        /// <c>false</c> if the data pointer is <c>nullptr</c>.</returns>
+        /// <remarks>
+        /// <para>A blob that has been truncated to zero size may retain its
+        /// allocation, so this operator is consistent with
+        /// <see cref="empty" /> rather than with the data pointer.</para>
+        /// <para>The non-constant overload is required as the conversion to
+        /// <c>void *</c> would be preferred for non-constant blobs
+        /// otherwise.</para>
+        /// </remarks>
+        /// <returns><c>true</c> if the blob contains at least one byte,
+        /// <c>false</c> otherwise.</returns>
+        inline operator bool(void) noexcept {
+            return (this->_size > 0);
+        }
+
+        /// <summary>
+        /// Answer whether the blob is non-empty.
+        /// </summary>
+        /// <returns><c>true</c> if the blob contains at least one byte,
+        /// <c>false</c> otherwise.</returns>
         inline operator bool(void) const noexcept {
-            return (this->_data != nullptr);
+            return (this->_size > 0);
         }
 
     private:
 
+        std::size_t _capacity;
         byte_type *_data;
         std::size_t _size;
 
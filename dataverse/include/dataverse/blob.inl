@@ -9,9 +9,10 @@
  */
 template<class TElement>
 visus::dataverse::blob::blob(_In_ const std::initializer_list<TElement>& data)
-        : _data(nullptr), _size(data.size() * sizeof(TElement)) {
+        : _capacity(0), _data(nullptr), _size(data.size() * sizeof(TElement)) {
     if (this->_size > 0) {
         this->_data = new byte_type[this->_size];
+        this->_capacity = this->_size;
         auto d = reinterpret_cast<TElement *>(this->_data);
         std::copy(data.begin(), data.end(), d);
     }
@@ -0,0 +1,247 @@
+﻿// <copyright file="blob_view.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#if (defined(_MSVC_LANG) && (_MSVC_LANG >= 201703L)) || (__cplusplus >= 201703L)
+#include <string_view>
+#define DATAVERSE_HAS_STRING_VIEW 1
+#endif /* (defined(_MSVC_LANG) && (_MSVC_LANG >= 201703L)) || ... */
+
+#if (defined(_MSVC_LANG) && (_MSVC_LANG >= 202002L)) || (__cplusplus >= 202002L)
+#include <span>
+#define DATAVERSE_HAS_SPAN 1
+#endif /* (defined(_MSVC_LANG) && (_MSVC_LANG >= 202002L)) || ... */
+
+#include "dataverse/api.h"
+#include "dataverse/blob.h"
+
+
+namespace visus {
+namespace dataverse {
+
+    /// <summary>
+    /// A non-owning, read-only view of a contiguous range of bytes, most
+    /// notably of (a part of) a <see cref="blob" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>The view consists of a pointer and a size only and is therefore
+    /// cheap to copy and pass by value. Slicing a view never copies the data it
+    /// refers to.</para>
+    /// <para>The view does not own the memory it refers to. Callers must make
+    /// sure that the memory lives at least as long as the view and any view
+    /// derived from it. Most importantly, a view of the response passed to a
+    /// callback must not be used after the callback returned.</para>
+    /// </remarks>
+    class DATAVERSE_API blob_view final {
+
+    public:
+
+        /// <summary>
+        /// The type used to represent a single byte.
+        /// </summary>
+        typedef blob::byte_type byte_type;
+
+        /// <summary>
+        /// A size that designates everything up to the end of the view.
+        /// </summary>
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        /// <summary>
+        /// Initialises a new, empty view.
+        /// </summary>
+        inline blob_view(void) noexcept : _data(nullptr), _size(0) { }
+
+        /// <summary>
+        /// Initialises a new view of the given memory range.
+        /// </summary>
+        /// <param name="data">A pointer to the begin of the range. This can
+        /// only be <c>nullptr</c> if <paramref name="cnt" /> is zero.</param>
+        /// <param name="cnt">The size of the range in bytes.</param>
+        inline blob_view(_In_reads_bytes_(cnt) const void *data,
+                _In_ const std::size_t cnt) noexcept
+            : _data(static_cast<const byte_type *>(data)),
+                _size((data != nullptr) ? cnt : 0) { }
+
+        /// <summary>
+        /// Initialises a new view of the whole content of a
+        /// <see cref="blob" />.
+        /// </summary>
+        /// <param name="data">The blob to be viewed.</param>
+        inline blob_view(_In_ const blob& data) noexcept
+            : _data(data.begin()), _size(data.size()) { }
+
+        /// <summary>
+        /// Initialises a new view of the characters in a string.
+        /// </summary>
+        /// <param name="data">The string to be viewed.</param>
+        inline blob_view(_In_ const std::string& data) noexcept
+            : _data(reinterpret_cast<const byte_type *>(data.data())),
+                _size(data.size()) { }
+
+        /// <summary>
+        /// Reinterprets the begin of the view as the specified type.
+        /// </summary>
+        /// <typeparam name="TPointer">The type to reinterpret the data as.
+        /// </typeparam>
+        /// <returns>The pointer to the begin of the view.</returns>
+        template<class TPointer>
+        inline _Ret_maybenull_ const TPointer *as(void) const noexcept {
+            return reinterpret_cast<const TPointer *>(this->_data);
+        }
+
+        /// <summary>
+        /// Reinterprets the data at the given offset as the specified type.
+        /// </summary>
+        /// <typeparam name="TPointer">The type to reinterpret the data as.
+        /// </typeparam>
+        /// <param name="offset">The offset in bytes from the begin of the
+        /// view.</param>
+        /// <returns>The pointer to the data at <paramref name="offset" /> or
+        /// <c>nullptr</c> if the offset is out of range.</returns>
+        template<class TPointer>
+        inline _Ret_maybenull_ const TPointer *as(
+                _In_ const std::size_t offset) const noexcept {
+            return (offset < this->_size)
+                ? reinterpret_cast<const TPointer *>(this->_data + offset)
+                : nullptr;
+        }
+
+        /// <summary>
+        /// Answer the pointer to the begin of the view.
+        /// </summary>
+        /// <returns>A pointer to the first byte.</returns>
+        inline _Ret_maybenull_ const byte_type *begin(void) const noexcept {
+            return this->_data;
+        }
+
+        /// <summary>
+        /// Answer the pointer to the begin of the view.
+        /// </summary>
+        /// <returns>A pointer to the first byte.</returns>
+        inline _Ret_maybenull_ const void *data(void) const noexcept {
+            return this->_data;
+        }
+
+        /// <summary>
+        /// Answer whether the view is empty.
+        /// </summary>
+        /// <returns><c>true</c> if the view does not contain any data,
+        /// <c>false</c> otherwise.</returns>
+        inline bool empty(void) const noexcept {
+            return (this->_size == 0);
+        }
+
+        /// <summary>
+        /// Answer the pointer past the last byte of the view.
+        /// </summary>
+        /// <returns>A pointer to the end of the view.</returns>
+        inline _Ret_maybenull_ const byte_type *end(void) const noexcept {
+            return this->_data + this->_size;
+        }
+
+        /// <summary>
+        /// Answer the size of the view in bytes.
+        /// </summary>
+        /// <returns>The number of bytes in the view.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_size;
+        }
+
+        /// <summary>
+        /// Answer a view of a part of this view.
+        /// </summary>
+        /// <remarks>
+        /// The range is clamped to this view, i.e. an offset beyond the end
+        /// yields an empty view and a count beyond the end yields a view of
+        /// the rest.
+        /// </remarks>
+        /// <param name="offset">The offset of the first byte of the slice.
+        /// </param>
+        /// <param name="cnt">The maximum size of the slice in bytes.</param>
+        /// <returns>A view of the requested range.</returns>
+        inline blob_view slice(_In_ const std::size_t offset,
+                _In_ const std::size_t cnt = npos) const noexcept {
+            const auto begin = (std::min)(offset, this->_size);
+            const auto size = (std::min)(cnt, this->_size - begin);
+            return blob_view(this->_data + begin, size);
+        }
+
+        /// <summary>
+        /// Copies the data into a string.
+        /// </summary>
+        /// <returns>A string holding a copy of the data.</returns>
+        /// <exception cref="std::bad_alloc">If the memory for the copy could
+        /// not be allocated.</exception>
+        inline std::string to_string(void) const {
+            return std::string(this->as<char>(), this->_size);
+        }
+
+#if defined(DATAVERSE_HAS_STRING_VIEW)
+        /// <summary>
+        /// Answer a string view of the data.
+        /// </summary>
+        /// <returns>The data as string view.</returns>
+        inline operator std::string_view(void) const noexcept {
+            return std::string_view(this->as<char>(), this->_size);
+        }
+#endif /* defined(DATAVERSE_HAS_STRING_VIEW) */
+
+#if defined(DATAVERSE_HAS_SPAN)
+        /// <summary>
+        /// Answer a span of the data.
+        /// </summary>
+        /// <returns>The data as span of bytes.</returns>
+        inline operator std::span<const byte_type>(void) const noexcept {
+            return std::span<const byte_type>(this->_data, this->_size);
+        }
+#endif /* defined(DATAVERSE_HAS_SPAN) */
+
+        /// <summary>
+        /// Answer the byte at the given position.
+        /// </summary>
+        /// <param name="offset">The offset of the byte, which must be within
+        /// the view.</param>
+        /// <returns>The requested byte.</returns>
+        inline byte_type operator [](_In_ const std::size_t offset)
+                const noexcept {
+            return this->_data[offset];
+        }
+
+        /// <summary>
+        /// Test for equality of the content.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>true</c> if both views contain the same bytes,
+        /// <c>false</c> otherwise.</returns>
+        inline bool operator ==(_In_ const blob_view& rhs) const noexcept {
+            return (this->_size == rhs._size) && ((this->_size == 0)
+                || (::memcmp(this->_data, rhs._data, this->_size) == 0));
+        }
+
+        /// <summary>
+        /// Test for inequality of the content.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>true</c> if the views contain different bytes,
+        /// <c>false</c> otherwise.</returns>
+        inline bool operator !=(_In_ const blob_view& rhs) const noexcept {
+            return !(*this == rhs);
+        }
+
+    private:
+
+        const byte_type *_data;
+        std::size_t _size;
+    };
+
+} /* namespace dataverse */
+} /* namespace visus */
@@ -0,0 +1,56 @@
+﻿// <copyright file="cache_statistics.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+
+namespace visus {
+namespace dataverse {
+
+    /// <summary>
+    /// Statistics about the effectiveness of a response cache.
+    /// </summary>
+    struct cache_statistics final {
+
+        /// <summary>
+        /// The number of entries that have been removed to make room for new
+        /// ones.
+        /// </summary>
+        std::uint64_t evictions;
+
+        /// <summary>
+        /// The number of requests that have been answered from the cache
+        /// without contacting the server.
+        /// </summary>
+        std::uint64_t hits;
+
+        /// <summary>
+        /// The number of requests that could not be answered from the cache
+        /// and caused the whole response to be transferred.
+        /// </summary>
+        std::uint64_t misses;
+
+        /// <summary>
+        /// The number of requests for which the server confirmed that the
+        /// cached response is still valid.
+        /// </summary>
+        std::uint64_t revalidations;
+
+        /// <summary>
+        /// The number of responses currently held by the cache.
+        /// </summary>
+        std::size_t entries;
+
+        /// <summary>
+        /// The number of bytes of the responses currently held by the cache.
+        /// </summary>
+        std::size_t size;
+    };
+
+} /* namespace dataverse */
+} /* namespace visus */
@@ -0,0 +1,123 @@
+﻿// <copyright file="checksum.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "dataverse/api.h"
+#include "dataverse/narrow_string.h"
+
+
+namespace visus {
+namespace dataverse {
+
+    /// <summary>
+    /// The size of a buffer that can hold the checksum of any supported
+    /// algorithm as hex string including the terminating zero.
+    /// </summary>
+    constexpr std::size_t max_checksum_length = 2 * 64 + 1;
+
+    /// <summary>
+    /// Computes the checksum of the file at the specified location as
+    /// Dataverse reports it for files, i.e. as lower-case hex string.
+    /// </summary>
+    /// <remarks>
+    /// The file is read sequentially in large blocks or mapped into memory
+    /// if possible. Computing the checksum of a large file takes a long
+    /// time, so callers should not invoke this method on a thread that needs
+    /// to be responsive.
+    /// </remarks>
+    /// <param name="dst">A buffer to receive the null-terminated checksum,
+    /// which should be able to hold at least
+    /// <see cref="max_checksum_length" /> characters.</param>
+    /// <param name="cnt_dst">The number of elements that can be stored to
+    /// <paramref name="dst" />.</param>
+    /// <param name="path">The path to the file.</param>
+    /// <param name="algorithm">The name of the algorithm as used by
+    /// Dataverse, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+    /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+    /// <returns>The number of characters required for the checksum, including
+    /// the terminating zero. Nothing is written if this is larger than
+    /// <paramref name="cnt_dst" />.</returns>
+    /// <exception cref="std::invalid_argument">If
+    /// <paramref name="algorithm" /> is not supported.</exception>
+    /// <exception cref="std::system_error">If the file could not be read or
+    /// hashed.</exception>
+    extern std::size_t DATAVERSE_API file_checksum(
+        _Out_writes_to_opt_(cnt_dst, return) char *dst,
+        _In_ const std::size_t cnt_dst,
+        _In_z_ const wchar_t *path,
+        _In_z_ const char *algorithm);
+
+    /// <summary>
+    /// Computes the checksum of the file at the specified location as
+    /// Dataverse reports it for files, i.e. as lower-case hex string.
+    /// </summary>
+    /// <param name="dst">A buffer to receive the null-terminated checksum,
+    /// which should be able to hold at least
+    /// <see cref="max_checksum_length" /> characters.</param>
+    /// <param name="cnt_dst">The number of elements that can be stored to
+    /// <paramref name="dst" />.</param>
+    /// <param name="path">The path to the file.</param>
+    /// <param name="algorithm">The name of the algorithm as used by
+    /// Dataverse, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+    /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+    /// <returns>The number of characters required for the checksum, including
+    /// the terminating zero. Nothing is written if this is larger than
+    /// <paramref name="cnt_dst" />.</returns>
+    /// <exception cref="std::invalid_argument">If
+    /// <paramref name="algorithm" /> is not supported.</exception>
+    /// <exception cref="std::system_error">If the file could not be read or
+    /// hashed.</exception>
+    extern std::size_t DATAVERSE_API file_checksum(
+        _Out_writes_to_opt_(cnt_dst, return) char *dst,
+        _In_ const std::size_t cnt_dst,
+        _In_ const const_narrow_string& path,
+        _In_z_ const char *algorithm);
+
+    /// <summary>
+    /// Computes the checksum of the file at the specified location as
+    /// Dataverse reports it for files, i.e. as lower-case hex string.
+    /// </summary>
+    /// <param name="path">The path to the file.</param>
+    /// <param name="algorithm">The name of the algorithm as used by
+    /// Dataverse, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+    /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+    /// <returns>The checksum of the file.</returns>
+    /// <exception cref="std::invalid_argument">If
+    /// <paramref name="algorithm" /> is not supported.</exception>
+    /// <exception cref="std::system_error">If the file could not be read or
+    /// hashed.</exception>
+    inline std::string file_checksum(_In_z_ const wchar_t *path,
+            _In_z_ const char *algorithm = "MD5") {
+        char buffer[max_checksum_length];
+        file_checksum(buffer, max_checksum_length, path, algorithm);
+        return buffer;
+    }
+
+    /// <summary>
+    /// Computes the checksum of the file at the specified location as
+    /// Dataverse reports it for files, i.e. as lower-case hex string.
+    /// </summary>
+    /// <param name="path">The path to the file.</param>
+    /// <param name="algorithm">The name of the algorithm as used by
+    /// Dataverse, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+    /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+    /// <returns>The checksum of the file.</returns>
+    /// <exception cref="std::invalid_argument">If
+    /// <paramref name="algorithm" /> is not supported.</exception>
+    /// <exception cref="std::system_error">If the file could not be read or
+    /// hashed.</exception>
+    inline std::string file_checksum(_In_ const const_narrow_string& path,
+            _In_z_ const char *algorithm = "MD5") {
+        char buffer[max_checksum_length];
+        file_checksum(buffer, max_checksum_length, path, algorithm);
+        return buffer;
+    }
+
+} /* namespace dataverse */
+} /* namespace visus */
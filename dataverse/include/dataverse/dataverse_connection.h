@@ -14,18 +14,28 @@
 #include <system_error>
 #include <vector>
 
+#include "dataverse/archive_compression.h"
 #include "dataverse/blob.h"
+#include "dataverse/blob_view.h"
+#include "dataverse/cache_statistics.h"
 #include "dataverse/convert.h"
 #include "dataverse/event.h"
 #include "dataverse/form_data.h"
 #include "dataverse/json.h"
+#include "dataverse/json_sax_handler.h"
+#include "dataverse/json_view.h"
+#include "dataverse/transfer_progress.h"
 
 
 namespace visus {
 namespace dataverse {
 
     /* Forward declarations. */
-    namespace detail { class dataverse_connection_impl; }
+    namespace detail {
+        class dataverse_connection_impl;
+        struct direct_upload_batch;
+        struct direct_upload_context;
+    }
 
     /// <summary>
     /// Represents the connection to the Dataverse and stores the API path
@@ -45,7 +55,7 @@ namespace dataverse {
         /// API free data that it passed to it when this data is no longer
         /// needed.
         /// </summary>
-        typedef void (*data_deleter_type)(_In_opt_ const void *);
+        typedef form_data::data_deleter_type data_deleter_type;
 
 #if defined(DATAVERSE_WITH_JSON)
         /// <summary>
@@ -55,12 +65,51 @@ namespace dataverse {
             _In_opt_ void *);
 #endif /* defined(DATAVERSE_WITH_JSON) */
 
+        /// <summary>
+        /// The callback to be invoked for an API response that is accessed
+        /// via a lazily parsed <see cref="json_view" />.
+        /// </summary>
+        /// <remarks>
+        /// The view refers to the response buffer of the request, i.e. it
+        /// and all views derived from it are only valid while the callback
+        /// is running.
+        /// </remarks>
+        typedef void (*on_json_response_type)(_In_ const json_view&,
+            _In_opt_ void *);
+
         /// <summary>
         /// The callback to be invoked for a raw response.
         /// </summary>
         typedef void (*on_response_type)(_In_ const blob&,
             _In_opt_ void *);
 
+        /// <summary>
+        /// The callback to be invoked if a response has been written to a
+        /// caller-provided buffer.
+        /// </summary>
+        /// <remarks>
+        /// The callback receives the caller-provided buffer, the number of
+        /// valid bytes in it and whether the response has been truncated,
+        /// because it did not fit into the buffer.
+        /// </remarks>
+        typedef void (*on_buffer_response_type)(
+            _In_reads_bytes_(cnt) byte_type *,
+            _In_ const std::size_t cnt,
+            _In_ const bool,
+            _In_opt_ void *);
+
+        /// <summary>
+        /// The callback to be invoked when a request has made progress.
+        /// </summary>
+        /// <remarks>
+        /// The callback receives the progress of the request, the progress
+        /// of all requests of the connection and the context pointer of the
+        /// operation that issued the request.
+        /// </remarks>
+        typedef void (*on_progress_type)(_In_ const transfer_progress&,
+            _In_ const transfer_progress&,
+            _In_opt_ void *);
+
         /// <summary>
         /// The callback to be invoked for an error.
         /// </summary>
@@ -88,6 +137,20 @@ namespace dataverse {
         /// </summary>
         static const wchar_t *const latest_version;
 
+        /// <summary>
+        /// Answer the number of bytes that the pool of recycled I/O contexts
+        /// retains for receiving responses.
+        /// </summary>
+        /// <remarks>
+        /// Contexts for requests are shared between all connections and reused
+        /// together with their response buffers, such that steady-state
+        /// traffic does not allocate memory for the responses. This method
+        /// allows for monitoring how much memory is held by the pool.
+        /// </remarks>
+        /// <returns>The capacity of all pooled response buffers in bytes.
+        /// </returns>
+        static std::size_t retained_memory(void);
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -104,6 +167,64 @@ namespace dataverse {
         /// </summary>
         ~dataverse_connection(void);
 
+        /// <summary>
+        /// Sets the content encodings the connection offers to the server for
+        /// compressing responses.
+        /// </summary>
+        /// <remarks>
+        /// <para>If set, the connection sends an &quot;Accept-Encoding&quot;
+        /// header with all subsequent requests to metadata endpoints and
+        /// transparently decodes compressed responses, i.e. callbacks always
+        /// receive the decoded data. JSON responses typically shrink by an
+        /// order of magnitude, which is most beneficial for large listings on
+        /// slow links. Downloads of data files via the access API are never
+        /// encoded, because the sizes and ranges of partial downloads refer to
+        /// the encoded representation.</para>
+        /// <para>Only encodings supported by the underlying cURL library can
+        /// be used. Compression is disabled by default, because it only
+        /// costs CPU time for responses that are small anyway.</para>
+        /// </remarks>
+        /// <param name="encodings">A comma-separated list of encodings like
+        /// &quot;gzip, deflate&quot;. An empty string offers all encodings
+        /// the library supports. It is safe to pass <c>nullptr</c>, in which
+        /// case no encoding is negotiated.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to store the
+        /// data could not be alloctated.</exception>
+        dataverse_connection& accept_encoding(
+            _In_opt_z_ const wchar_t *encodings);
+
+        /// <summary>
+        /// Sets the content encodings the connection offers to the server for
+        /// compressing responses.
+        /// </summary>
+        /// <remarks>
+        /// <para>If set, the connection sends an &quot;Accept-Encoding&quot;
+        /// header with all subsequent requests to metadata endpoints and
+        /// transparently decodes compressed responses, i.e. callbacks always
+        /// receive the decoded data. JSON responses typically shrink by an
+        /// order of magnitude, which is most beneficial for large listings on
+        /// slow links. Downloads of data files via the access API are never
+        /// encoded, because the sizes and ranges of partial downloads refer to
+        /// the encoded representation.</para>
+        /// <para>Only encodings supported by the underlying cURL library can
+        /// be used. Compression is disabled by default, because it only
+        /// costs CPU time for responses that are small anyway.</para>
+        /// </remarks>
+        /// <param name="encodings">A comma-separated list of encodings like
+        /// &quot;gzip, deflate&quot;. An empty string offers all encodings
+        /// the library supports. It is safe to pass <c>nullptr</c>, in which
+        /// case no encoding is negotiated.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to store the
+        /// data could not be alloctated.</exception>
+        dataverse_connection& accept_encoding(
+            _In_ const const_narrow_string& encodings);
+
         /// <summary>
         /// Sets a new API key to authenticate with Dataverse.
         /// </summary>
@@ -179,6 +300,248 @@ namespace dataverse {
         dataverse_connection& base_path(
             _In_ const const_narrow_string& base_path);
 
+        /// <summary>
+        /// Download the file with the specified ID into a file on disk via the
+        /// download cache.
+        /// </summary>
+        /// <remarks>
+        /// <para>If a file with the same ID, format and checksum is in the
+        /// cache configured via <see cref="download_cache" />, it is made
+        /// available at <paramref name="path" /> without contacting the
+        /// server. Otherwise, the file is downloaded into the cache first. If
+        /// the download cache is disabled, the method behaves like a
+        /// non-resumable <see cref="download" /> to
+        /// <paramref name="path" />.</para>
+        /// <para>Files are handed out as reflinks if the file system supports
+        /// this. Otherwise, <paramref name="path" /> is a hard link to the file
+        /// in the cache, which means that modifying it would also change the
+        /// cached copy. Callers should therefore treat the file as read-only.
+        /// Only if linking the file is not possible at all, it is copied.
+        /// </para>
+        /// <para>The checksum and its type are used as part of the key, i.e.
+        /// they must be the checksum of the file on the server as reported in
+        /// the metadata of the data set. Files uploaded at different times can
+        /// have checksums of different types. Downloaded data are only added
+        /// to the cache if they match the checksum. Otherwise, the download is
+        /// discarded and <paramref name="on_error" /> is invoked with an error
+        /// of the category &quot;Integrity&quot;.</para>
+        /// <para>The response passed to <paramref name="on_response" /> is
+        /// empty, because the data have been written to
+        /// <paramref name="path" />.</para>
+        /// </remarks>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="checksum_type">The hash algorithm as named in the
+        /// metadata of the file, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+        /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+        /// <param name="checksum">The checksum of the file as hex string.
+        /// </param>
+        /// <param name="path">The path to the file to write the download to.
+        /// Any existing file at this location will be replaced.</param>
+        /// <param name="on_response">A callback to be invoked if the file is
+        /// available at <paramref name="path" />.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="checksum_type" />, <paramref name="checksum" /> or
+        /// <paramref name="path" /> is <c>nullptr</c> or if the hash
+        /// algorithm is not supported.</exception>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the output file could not be
+        /// opened or if the request failed right away. Note that even if the
+        /// request initially succeeded, it might still fail and call
+        /// <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& cached_download(_In_ const std::uint64_t id,
+            _In_z_ const wchar_t *format,
+            _In_z_ const wchar_t *checksum_type,
+            _In_z_ const wchar_t *checksum,
+            _In_z_ const wchar_t *path,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Download the file with the specified ID into a file on disk via the
+        /// download cache.
+        /// </summary>
+        /// <remarks>
+        /// See the wide-string variant of this method for details.
+        /// </remarks>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="checksum_type">The hash algorithm as named in the
+        /// metadata of the file, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+        /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+        /// <param name="checksum">The checksum of the file as hex string.
+        /// </param>
+        /// <param name="path">The path to the file to write the download to.
+        /// Any existing file at this location will be replaced.</param>
+        /// <param name="on_response">A callback to be invoked if the file is
+        /// available at <paramref name="path" />.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="checksum_type" />, <paramref name="checksum" /> or
+        /// <paramref name="path" /> is <c>nullptr</c> or if the hash
+        /// algorithm is not supported.</exception>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the output file could not be
+        /// opened or if the request failed right away. Note that even if the
+        /// request initially succeeded, it might still fail and call
+        /// <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& cached_download(_In_ const std::uint64_t id,
+            _In_ const const_narrow_string& format,
+            _In_ const const_narrow_string& checksum_type,
+            _In_ const const_narrow_string& checksum,
+            _In_ const const_narrow_string& path,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Gets a future for the download of the file with the specified ID
+        /// into a file on disk via the download cache.
+        /// </summary>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="checksum_type">The hash algorithm as named in the
+        /// metadata of the file, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+        /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+        /// <param name="checksum">The checksum of the file as hex string.
+        /// </param>
+        /// <param name="path">The path to the file to write the download to.
+        /// </param>
+        /// <returns>A future that becomes ready once the file is available at
+        /// <paramref name="path" />.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline std::future<void> cached_download(_In_ const std::uint64_t id,
+                _In_z_ const wchar_t *format,
+                _In_z_ const wchar_t *checksum_type,
+                _In_z_ const wchar_t *checksum,
+                _In_z_ const wchar_t *path) {
+            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
+                const std::uint64_t,
+                const wchar_t *,
+                const wchar_t *,
+                const wchar_t *,
+                const wchar_t *,
+                const on_response_type,
+                const on_error_type,
+                void *);
+            return invoke_async(
+                static_cast<actual_type>(&dataverse_connection::cached_download),
+                *this, id, format, checksum_type, checksum, path);
+        }
+
+        /// <summary>
+        /// Sets the hash algorithm used for the checksums of direct uploads.
+        /// </summary>
+        /// <remarks>
+        /// <para>Dataverse can be configured to use MD5, SHA-1, SHA-256 or
+        /// SHA-512 for the checksums of its files. Direct uploads must use
+        /// the same algorithm as the server, because the client computes the
+        /// checksum. The default is MD5, which is also the default of
+        /// Dataverse.</para>
+        /// <para>The checksum is registered as &quot;checksum&quot; object
+        /// with the file. The hash functions of the operating system or
+        /// OpenSSL are used, which select the fastest implementation for the
+        /// CPU, e.g. the SHA extensions of x64 and ARMv8, at runtime.</para>
+        /// <para>The algorithm is determined when an upload is started, i.e.
+        /// changing it does not affect uploads in progress.</para>
+        /// </remarks>
+        /// <param name="algorithm">The name of the algorithm, i.e.
+        /// &quot;MD5&quot;, &quot;SHA-1&quot;, &quot;SHA-256&quot; or
+        /// &quot;SHA-512&quot;. The name is not case-sensitive and the hyphen
+        /// is optional.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="algorithm" /> is not supported.</exception>
+        dataverse_connection& checksum_algorithm(
+            _In_z_ const wchar_t *algorithm);
+
+        /// <summary>
+        /// Sets the hash algorithm used for the checksums of direct uploads.
+        /// </summary>
+        /// <remarks>
+        /// See the wide-string variant of this method for details.
+        /// </remarks>
+        /// <param name="algorithm">The name of the algorithm, i.e.
+        /// &quot;MD5&quot;, &quot;SHA-1&quot;, &quot;SHA-256&quot; or
+        /// &quot;SHA-512&quot;.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="algorithm" /> is not supported.</exception>
+        dataverse_connection& checksum_algorithm(
+            _In_ const const_narrow_string& algorithm);
+
+        /// <summary>
+        /// Answer the hash algorithm used for the checksums of direct uploads.
+        /// </summary>
+        /// <returns>The name of the algorithm as used by Dataverse, e.g.
+        /// &quot;SHA-256&quot;. The string is static and remains valid after
+        /// the connection has been destroyed.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        _Ret_z_ const char *checksum_algorithm(void) const;
+
+        /// <summary>
+        /// Enables or disables coalescing of identical GET requests.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, a GET request for a resource that is already
+        /// being retrieved with the same credentials does not cause another
+        /// transfer. Instead, the request is attached to the one in flight and
+        /// its callbacks are invoked with the same response once the transfer
+        /// completes. This is most beneficial if many threads query the same
+        /// data set or file listing at about the same time.</para>
+        /// <para>Only requests whose response is delivered as a
+        /// <see cref="blob" /> or as parsed JSON are coalesced. Downloads into
+        /// files or caller-provided buffers and streamed responses are always
+        /// transferred separately. Coalescing is disabled by default, because
+        /// callers might expect every request to observe the latest state on
+        /// the server.</para>
+        /// </remarks>
+        /// <param name="enable"><c>true</c> for coalescing identical GET
+        /// requests, <c>false</c> for sending every request.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        dataverse_connection& coalesce_requests(_In_ const bool enable);
+
+        /// <summary>
+        /// Answer whether identical GET requests are coalesced.
+        /// </summary>
+        /// <returns><c>true</c> if identical GET requests in flight are
+        /// coalesced, <c>false</c> otherwise.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        bool coalesce_requests(void) const;
+
         /// <summary>
         /// Gets the description of a data set, which is required for instance
         /// for enumerating the files in it.
@@ -409,6 +772,10 @@ namespace dataverse {
         /// <remarks>
         /// <para>This method will only work if the administrator of the target
         /// Dataverse has enabled direct uploads.</para>
+        /// <para>The method does not access the file itself, but returns
+        /// immediately. The file is opened on a worker thread and hashed while
+        /// it is being uploaded. Therefore, problems with the file are
+        /// reported asynchronously like any other error.</para>
         /// </remarks>
         /// <param name="persistent_id">The persistent ID of the data set the
         /// file should be added to, which typically has the form
@@ -470,6 +837,10 @@ namespace dataverse {
         /// <remarks>
         /// <para>This method will only work if the administrator of the target
         /// Dataverse has enabled direct uploads.</para>
+        /// <para>The method does not access the file itself, but returns
+        /// immediately. The file is opened on a worker thread and hashed while
+        /// it is being uploaded. Therefore, problems with the file are
+        /// reported asynchronously like any other error.</para>
         /// </remarks>
         /// <typeparam name="TTraits">The type of the character traits of a
         /// string.</typeparam>
@@ -535,6 +906,10 @@ namespace dataverse {
         /// <remarks>
         /// <para>This method will only work if the administrator of the target
         /// Dataverse has enabled direct uploads.</para>
+        /// <para>The method does not access the file itself, but returns
+        /// immediately. The file is opened on a worker thread and hashed while
+        /// it is being uploaded. Therefore, problems with the file are
+        /// reported asynchronously like any other error.</para>
         /// </remarks>
         /// <param name="persistent_id">The persistent ID of the data set the
         /// file should be added to, which typically has the form
@@ -603,6 +978,10 @@ namespace dataverse {
         /// <remarks>
         /// <para>This method will only work if the administrator of the target
         /// Dataverse has enabled direct uploads.</para>
+        /// <para>The method does not access the file itself, but returns
+        /// immediately. The file is opened on a worker thread and hashed while
+        /// it is being uploaded. Therefore, problems with the file are
+        /// reported asynchronously like any other error.</para>
         /// </remarks>
         /// <typeparam name="TAlloc">The allocator of a vector.</typeparam>
         /// <param name="persistent_id">The persistent ID of the data set the
@@ -662,6 +1041,10 @@ namespace dataverse {
         /// <remarks>
         /// <para>This method will only work if the administrator of the target
         /// Dataverse has enabled direct uploads.</para>
+        /// <para>The method does not access the file itself, but returns
+        /// immediately. The file is opened on a worker thread and hashed while
+        /// it is being uploaded. Therefore, problems with the file are
+        /// reported asynchronously like any other error.</para>
         /// </remarks>
         /// <param name="persistent_id">The persistent ID of the data set the
         /// file should be added to, which typically has the form
@@ -726,6 +1109,10 @@ namespace dataverse {
         /// <remarks>
         /// <para>This method will only work if the administrator of the target
         /// Dataverse has enabled direct uploads.</para>
+        /// <para>The method does not access the file itself, but returns
+        /// immediately. The file is opened on a worker thread and hashed while
+        /// it is being uploaded. Therefore, problems with the file are
+        /// reported asynchronously like any other error.</para>
         /// </remarks>
         /// <typeparam name="TAlloc">The allocator of a vector.</typeparam>
         /// <param name="persistent_id">The persistent ID of the data set the
@@ -785,11 +1172,48 @@ namespace dataverse {
         }
 
         /// <summary>
-        /// Download the file with the specified ID into a memory buffer.
+        /// Performs a &quot;direct upload&quot; of data in memory to the S3
+        /// backend.
         /// </summary>
-        /// <param name="id">The unqiue ID of the file.</param>
-        /// <param name="format">The format of the file to retrieve, which can
-        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <remarks>
+        /// <para>This variant is intended for applications that hold their
+        /// results in memory, which would otherwise need to write a temporary
+        /// file first. The data are hashed on a worker thread before the
+        /// upload starts, and the S3 request reads them directly from
+        /// <paramref name="data" />, i.e. they are neither copied nor written
+        /// to disk.</para>
+        /// <para>Large data are uploaded in parts like files if the server
+        /// requests this.</para>
+        /// </remarks>
+        /// <param name="persistent_id">The persistent ID of the data set the
+        /// file should be added to, which typically has the form
+        /// &quot;doi:the-doi&quot;.</param>
+        /// <param name="name">The name of the file in the data set.</param>
+        /// <param name="data">The content of the file. The caller remains
+        /// owner of this memory if no <paramref name="data_deleter" /> is set
+        /// and must make sure that the data remain valid until the upload
+        /// completed or failed.</param>
+        /// <param name="cnt">The size of the data in bytes.</param>
+        /// <param name="data_deleter">If not <c>nullptr</c>, the object will
+        /// eventually free <paramref name="data" /> using this callback, also
+        /// if the upload fails.</param>
+        /// <param name="mime_type">The MIME type of the file to be uploaded.
+        /// This must be manually set for direct uploads, because the Dataverse
+        /// cannot determine this on its own using this upload path.</param>
+        /// <param name="description">A description of the file.</param>
+        /// <param name="directory">The name of the folder to organise the file
+        /// in a tree structure. If this is an empty string, the file will be
+        /// placed at root level. Make sure to terminate the path with a
+        /// slash.</param>
+        /// <param name="categories">A list of
+        /// <paramref name="cnt_cats" /> categories to be assigned to
+        /// the file. It is safe to pass <c>nullptr</c>.</param>
+        /// <param name="cnt_cats">The number of categories to add.
+        /// </param>
+        /// <param name="restricted"><c>true</c> for marking the file as
+        /// restricted such that it can only be uploaded when registering in
+        /// the guestbook. <c>false</c> for making the file freely available.
+        /// </param>
         /// <param name="on_response">A callback to be invoked if the response
         /// to the request was received.</param>
         /// <param name="on_error">A callback to be invoked if the request
@@ -799,23 +1223,70 @@ namespace dataverse {
         /// <returns><c>*this</c>.</returns>
         /// <exception cref="std::system_error">If the method was called on an
         /// object that has been moved.</exception>
-        /// <exception cref="std::system_error">If the request failed right away.
-        /// Note that even if the request initially succeeded, it might still
-        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="data" />
+        /// is <c>nullptr</c> although <paramref name="cnt" /> is not zero.
+        /// </exception>
         /// <exception cref="std::bad_alloc">If the memory required to build the
         /// request could not be alloctated.</exception>
-        dataverse_connection& download(_In_ const std::uint64_t id,
-            _In_z_ const wchar_t *format,
+        dataverse_connection& direct_upload(
+            _In_z_ const wchar_t *persistent_id,
+            _In_z_ const wchar_t *name,
+            _In_reads_bytes_(cnt) const byte_type *data,
+            _In_ const std::size_t cnt,
+            _In_opt_ const data_deleter_type data_deleter,
+            _In_opt_z_ const wchar_t *mime_type,
+            _In_z_ const wchar_t *description,
+            _In_z_ const wchar_t *directory,
+            _In_reads_z_(cnt_cats) const wchar_t **categories,
+            _In_ const std::size_t cnt_cats,
+            _In_ const bool restricted,
             _In_ const on_response_type on_response,
             _In_ const on_error_type on_error,
             _In_opt_ void *context = nullptr);
 
         /// <summary>
-        /// Download the file with the specified ID into a memory buffer.
+        /// Performs a &quot;direct upload&quot; of data in memory to the S3
+        /// backend.
         /// </summary>
-        /// <param name="id">The unqiue ID of the file.</param>
-        /// <param name="format">The format of the file to retrieve, which can
-        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <remarks>
+        /// <para>This variant is intended for applications that hold their
+        /// results in memory, which would otherwise need to write a temporary
+        /// file first. The data are hashed on a worker thread before the
+        /// upload starts, and the S3 request reads them directly from
+        /// <paramref name="data" />, i.e. they are neither copied nor written
+        /// to disk.</para>
+        /// <para>Large data are uploaded in parts like files if the server
+        /// requests this.</para>
+        /// </remarks>
+        /// <param name="persistent_id">The persistent ID of the data set the
+        /// file should be added to, which typically has the form
+        /// &quot;doi:the-doi&quot;.</param>
+        /// <param name="name">The name of the file in the data set.</param>
+        /// <param name="data">The content of the file. The caller remains
+        /// owner of this memory if no <paramref name="data_deleter" /> is set
+        /// and must make sure that the data remain valid until the upload
+        /// completed or failed.</param>
+        /// <param name="cnt">The size of the data in bytes.</param>
+        /// <param name="data_deleter">If not <c>nullptr</c>, the object will
+        /// eventually free <paramref name="data" /> using this callback, also
+        /// if the upload fails.</param>
+        /// <param name="mime_type">The MIME type of the file to be uploaded.
+        /// This must be manually set for direct uploads, because the Dataverse
+        /// cannot determine this on its own using this upload path.</param>
+        /// <param name="description">A description of the file.</param>
+        /// <param name="directory">The name of the folder to organise the file
+        /// in a tree structure. If this is an empty string, the file will be
+        /// placed at root level. Make sure to terminate the path with a
+        /// slash.</param>
+        /// <param name="categories">A list of
+        /// <paramref name="cnt_cats" /> categories to be assigned to
+        /// the file. It is safe to pass <c>nullptr</c>.</param>
+        /// <param name="cnt_cats">The number of categories to add.
+        /// </param>
+        /// <param name="restricted"><c>true</c> for marking the file as
+        /// restricted such that it can only be uploaded when registering in
+        /// the guestbook. <c>false</c> for making the file freely available.
+        /// </param>
         /// <param name="on_response">A callback to be invoked if the response
         /// to the request was received.</param>
         /// <param name="on_error">A callback to be invoked if the request
@@ -825,29 +1296,531 @@ namespace dataverse {
         /// <returns><c>*this</c>.</returns>
         /// <exception cref="std::system_error">If the method was called on an
         /// object that has been moved.</exception>
-        /// <exception cref="std::system_error">If the request failed right away.
-        /// Note that even if the request initially succeeded, it might still
-        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="data" />
+        /// is <c>nullptr</c> although <paramref name="cnt" /> is not zero.
+        /// </exception>
         /// <exception cref="std::bad_alloc">If the memory required to build the
         /// request could not be alloctated.</exception>
-        dataverse_connection& download(_In_ const std::uint64_t id,
-            _In_ const const_narrow_string& format,
+        dataverse_connection& direct_upload(
+            _In_ const const_narrow_string& persistent_id,
+            _In_ const const_narrow_string& name,
+            _In_reads_bytes_(cnt) const byte_type *data,
+            _In_ const std::size_t cnt,
+            _In_opt_ const data_deleter_type data_deleter,
+            _In_ const const_narrow_string& mime_type,
+            _In_ const const_narrow_string& description,
+            _In_ const const_narrow_string& directory,
+            _In_reads_opt_(cnt_cats) const const_narrow_string *categories,
+            _In_ const std::size_t cnt_cats,
+            _In_ const bool restricted,
             _In_ const on_response_type on_response,
             _In_ const on_error_type on_error,
             _In_opt_ void *context = nullptr);
 
         /// <summary>
-        /// Gets a future for the contents of the file with the specified ID.
+        /// Performs &quot;direct uploads&quot; of multiple files to the S3
+        /// backend and registers all of them with a single request.
         /// </summary>
-        /// <param name="id">The unqiue ID of the file.</param>
-        /// <param name="format">The format of the file to retrieve, which can
-        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
-        /// <returns>A future for the contents of the file.</returns>
+        /// <remarks>
+        /// <para>The files are hashed and uploaded like in
+        /// <see cref="direct_upload_files" />, but they are not registered
+        /// individually once they have been stored. Instead, the descriptions
+        /// of all files are posted as a JSON array to the
+        /// &quot;addFiles&quot; API once the last file has been stored. As
+        /// every registration creates a new draft version of the data set
+        /// and locks it while the version is being updated, this is much
+        /// faster for many small files, e.g. when archiving a directory.
+        /// </para>
+        /// <para>The upload is all-or-nothing on the client side: if any file
+        /// cannot be stored, no file is registered and
+        /// <paramref name="on_error" /> is called with the first error. The
+        /// objects that have been stored remain tagged as temporary and are
+        /// removed by the storage. Dataverse might still reject individual
+        /// files, e.g. duplicates, which is reported in the response of the
+        /// registration.</para>
+        /// <para>Either <paramref name="on_response" /> or
+        /// <paramref name="on_error" /> is called exactly once for the whole
+        /// batch.</para>
+        /// </remarks>
+        /// <param name="persistent_id">The persistent ID of the data set the
+        /// files should be added to, which typically has the form
+        /// &quot;doi:the-doi&quot;.</param>
+        /// <param name="paths">The paths to the <paramref name="cnt" /> files
+        /// to be uploaded.</param>
+        /// <param name="cnt">The number of files to be uploaded.</param>
+        /// <param name="mime_type">The MIME type of all files. If this is
+        /// <c>nullptr</c>, &quot;application/octet-stream&quot; is used.
+        /// </param>
+        /// <param name="directory">The name of the folder to organise the files
+        /// in a tree structure. If this is an empty string, the files will be
+        /// placed at root level. Make sure to terminate the path with a
+        /// slash.</param>
+        /// <param name="restricted"><c>true</c> for marking the files as
+        /// restricted, <c>false</c> for making them freely available.</param>
+        /// <param name="on_response">A callback to be invoked with the
+        /// response to the registration of all files.</param>
+        /// <param name="on_error">A callback to be invoked if any file could
+        /// not be uploaded or if the registration failed.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
         /// <exception cref="std::system_error">If the method was called on an
         /// object that has been moved.</exception>
-        /// <exception cref="std::system_error">If the request failed right away.
-        /// Note that even if the request initially succeeded, it might still
-        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="paths" />
+        /// is <c>nullptr</c> although <paramref name="cnt" /> is not zero.
+        /// </exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// requests could not be alloctated.</exception>
+        dataverse_connection& direct_upload_all(
+            _In_z_ const wchar_t *persistent_id,
+            _In_reads_(cnt) const wchar_t **paths,
+            _In_ const std::size_t cnt,
+            _In_opt_z_ const wchar_t *mime_type,
+            _In_z_ const wchar_t *directory,
+            _In_ const bool restricted,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Performs &quot;direct uploads&quot; of multiple files to the S3
+        /// backend and registers all of them with a single request.
+        /// </summary>
+        /// <remarks>
+        /// See the wide-string variant of this method for details.
+        /// </remarks>
+        /// <param name="persistent_id">The persistent ID of the data set the
+        /// files should be added to, which typically has the form
+        /// &quot;doi:the-doi&quot;.</param>
+        /// <param name="paths">The paths to the <paramref name="cnt" /> files
+        /// to be uploaded.</param>
+        /// <param name="cnt">The number of files to be uploaded.</param>
+        /// <param name="mime_type">The MIME type of all files.</param>
+        /// <param name="directory">The name of the folder to organise the files
+        /// in a tree structure.</param>
+        /// <param name="restricted"><c>true</c> for marking the files as
+        /// restricted, <c>false</c> for making them freely available.</param>
+        /// <param name="on_response">A callback to be invoked with the
+        /// response to the registration of all files.</param>
+        /// <param name="on_error">A callback to be invoked if any file could
+        /// not be uploaded or if the registration failed.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="paths" />
+        /// is <c>nullptr</c> although <paramref name="cnt" /> is not zero.
+        /// </exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// requests could not be alloctated.</exception>
+        dataverse_connection& direct_upload_all(
+            _In_ const const_narrow_string& persistent_id,
+            _In_reads_(cnt) const const_narrow_string *paths,
+            _In_ const std::size_t cnt,
+            _In_ const const_narrow_string& mime_type,
+            _In_ const const_narrow_string& directory,
+            _In_ const bool restricted,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Performs &quot;direct uploads&quot; of multiple files to the S3
+        /// backend.
+        /// </summary>
+        /// <remarks>
+        /// <para>In contrast to calling <see cref="direct_upload" /> for every
+        /// file, this method computes the hashes of the files in parallel on
+        /// a bounded pool of hashing threads before the files are uploaded.
+        /// Only a limited number of files is hashed or uploaded at the same
+        /// time, and new files are only started once others have completed,
+        /// such that large batches neither exhaust memory nor the number of
+        /// connections to the server.</para>
+        /// <para>Like <see cref="direct_upload" />, the method does not access
+        /// the files itself, but returns immediately.</para>
+        /// <para>Either <paramref name="on_response" /> or
+        /// <paramref name="on_error" /> is called exactly once for every file,
+        /// in no particular order.</para>
+        /// </remarks>
+        /// <param name="persistent_id">The persistent ID of the data set the
+        /// files should be added to, which typically has the form
+        /// &quot;doi:the-doi&quot;.</param>
+        /// <param name="paths">The paths to the <paramref name="cnt" /> files
+        /// to be uploaded.</param>
+        /// <param name="cnt">The number of files to be uploaded.</param>
+        /// <param name="mime_type">The MIME type of all files. If this is
+        /// <c>nullptr</c>, &quot;application/octet-stream&quot; is used.
+        /// </param>
+        /// <param name="directory">The name of the folder to organise the files
+        /// in a tree structure. If this is an empty string, the files will be
+        /// placed at root level. Make sure to terminate the path with a
+        /// slash.</param>
+        /// <param name="restricted"><c>true</c> for marking the files as
+        /// restricted, <c>false</c> for making them freely available.</param>
+        /// <param name="on_response">A callback to be invoked for every file
+        /// that has been registered.</param>
+        /// <param name="on_error">A callback to be invoked for every file that
+        /// could not be uploaded.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="paths" />
+        /// is <c>nullptr</c> although <paramref name="cnt" /> is not zero.
+        /// </exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// requests could not be alloctated.</exception>
+        dataverse_connection& direct_upload_files(
+            _In_z_ const wchar_t *persistent_id,
+            _In_reads_(cnt) const wchar_t **paths,
+            _In_ const std::size_t cnt,
+            _In_opt_z_ const wchar_t *mime_type,
+            _In_z_ const wchar_t *directory,
+            _In_ const bool restricted,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Performs &quot;direct uploads&quot; of multiple files to the S3
+        /// backend.
+        /// </summary>
+        /// <remarks>
+        /// See the wide-string variant of this method for details.
+        /// </remarks>
+        /// <param name="persistent_id">The persistent ID of the data set the
+        /// files should be added to, which typically has the form
+        /// &quot;doi:the-doi&quot;.</param>
+        /// <param name="paths">The paths to the <paramref name="cnt" /> files
+        /// to be uploaded.</param>
+        /// <param name="cnt">The number of files to be uploaded.</param>
+        /// <param name="mime_type">The MIME type of all files.</param>
+        /// <param name="directory">The name of the folder to organise the files
+        /// in a tree structure.</param>
+        /// <param name="restricted"><c>true</c> for marking the files as
+        /// restricted, <c>false</c> for making them freely available.</param>
+        /// <param name="on_response">A callback to be invoked for every file
+        /// that has been registered.</param>
+        /// <param name="on_error">A callback to be invoked for every file that
+        /// could not be uploaded.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="paths" />
+        /// is <c>nullptr</c> although <paramref name="cnt" /> is not zero.
+        /// </exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// requests could not be alloctated.</exception>
+        dataverse_connection& direct_upload_files(
+            _In_ const const_narrow_string& persistent_id,
+            _In_reads_(cnt) const const_narrow_string *paths,
+            _In_ const std::size_t cnt,
+            _In_ const const_narrow_string& mime_type,
+            _In_ const const_narrow_string& directory,
+            _In_ const bool restricted,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Sets the maximum number of parts of a multipart direct upload that
+        /// are transferred at the same time.
+        /// </summary>
+        /// <remarks>
+        /// <para>Dataverse requests a multipart upload for files that exceed
+        /// the limit of its S3 store. In this case, every part is transferred
+        /// with its own PUT request, which reads its range of the file
+        /// independently from the other parts. Transferring several parts at
+        /// the same time usually makes better use of the bandwidth, because
+        /// every connection to S3 is limited by its own congestion window.
+        /// </para>
+        /// <para>The setting is determined when an upload is started, i.e.
+        /// changing it does not affect uploads in progress.</para>
+        /// </remarks>
+        /// <param name="parallelism">The maximum number of parts in flight per
+        /// file. Zero is interpreted as one. The default is four.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        dataverse_connection& direct_upload_parallelism(
+            _In_ const std::size_t parallelism);
+
+        /// <summary>
+        /// Answer the maximum number of parts of a multipart direct upload that
+        /// are transferred at the same time.
+        /// </summary>
+        /// <returns>The maximum number of parts in flight per file.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        std::size_t direct_upload_parallelism(void) const;
+
+        /// <summary>
+        /// Sets the minimum size of the parts of a multipart direct upload.
+        /// </summary>
+        /// <remarks>
+        /// <para>Dataverse determines the size of the parts and provides the
+        /// presigned URLs for them. The size requested by the server is
+        /// therefore always the lower bound. If the configured size is larger,
+        /// fewer and larger parts are transferred and the remaining URLs are
+        /// not used, which reduces the overhead of the requests on fast
+        /// connections. The size should be a multiple of the size requested
+        /// by the server.</para>
+        /// <para>The setting is determined when an upload is started, i.e.
+        /// changing it does not affect uploads in progress.</para>
+        /// </remarks>
+        /// <param name="size">The minimum size of a part in bytes, or zero
+        /// for using the size requested by the server, which is the default.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        dataverse_connection& direct_upload_part_size(
+            _In_ const std::uint64_t size);
+
+        /// <summary>
+        /// Answer the minimum size of the parts of a multipart direct upload.
+        /// </summary>
+        /// <returns>The minimum size of a part in bytes, or zero if the size
+        /// requested by the server is used.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        std::uint64_t direct_upload_part_size(void) const;
+
+        /// <summary>
+        /// Configures a cache for GET responses on disk, which can be shared
+        /// by multiple processes.
+        /// </summary>
+        /// <remarks>
+        /// <para>The disk cache works like the in-memory
+        /// <see cref="response_cache" />, but stores every response in its own
+        /// file in the given directory. Multiple processes can use the same
+        /// directory at the same time, such that short-lived processes on the
+        /// same machine do not need to retrieve the same metadata over and
+        /// over again. Cached responses are revalidated using their
+        /// &quot;ETag&quot; or &quot;Last-Modified&quot; header once they
+        /// have expired.</para>
+        /// <para>If both caches are enabled, the in-memory cache is asked
+        /// first. Responses found on disk are added to the in-memory cache.
+        /// Like the in-memory cache, the disk cache only holds metadata, i.e.
+        /// neither data files nor the URLs for direct uploads.</para>
+        /// <para>The files are named after a hash of the URL and the API key,
+        /// but they contain the responses in plain text. The directory should
+        /// therefore only be accessible by the user running the processes.
+        /// </para>
+        /// <para>If the files in the directory exceed
+        /// <paramref name="capacity" />, the ones that have not been used for
+        /// the longest time are removed until three quarters of the capacity
+        /// are left. Expired responses that cannot be revalidated are removed
+        /// when they are looked up.</para>
+        /// </remarks>
+        /// <param name="directory">The directory holding the cache, which is
+        /// created if it does not exist. It is safe to pass <c>nullptr</c>,
+        /// which disables the disk cache.</param>
+        /// <param name="capacity">The maximum size of all files in the cache
+        /// in bytes.</param>
+        /// <param name="ttl">The time in milliseconds for which a response is
+        /// used without asking the server.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the directory could not be
+        /// created.</exception>
+        dataverse_connection& disk_cache(_In_opt_z_ const wchar_t *directory,
+            _In_ const std::uint64_t capacity,
+            _In_ const int ttl);
+
+        /// <summary>
+        /// Configures a cache for GET responses on disk, which can be shared
+        /// by multiple processes.
+        /// </summary>
+        /// <param name="directory">The directory holding the cache, which is
+        /// created if it does not exist. It is safe to pass <c>nullptr</c>,
+        /// which disables the disk cache.</param>
+        /// <param name="capacity">The maximum size of all files in the cache
+        /// in bytes.</param>
+        /// <param name="ttl">The time in milliseconds for which a response is
+        /// used without asking the server.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the directory could not be
+        /// created.</exception>
+        dataverse_connection& disk_cache(
+            _In_ const const_narrow_string& directory,
+            _In_ const std::uint64_t capacity,
+            _In_ const int ttl);
+
+        /// <summary>
+        /// Configures a cache for GET responses on disk, which can be shared
+        /// by multiple processes.
+        /// </summary>
+        /// <typeparam name="TRep">The type used to represent the ticks of the
+        /// time to live.</typeparam>
+        /// <typeparam name="TRatio">The unit of the time to live.</typeparam>
+        /// <param name="directory">The directory holding the cache, which is
+        /// created if it does not exist. It is safe to pass <c>nullptr</c>,
+        /// which disables the disk cache.</param>
+        /// <param name="capacity">The maximum size of all files in the cache
+        /// in bytes.</param>
+        /// <param name="ttl">The time for which a response is used without
+        /// asking the server.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the directory could not be
+        /// created.</exception>
+        template<class TRep, class TRatio>
+        inline dataverse_connection& disk_cache(
+                _In_opt_z_ const wchar_t *directory,
+                _In_ const std::uint64_t capacity,
+                _In_ std::chrono::duration<TRep, TRatio> ttl) {
+            typedef std::chrono::duration<int, std::milli> millis_type;
+            auto millis = std::chrono::duration_cast<millis_type>(ttl);
+            return this->disk_cache(directory, capacity, millis.count());
+        }
+
+        /// <summary>
+        /// Answer statistics about the effectiveness of the disk cache for GET
+        /// responses.
+        /// </summary>
+        /// <remarks>
+        /// Hits and misses only cover the requests made via this connection.
+        /// The number and the size of the files are determined whenever the
+        /// directory is trimmed, so they are only an estimate if other
+        /// processes use the directory, too.
+        /// </remarks>
+        /// <returns>The statistics of the disk cache.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        cache_statistics disk_cache_statistics(void) const;
+
+        /// <summary>
+        /// Configures a directory in which files downloaded via
+        /// <see cref="cached_download" /> are kept for later use.
+        /// </summary>
+        /// <remarks>
+        /// <para>Files in the cache are identified by their ID, format and
+        /// checksum. Therefore, they never need to be revalidated. The
+        /// directory can be shared by multiple processes, because downloads
+        /// are only moved into place once they are complete.</para>
+        /// <para>If the files in the directory exceed
+        /// <paramref name="capacity" />, the ones that have not been used for
+        /// the longest time are removed whenever a new file has been added.
+        /// </para>
+        /// </remarks>
+        /// <param name="directory">The directory holding the cache, which is
+        /// created if it does not exist. It is safe to pass <c>nullptr</c>,
+        /// which disables the download cache.</param>
+        /// <param name="capacity">The maximum size of all files in the cache
+        /// in bytes.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the directory could not be
+        /// created.</exception>
+        dataverse_connection& download_cache(
+            _In_opt_z_ const wchar_t *directory,
+            _In_ const std::uint64_t capacity);
+
+        /// <summary>
+        /// Configures a directory in which files downloaded via
+        /// <see cref="cached_download" /> are kept for later use.
+        /// </summary>
+        /// <param name="directory">The directory holding the cache, which is
+        /// created if it does not exist. It is safe to pass <c>nullptr</c>,
+        /// which disables the download cache.</param>
+        /// <param name="capacity">The maximum size of all files in the cache
+        /// in bytes.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the directory could not be
+        /// created.</exception>
+        dataverse_connection& download_cache(
+            _In_ const const_narrow_string& directory,
+            _In_ const std::uint64_t capacity);
+
+        /// <summary>
+        /// Answer statistics about the effectiveness of the download cache.
+        /// </summary>
+        /// <remarks>
+        /// Hits and misses only cover the requests made via this connection.
+        /// The number and the size of the files reflect the state of the
+        /// directory when the connection last removed files from it.
+        /// </remarks>
+        /// <returns>The statistics of the download cache.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        cache_statistics download_cache_statistics(void) const;
+
+        /// <summary>
+        /// Download the file with the specified ID into a memory buffer.
+        /// </summary>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& download(_In_ const std::uint64_t id,
+            _In_z_ const wchar_t *format,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Download the file with the specified ID into a memory buffer.
+        /// </summary>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& download(_In_ const std::uint64_t id,
+            _In_ const const_narrow_string& format,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Gets a future for the contents of the file with the specified ID.
+        /// </summary>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <returns>A future for the contents of the file.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
         /// <exception cref="std::bad_alloc">If the memory required to build the
         /// request could not be alloctated.</exception>
         inline std::future<blob> download(_In_ const std::uint64_t id,
@@ -881,94 +1854,666 @@ namespace dataverse {
                 _In_ const const_narrow_string& format) {
             typedef dataverse_connection& (dataverse_connection:: *actual_type)(
                 const std::uint64_t,
-                const const_narrow_string&,
+                const const_narrow_string&,
+                const on_response_type,
+                const on_error_type,
+                void *);
+            return invoke_async<blob>(
+                static_cast<actual_type>(&dataverse_connection::download),
+                *this, id, format);
+        }
+
+        /// <summary>
+        /// Download the file with the specified ID into a file on disk, which
+        /// can be resumed if the transfer is interrupted.
+        /// </summary>
+        /// <remarks>
+        /// <para>While the download is in progress, the library maintains a
+        /// small checkpoint file next to <paramref name="path" />, which has
+        /// the additional extension &quot;.checkpoint&quot; and records the
+        /// ranges of the file that have already been written along with the
+        /// entity tag and the size of the remote file. The checkpoint is
+        /// removed once the download completed successfully.</para>
+        /// <para>If <paramref name="resume" /> is set and a checkpoint from a
+        /// previous attempt exists, only the missing part of the file is
+        /// requested from the server. If the server reports that the remote
+        /// file has changed since the checkpoint was written, the partial file
+        /// is discarded and the download starts over.</para>
+        /// <para>The response passed to <paramref name="on_response" /> is
+        /// empty, because the data have been written to
+        /// <paramref name="path" />.</para>
+        /// </remarks>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="path">The path to the file to write the download to.
+        /// </param>
+        /// <param name="resume">If <c>true</c>, continue from the checkpoint of
+        /// a previous attempt if there is one. Otherwise, any existing file at
+        /// <paramref name="path" /> will be overwritten.</param>
+        /// <param name="on_response">A callback to be invoked if the download
+        /// has completed.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the output file could not be
+        /// opened or if the request failed right away. Note that even if the
+        /// request initially succeeded, it might still fail and call
+        /// <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& download(_In_ const std::uint64_t id,
+            _In_z_ const wchar_t *format,
+            _In_z_ const wchar_t *path,
+            _In_ const bool resume,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Download the file with the specified ID into a file on disk, which
+        /// can be resumed if the transfer is interrupted.
+        /// </summary>
+        /// <remarks>
+        /// See the wide-string variant of this method for details on the
+        /// checkpoint.
+        /// </remarks>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="path">The path to the file to write the download to.
+        /// </param>
+        /// <param name="resume">If <c>true</c>, continue from the checkpoint of
+        /// a previous attempt if there is one. Otherwise, any existing file at
+        /// <paramref name="path" /> will be overwritten.</param>
+        /// <param name="on_response">A callback to be invoked if the download
+        /// has completed.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the output file could not be
+        /// opened or if the request failed right away. Note that even if the
+        /// request initially succeeded, it might still fail and call
+        /// <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& download(_In_ const std::uint64_t id,
+            _In_ const const_narrow_string& format,
+            _In_ const const_narrow_string& path,
+            _In_ const bool resume,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Gets a future for the resumable download of the file with the
+        /// specified ID into a file on disk.
+        /// </summary>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="path">The path to the file to write the download to.
+        /// </param>
+        /// <param name="resume">If <c>true</c>, continue from the checkpoint of
+        /// a previous attempt if there is one.</param>
+        /// <returns>A future that becomes ready once the file has been
+        /// written.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline std::future<void> download(_In_ const std::uint64_t id,
+                _In_z_ const wchar_t *format,
+                _In_z_ const wchar_t *path,
+                _In_ const bool resume) {
+            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
+                const std::uint64_t,
+                const wchar_t *,
+                const wchar_t *,
+                const bool,
+                const on_response_type,
+                const on_error_type,
+                void *);
+            return invoke_async(
+                static_cast<actual_type>(&dataverse_connection::download),
+                *this, id, format, path, resume);
+        }
+
+        /// <summary>
+        /// Gets a future for the resumable download of the file with the
+        /// specified ID into a file on disk.
+        /// </summary>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="path">The path to the file to write the download to.
+        /// </param>
+        /// <param name="resume">If <c>true</c>, continue from the checkpoint of
+        /// a previous attempt if there is one.</param>
+        /// <returns>A future that becomes ready once the file has been
+        /// written.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline std::future<void> download(_In_ const std::uint64_t id,
+                _In_ const const_narrow_string& format,
+                _In_ const const_narrow_string& path,
+                _In_ const bool resume) {
+            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
+                const std::uint64_t,
+                const const_narrow_string&,
+                const const_narrow_string&,
+                const bool,
+                const on_response_type,
+                const on_error_type,
+                void *);
+            return invoke_async(
+                static_cast<actual_type>(&dataverse_connection::download),
+                *this, id, format, path, resume);
+        }
+
+        /// <summary>
+        /// Download the file with the specified ID into a caller-provided
+        /// buffer.
+        /// </summary>
+        /// <remarks>
+        /// <para>The response is written directly into
+        /// <paramref name="buffer" /> while it is being received, which saves
+        /// the allocation of and the copy into a <see cref="blob" />. The
+        /// caller must keep the buffer alive until one of the callbacks has
+        /// been invoked.</para>
+        /// <para>If the file does not fit into the buffer, the transfer is
+        /// aborted. If <paramref name="truncate" /> is set, this is considered
+        /// a success and <paramref name="on_response" /> is invoked with the
+        /// truncation flag set. Otherwise, <paramref name="on_error" /> is
+        /// invoked to report the overflow.</para>
+        /// </remarks>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="buffer">The buffer to receive the file.</param>
+        /// <param name="capacity">The size of <paramref name="buffer" /> in
+        /// bytes.</param>
+        /// <param name="truncate">If <c>true</c>, a file that is larger than
+        /// <paramref name="buffer" /> is truncated. Otherwise, such a file is
+        /// reported as an error.</param>
+        /// <param name="on_response">A callback to be invoked if the file has
+        /// been received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="buffer" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& download(_In_ const std::uint64_t id,
+            _In_z_ const wchar_t *format,
+            _Out_writes_bytes_(capacity) byte_type *buffer,
+            _In_ const std::size_t capacity,
+            _In_ const bool truncate,
+            _In_ const on_buffer_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Download the file with the specified ID into a caller-provided
+        /// buffer.
+        /// </summary>
+        /// <remarks>
+        /// See the wide-string variant of this method for details on how
+        /// overflows are handled.
+        /// </remarks>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="buffer">The buffer to receive the file.</param>
+        /// <param name="capacity">The size of <paramref name="buffer" /> in
+        /// bytes.</param>
+        /// <param name="truncate">If <c>true</c>, a file that is larger than
+        /// <paramref name="buffer" /> is truncated. Otherwise, such a file is
+        /// reported as an error.</param>
+        /// <param name="on_response">A callback to be invoked if the file has
+        /// been received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="buffer" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& download(_In_ const std::uint64_t id,
+            _In_ const const_narrow_string& format,
+            _Out_writes_bytes_(capacity) byte_type *buffer,
+            _In_ const std::size_t capacity,
+            _In_ const bool truncate,
+            _In_ const on_buffer_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Download the file with the specified persistent identifier into a
+        /// memory buffer.
+        /// </summary>
+        /// <param name="persistent_id">The persistent ID of the file, which is
+        /// the DOI of the data set concatenated with some unique ID of the
+        /// file. Note that this might not work for unpublished data.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="version">The version of the file to be retrieved. This
+        /// can be one of the special constants like
+        /// <see cref="dataverse_connection::latest_version" />.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& download(_In_z_ const wchar_t *persistent_id,
+            _In_z_ const wchar_t *format,
+            _In_z_ const wchar_t *version,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Download the file with the specified persistent identifier into a
+        /// memory buffer.
+        /// </summary>
+        /// <param name="persistent_id">The persistent ID of the file, which is
+        /// the DOI of the data set concatenated with some unique ID of the
+        /// file. Note that this might not work for unpublished data.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="version">The version of the file to be retrieved. This
+        /// can be one of the special constants like
+        /// <see cref="dataverse_connection::latest_version" />.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& download(
+            _In_ const const_narrow_string& persistent_id,
+            _In_ const const_narrow_string& format,
+            _In_ const const_narrow_string& version,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Gets a future for the contents of the file with the specified
+        /// persistent identifier.
+        /// </summary>
+        /// <param name="persistent_id">The persistent ID of the file, which is
+        /// the DOI of the data set concatenated with some unique ID of the
+        /// file. Note that this might not work for unpublished data.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="version">The version of the file to be retrieved. This
+        /// can be one of the special constants like
+        /// <see cref="dataverse_connection::latest_version" />.</param>
+        /// <returns>A future for the contents of the file.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline std::future<blob> download(_In_z_ const wchar_t *persistent_id,
+                _In_z_ const wchar_t *format = L"original",
+                _In_z_ const wchar_t *version = latest_version) {
+            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
+                const wchar_t *,
+                const wchar_t *,
+                const wchar_t *,
+                const on_response_type,
+                const on_error_type,
+                void *);
+            return invoke_async<blob>(
+                static_cast<actual_type>(&dataverse_connection::download),
+                *this, persistent_id, format, version);
+        }
+
+        /// <summary>
+        /// Gets a future for the contents of the file with the specified
+        /// persistent identifier.
+        /// </summary>
+        /// <param name="persistent_id">The persistent ID of the file, which is
+        /// the DOI of the data set concatenated with some unique ID of the
+        /// file. Note that this might not work for unpublished data.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="version">The version of the file to be retrieved. This
+        /// can be one of the special constants like
+        /// <see cref="dataverse_connection::latest_version" />.</param>
+        /// <returns>A future for the contents of the file.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline std::future<blob> download(
+                _In_ const const_narrow_string& persistent_id,
+                _In_ const const_narrow_string& format,
+                _In_ const const_narrow_string& version) {
+            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
+                const const_narrow_string&,
+                const const_narrow_string&,
+                const const_narrow_string&,
+                const on_response_type,
+                const on_error_type,
+                void *);
+            return invoke_async<blob>(
+                static_cast<actual_type>(&dataverse_connection::download),
+                *this, persistent_id, format, version);
+        }
+
+        /// <summary>
+        /// Download the file with the specified ID into a memory buffer and
+        /// verify its checksum while it is being received.
+        /// </summary>
+        /// <remarks>
+        /// <para>The data are hashed chunk by chunk as they arrive, i.e. there
+        /// is no second pass over the response once the transfer completed.
+        /// If the hash does not match <paramref name="checksum" />,
+        /// <paramref name="on_error" /> is invoked with the error category
+        /// &quot;Integrity&quot; instead of <paramref name="on_response" />.
+        /// </para>
+        /// <para>Verified downloads are never answered from the response
+        /// caches and never coalesced with other requests.</para>
+        /// </remarks>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="checksum_type">The hash algorithm as named in the
+        /// metadata of the file, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+        /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+        /// <param name="checksum">The expected hash of the file as hex string.
+        /// </param>
+        /// <param name="on_response">A callback to be invoked if the file
+        /// has been received and matches the checksum.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously or if the checksum does not match.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="checksum_type" /> or <paramref name="checksum" />
+        /// is <c>nullptr</c> or if the hash algorithm is not supported.
+        /// </exception>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& verified_download(_In_ const std::uint64_t id,
+            _In_z_ const wchar_t *format,
+            _In_z_ const wchar_t *checksum_type,
+            _In_z_ const wchar_t *checksum,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Download the file with the specified ID into a memory buffer and
+        /// verify its checksum while it is being received.
+        /// </summary>
+        /// <remarks>
+        /// See the wide-string variant of this method for details.
+        /// </remarks>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="checksum_type">The hash algorithm as named in the
+        /// metadata of the file, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+        /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+        /// <param name="checksum">The expected hash of the file as hex string.
+        /// </param>
+        /// <param name="on_response">A callback to be invoked if the file
+        /// has been received and matches the checksum.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously or if the checksum does not match.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="checksum_type" /> or <paramref name="checksum" />
+        /// is <c>nullptr</c> or if the hash algorithm is not supported.
+        /// </exception>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& verified_download(_In_ const std::uint64_t id,
+            _In_ const const_narrow_string& format,
+            _In_ const const_narrow_string& checksum_type,
+            _In_ const const_narrow_string& checksum,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Gets a future for the contents of the file with the specified ID,
+        /// which are verified against the given checksum.
+        /// </summary>
+        /// <param name="id">The unqiue ID of the file.</param>
+        /// <param name="format">The format of the file to retrieve, which can
+        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
+        /// <param name="checksum_type">The hash algorithm as named in the
+        /// metadata of the file, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+        /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+        /// <param name="checksum">The expected hash of the file as hex string.
+        /// </param>
+        /// <returns>A future for the contents of the file.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline std::future<blob> verified_download(_In_ const std::uint64_t id,
+                _In_z_ const wchar_t *format,
+                _In_z_ const wchar_t *checksum_type,
+                _In_z_ const wchar_t *checksum) {
+            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
+                const std::uint64_t,
+                const wchar_t *,
+                const wchar_t *,
+                const wchar_t *,
                 const on_response_type,
                 const on_error_type,
                 void *);
             return invoke_async<blob>(
-                static_cast<actual_type>(&dataverse_connection::download),
-                *this, id, format);
+                static_cast<actual_type>(&dataverse_connection::verified_download),
+                *this, id, format, checksum_type, checksum);
         }
+
         /// <summary>
-        /// Download the file with the specified persistent identifier into a
-        /// memory buffer.
+        /// Download the file with the specified ID into a file on disk, which
+        /// can be resumed if the transfer is interrupted, and verify its
+        /// checksum while it is being received.
         /// </summary>
-        /// <param name="persistent_id">The persistent ID of the file, which is
-        /// the DOI of the data set concatenated with some unique ID of the
-        /// file. Note that this might not work for unpublished data.</param>
+        /// <remarks>
+        /// <para>The data are hashed chunk by chunk as they are written to
+        /// <paramref name="path" />. If a previous attempt is resumed, the part
+        /// of the file that is already on disk is hashed before the rest is
+        /// received.</para>
+        /// <para>If the hash does not match <paramref name="checksum" />,
+        /// <paramref name="on_error" /> is invoked with the error category
+        /// &quot;Integrity&quot; instead of <paramref name="on_response" />.
+        /// The checkpoint is removed in this case, because the file cannot be
+        /// repaired by resuming the download.</para>
+        /// </remarks>
+        /// <param name="id">The unqiue ID of the file.</param>
         /// <param name="format">The format of the file to retrieve, which can
         /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
-        /// <param name="version">The version of the file to be retrieved. This
-        /// can be one of the special constants like
-        /// <see cref="dataverse_connection::latest_version" />.</param>
-        /// <param name="on_response">A callback to be invoked if the response
-        /// to the request was received.</param>
+        /// <param name="checksum_type">The hash algorithm as named in the
+        /// metadata of the file, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+        /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+        /// <param name="checksum">The expected hash of the file as hex string.
+        /// </param>
+        /// <param name="path">The path to the file to write the download to.
+        /// </param>
+        /// <param name="resume">If <c>true</c>, continue from the checkpoint of
+        /// a previous attempt if there is one. Otherwise, any existing file at
+        /// <paramref name="path" /> will be overwritten.</param>
+        /// <param name="on_response">A callback to be invoked if the file
+        /// has been received and matches the checksum.</param>
         /// <param name="on_error">A callback to be invoked if the request
-        /// failed asynchronously.</param>
+        /// failed asynchronously or if the checksum does not match.</param>
         /// <param name="context">A user-defined context pointer passed to the
         /// callbacks.</param>
         /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="checksum_type" /> or <paramref name="checksum" />
+        /// is <c>nullptr</c> or if the hash algorithm is not supported.
+        /// </exception>
         /// <exception cref="std::system_error">If the method was called on an
         /// object that has been moved.</exception>
-        /// <exception cref="std::system_error">If the request failed right away.
+        /// <exception cref="std::system_error">If the output file could not be
+        /// opened or if the request failed right away.
         /// Note that even if the request initially succeeded, it might still
         /// fail and call <paramref name="on_error" /> later.</exception>
         /// <exception cref="std::bad_alloc">If the memory required to build the
         /// request could not be alloctated.</exception>
-        dataverse_connection& download(_In_z_ const wchar_t *persistent_id,
+        dataverse_connection& verified_download(_In_ const std::uint64_t id,
             _In_z_ const wchar_t *format,
-            _In_z_ const wchar_t *version,
+            _In_z_ const wchar_t *checksum_type,
+            _In_z_ const wchar_t *checksum,
+            _In_z_ const wchar_t *path,
+            _In_ const bool resume,
             _In_ const on_response_type on_response,
             _In_ const on_error_type on_error,
             _In_opt_ void *context = nullptr);
 
         /// <summary>
-        /// Download the file with the specified persistent identifier into a
-        /// memory buffer.
+        /// Download the file with the specified ID into a file on disk, which
+        /// can be resumed if the transfer is interrupted, and verify its
+        /// checksum while it is being received.
         /// </summary>
-        /// <param name="persistent_id">The persistent ID of the file, which is
-        /// the DOI of the data set concatenated with some unique ID of the
-        /// file. Note that this might not work for unpublished data.</param>
+        /// <remarks>
+        /// See the wide-string variant of this method for details.
+        /// </remarks>
+        /// <param name="id">The unqiue ID of the file.</param>
         /// <param name="format">The format of the file to retrieve, which can
         /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
-        /// <param name="version">The version of the file to be retrieved. This
-        /// can be one of the special constants like
-        /// <see cref="dataverse_connection::latest_version" />.</param>
-        /// <param name="on_response">A callback to be invoked if the response
-        /// to the request was received.</param>
+        /// <param name="checksum_type">The hash algorithm as named in the
+        /// metadata of the file, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+        /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+        /// <param name="checksum">The expected hash of the file as hex string.
+        /// </param>
+        /// <param name="path">The path to the file to write the download to.
+        /// </param>
+        /// <param name="resume">If <c>true</c>, continue from the checkpoint of
+        /// a previous attempt if there is one. Otherwise, any existing file at
+        /// <paramref name="path" /> will be overwritten.</param>
+        /// <param name="on_response">A callback to be invoked if the file
+        /// has been received and matches the checksum.</param>
         /// <param name="on_error">A callback to be invoked if the request
-        /// failed asynchronously.</param>
+        /// failed asynchronously or if the checksum does not match.</param>
         /// <param name="context">A user-defined context pointer passed to the
         /// callbacks.</param>
         /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="checksum_type" /> or <paramref name="checksum" />
+        /// is <c>nullptr</c> or if the hash algorithm is not supported.
+        /// </exception>
         /// <exception cref="std::system_error">If the method was called on an
         /// object that has been moved.</exception>
-        /// <exception cref="std::system_error">If the request failed right away.
+        /// <exception cref="std::system_error">If the output file could not be
+        /// opened or if the request failed right away.
         /// Note that even if the request initially succeeded, it might still
         /// fail and call <paramref name="on_error" /> later.</exception>
         /// <exception cref="std::bad_alloc">If the memory required to build the
         /// request could not be alloctated.</exception>
-        dataverse_connection& download(
-            _In_ const const_narrow_string& persistent_id,
+        dataverse_connection& verified_download(_In_ const std::uint64_t id,
             _In_ const const_narrow_string& format,
-            _In_ const const_narrow_string& version,
+            _In_ const const_narrow_string& checksum_type,
+            _In_ const const_narrow_string& checksum,
+            _In_ const const_narrow_string& path,
+            _In_ const bool resume,
             _In_ const on_response_type on_response,
             _In_ const on_error_type on_error,
             _In_opt_ void *context = nullptr);
 
         /// <summary>
-        /// Gets a future for the contents of the file with the specified
-        /// persistent identifier.
+        /// Gets a future for the verified, resumable download of the file with
+        /// the specified ID into a file on disk.
         /// </summary>
-        /// <param name="persistent_id">The persistent ID of the file, which is
-        /// the DOI of the data set concatenated with some unique ID of the
-        /// file. Note that this might not work for unpublished data.</param>
+        /// <param name="id">The unqiue ID of the file.</param>
         /// <param name="format">The format of the file to retrieve, which can
         /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
-        /// <param name="version">The version of the file to be retrieved. This
-        /// can be one of the special constants like
-        /// <see cref="dataverse_connection::latest_version" />.</param>
-        /// <returns>A future for the contents of the file.</returns>
+        /// <param name="checksum_type">The hash algorithm as named in the
+        /// metadata of the file, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+        /// &quot;SHA-256&quot; or &quot;SHA-512&quot;.</param>
+        /// <param name="checksum">The expected hash of the file as hex string.
+        /// </param>
+        /// <param name="path">The path to the file to write the download to.
+        /// </param>
+        /// <param name="resume">If <c>true</c>, continue from the checkpoint of
+        /// a previous attempt if there is one. Otherwise, any existing file at
+        /// <paramref name="path" /> will be overwritten.</param>
+        /// <returns>A future that becomes ready once the file has been
+        /// written and verified.</returns>
         /// <exception cref="std::system_error">If the method was called on an
         /// object that has been moved.</exception>
         /// <exception cref="std::system_error">If the request failed right away.
@@ -976,55 +2521,25 @@ namespace dataverse {
         /// fail and call <paramref name="on_error" /> later.</exception>
         /// <exception cref="std::bad_alloc">If the memory required to build the
         /// request could not be alloctated.</exception>
-        inline std::future<blob> download(_In_z_ const wchar_t *persistent_id,
-                _In_z_ const wchar_t *format = L"original",
-                _In_z_ const wchar_t *version = latest_version) {
+        inline std::future<void> verified_download(_In_ const std::uint64_t id,
+                _In_z_ const wchar_t *format,
+                _In_z_ const wchar_t *checksum_type,
+                _In_z_ const wchar_t *checksum,
+                _In_z_ const wchar_t *path,
+                _In_ const bool resume) {
             typedef dataverse_connection& (dataverse_connection:: *actual_type)(
+                const std::uint64_t,
                 const wchar_t *,
                 const wchar_t *,
                 const wchar_t *,
+                const wchar_t *,
+                const bool,
                 const on_response_type,
                 const on_error_type,
                 void *);
-            return invoke_async<blob>(
-                static_cast<actual_type>(&dataverse_connection::download),
-                *this, persistent_id, format, version);
-        }
-
-        /// <summary>
-        /// Gets a future for the contents of the file with the specified
-        /// persistent identifier.
-        /// </summary>
-        /// <param name="persistent_id">The persistent ID of the file, which is
-        /// the DOI of the data set concatenated with some unique ID of the
-        /// file. Note that this might not work for unpublished data.</param>
-        /// <param name="format">The format of the file to retrieve, which can
-        /// be something like &quot;original&quot; or &quot;RData&quot;.</param>
-        /// <param name="version">The version of the file to be retrieved. This
-        /// can be one of the special constants like
-        /// <see cref="dataverse_connection::latest_version" />.</param>
-        /// <returns>A future for the contents of the file.</returns>
-        /// <exception cref="std::system_error">If the method was called on an
-        /// object that has been moved.</exception>
-        /// <exception cref="std::system_error">If the request failed right away.
-        /// Note that even if the request initially succeeded, it might still
-        /// fail and call <paramref name="on_error" /> later.</exception>
-        /// <exception cref="std::bad_alloc">If the memory required to build the
-        /// request could not be alloctated.</exception>
-        inline std::future<blob> download(
-                _In_ const const_narrow_string& persistent_id,
-                _In_ const const_narrow_string& format,
-                _In_ const const_narrow_string& version) {
-            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
-                const const_narrow_string&,
-                const const_narrow_string&,
-                const const_narrow_string&,
-                const on_response_type,
-                const on_error_type,
-                void *);
-            return invoke_async<blob>(
-                static_cast<actual_type>(&dataverse_connection::download),
-                *this, persistent_id, format, version);
+            return invoke_async(
+                static_cast<actual_type>(&dataverse_connection::verified_download),
+                *this, id, format, checksum_type, checksum, path, resume);
         }
 
         /// <summary>
@@ -1113,28 +2628,188 @@ namespace dataverse {
         }
 
         /// <summary>
-        /// Deletes the specified resource and returns a future that can be used
-        /// to determine whether the operation succeeded.
+        /// Deletes the specified resource and returns a future that can be used
+        /// to determine whether the operation succeeded.
+        /// </summary>
+        /// <remarks>
+        /// This method performs an HTTP <c>DELETE</c>, but we could not name it
+        /// this way, because <c>delete</c> is a C++ keyword.
+        /// </remarks>
+        /// <param name="resource">The path to the resource. The
+        /// <see cref="base_path" /> will be prepended if it is set.</param>
+        /// <returns>A future for the result of the opration.</returns>
+        inline std::future<void> erase(_In_ const const_narrow_string &resource) {
+            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
+                const const_narrow_string&, const on_response_type,
+                const on_error_type, void *);
+            return invoke_async(
+                static_cast<actual_type>(&dataverse_connection::erase),
+                *this, resource);
+        }
+
+        /// <summary>
+        /// Gets the files in the data set with the given ID.
+        /// </summary>
+        /// <param name="id">The ID of the data set, which is unfortunately not
+        /// the persistent identifier, but the primary key, which can be
+        /// retrieved using <see cref="data_set" /> from the persistent
+        /// identifier.</param>
+        /// <param name="version">The version of the data set to retrieve, which
+        /// is typically something like &quot;1.0&quot;. You can also use the
+        /// constants for special versions like
+        /// <see cref="dataverse_connection::latest_version" />.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& files(_In_ const std::uint64_t id,
+            _In_z_ const wchar_t *version,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Gets the files in the data set with the given ID.
+        /// </summary>
+        /// <param name="id">The ID of the data set, which is unfortunately not
+        /// the persistent identifier, but the primary key, which can be
+        /// retrieved using <see cref="data_set" /> from the persistent
+        /// identifier.</param>
+        /// <param name="version">The version of the data set to retrieve, which
+        /// is typically something like &quot;1.0&quot;</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& files(_In_ const std::uint64_t id,
+            _In_ const const_narrow_string& version,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Gets the files in the data set with the given ID and provides
+        /// on-demand access to the response via a <see cref="json_view" />.
+        /// </summary>
+        /// <remarks>
+        /// In contrast to the overload using <c>nlohmann::json</c>, the
+        /// response is not parsed into a DOM, which makes this overload the
+        /// most efficient way of extracting a few properties from a large
+        /// listing.
+        /// </remarks>
+        /// <param name="id">The ID of the data set, which is unfortunately not
+        /// the persistent identifier, but the primary key, which can be
+        /// retrieved using <see cref="data_set" /> from the persistent
+        /// identifier.</param>
+        /// <param name="version">The version of the data set to retrieve, which
+        /// is typically something like &quot;1.0&quot;. You can also use the
+        /// constants for special versions like
+        /// <see cref="dataverse_connection::latest_version" />.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline dataverse_connection& files(_In_ const std::uint64_t id,
+                _In_z_ const wchar_t *version,
+                _In_ const on_json_response_type on_response,
+                _In_ const on_error_type on_error,
+                _In_opt_ void *context = nullptr) {
+            const auto url = std::wstring(L"/datasets/") + std::to_wstring(id)
+                + std::wstring(L"/versions/") + version
+                + std::wstring(L"/files");
+            this->get(url.c_str(),
+                translate_json_response,
+                reinterpret_cast<const void *>(on_response),
+                on_error,
+                context);
+            return *this;
+        }
+
+        /// <summary>
+        /// Gets the files in the data set with the given ID and provides
+        /// on-demand access to the response via a <see cref="json_view" />.
+        /// </summary>
+        /// <remarks>
+        /// In contrast to the overload using <c>nlohmann::json</c>, the
+        /// response is not parsed into a DOM, which makes this overload the
+        /// most efficient way of extracting a few properties from a large
+        /// listing.
+        /// </remarks>
+        /// <param name="id">The ID of the data set, which is unfortunately not
+        /// the persistent identifier, but the primary key, which can be
+        /// retrieved using <see cref="data_set" /> from the persistent
+        /// identifier.</param>
+        /// <param name="version">The version of the data set to retrieve, which
+        /// is typically something like &quot;1.0&quot;.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline dataverse_connection& files(_In_ const std::uint64_t id,
+                _In_ const const_narrow_string& version,
+                _In_ const on_json_response_type on_response,
+                _In_ const on_error_type on_error,
+                _In_opt_ void *context = nullptr) {
+            const auto url = std::wstring(L"/datasets/") + std::to_wstring(id)
+                + std::wstring(L"/versions/") + convert<wchar_t>(version)
+                + std::wstring(L"/files");
+            this->get(url.c_str(),
+                translate_json_response,
+                reinterpret_cast<const void *>(on_response),
+                on_error,
+                context);
+            return *this;
+        }
+
+        /// <summary>
+        /// Gets the files in the data set with the given ID and feeds the
+        /// response to the given SAX handler while it is being received.
         /// </summary>
         /// <remarks>
-        /// This method performs an HTTP <c>DELETE</c>, but we could not name it
-        /// this way, because <c>delete</c> is a C++ keyword.
+        /// This is the most memory-efficient way of processing the listings
+        /// of huge data sets, because neither the response nor a DOM of it
+        /// is ever held in memory.
         /// </remarks>
-        /// <param name="resource">The path to the resource. The
-        /// <see cref="base_path" /> will be prepended if it is set.</param>
-        /// <returns>A future for the result of the opration.</returns>
-        inline std::future<void> erase(_In_ const const_narrow_string &resource) {
-            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
-                const const_narrow_string&, const on_response_type,
-                const on_error_type, void *);
-            return invoke_async(
-                static_cast<actual_type>(&dataverse_connection::erase),
-                *this, resource);
-        }
-
-        /// <summary>
-        /// Gets the files in the data set with the given ID.
-        /// </summary>
         /// <param name="id">The ID of the data set, which is unfortunately not
         /// the persistent identifier, but the primary key, which can be
         /// retrieved using <see cref="data_set" /> from the persistent
@@ -1143,10 +2818,15 @@ namespace dataverse {
         /// is typically something like &quot;1.0&quot;. You can also use the
         /// constants for special versions like
         /// <see cref="dataverse_connection::latest_version" />.</param>
-        /// <param name="on_response">A callback to be invoked if the response
-        /// to the request was received.</param>
+        /// <param name="handler">The handler receiving the parser events. The
+        /// handler must live until one of the callbacks has been invoked.
+        /// </param>
+        /// <param name="on_response">A callback to be invoked once the whole
+        /// response has been parsed. The response passed to the callback is
+        /// empty.</param>
         /// <param name="on_error">A callback to be invoked if the request
-        /// failed asynchronously.</param>
+        /// failed asynchronously, if the response is malformed or if the
+        /// handler cancelled parsing.</param>
         /// <param name="context">A user-defined context pointer passed to the
         /// callbacks.</param>
         /// <returns><c>*this</c>.</returns>
@@ -1157,25 +2837,43 @@ namespace dataverse {
         /// fail and call <paramref name="on_error" /> later.</exception>
         /// <exception cref="std::bad_alloc">If the memory required to build the
         /// request could not be alloctated.</exception>
-        dataverse_connection& files(_In_ const std::uint64_t id,
-            _In_z_ const wchar_t *version,
-            _In_ const on_response_type on_response,
-            _In_ const on_error_type on_error,
-            _In_opt_ void *context = nullptr);
+        inline dataverse_connection& files(_In_ const std::uint64_t id,
+                _In_z_ const wchar_t *version,
+                _In_ json_sax_handler& handler,
+                _In_ const on_response_type on_response,
+                _In_ const on_error_type on_error,
+                _In_opt_ void *context = nullptr) {
+            const auto url = std::wstring(L"/datasets/") + std::to_wstring(id)
+                + std::wstring(L"/versions/") + version
+                + std::wstring(L"/files");
+            return this->get(url.c_str(), handler, on_response, on_error,
+                context);
+        }
 
         /// <summary>
-        /// Gets the files in the data set with the given ID.
+        /// Gets the files in the data set with the given ID and feeds the
+        /// response to the given SAX handler while it is being received.
         /// </summary>
+        /// <remarks>
+        /// This is the most memory-efficient way of processing the listings
+        /// of huge data sets, because neither the response nor a DOM of it
+        /// is ever held in memory.
+        /// </remarks>
         /// <param name="id">The ID of the data set, which is unfortunately not
         /// the persistent identifier, but the primary key, which can be
         /// retrieved using <see cref="data_set" /> from the persistent
         /// identifier.</param>
         /// <param name="version">The version of the data set to retrieve, which
-        /// is typically something like &quot;1.0&quot;</param>
-        /// <param name="on_response">A callback to be invoked if the response
-        /// to the request was received.</param>
+        /// is typically something like &quot;1.0&quot;.</param>
+        /// <param name="handler">The handler receiving the parser events. The
+        /// handler must live until one of the callbacks has been invoked.
+        /// </param>
+        /// <param name="on_response">A callback to be invoked once the whole
+        /// response has been parsed. The response passed to the callback is
+        /// empty.</param>
         /// <param name="on_error">A callback to be invoked if the request
-        /// failed asynchronously.</param>
+        /// failed asynchronously, if the response is malformed or if the
+        /// handler cancelled parsing.</param>
         /// <param name="context">A user-defined context pointer passed to the
         /// callbacks.</param>
         /// <returns><c>*this</c>.</returns>
@@ -1186,11 +2884,18 @@ namespace dataverse {
         /// fail and call <paramref name="on_error" /> later.</exception>
         /// <exception cref="std::bad_alloc">If the memory required to build the
         /// request could not be alloctated.</exception>
-        dataverse_connection& files(_In_ const std::uint64_t id,
-            _In_ const const_narrow_string& version,
-            _In_ const on_response_type on_response,
-            _In_ const on_error_type on_error,
-            _In_opt_ void *context = nullptr);
+        inline dataverse_connection& files(_In_ const std::uint64_t id,
+                _In_ const const_narrow_string& version,
+                _In_ json_sax_handler& handler,
+                _In_ const on_response_type on_response,
+                _In_ const on_error_type on_error,
+                _In_opt_ void *context = nullptr) {
+            const auto url = std::wstring(L"/datasets/") + std::to_wstring(id)
+                + std::wstring(L"/versions/") + convert<wchar_t>(version)
+                + std::wstring(L"/files");
+            return this->get(url.c_str(), handler, on_response, on_error,
+                context);
+        }
 
 #if defined(DATAVERSE_WITH_JSON)
         /// <summary>
@@ -1457,6 +3162,149 @@ namespace dataverse {
             return *this;
         }
 
+        /// <summary>
+        /// Retrieves the resource at the specified location using a GET
+        /// request and provides on-demand access to the response via a
+        /// <see cref="json_view" />.
+        /// </summary>
+        /// <param name="resource">The path to the resource. The
+        /// <see cref="base_path" /> will be prepended if it is set.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline dataverse_connection& get(_In_opt_z_ const wchar_t *resource,
+                _In_ const on_json_response_type on_response,
+                _In_ const on_error_type on_error,
+                _In_opt_ void *context = nullptr) {
+            this->get(resource,
+                translate_json_response,
+                reinterpret_cast<const void *>(on_response),
+                on_error,
+                context);
+            return *this;
+        }
+
+        /// <summary>
+        /// Retrieves the resource at the specified location using a GET
+        /// request and provides on-demand access to the response via a
+        /// <see cref="json_view" />.
+        /// </summary>
+        /// <param name="resource">The path to the resource. The
+        /// <see cref="base_path" /> will be prepended if it is set.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline dataverse_connection& get(
+                _In_ const const_narrow_string& resource,
+                _In_ const on_json_response_type on_response,
+                _In_ const on_error_type on_error,
+                _In_opt_ void *context = nullptr) {
+            this->get(resource,
+                translate_json_response,
+                reinterpret_cast<const void *>(on_response),
+                on_error,
+                context);
+            return *this;
+        }
+
+        /// <summary>
+        /// Retrieves the resource at the specified location using a GET
+        /// request and feeds the response to the given SAX handler while it
+        /// is being received.
+        /// </summary>
+        /// <remarks>
+        /// Parsing overlaps with the transfer and neither the whole response
+        /// nor a DOM of it is ever held in memory. If the server reports an
+        /// error, the handler is not invoked and the error is reported to
+        /// <paramref name="on_error" /> as usual.
+        /// </remarks>
+        /// <param name="resource">The path to the resource. The
+        /// <see cref="base_path" /> will be prepended if it is set.</param>
+        /// <param name="handler">The handler receiving the parser events. The
+        /// handler must live until one of the callbacks has been invoked.
+        /// </param>
+        /// <param name="on_response">A callback to be invoked once the whole
+        /// response has been parsed. The response passed to the callback is
+        /// empty.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously, if the response is malformed or if the
+        /// handler cancelled parsing.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& get(_In_opt_z_ const wchar_t *resource,
+            _In_ json_sax_handler& handler,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Retrieves the resource at the specified location using a GET
+        /// request and feeds the response to the given SAX handler while it
+        /// is being received.
+        /// </summary>
+        /// <remarks>
+        /// Parsing overlaps with the transfer and neither the whole response
+        /// nor a DOM of it is ever held in memory. If the server reports an
+        /// error, the handler is not invoked and the error is reported to
+        /// <paramref name="on_error" /> as usual.
+        /// </remarks>
+        /// <param name="resource">The path to the resource. The
+        /// <see cref="base_path" /> will be prepended if it is set.</param>
+        /// <param name="handler">The handler receiving the parser events. The
+        /// handler must live until one of the callbacks has been invoked.
+        /// </param>
+        /// <param name="on_response">A callback to be invoked once the whole
+        /// response has been parsed. The response passed to the callback is
+        /// empty.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously, if the response is malformed or if the
+        /// handler cancelled parsing.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& get(_In_ const const_narrow_string& resource,
+            _In_ json_sax_handler& handler,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
         /// <summary>
         /// Asynchronously retrieves the resource at the specified location
         /// using a GET request and provides a future for the result.
@@ -1654,21 +3502,105 @@ namespace dataverse {
         }
 
         /// <summary>
-        /// Posts the given data to the given resource location.
+        /// Posts the given data to the given resource location.
+        /// </summary>
+        /// <remarks>
+        /// This method can be used to create data sets.
+        /// </remarks>
+        /// <param name="resource">The path to the resource to post. The
+        /// base path configured will be prepended if set.</param>
+        /// <param name="data">The data to post. The caller remains owner
+        /// of this memory if no <see cref="data_deleter" /> is set and must
+        /// make sure that the data remain valid until the request completed or
+        /// failed.</param>
+        /// <param name="cnt">The size of the data in bytes.</param>
+        /// <param name="data_deleter">If not <c>nullptr</c>, the object will
+        /// eventually free <paramref name="data" /> using this callback.
+        /// </param>
+        /// <param name="content_type">The MIME type of the data to be posted.
+        /// </param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline dataverse_connection& post(_In_opt_z_ const wchar_t *resource,
+                _In_reads_bytes_(cnt) const byte_type *data,
+                _In_ const std::size_t cnt,
+                _In_opt_ const data_deleter_type data_deleter,
+                _In_opt_z_ const wchar_t *content_type,
+                _In_ const on_response_type on_response,
+                _In_ const on_error_type on_error,
+                _In_opt_ void *context = nullptr) {
+            this->post(resource, data, cnt, data_deleter, content_type,
+                on_response, nullptr, on_error, context);
+            return *this;
+        }
+
+        /// <summary>
+        /// Posts the given data to the given resource location.
+        /// </summary>
+        /// <remarks>
+        /// This method can be used to create data sets.
+        /// </remarks>
+        /// <param name="resource">The path to the resource to post. The
+        /// base path configured will be prepended if set.</param>
+        /// <param name="data">The data to post. The caller remains owner
+        /// of this memory if no <see cref="data_deleter" /> is set and must
+        /// make sure that the data remain valid until the request completed or
+        /// failed.</param>
+        /// <param name="cnt">The size of the data in bytes.</param>
+        /// <param name="data_deleter">If not <c>nullptr</c>, the object will
+        /// eventually free <paramref name="data" /> using this callback.
+        /// </param>
+        /// <param name="content_type">The MIME type of the data to be posted.
+        /// </param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline dataverse_connection& post(
+                _In_ const const_narrow_string& resource,
+                _In_reads_bytes_(cnt) const byte_type *data,
+                _In_ const std::size_t cnt,
+                _In_opt_ const data_deleter_type data_deleter,
+                _In_ const const_narrow_string& content_type,
+                _In_ const on_response_type on_response,
+                _In_ const on_error_type on_error,
+                _In_opt_ void *context = nullptr) {
+            this->post(resource, data, cnt, data_deleter, content_type,
+                on_response, nullptr, on_error, context);
+            return *this;
+        }
+
+        /// <summary>
+        /// Posts the data in the given view to the given resource location.
         /// </summary>
-        /// <remarks>
-        /// This method can be used to create data sets.
-        /// </remarks>
-        /// <param name="resource">The path to the resource to post. The
+        /// <param name="resource">The path to the resource. The
         /// base path configured will be prepended if set.</param>
-        /// <param name="data">The data to post. The caller remains owner
-        /// of this memory if no <see cref="data_deleter" /> is set and must
-        /// make sure that the data remain valid until the request completed or
-        /// failed.</param>
-        /// <param name="cnt">The size of the data in bytes.</param>
-        /// <param name="data_deleter">If not <c>nullptr</c>, the object will
-        /// eventually free <paramref name="data" /> using this callback.
-        /// </param>
+        /// <param name="data">A view of the data, e.g. a <see cref="blob" />
+        /// or a slice of a response. The view is not copied, i.e. the caller
+        /// must make sure that the data remain valid until the request
+        /// completed or failed.</param>
         /// <param name="content_type">The MIME type of the data to be posted.
         /// </param>
         /// <param name="on_response">A callback to be invoked if the response
@@ -1686,34 +3618,24 @@ namespace dataverse {
         /// <exception cref="std::bad_alloc">If the memory required to build the
         /// request could not be alloctated.</exception>
         inline dataverse_connection& post(_In_opt_z_ const wchar_t *resource,
-                _In_reads_bytes_(cnt) const byte_type *data,
-                _In_ const std::size_t cnt,
-                _In_opt_ const data_deleter_type data_deleter,
+                _In_ const blob_view& data,
                 _In_opt_z_ const wchar_t *content_type,
                 _In_ const on_response_type on_response,
                 _In_ const on_error_type on_error,
                 _In_opt_ void *context = nullptr) {
-            this->post(resource, data, cnt, data_deleter, content_type,
-                on_response, nullptr, on_error, context);
-            return *this;
+            return this->post(resource, data.begin(), data.size(), nullptr,
+                content_type, on_response, on_error, context);
         }
 
         /// <summary>
-        /// Posts the given data to the given resource location.
+        /// Posts the data in the given view to the given resource location.
         /// </summary>
-        /// <remarks>
-        /// This method can be used to create data sets.
-        /// </remarks>
-        /// <param name="resource">The path to the resource to post. The
+        /// <param name="resource">The path to the resource. The
         /// base path configured will be prepended if set.</param>
-        /// <param name="data">The data to post. The caller remains owner
-        /// of this memory if no <see cref="data_deleter" /> is set and must
-        /// make sure that the data remain valid until the request completed or
-        /// failed.</param>
-        /// <param name="cnt">The size of the data in bytes.</param>
-        /// <param name="data_deleter">If not <c>nullptr</c>, the object will
-        /// eventually free <paramref name="data" /> using this callback.
-        /// </param>
+        /// <param name="data">A view of the data, e.g. a <see cref="blob" />
+        /// or a slice of a response. The view is not copied, i.e. the caller
+        /// must make sure that the data remain valid until the request
+        /// completed or failed.</param>
         /// <param name="content_type">The MIME type of the data to be posted.
         /// </param>
         /// <param name="on_response">A callback to be invoked if the response
@@ -1732,16 +3654,13 @@ namespace dataverse {
         /// request could not be alloctated.</exception>
         inline dataverse_connection& post(
                 _In_ const const_narrow_string& resource,
-                _In_reads_bytes_(cnt) const byte_type *data,
-                _In_ const std::size_t cnt,
-                _In_opt_ const data_deleter_type data_deleter,
+                _In_ const blob_view& data,
                 _In_ const const_narrow_string& content_type,
                 _In_ const on_response_type on_response,
                 _In_ const on_error_type on_error,
                 _In_opt_ void *context = nullptr) {
-            this->post(resource, data, cnt, data_deleter, content_type,
-                on_response, nullptr, on_error, context);
-            return *this;
+            return this->post(resource, data.begin(), data.size(), nullptr,
+                content_type, on_response, on_error, context);
         }
 
         /// <summary>
@@ -2048,6 +3967,75 @@ namespace dataverse {
         }
 #endif /* defined(DATAVERSE_WITH_JSON) */
 
+        /// <summary>
+        /// Answer the aggregated progress of the requests of the connection.
+        /// </summary>
+        /// <remarks>
+        /// <para>The transferred bytes accumulate over all requests, whereas
+        /// the totals, the rate and the number of transfers only cover the
+        /// requests that are currently in flight. The totals include the
+        /// bytes that have already been transferred by these requests.</para>
+        /// <para>The progress is only tracked while a
+        /// <see cref="progress_handler" /> is installed.</para>
+        /// </remarks>
+        /// <returns>The aggregated progress of the connection.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        transfer_progress progress(void) const;
+
+        /// <summary>
+        /// Installs a callback that reports the progress of each request and
+        /// of the connection as a whole.
+        /// </summary>
+        /// <remarks>
+        /// <para>The handler is called on the I/O thread while a request is
+        /// being transferred, but at most once per
+        /// <paramref name="interval" /> and request. It receives the context
+        /// pointer of the operation that issued the request, e.g. the context
+        /// passed to <see cref="upload" />. The handler must therefore return
+        /// quickly and must not throw.</para>
+        /// <para>The handler can be changed at any time, but only affects
+        /// requests issued afterwards. Requests in flight keep reporting to
+        /// the handler that was installed when they were issued.</para>
+        /// </remarks>
+        /// <param name="handler">The callback to be invoked. It is safe to
+        /// pass <c>nullptr</c>, which disables progress tracking.</param>
+        /// <param name="interval">The minimum time between two reports for
+        /// the same request in milliseconds.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="interval" /> is negative.</exception>
+        dataverse_connection& progress_handler(
+            _In_opt_ const on_progress_type handler,
+            _In_ const int interval);
+
+        /// <summary>
+        /// Installs a callback that reports the progress of each request and
+        /// of the connection as a whole.
+        /// </summary>
+        /// <typeparam name="TRep">The type used to represent the ticks of the
+        /// interval.</typeparam>
+        /// <typeparam name="TRatio">The unit of the interval.</typeparam>
+        /// <param name="handler">The callback to be invoked. It is safe to
+        /// pass <c>nullptr</c>, which disables progress tracking.</param>
+        /// <param name="interval">The minimum time between two reports for
+        /// the same request.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="interval" /> is negative.</exception>
+        template<class TRep, class TRatio>
+        inline dataverse_connection& progress_handler(
+                _In_opt_ const on_progress_type handler,
+                _In_ std::chrono::duration<TRep, TRatio> interval) {
+            typedef std::chrono::duration<int, std::milli> millis_type;
+            auto millis = std::chrono::duration_cast<millis_type>(interval);
+            return this->progress_handler(handler, millis.count());
+        }
+
         /// <summary>
         /// Puts the given data to the given resource location.
         /// </summary>
@@ -2133,6 +4121,77 @@ namespace dataverse {
             return *this;
         }
 
+        /// <summary>
+        /// Puts the data in the given view to the given resource location.
+        /// </summary>
+        /// <param name="resource">The path to the resource. The
+        /// base path configured will be prepended if set.</param>
+        /// <param name="data">A view of the data, e.g. a <see cref="blob" />
+        /// or a slice of a response. The view is not copied, i.e. the caller
+        /// must make sure that the data remain valid until the request
+        /// completed or failed.</param>
+        /// <param name="content_type">The MIME type of the data to be stored.
+        /// </param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline dataverse_connection& put(_In_opt_z_ const wchar_t *resource,
+                _In_ const blob_view& data,
+                _In_opt_z_ const wchar_t *content_type,
+                _In_ const on_response_type on_response,
+                _In_ const on_error_type on_error,
+                _In_opt_ void *context = nullptr) {
+            return this->put(resource, data.begin(), data.size(), nullptr,
+                content_type, on_response, on_error, context);
+        }
+
+        /// <summary>
+        /// Puts the data in the given view to the given resource location.
+        /// </summary>
+        /// <param name="resource">The path to the resource. The
+        /// base path configured will be prepended if set.</param>
+        /// <param name="data">A view of the data, e.g. a <see cref="blob" />
+        /// or a slice of a response. The view is not copied, i.e. the caller
+        /// must make sure that the data remain valid until the request
+        /// completed or failed.</param>
+        /// <param name="content_type">The MIME type of the data to be stored.
+        /// </param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline dataverse_connection& put(
+                _In_ const const_narrow_string& resource,
+                _In_ const blob_view& data,
+                _In_ const const_narrow_string& content_type,
+                _In_ const on_response_type on_response,
+                _In_ const on_error_type on_error,
+                _In_opt_ void *context = nullptr) {
+            return this->put(resource, data.begin(), data.size(), nullptr,
+                content_type, on_response, on_error, context);
+        }
+
         /// <summary>
         /// Deletes the specified resource.
         /// </summary>
@@ -2225,7 +4284,183 @@ namespace dataverse {
         /// Replaces the file with the sepcified database identifier with the
         /// content of the file at the specified location.
         /// </summary>
-        /// <param name="id">The database ID of the file to be replaced.</param>
+        /// <param name="id">The database ID of the file to be replaced.</param>
+        /// <param name="path">The path to the file to be uploaded.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& replace(_In_ const std::uint64_t id,
+            _In_z_ const wchar_t *path,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Replaces the file with the sepcified database identifier with the
+        /// content of the file at the specified location.
+        /// </summary>
+        /// <param name="id">The database ID of the file to be replaced.</param>
+        /// <param name="path">The path to the file to be uploaded.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& replace(_In_ const std::uint64_t id,
+            _In_ const const_narrow_string& path,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Replaces the file with the sepcified database identifier with the
+        /// content of the file at the specified location.
+        /// </summary>
+        /// <param name="id">The database ID of the file to be replaced.</param>
+        /// <param name="path">The path to the file to be uploaded.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline std::future<blob> replace(_In_ const std::uint64_t id,
+                _In_ const std::wstring& path) {
+            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
+                const std::uint64_t,
+                const wchar_t *,
+                const on_response_type, const on_error_type, void *);
+            return invoke_async<blob>(
+                static_cast<actual_type>(&dataverse_connection::replace), *this,
+                id, path.c_str());
+        }
+
+        /// <summary>
+        /// Replaces the file with the sepcified database identifier with the
+        /// content of the file at the specified location.
+        /// </summary>
+        /// <param name="id">The database ID of the file to be replaced.</param>
+        /// <param name="path">The path to the file to be uploaded.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::system_error">If the request failed right away.
+        /// Note that even if the request initially succeeded, it might still
+        /// fail and call <paramref name="on_error" /> later.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline std::future<blob> replace(_In_ const std::uint64_t id,
+                _In_ const const_narrow_string& path) {
+            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
+                const std::uint64_t,
+                const const_narrow_string&,
+                const on_response_type, const on_error_type, void *);
+            return invoke_async<blob>(
+                static_cast<actual_type>(&dataverse_connection::replace), *this,
+                id, path);
+        }
+
+        /// <summary>
+        /// Configures the in-memory cache for GET responses.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, GET requests whose response is delivered as a
+        /// <see cref="blob" /> or as parsed JSON are answered from memory for
+        /// <paramref name="ttl" /> milliseconds after the response has been
+        /// received. Afterwards, the cached response is revalidated using its
+        /// &quot;ETag&quot; or &quot;Last-Modified&quot; header if the server
+        /// sent one, i.e. unchanged responses are not transferred again.
+        /// Responses are only reused for requests using the same API key.
+        /// Only metadata are cached, i.e. neither data files retrieved via the
+        /// data access API nor the URLs for direct uploads.</para>
+        /// <para>If the cached responses exceed <paramref name="capacity" />,
+        /// the least recently used ones are evicted. The cache is disabled by
+        /// default.</para>
+        /// </remarks>
+        /// <param name="capacity">The maximum size of all cached responses in
+        /// bytes. Zero disables the cache and releases all responses.</param>
+        /// <param name="ttl">The time in milliseconds for which a response is
+        /// used without asking the server. Zero causes every request to be
+        /// revalidated.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        dataverse_connection& response_cache(_In_ const std::size_t capacity,
+            _In_ const int ttl);
+
+        /// <summary>
+        /// Configures the in-memory cache for GET responses.
+        /// </summary>
+        /// <typeparam name="TRep">The type used to represent the ticks of the
+        /// time to live.</typeparam>
+        /// <typeparam name="TRatio">The unit of the time to live.</typeparam>
+        /// <param name="capacity">The maximum size of all cached responses in
+        /// bytes. Zero disables the cache and releases all responses.</param>
+        /// <param name="ttl">The time for which a response is used without
+        /// asking the server.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        template<class TRep, class TRatio>
+        inline dataverse_connection& response_cache(
+                _In_ const std::size_t capacity,
+                _In_ std::chrono::duration<TRep, TRatio> ttl) {
+            typedef std::chrono::duration<int, std::milli> millis_type;
+            auto millis = std::chrono::duration_cast<millis_type>(ttl);
+            return this->response_cache(capacity, millis.count());
+        }
+
+        /// <summary>
+        /// Answer statistics about the effectiveness of the in-memory cache for
+        /// GET responses.
+        /// </summary>
+        /// <returns>The statistics of the response cache.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        cache_statistics response_cache_statistics(void) const;
+
+        /// <summary>
+        /// Continues all streamed uploads whose producer returned
+        /// <see cref="form_data::pause_read" />.
+        /// </summary>
+        /// <remarks>
+        /// The uploads are resumed on the I/O thread, which calls the
+        /// producers again. A producer that still has no data can pause its
+        /// upload again. It is safe to call the method if no upload is paused.
+        /// </remarks>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        dataverse_connection& resume_uploads(void);
+
+        /// <summary>
+        /// Upload a file for the data set with the specified persistent ID.
+        /// </summary>
+        /// <param name="persistent_id">The persistent ID of the data set the
+        /// file should be added to, which typically has the form
+        /// &quot;doi:the-doi&quot;.</param>
         /// <param name="path">The path to the file to be uploaded.</param>
         /// <param name="on_response">A callback to be invoked if the response
         /// to the request was received.</param>
@@ -2241,17 +4476,18 @@ namespace dataverse {
         /// fail and call <paramref name="on_error" /> later.</exception>
         /// <exception cref="std::bad_alloc">If the memory required to build the
         /// request could not be alloctated.</exception>
-        dataverse_connection& replace(_In_ const std::uint64_t id,
+        dataverse_connection& upload(_In_z_ const wchar_t *persistent_id,
             _In_z_ const wchar_t *path,
             _In_ const on_response_type on_response,
             _In_ const on_error_type on_error,
             _In_opt_ void *context = nullptr);
 
         /// <summary>
-        /// Replaces the file with the sepcified database identifier with the
-        /// content of the file at the specified location.
+        /// Upload a file for the data set with the specified persistent ID.
         /// </summary>
-        /// <param name="id">The database ID of the file to be replaced.</param>
+        /// <param name="persistent_id">The persistent ID of the data set the
+        /// file should be added to, which typically has the form
+        /// &quot;doi:the-doi&quot;.</param>
         /// <param name="path">The path to the file to be uploaded.</param>
         /// <param name="on_response">A callback to be invoked if the response
         /// to the request was received.</param>
@@ -2267,62 +4503,13 @@ namespace dataverse {
         /// fail and call <paramref name="on_error" /> later.</exception>
         /// <exception cref="std::bad_alloc">If the memory required to build the
         /// request could not be alloctated.</exception>
-        dataverse_connection& replace(_In_ const std::uint64_t id,
+        dataverse_connection& upload(
+            _In_ const const_narrow_string& persistent_id,
             _In_ const const_narrow_string& path,
             _In_ const on_response_type on_response,
             _In_ const on_error_type on_error,
             _In_opt_ void *context = nullptr);
 
-        /// <summary>
-        /// Replaces the file with the sepcified database identifier with the
-        /// content of the file at the specified location.
-        /// </summary>
-        /// <param name="id">The database ID of the file to be replaced.</param>
-        /// <param name="path">The path to the file to be uploaded.</param>
-        /// <returns><c>*this</c>.</returns>
-        /// <exception cref="std::system_error">If the method was called on an
-        /// object that has been moved.</exception>
-        /// <exception cref="std::system_error">If the request failed right away.
-        /// Note that even if the request initially succeeded, it might still
-        /// fail and call <paramref name="on_error" /> later.</exception>
-        /// <exception cref="std::bad_alloc">If the memory required to build the
-        /// request could not be alloctated.</exception>
-        inline std::future<blob> replace(_In_ const std::uint64_t id,
-                _In_ const std::wstring& path) {
-            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
-                const std::uint64_t,
-                const wchar_t *,
-                const on_response_type, const on_error_type, void *);
-            return invoke_async<blob>(
-                static_cast<actual_type>(&dataverse_connection::replace), *this,
-                id, path.c_str());
-        }
-
-        /// <summary>
-        /// Replaces the file with the sepcified database identifier with the
-        /// content of the file at the specified location.
-        /// </summary>
-        /// <param name="id">The database ID of the file to be replaced.</param>
-        /// <param name="path">The path to the file to be uploaded.</param>
-        /// <returns><c>*this</c>.</returns>
-        /// <exception cref="std::system_error">If the method was called on an
-        /// object that has been moved.</exception>
-        /// <exception cref="std::system_error">If the request failed right away.
-        /// Note that even if the request initially succeeded, it might still
-        /// fail and call <paramref name="on_error" /> later.</exception>
-        /// <exception cref="std::bad_alloc">If the memory required to build the
-        /// request could not be alloctated.</exception>
-        inline std::future<blob> replace(_In_ const std::uint64_t id,
-                _In_ const const_narrow_string& path) {
-            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
-                const std::uint64_t,
-                const const_narrow_string&,
-                const on_response_type, const on_error_type, void *);
-            return invoke_async<blob>(
-                static_cast<actual_type>(&dataverse_connection::replace), *this,
-                id, path);
-        }
-
         /// <summary>
         /// Upload a file for the data set with the specified persistent ID.
         /// </summary>
@@ -2330,6 +4517,20 @@ namespace dataverse {
         /// file should be added to, which typically has the form
         /// &quot;doi:the-doi&quot;.</param>
         /// <param name="path">The path to the file to be uploaded.</param>
+        /// <param name="description">A description of the file.</param>
+        /// <param name="directory">The name of the folder to organise the file
+        /// in a tree structure. If this is an empty string, the file will be
+        /// placed at root level. Make sure to terminate the path with a
+        /// slash.</param>
+        /// <param name="categories">A list of
+        /// <paramref name="cnt_cats" /> categories to be assigned to
+        /// the file. It is safe to pass <c>nullptr</c>.</param>
+        /// <param name="cnt_cats">The number of categories to add.
+        /// </param>
+        /// <param name="restricted"><c>true</c> for marking the file as
+        /// restricted such that it can only be uploaded when registering in
+        /// the guestbook. <c>false</c> for making the file freely available.
+        /// </param>
         /// <param name="on_response">A callback to be invoked if the response
         /// to the request was received.</param>
         /// <param name="on_error">A callback to be invoked if the request
@@ -2346,6 +4547,11 @@ namespace dataverse {
         /// request could not be alloctated.</exception>
         dataverse_connection& upload(_In_z_ const wchar_t *persistent_id,
             _In_z_ const wchar_t *path,
+            _In_z_ const wchar_t *description,
+            _In_z_ const wchar_t *directory,
+            const wchar_t **categories,
+            _In_ const std::size_t cnt_cats,
+            _In_ const bool restricted,
             _In_ const on_response_type on_response,
             _In_ const on_error_type on_error,
             _In_opt_ void *context = nullptr);
@@ -2357,6 +4563,20 @@ namespace dataverse {
         /// file should be added to, which typically has the form
         /// &quot;doi:the-doi&quot;.</param>
         /// <param name="path">The path to the file to be uploaded.</param>
+        /// <param name="description">A description of the file.</param>
+        /// <param name="directory">The name of the folder to organise the file
+        /// in a tree structure. If this is an empty string, the file will be
+        /// placed at root level. Make sure to terminate the path with a
+        /// slash.</param>
+        /// <param name="categories">A list of
+        /// <paramref name="cnt_cats" /> categories to be assigned to
+        /// the file. It is safe to pass <c>nullptr</c>.</param>
+        /// <param name="cnt_cats">The number of categories to add.
+        /// </param>
+        /// <param name="restricted"><c>true</c> for marking the file as
+        /// restricted such that it can only be uploaded when registering in
+        /// the guestbook. <c>false</c> for making the file freely available.
+        /// </param>
         /// <param name="on_response">A callback to be invoked if the response
         /// to the request was received.</param>
         /// <param name="on_error">A callback to be invoked if the request
@@ -2374,17 +4594,52 @@ namespace dataverse {
         dataverse_connection& upload(
             _In_ const const_narrow_string& persistent_id,
             _In_ const const_narrow_string& path,
+            _In_ const const_narrow_string& description,
+            _In_ const const_narrow_string& directory,
+            _In_reads_opt_(cnt_cats) const const_narrow_string *categories,
+            _In_ const std::size_t cnt_cats,
+            _In_ const bool restricted,
             _In_ const on_response_type on_response,
             _In_ const on_error_type on_error,
             _In_opt_ void *context = nullptr);
 
         /// <summary>
-        /// Upload a file for the data set with the specified persistent ID.
+        /// Upload a file for the data set with the specified persistent ID
+        /// whose content is streamed from the given producer.
         /// </summary>
+        /// <remarks>
+        /// <para>The length of the data does not need to be known in advance,
+        /// because the request is sent using chunked transfer encoding. This
+        /// allows for archiving results while they are still being generated
+        /// without staging them on disk first. The producer is called on the
+        /// I/O thread of the connection whenever curl needs more data.</para>
+        /// <para>The data are hashed on the fly using the
+        /// <see cref="checksum_algorithm" /> of the connection. If Dataverse
+        /// reports a checksum of the same type for the new file, it is
+        /// compared to the hash of the streamed data and a mismatch is
+        /// reported via <paramref name="on_error" />.</para>
+        /// <para>As the data cannot be produced again, the request fails if
+        /// the body would need to be sent twice, e.g. after a redirect.
+        /// </para>
+        /// <para>If the producer has no data available yet, it can return
+        /// <see cref="form_data::pause_read" />, which pauses the upload
+        /// without blocking the I/O thread. Once more data are available, the
+        /// upload must be continued via <see cref="resume_uploads" />. If the
+        /// producer throws, the upload is aborted and the exception is
+        /// reported via <paramref name="on_error" />.</para>
+        /// </remarks>
         /// <param name="persistent_id">The persistent ID of the data set the
         /// file should be added to, which typically has the form
         /// &quot;doi:the-doi&quot;.</param>
-        /// <param name="path">The path to the file to be uploaded.</param>
+        /// <param name="name">The name of the file in the data set.</param>
+        /// <param name="producer">The callback writing at most
+        /// <c>size * cnt</c> bytes of the file to the buffer it is given. It
+        /// returns the number of bytes written, zero at the end of the file,
+        /// <see cref="form_data::pause_read" /> if no data are available yet,
+        /// or any other value larger than the buffer for aborting the upload.
+        /// </param>
+        /// <param name="producer_context">A user-defined context pointer
+        /// passed to <paramref name="producer" />.</param>
         /// <param name="description">A description of the file.</param>
         /// <param name="directory">The name of the folder to organise the file
         /// in a tree structure. If this is an empty string, the file will be
@@ -2408,16 +4663,20 @@ namespace dataverse {
         /// <returns><c>*this</c>.</returns>
         /// <exception cref="std::system_error">If the method was called on an
         /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="producer" /> is <c>nullptr</c>.</exception>
         /// <exception cref="std::system_error">If the request failed right away.
         /// Note that even if the request initially succeeded, it might still
         /// fail and call <paramref name="on_error" /> later.</exception>
         /// <exception cref="std::bad_alloc">If the memory required to build the
         /// request could not be alloctated.</exception>
         dataverse_connection& upload(_In_z_ const wchar_t *persistent_id,
-            _In_z_ const wchar_t *path,
+            _In_z_ const wchar_t *name,
+            _In_ const form_data::on_read_type producer,
+            _In_opt_ void *producer_context,
             _In_z_ const wchar_t *description,
             _In_z_ const wchar_t *directory,
-            const wchar_t **categories,
+            _In_reads_z_(cnt_cats) const wchar_t **categories,
             _In_ const std::size_t cnt_cats,
             _In_ const bool restricted,
             _In_ const on_response_type on_response,
@@ -2425,12 +4684,42 @@ namespace dataverse {
             _In_opt_ void *context = nullptr);
 
         /// <summary>
-        /// Upload a file for the data set with the specified persistent ID.
+        /// Upload a file for the data set with the specified persistent ID
+        /// whose content is streamed from the given producer.
         /// </summary>
+        /// <remarks>
+        /// <para>The length of the data does not need to be known in advance,
+        /// because the request is sent using chunked transfer encoding. This
+        /// allows for archiving results while they are still being generated
+        /// without staging them on disk first. The producer is called on the
+        /// I/O thread of the connection whenever curl needs more data.</para>
+        /// <para>The data are hashed on the fly using the
+        /// <see cref="checksum_algorithm" /> of the connection. If Dataverse
+        /// reports a checksum of the same type for the new file, it is
+        /// compared to the hash of the streamed data and a mismatch is
+        /// reported via <paramref name="on_error" />.</para>
+        /// <para>As the data cannot be produced again, the request fails if
+        /// the body would need to be sent twice, e.g. after a redirect.
+        /// </para>
+        /// <para>If the producer has no data available yet, it can return
+        /// <see cref="form_data::pause_read" />, which pauses the upload
+        /// without blocking the I/O thread. Once more data are available, the
+        /// upload must be continued via <see cref="resume_uploads" />. If the
+        /// producer throws, the upload is aborted and the exception is
+        /// reported via <paramref name="on_error" />.</para>
+        /// </remarks>
         /// <param name="persistent_id">The persistent ID of the data set the
         /// file should be added to, which typically has the form
         /// &quot;doi:the-doi&quot;.</param>
-        /// <param name="path">The path to the file to be uploaded.</param>
+        /// <param name="name">The name of the file in the data set.</param>
+        /// <param name="producer">The callback writing at most
+        /// <c>size * cnt</c> bytes of the file to the buffer it is given. It
+        /// returns the number of bytes written, zero at the end of the file,
+        /// <see cref="form_data::pause_read" /> if no data are available yet,
+        /// or any other value larger than the buffer for aborting the upload.
+        /// </param>
+        /// <param name="producer_context">A user-defined context pointer
+        /// passed to <paramref name="producer" />.</param>
         /// <param name="description">A description of the file.</param>
         /// <param name="directory">The name of the folder to organise the file
         /// in a tree structure. If this is an empty string, the file will be
@@ -2454,6 +4743,8 @@ namespace dataverse {
         /// <returns><c>*this</c>.</returns>
         /// <exception cref="std::system_error">If the method was called on an
         /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="producer" /> is <c>nullptr</c>.</exception>
         /// <exception cref="std::system_error">If the request failed right away.
         /// Note that even if the request initially succeeded, it might still
         /// fail and call <paramref name="on_error" /> later.</exception>
@@ -2461,7 +4752,9 @@ namespace dataverse {
         /// request could not be alloctated.</exception>
         dataverse_connection& upload(
             _In_ const const_narrow_string& persistent_id,
-            _In_ const const_narrow_string& path,
+            _In_ const const_narrow_string& name,
+            _In_ const form_data::on_read_type producer,
+            _In_opt_ void *producer_context,
             _In_ const const_narrow_string& description,
             _In_ const const_narrow_string& directory,
             _In_reads_opt_(cnt_cats) const const_narrow_string *categories,
@@ -2754,6 +5047,256 @@ namespace dataverse {
         }
 #endif /* defined(DATAVERSE_WITH_JSON) */
 
+        /// <summary>
+        /// Upload many files for the data set with the specified persistent
+        /// ID as a single ZIP archive, which Dataverse unpacks.
+        /// </summary>
+        /// <remarks>
+        /// <para>Every upload creates a new draft version of the data set,
+        /// which makes uploading thousands of small files one by one very
+        /// expensive. This method bundles the files into a ZIP archive that
+        /// is built while it is being sent, i.e. the archive exists neither
+        /// in memory nor on disk. The request is sent using chunked transfer
+        /// encoding, and the files are only opened once the archive reaches
+        /// them.</para>
+        /// <para>Dataverse preserves the folders of the entries in the
+        /// archive as directory labels of the files it adds.</para>
+        /// <para>The method returns immediately. If a file cannot be read,
+        /// the transfer is aborted and the reason is reported via
+        /// <paramref name="on_error" />. As the archive cannot be produced
+        /// again, the request also fails if the body would need to be sent
+        /// twice, e.g. after a redirect.</para>
+        /// <para>Archives are written without ZIP64 extensions, so they must
+        /// not exceed 4 GiB.</para>
+        /// </remarks>
+        /// <param name="persistent_id">The persistent ID of the data set the
+        /// files should be added to, which typically has the form
+        /// &quot;doi:the-doi&quot;.</param>
+        /// <param name="paths">The paths to the <paramref name="cnt" /> files
+        /// to be uploaded.</param>
+        /// <param name="directories">The folders in the data set the files
+        /// are placed in, one for each of the <paramref name="paths" />. It
+        /// is safe to pass <c>nullptr</c> for placing all files at root
+        /// level.</param>
+        /// <param name="cnt">The number of files to be uploaded.</param>
+        /// <param name="compression">Determines whether the files are stored
+        /// or deflated in the archive.</param>
+        /// <param name="description">A description of the files.</param>
+        /// <param name="categories">A list of
+        /// <paramref name="cnt_cats" /> categories to be assigned to
+        /// the files. It is safe to pass <c>nullptr</c>.</param>
+        /// <param name="cnt_cats">The number of categories to add.
+        /// </param>
+        /// <param name="restricted"><c>true</c> for marking the files as
+        /// restricted, <c>false</c> for making them freely available.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="paths" />
+        /// is <c>nullptr</c> or empty, or if <paramref name="compression" />
+        /// is not supported.</exception>
+        /// <exception cref="std::range_error">If more than 65535 files are to
+        /// be uploaded.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& upload_archive(
+            _In_z_ const wchar_t *persistent_id,
+            _In_reads_(cnt) const wchar_t **paths,
+            _In_reads_opt_(cnt) const wchar_t **directories,
+            _In_ const std::size_t cnt,
+            _In_ const archive_compression compression,
+            _In_z_ const wchar_t *description,
+            _In_reads_opt_(cnt_cats) const wchar_t **categories,
+            _In_ const std::size_t cnt_cats,
+            _In_ const bool restricted,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Upload many files for the data set with the specified persistent
+        /// ID as a single ZIP archive, which Dataverse unpacks.
+        /// </summary>
+        /// <remarks>
+        /// See the wide-string variant of this method for details.
+        /// </remarks>
+        /// <param name="persistent_id">The persistent ID of the data set the
+        /// files should be added to, which typically has the form
+        /// &quot;doi:the-doi&quot;.</param>
+        /// <param name="paths">The paths to the <paramref name="cnt" /> files
+        /// to be uploaded.</param>
+        /// <param name="directories">The folders in the data set the files
+        /// are placed in, one for each of the <paramref name="paths" />. It
+        /// is safe to pass <c>nullptr</c> for placing all files at root
+        /// level.</param>
+        /// <param name="cnt">The number of files to be uploaded.</param>
+        /// <param name="compression">Determines whether the files are stored
+        /// or deflated in the archive.</param>
+        /// <param name="description">A description of the files.</param>
+        /// <param name="categories">A list of
+        /// <paramref name="cnt_cats" /> categories to be assigned to
+        /// the files. It is safe to pass <c>nullptr</c>.</param>
+        /// <param name="cnt_cats">The number of categories to add.
+        /// </param>
+        /// <param name="restricted"><c>true</c> for marking the files as
+        /// restricted, <c>false</c> for making them freely available.</param>
+        /// <param name="on_response">A callback to be invoked if the response
+        /// to the request was received.</param>
+        /// <param name="on_error">A callback to be invoked if the request
+        /// failed asynchronously.</param>
+        /// <param name="context">A user-defined context pointer passed to the
+        /// callbacks.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="paths" />
+        /// is <c>nullptr</c> or empty, or if <paramref name="compression" />
+        /// is not supported.</exception>
+        /// <exception cref="std::range_error">If more than 65535 files are to
+        /// be uploaded.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        dataverse_connection& upload_archive(
+            _In_ const const_narrow_string& persistent_id,
+            _In_reads_(cnt) const const_narrow_string *paths,
+            _In_reads_opt_(cnt) const const_narrow_string *directories,
+            _In_ const std::size_t cnt,
+            _In_ const archive_compression compression,
+            _In_ const const_narrow_string& description,
+            _In_reads_opt_(cnt_cats) const const_narrow_string *categories,
+            _In_ const std::size_t cnt_cats,
+            _In_ const bool restricted,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Upload many files for the data set with the specified persistent
+        /// ID as a single ZIP archive, which Dataverse unpacks, and returns a
+        /// future for the response.
+        /// </summary>
+        /// <remarks>
+        /// See the wide-string variant of this method with callbacks for
+        /// details.
+        /// </remarks>
+        /// <param name="persistent_id">The persistent ID of the data set the
+        /// files should be added to, which typically has the form
+        /// &quot;doi:the-doi&quot;.</param>
+        /// <param name="paths">The paths to the <paramref name="cnt" /> files
+        /// to be uploaded.</param>
+        /// <param name="directories">The folders in the data set the files
+        /// are placed in, one for each of the <paramref name="paths" />. It
+        /// is safe to pass <c>nullptr</c> for placing all files at root
+        /// level.</param>
+        /// <param name="cnt">The number of files to be uploaded.</param>
+        /// <param name="compression">Determines whether the files are stored
+        /// or deflated in the archive.</param>
+        /// <param name="description">A description of the files.</param>
+        /// <param name="categories">A list of
+        /// <paramref name="cnt_cats" /> categories to be assigned to
+        /// the files. It is safe to pass <c>nullptr</c>.</param>
+        /// <param name="cnt_cats">The number of categories to add.
+        /// </param>
+        /// <param name="restricted"><c>true</c> for marking the files as
+        /// restricted, <c>false</c> for making them freely available.</param>
+        /// <returns>A future for the response of Dataverse.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="paths" />
+        /// is <c>nullptr</c> or empty, or if <paramref name="compression" />
+        /// is not supported.</exception>
+        /// <exception cref="std::range_error">If more than 65535 files are to
+        /// be uploaded.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline std::future<blob> upload_archive(
+                _In_z_ const wchar_t *persistent_id,
+                _In_reads_(cnt) const wchar_t **paths,
+                _In_reads_opt_(cnt) const wchar_t **directories,
+                _In_ const std::size_t cnt,
+                _In_ const archive_compression compression,
+                _In_z_ const wchar_t *description,
+                _In_reads_opt_(cnt_cats) const wchar_t **categories,
+                _In_ const std::size_t cnt_cats,
+                _In_ const bool restricted) {
+            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
+                const wchar_t *, const wchar_t **, const wchar_t **,
+                const std::size_t, const archive_compression, const wchar_t *,
+                const wchar_t **, const std::size_t, const bool,
+                const on_response_type, const on_error_type, void *);
+            return invoke_async<blob>(
+                static_cast<actual_type>(&dataverse_connection::upload_archive),
+                *this, persistent_id, paths, directories, cnt, compression,
+                description, categories, cnt_cats, restricted);
+        }
+
+        /// <summary>
+        /// Upload many files for the data set with the specified persistent
+        /// ID as a single ZIP archive, which Dataverse unpacks, and returns a
+        /// future for the response.
+        /// </summary>
+        /// <remarks>
+        /// See the wide-string variant of this method with callbacks for
+        /// details.
+        /// </remarks>
+        /// <param name="persistent_id">The persistent ID of the data set the
+        /// files should be added to, which typically has the form
+        /// &quot;doi:the-doi&quot;.</param>
+        /// <param name="paths">The paths to the <paramref name="cnt" /> files
+        /// to be uploaded.</param>
+        /// <param name="directories">The folders in the data set the files
+        /// are placed in, one for each of the <paramref name="paths" />. It
+        /// is safe to pass <c>nullptr</c> for placing all files at root
+        /// level.</param>
+        /// <param name="cnt">The number of files to be uploaded.</param>
+        /// <param name="compression">Determines whether the files are stored
+        /// or deflated in the archive.</param>
+        /// <param name="description">A description of the files.</param>
+        /// <param name="categories">A list of
+        /// <paramref name="cnt_cats" /> categories to be assigned to
+        /// the files. It is safe to pass <c>nullptr</c>.</param>
+        /// <param name="cnt_cats">The number of categories to add.
+        /// </param>
+        /// <param name="restricted"><c>true</c> for marking the files as
+        /// restricted, <c>false</c> for making them freely available.</param>
+        /// <returns>A future for the response of Dataverse.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="paths" />
+        /// is <c>nullptr</c> or empty, or if <paramref name="compression" />
+        /// is not supported.</exception>
+        /// <exception cref="std::range_error">If more than 65535 files are to
+        /// be uploaded.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// request could not be alloctated.</exception>
+        inline std::future<blob> upload_archive(
+                _In_ const const_narrow_string& persistent_id,
+                _In_reads_(cnt) const const_narrow_string *paths,
+                _In_reads_opt_(cnt) const const_narrow_string *directories,
+                _In_ const std::size_t cnt,
+                _In_ const archive_compression compression,
+                _In_ const const_narrow_string& description,
+                _In_reads_opt_(cnt_cats) const const_narrow_string *categories,
+                _In_ const std::size_t cnt_cats,
+                _In_ const bool restricted) {
+            typedef dataverse_connection& (dataverse_connection:: *actual_type)(
+                const const_narrow_string&, const const_narrow_string *,
+                const const_narrow_string *, const std::size_t,
+                const archive_compression, const const_narrow_string&,
+                const const_narrow_string *, const std::size_t, const bool,
+                const on_response_type, const on_error_type, void *);
+            return invoke_async<blob>(
+                static_cast<actual_type>(&dataverse_connection::upload_archive),
+                *this, persistent_id, paths, directories, cnt, compression,
+                description, categories, cnt_cats, restricted);
+        }
+
         /// <summary>
         /// Move assignment.
         /// </summary>
@@ -2814,6 +5357,13 @@ namespace dataverse {
         static void translate_api_reponse(_In_ const blob& response,
             _In_ void *client_data);
 
+        /// <summary>
+        /// The callback to convert the native callback to a
+        /// <see cref="json_view" /> callback.
+        /// </summary>
+        static void translate_json_response(_In_ const blob& response,
+            _In_ void *client_data);
+
         /// <summary>
         /// Checks that the API has not been disposed and returns its
         /// implementation if this is the case.
@@ -2845,6 +5395,18 @@ namespace dataverse {
             _In_ const on_error_type on_error,
             _In_opt_ void *context);
 
+        /// <summary>
+        /// Begins the upload described by the fully prepared
+        /// <paramref name="context" /> by requesting the one-time upload URL.
+        /// </summary>
+        /// <remarks>
+        /// The file must have been opened and its properties must have been
+        /// added to the description. The method takes ownership of the
+        /// context, i.e. the context is deleted once the upload completed,
+        /// no matter whether successfully or not.
+        /// </remarks>
+        static void direct_upload(_In_ detail::direct_upload_context *context);
+
         void direct_upload(_In_ const const_narrow_string& persistent_id,
             _In_ const const_narrow_string& path,
             _In_ const const_narrow_string& mime_type,
@@ -2858,6 +5420,33 @@ namespace dataverse {
             _In_ const on_error_type on_error,
             _In_opt_ void *context);
 
+        /// <summary>
+        /// Starts hashing and uploading the files of the given
+        /// <paramref name="batch" />, which determines how the files are
+        /// registered.
+        /// </summary>
+        /// <remarks>
+        /// The method takes ownership of the batch, i.e. the batch is deleted
+        /// once the last file has been reported or if the method throws.
+        /// </remarks>
+        void direct_upload_files(_In_ detail::direct_upload_batch *batch,
+            _In_z_ const wchar_t *persistent_id,
+            _In_reads_(cnt) const wchar_t **paths,
+            _In_ const std::size_t cnt,
+            _In_opt_z_ const wchar_t *mime_type,
+            _In_z_ const wchar_t *directory,
+            _In_ const bool restricted);
+
+        void download(_In_ const std::uint64_t id,
+            _In_z_ const wchar_t *format,
+            _In_opt_z_ const wchar_t *checksum_type,
+            _In_opt_z_ const wchar_t *checksum,
+            _In_z_ const wchar_t *path,
+            _In_ const bool resume,
+            _In_ const on_response_type on_response,
+            _In_ const on_error_type on_error,
+            _In_opt_ void *context);
+
         void get(_In_opt_z_ const wchar_t *resource,
             _In_ const on_response_type on_response,
             _In_opt_ const void *on_api_response,
@@ -2956,6 +5545,17 @@ namespace dataverse {
             _In_ const on_error_type on_error,
             _In_opt_ void *context);
 
+        /// <summary>
+        /// Registers a file that has been stored in S3 with the data set,
+        /// which is the last step of a direct upload.
+        /// </summary>
+        /// <remarks>
+        /// The checksum must already be in the description of the
+        /// <paramref name="context" />. The method takes ownership of the
+        /// context like <see cref="direct_upload" />.
+        /// </remarks>
+        static void register_file(_In_ detail::direct_upload_context *context);
+
         detail::dataverse_connection_impl *_impl;
     };
 
@@ -104,7 +104,7 @@ void visus::dataverse::dataverse_connection::translate_api_reponse(
         if (json["status"].template get<std::string>() == "ERROR") {
             // TODO: this (content of 'message') seems to be wrong ...
             auto message = json["status"].template get<std::string>();
-            report_api_error(context, message.c_str());
+            report_api_error(client_data, message.c_str());
         } else {
             on_api_response(json, context);
         }
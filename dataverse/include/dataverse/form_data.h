@@ -8,6 +8,7 @@
 #include <cinttypes>
 #include <cstdlib>
 #include <fstream>
+#include <limits>
 
 #if defined(_WIN32)
 #include <Windows.h>
@@ -15,6 +16,7 @@
 
 #include "dataverse/api.h"
 #include "dataverse/blob.h"
+#include "dataverse/blob_view.h"
 #include "dataverse/convert.h"
 
 
@@ -41,10 +43,21 @@ namespace dataverse {
         /// </summary>
         typedef blob::byte_type byte_type;
 
+        /// <summary>
+        /// The type of a deleter callback that allows the caller to have the
+        /// form free data that it passed to it when this data is no longer
+        /// needed.
+        /// </summary>
+        typedef void (*data_deleter_type)(_In_opt_ const void *);
+
         /// <summary>
         /// Signature of the data read function used for incrementally
         /// transferring large files.
         /// </summary>
+        /// <remarks>
+        /// The function returns the number of bytes written to
+        /// <paramref name="dst" />, which is zero at the end of the data.
+        /// </remarks>
         typedef std::size_t (*on_read_type)(
             _Out_writes_bytes_(cnt *size) char *dst,
             _In_ const size_t size,
@@ -65,6 +78,29 @@ namespace dataverse {
         /// </summary>
         typedef void (*on_close_type)(_In_opt_ void *);
 
+        /// <summary>
+        /// The size to be passed to <see cref="add_file" /> if the length of
+        /// the data is not known in advance.
+        /// </summary>
+        /// <remarks>
+        /// Forms with a field of unknown size are sent using chunked transfer
+        /// encoding, which allows for streaming data while they are being
+        /// produced.
+        /// </remarks>
+        static constexpr std::size_t unknown_size
+            = (std::numeric_limits<std::size_t>::max)();
+
+        /// <summary>
+        /// The value an <see cref="on_read_type" /> returns if it has no data
+        /// available right now, which pauses the transfer.
+        /// </summary>
+        /// <remarks>
+        /// The value is the same as curl's <c>CURL_READFUNC_PAUSE</c>. Streamed
+        /// uploads of a <see cref="dataverse_connection" /> are continued via
+        /// <see cref="dataverse_connection::resume_uploads" />.
+        /// </remarks>
+        static constexpr std::size_t pause_read = 0x10000001;
+
         /// <summary>
         /// An implementation of <see cref="on_close_type" /> for use with POSIX
         /// file handles.
@@ -169,12 +205,138 @@ namespace dataverse {
             _In_reads_bytes_(cnt) _In_ const byte_type *data,
             _In_ const std::size_t cnt);
 
+        /// <summary>
+        /// Adds a field that references the given memory instead of copying
+        /// it.
+        /// </summary>
+        /// <remarks>
+        /// In contrast to the variant without deleter, the data are read
+        /// directly from <paramref name="data" /> while the request is being
+        /// sent, which avoids holding a second copy of large data in memory.
+        /// </remarks>
+        /// <param name="name">The name of the field.</param>
+        /// <param name="data">The content of the field. The caller remains
+        /// owner of this memory if no <paramref name="deleter" /> is set and
+        /// must make sure that the data remain valid until the request
+        /// completed or failed.</param>
+        /// <param name="cnt">The size of the data in bytes.</param>
+        /// <param name="deleter">If not <c>nullptr</c>, the form will free
+        /// <paramref name="data" /> using this callback once it is not needed
+        /// anymore, also if this method fails.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the form data are invalid,
+        /// e.g. because the object has been moved.</exception>
+        form_data& add_field(_In_z_ const wchar_t *name,
+            _In_reads_bytes_(cnt) const byte_type *data,
+            _In_ const std::size_t cnt,
+            _In_opt_ const data_deleter_type deleter);
+
+        /// <summary>
+        /// Adds a field that references the given memory instead of copying
+        /// it.
+        /// </summary>
+        /// <remarks>
+        /// In contrast to the variant without deleter, the data are read
+        /// directly from <paramref name="data" /> while the request is being
+        /// sent, which avoids holding a second copy of large data in memory.
+        /// </remarks>
+        /// <param name="name">The name of the field.</param>
+        /// <param name="data">The content of the field. The caller remains
+        /// owner of this memory if no <paramref name="deleter" /> is set and
+        /// must make sure that the data remain valid until the request
+        /// completed or failed.</param>
+        /// <param name="cnt">The size of the data in bytes.</param>
+        /// <param name="deleter">If not <c>nullptr</c>, the form will free
+        /// <paramref name="data" /> using this callback once it is not needed
+        /// anymore, also if this method fails.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the form data are invalid,
+        /// e.g. because the object has been moved.</exception>
+        form_data& add_field(_In_ const const_narrow_string& name,
+            _In_reads_bytes_(cnt) const byte_type *data,
+            _In_ const std::size_t cnt,
+            _In_opt_ const data_deleter_type deleter);
+
+        /// <summary>
+        /// Adds a field holding the bytes of the given view, which might be a
+        /// slice of a <see cref="blob" /> or a response.
+        /// </summary>
+        /// <param name="name">The name of the field.</param>
+        /// <param name="data">The content of the field, which is copied.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        inline form_data& add_field(_In_z_ const wchar_t *name,
+                _In_ const blob_view& data) {
+            return this->add_field(name, data.begin(), data.size());
+        }
+
+        /// <summary>
+        /// Adds a field holding the bytes of the given view, which might be a
+        /// slice of a <see cref="blob" /> or a response.
+        /// </summary>
+        /// <param name="name">The name of the field.</param>
+        /// <param name="data">The content of the field, which is copied.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        inline form_data& add_field(_In_ const const_narrow_string& name,
+                _In_ const blob_view& data) {
+            return this->add_field(name, data.begin(), data.size());
+        }
+
         form_data& add_file(_In_z_ const wchar_t *name,
             _In_z_ const wchar_t *path);
 
         form_data& add_file(_In_ const const_narrow_string& name,
             _In_ const const_narrow_string& path);
 
+        /// <summary>
+        /// Adds a file field that references the given memory instead of
+        /// copying it.
+        /// </summary>
+        /// <param name="name">The name of the field.</param>
+        /// <param name="file_name">The name of the file reported to the
+        /// server. If this is <c>nullptr</c>, no file name is sent.</param>
+        /// <param name="data">The content of the file. The caller remains
+        /// owner of this memory if no <paramref name="deleter" /> is set and
+        /// must make sure that the data remain valid until the request
+        /// completed or failed.</param>
+        /// <param name="cnt">The size of the data in bytes.</param>
+        /// <param name="deleter">If not <c>nullptr</c>, the form will free
+        /// <paramref name="data" /> using this callback once it is not needed
+        /// anymore, also if this method fails.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the form data are invalid,
+        /// e.g. because the object has been moved.</exception>
+        form_data& add_file(_In_z_ const wchar_t *name,
+            _In_opt_z_ const wchar_t *file_name,
+            _In_reads_bytes_(cnt) const byte_type *data,
+            _In_ const std::size_t cnt,
+            _In_opt_ const data_deleter_type deleter);
+
+        /// <summary>
+        /// Adds a file field that references the given memory instead of
+        /// copying it.
+        /// </summary>
+        /// <param name="name">The name of the field.</param>
+        /// <param name="file_name">The name of the file reported to the
+        /// server. If this is <c>nullptr</c>, no file name is sent.</param>
+        /// <param name="data">The content of the file. The caller remains
+        /// owner of this memory if no <paramref name="deleter" /> is set and
+        /// must make sure that the data remain valid until the request
+        /// completed or failed.</param>
+        /// <param name="cnt">The size of the data in bytes.</param>
+        /// <param name="deleter">If not <c>nullptr</c>, the form will free
+        /// <paramref name="data" /> using this callback once it is not needed
+        /// anymore, also if this method fails.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::system_error">If the form data are invalid,
+        /// e.g. because the object has been moved.</exception>
+        form_data& add_file(_In_ const const_narrow_string& name,
+            _In_ const const_narrow_string& file_name,
+            _In_reads_bytes_(cnt) const byte_type *data,
+            _In_ const std::size_t cnt,
+            _In_opt_ const data_deleter_type deleter);
+
         form_data& add_file(_In_z_ const wchar_t *name,
             _In_ const std::size_t size,
             _In_ on_read_type on_read,
@@ -189,6 +351,54 @@ namespace dataverse {
             _In_opt_ on_close_type on_close,
             _In_opt_ void *context);
 
+        /// <summary>
+        /// Adds a file field whose content is provided by the given callbacks.
+        /// </summary>
+        /// <param name="name">The name of the field.</param>
+        /// <param name="file_name">The name of the file reported to the
+        /// server. If this is <c>nullptr</c>, no file name is sent.</param>
+        /// <param name="size">The size of the file in bytes or
+        /// <see cref="unknown_size" /> if the data are streamed.</param>
+        /// <param name="on_read">The callback providing the data.</param>
+        /// <param name="on_seek">The callback repositioning the data, which
+        /// might be <c>nullptr</c> if the data cannot be rewound.</param>
+        /// <param name="on_close">The callback invoked when the form is
+        /// freed, which might be <c>nullptr</c>.</param>
+        /// <param name="context">The context pointer passed to the callbacks.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        form_data& add_file(_In_z_ const wchar_t *name,
+            _In_opt_z_ const wchar_t *file_name,
+            _In_ const std::size_t size,
+            _In_ on_read_type on_read,
+            _In_opt_ on_seek_type on_seek,
+            _In_opt_ on_close_type on_close,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Adds a file field whose content is provided by the given callbacks.
+        /// </summary>
+        /// <param name="name">The name of the field.</param>
+        /// <param name="file_name">The name of the file reported to the
+        /// server. If this is <c>nullptr</c>, no file name is sent.</param>
+        /// <param name="size">The size of the file in bytes or
+        /// <see cref="unknown_size" /> if the data are streamed.</param>
+        /// <param name="on_read">The callback providing the data.</param>
+        /// <param name="on_seek">The callback repositioning the data, which
+        /// might be <c>nullptr</c> if the data cannot be rewound.</param>
+        /// <param name="on_close">The callback invoked when the form is
+        /// freed, which might be <c>nullptr</c>.</param>
+        /// <param name="context">The context pointer passed to the callbacks.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        form_data& add_file(_In_ const const_narrow_string& name,
+            _In_ const const_narrow_string& file_name,
+            _In_ const std::size_t size,
+            _In_ on_read_type on_read,
+            _In_opt_ on_seek_type on_seek,
+            _In_opt_ on_close_type on_close,
+            _In_opt_ void *context);
+
         /// <summary>
         /// Move assignment.
         /// </summary>
@@ -0,0 +1,166 @@
+﻿// <copyright file="json_sax_handler.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "dataverse/api.h"
+
+
+namespace visus {
+namespace dataverse {
+
+    /// <summary>
+    /// The interface of a handler that receives the events of a JSON document
+    /// while it is being parsed incrementally.
+    /// </summary>
+    /// <remarks>
+    /// <para>A SAX handler allows for processing a response while it is still
+    /// being received. The response is fed to the parser in the chunks
+    /// provided by the network layer, i.e. parsing overlaps with the
+    /// transfer and neither the whole response nor a DOM of it ever needs to
+    /// exist in memory.</para>
+    /// <para>All methods are called on the I/O thread of the connection. Any
+    /// string passed to the handler is unescaped UTF-8 that is only valid
+    /// during the call. All methods return whether parsing should continue,
+    /// i.e. returning <c>false</c> cancels the request, which is reported as
+    /// an error. The default implementations ignore the event, so that
+    /// subclasses only need to override the events they are interested in.
+    /// </para>
+    /// </remarks>
+    class json_sax_handler {
+
+    public:
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        virtual ~json_sax_handler(void) = default;
+
+        /// <summary>
+        /// Receives a Boolean value.
+        /// </summary>
+        /// <param name="value">The value.</param>
+        /// <returns><c>true</c> to continue parsing, <c>false</c> to cancel.
+        /// </returns>
+        virtual bool boolean(_In_ const bool /* value */) {
+            return true;
+        }
+
+        /// <summary>
+        /// Indicates the end of an array.
+        /// </summary>
+        /// <returns><c>true</c> to continue parsing, <c>false</c> to cancel.
+        /// </returns>
+        virtual bool end_array(void) {
+            return true;
+        }
+
+        /// <summary>
+        /// Indicates the end of an object.
+        /// </summary>
+        /// <returns><c>true</c> to continue parsing, <c>false</c> to cancel.
+        /// </returns>
+        virtual bool end_object(void) {
+            return true;
+        }
+
+        /// <summary>
+        /// Receives the name of the next member of an object.
+        /// </summary>
+        /// <param name="name">The unescaped UTF-8 name of the member, which
+        /// is not null-terminated.</param>
+        /// <param name="cnt">The length of <paramref name="name" /> in bytes.
+        /// </param>
+        /// <returns><c>true</c> to continue parsing, <c>false</c> to cancel.
+        /// </returns>
+        virtual bool key(_In_reads_(_Param_(2)) const char * /* name */,
+                _In_ const std::size_t /* cnt */) {
+            return true;
+        }
+
+        /// <summary>
+        /// Receives a <c>null</c> value.
+        /// </summary>
+        /// <returns><c>true</c> to continue parsing, <c>false</c> to cancel.
+        /// </returns>
+        virtual bool null(void) {
+            return true;
+        }
+
+        /// <summary>
+        /// Receives a number that has a fractional part or an exponent, or
+        /// that does not fit into a 64-bit integer.
+        /// </summary>
+        /// <param name="value">The value of the number.</param>
+        /// <param name="raw">The text of the number as it appears in the
+        /// document, which is not null-terminated.</param>
+        /// <param name="cnt">The length of <paramref name="raw" /> in bytes.
+        /// </param>
+        /// <returns><c>true</c> to continue parsing, <c>false</c> to cancel.
+        /// </returns>
+        virtual bool number_float(_In_ const double /* value */,
+                _In_reads_(_Param_(3)) const char * /* raw */,
+                _In_ const std::size_t /* cnt */) {
+            return true;
+        }
+
+        /// <summary>
+        /// Receives a negative integral number.
+        /// </summary>
+        /// <param name="value">The value of the number.</param>
+        /// <returns><c>true</c> to continue parsing, <c>false</c> to cancel.
+        /// </returns>
+        virtual bool number_integer(_In_ const std::int64_t /* value */) {
+            return true;
+        }
+
+        /// <summary>
+        /// Receives a non-negative integral number.
+        /// </summary>
+        /// <param name="value">The value of the number.</param>
+        /// <returns><c>true</c> to continue parsing, <c>false</c> to cancel.
+        /// </returns>
+        virtual bool number_unsigned(_In_ const std::uint64_t /* value */) {
+            return true;
+        }
+
+        /// <summary>
+        /// Indicates the begin of an array.
+        /// </summary>
+        /// <returns><c>true</c> to continue parsing, <c>false</c> to cancel.
+        /// </returns>
+        virtual bool start_array(void) {
+            return true;
+        }
+
+        /// <summary>
+        /// Indicates the begin of an object.
+        /// </summary>
+        /// <returns><c>true</c> to continue parsing, <c>false</c> to cancel.
+        /// </returns>
+        virtual bool start_object(void) {
+            return true;
+        }
+
+        /// <summary>
+        /// Receives a string value.
+        /// </summary>
+        /// <param name="value">The unescaped UTF-8 value, which is not
+        /// null-terminated.</param>
+        /// <param name="cnt">The length of <paramref name="value" /> in bytes.
+        /// </param>
+        /// <returns><c>true</c> to continue parsing, <c>false</c> to cancel.
+        /// </returns>
+        virtual bool string(_In_reads_(_Param_(2)) const char * /* value */,
+                _In_ const std::size_t /* cnt */) {
+            return true;
+        }
+    };
+
+} /* namespace dataverse */
+} /* namespace visus */
@@ -0,0 +1,337 @@
+﻿// <copyright file="json_view.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "dataverse/api.h"
+#include "dataverse/blob.h"
+#include "dataverse/blob_view.h"
+
+
+namespace visus {
+namespace dataverse {
+
+    /// <summary>
+    /// A read-only view of a JSON value that is stored as text in a
+    /// <see cref="blob" /> or any other memory block.
+    /// </summary>
+    /// <remarks>
+    /// <para>In contrast to a JSON DOM, the view does not copy or convert the
+    /// data it refers to. The text is only parsed on demand, i.e. looking up
+    /// a member skips all values before it without allocating any memory and
+    /// without even looking at the values after it. This makes the view the
+    /// cheapest way of extracting a few values from a large response.</para>
+    /// <para>As a consequence, the view does not validate the whole document.
+    /// Malformed parts of the document are only detected when they are
+    /// scanned, in which case the lookup yields an invalid view.</para>
+    /// <para>The view does not own the memory it refers to. Callers must make
+    /// sure that the memory lives at least as long as the view and any view
+    /// derived from it. Most importantly, views passed to a callback must not
+    /// be used after the callback returned.</para>
+    /// </remarks>
+    class DATAVERSE_API json_view final {
+
+    public:
+
+        /// <summary>
+        /// Possible types of the value a <see cref="json_view" /> refers to.
+        /// </summary>
+        enum class value_type {
+            /// <summary>
+            /// The view is invalid, e.g. because a lookup failed or because
+            /// the document is malformed.
+            /// </summary>
+            invalid,
+            null,
+            boolean,
+            number,
+            string,
+            array,
+            object
+        };
+
+        /// <summary>
+        /// Initialises a new, invalid view.
+        /// </summary>
+        inline json_view(void) noexcept : _data(nullptr), _end(nullptr),
+            _key(nullptr), _key_size(0), _size(0) { }
+
+        /// <summary>
+        /// Initialises a new view of the JSON document in the given memory.
+        /// </summary>
+        /// <param name="data">A pointer to the UTF-8-encoded text of the
+        /// document, which does not need to be null-terminated.</param>
+        /// <param name="cnt">The length of <paramref name="data" /> in bytes.
+        /// </param>
+        json_view(_In_reads_bytes_(cnt) const char *data,
+            _In_ const std::size_t cnt) noexcept;
+
+        /// <summary>
+        /// Initialises a new view of the JSON document in the given
+        /// <see cref="blob" /> or a slice of it.
+        /// </summary>
+        /// <param name="data">A view of the UTF-8-encoded text of the
+        /// document.</param>
+        explicit inline json_view(_In_ const blob_view& data) noexcept
+            : json_view(data.as<char>(), data.size()) { }
+
+        /// <summary>
+        /// Looks up the value designated by the given JSON pointer
+        /// (RFC 6901), e.g. &quot;/data/files/0/dataFile/id&quot;.
+        /// </summary>
+        /// <param name="pointer">The JSON pointer relative to this value. An
+        /// empty string or <c>nullptr</c> designates the value itself.</param>
+        /// <returns>A view of the value, which is invalid if the value does
+        /// not exist.</returns>
+        json_view at(_In_opt_z_ const char *pointer) const noexcept;
+
+        /// <summary>
+        /// Answer the raw text of the value.
+        /// </summary>
+        /// <returns>A pointer to the begin of the value or <c>nullptr</c> if
+        /// the view is invalid.</returns>
+        inline _Ret_maybenull_ const char *data(void) const noexcept {
+            return this->_data;
+        }
+
+        /// <summary>
+        /// Looks up the element at the given position if the value is an
+        /// array.
+        /// </summary>
+        /// <remarks>
+        /// Finding an element requires scanning all elements before it. Use
+        /// <see cref="first" /> and <see cref="next" /> for enumerating all
+        /// elements.
+        /// </remarks>
+        /// <param name="index">The zero-based index of the element.</param>
+        /// <returns>A view of the element, which is invalid if the value is
+        /// not an array or if <paramref name="index" /> is out of range.
+        /// </returns>
+        json_view element(_In_ const std::size_t index) const noexcept;
+
+        /// <summary>
+        /// Answer whether the value is a string that is equal to the given
+        /// UTF-8 string.
+        /// </summary>
+        /// <remarks>
+        /// The method compares without unescaping the value into a new
+        /// buffer.
+        /// </remarks>
+        /// <param name="str">The string to compare to.</param>
+        /// <param name="cnt">The length of <paramref name="str" /> in bytes.
+        /// </param>
+        /// <returns><c>true</c> if the value is the given string,
+        /// <c>false</c> otherwise.</returns>
+        bool equals(_In_reads_(cnt) const char *str,
+            _In_ const std::size_t cnt) const noexcept;
+
+        /// <summary>
+        /// Answer whether the value is a string that is equal to the given
+        /// null-terminated UTF-8 string.
+        /// </summary>
+        /// <param name="str">The string to compare to.</param>
+        /// <returns><c>true</c> if the value is the given string,
+        /// <c>false</c> otherwise.</returns>
+        inline bool equals(_In_z_ const char *str) const noexcept {
+            return (str != nullptr) && this->equals(str, ::strlen(str));
+        }
+
+        /// <summary>
+        /// Answer the first element of an array or the value of the first
+        /// member of an object.
+        /// </summary>
+        /// <returns>A view of the first child, which is invalid if the value
+        /// is empty or not a container.</returns>
+        json_view first(void) const noexcept;
+
+        /// <summary>
+        /// Retrieves the name of the member this view refers to.
+        /// </summary>
+        /// <param name="dst">A buffer receiving the null-terminated, unescaped
+        /// name. It is safe to pass <c>nullptr</c> for measuring the required
+        /// buffer size.</param>
+        /// <param name="cnt">The size of <paramref name="dst" /> in bytes.
+        /// </param>
+        /// <returns>The required buffer size in bytes including the
+        /// terminating null, or zero if the view is not a member of an
+        /// object.</returns>
+        std::size_t key(_Out_writes_opt_(cnt) char *dst,
+            _In_ const std::size_t cnt) const noexcept;
+
+        /// <summary>
+        /// Retrieves the name of the member this view refers to.
+        /// </summary>
+        /// <returns>The name of the member, which is empty if the view is not
+        /// a member of an object.</returns>
+        inline std::string key(void) const {
+            std::vector<char> buffer(this->key(nullptr, 0));
+            const auto cnt = this->key(buffer.data(), buffer.size());
+            return (cnt > 0)
+                ? std::string(buffer.data(), buffer.data() + cnt - 1)
+                : std::string();
+        }
+
+        /// <summary>
+        /// Answer the length of the raw text of the value in bytes.
+        /// </summary>
+        /// <remarks>
+        /// The length of a value is only known once it has been skipped
+        /// while looking up another one. If that is not the case, the value
+        /// needs to be scanned by this method.
+        /// </remarks>
+        /// <returns>The length of the value or zero if the view or the value
+        /// is invalid.</returns>
+        std::size_t length(void) const noexcept;
+
+        /// <summary>
+        /// Looks up the member with the given name if the value is an object.
+        /// </summary>
+        /// <param name="name">The UTF-8-encoded name of the member.</param>
+        /// <param name="cnt">The length of <paramref name="name" /> in bytes.
+        /// </param>
+        /// <returns>A view of the member's value, which is invalid if the
+        /// value is not an object or has no such member.</returns>
+        json_view member(_In_reads_(cnt) const char *name,
+            _In_ const std::size_t cnt) const noexcept;
+
+        /// <summary>
+        /// Looks up the member with the given name if the value is an object.
+        /// </summary>
+        /// <param name="name">The null-terminated UTF-8-encoded name of the
+        /// member.</param>
+        /// <returns>A view of the member's value, which is invalid if the
+        /// value is not an object or has no such member.</returns>
+        inline json_view member(_In_z_ const char *name) const noexcept {
+            return (name != nullptr)
+                ? this->member(name, ::strlen(name))
+                : json_view();
+        }
+
+        /// <summary>
+        /// Answer the next element or member after this one in the enclosing
+        /// array or object.
+        /// </summary>
+        /// <returns>A view of the next sibling, which is invalid if this is
+        /// the last one.</returns>
+        json_view next(void) const noexcept;
+
+        /// <summary>
+        /// Answer the number of elements of an array or the number of members
+        /// of an object.
+        /// </summary>
+        /// <returns>The number of children, which is zero for all other
+        /// values.</returns>
+        std::size_t size(void) const noexcept;
+
+        /// <summary>
+        /// Interprets the value as Boolean.
+        /// </summary>
+        /// <returns>The value.</returns>
+        /// <exception cref="std::system_error">If the value is not a Boolean.
+        /// </exception>
+        bool to_boolean(void) const;
+
+        /// <summary>
+        /// Interprets the value as floating-point number.
+        /// </summary>
+        /// <returns>The value.</returns>
+        /// <exception cref="std::system_error">If the value is not a number.
+        /// </exception>
+        double to_double(void) const;
+
+        /// <summary>
+        /// Interprets the value as signed integer.
+        /// </summary>
+        /// <returns>The value.</returns>
+        /// <exception cref="std::system_error">If the value is not an integral
+        /// number or out of range.</exception>
+        std::int64_t to_int64(void) const;
+
+        /// <summary>
+        /// Retrieves the unescaped UTF-8 content of a string value.
+        /// </summary>
+        /// <param name="dst">A buffer receiving the null-terminated string.
+        /// It is safe to pass <c>nullptr</c> for measuring the required
+        /// buffer size.</param>
+        /// <param name="cnt">The size of <paramref name="dst" /> in bytes.
+        /// </param>
+        /// <returns>The required buffer size in bytes including the
+        /// terminating null.</returns>
+        /// <exception cref="std::system_error">If the value is not a string
+        /// or contains an invalid escape sequence.</exception>
+        std::size_t to_string(_Out_writes_opt_(cnt) char *dst,
+            _In_ const std::size_t cnt) const;
+
+        /// <summary>
+        /// Retrieves the unescaped UTF-8 content of a string value.
+        /// </summary>
+        /// <returns>The value.</returns>
+        /// <exception cref="std::system_error">If the value is not a string
+        /// or contains an invalid escape sequence.</exception>
+        inline std::string to_string(void) const {
+            std::vector<char> buffer(this->to_string(nullptr, 0));
+            const auto cnt = this->to_string(buffer.data(), buffer.size());
+            return std::string(buffer.data(), buffer.data() + cnt - 1);
+        }
+
+        /// <summary>
+        /// Interprets the value as unsigned integer.
+        /// </summary>
+        /// <returns>The value.</returns>
+        /// <exception cref="std::system_error">If the value is not an integral
+        /// number or out of range.</exception>
+        std::uint64_t to_uint64(void) const;
+
+        /// <summary>
+        /// Answer the type of the value.
+        /// </summary>
+        /// <remarks>
+        /// The type is derived from the first character of the value. It
+        /// does not imply that the value is well-formed.
+        /// </remarks>
+        /// <returns>The type of the value.</returns>
+        value_type type(void) const noexcept;
+
+        /// <summary>
+        /// Answer whether the view refers to a value.
+        /// </summary>
+        /// <returns><c>true</c> if the view is valid, <c>false</c> otherwise.
+        /// </returns>
+        inline bool valid(void) const noexcept {
+            return (this->_data != nullptr);
+        }
+
+        /// <summary>
+        /// Answer whether the view refers to a value.
+        /// </summary>
+        /// <returns><c>true</c> if the view is valid, <c>false</c> otherwise.
+        /// </returns>
+        inline operator bool(void) const noexcept {
+            return this->valid();
+        }
+
+    private:
+
+        json_view(_In_ const char *data,
+            _In_ const char *end,
+            _In_opt_ const char *key,
+            _In_ const std::size_t key_size,
+            _In_ const std::size_t size) noexcept;
+
+        const char *_data;
+        const char *_end;
+        const char *_key;
+        std::size_t _key_size;
+        std::size_t _size;
+    };
+
+} /* namespace dataverse */
+} /* namespace visus */
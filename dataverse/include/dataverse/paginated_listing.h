@@ -0,0 +1,217 @@
+﻿// <copyright file="paginated_listing.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <string>
+
+#include "dataverse/dataverse_connection.h"
+#include "dataverse/json_view.h"
+
+
+namespace visus {
+namespace dataverse {
+
+    /* Forward declarations. */
+    namespace detail { struct paginated_listing_impl; }
+
+    /// <summary>
+    /// A pull iterator over the elements of a listing that the API delivers
+    /// in pages, e.g. the files of a data set version.
+    /// </summary>
+    /// <remarks>
+    /// <para>The listing retrieves the resource page by page by appending the
+    /// &quot;limit&quot; and &quot;offset&quot; query parameters and
+    /// enumerates the elements of the &quot;data&quot; array of each page.
+    /// While the caller processes the current page, the listing fetches the
+    /// following ones in the background, but it never holds more than the
+    /// configured number of pages in memory. The listing ends with the first
+    /// page that has fewer elements than requested.</para>
+    /// <para>The listing is not thread-safe, i.e. it must only be iterated by
+    /// one thread at a time. The connection it was created for must live at
+    /// least as long as the listing.</para>
+    /// </remarks>
+    class DATAVERSE_API paginated_listing final {
+
+    public:
+
+        /// <summary>
+        /// The default number of elements requested per page.
+        /// </summary>
+        static constexpr std::size_t default_page_size = 1000;
+
+        /// <summary>
+        /// The default number of pages the listing holds in memory, including
+        /// the one being iterated and those being prefetched.
+        /// </summary>
+        static constexpr std::size_t default_max_pages = 2;
+
+        /// <summary>
+        /// Creates a listing of the files in the data set with the given ID.
+        /// </summary>
+        /// <param name="connection">The connection used to retrieve the pages.
+        /// </param>
+        /// <param name="id">The ID of the data set, which is unfortunately not
+        /// the persistent identifier, but the primary key.</param>
+        /// <param name="version">The version of the data set to retrieve, which
+        /// is typically something like &quot;1.0&quot; or one of the constants
+        /// like <see cref="dataverse_connection::latest_version" />.</param>
+        /// <param name="page_size">The number of files per page.</param>
+        /// <param name="max_pages">The maximum number of pages held in memory.
+        /// </param>
+        /// <returns>A listing of the files.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="page_size" /> or <paramref name="max_pages" /> is
+        /// zero.</exception>
+        static inline paginated_listing files(
+                _In_ dataverse_connection& connection,
+                _In_ const std::uint64_t id,
+                _In_z_ const wchar_t *version,
+                _In_ const std::size_t page_size = default_page_size,
+                _In_ const std::size_t max_pages = default_max_pages) {
+            const auto url = std::wstring(L"/datasets/") + std::to_wstring(id)
+                + std::wstring(L"/versions/") + version
+                + std::wstring(L"/files");
+            return paginated_listing(connection, url.c_str(), page_size,
+                max_pages);
+        }
+
+        /// <summary>
+        /// Creates a listing of the files in the data set with the given ID.
+        /// </summary>
+        /// <param name="connection">The connection used to retrieve the pages.
+        /// </param>
+        /// <param name="id">The ID of the data set, which is unfortunately not
+        /// the persistent identifier, but the primary key.</param>
+        /// <param name="version">The version of the data set to retrieve, which
+        /// is typically something like &quot;1.0&quot;.</param>
+        /// <param name="page_size">The number of files per page.</param>
+        /// <param name="max_pages">The maximum number of pages held in memory.
+        /// </param>
+        /// <returns>A listing of the files.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="page_size" /> or <paramref name="max_pages" /> is
+        /// zero.</exception>
+        static inline paginated_listing files(
+                _In_ dataverse_connection& connection,
+                _In_ const std::uint64_t id,
+                _In_ const const_narrow_string& version,
+                _In_ const std::size_t page_size = default_page_size,
+                _In_ const std::size_t max_pages = default_max_pages) {
+            const auto v = convert<wchar_t>(version);
+            return files(connection, id, v.c_str(), page_size, max_pages);
+        }
+
+        /// <summary>
+        /// Initialises a new listing of the given resource.
+        /// </summary>
+        /// <remarks>
+        /// The constructor starts retrieving the first pages right away.
+        /// </remarks>
+        /// <param name="connection">The connection used to retrieve the pages.
+        /// </param>
+        /// <param name="resource">The path to the resource, which may already
+        /// have a query string. The <see cref="dataverse_connection::base_path" />
+        /// will be prepended if it is set.</param>
+        /// <param name="page_size">The number of elements per page.</param>
+        /// <param name="max_pages">The maximum number of pages held in memory,
+        /// which must be at least one. If larger than one, the listing
+        /// prefetches pages while the caller iterates.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="page_size" /> or <paramref name="max_pages" /> is
+        /// zero.</exception>
+        /// <exception cref="std::system_error">If the first request failed
+        /// right away.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// requests could not be alloctated.</exception>
+        paginated_listing(_In_ dataverse_connection& connection,
+            _In_z_ const wchar_t *resource,
+            _In_ const std::size_t page_size = default_page_size,
+            _In_ const std::size_t max_pages = default_max_pages);
+
+        /// <summary>
+        /// Initialises a new listing of the given resource.
+        /// </summary>
+        /// <param name="connection">The connection used to retrieve the pages.
+        /// </param>
+        /// <param name="resource">The path to the resource, which may already
+        /// have a query string. The <see cref="dataverse_connection::base_path" />
+        /// will be prepended if it is set.</param>
+        /// <param name="page_size">The number of elements per page.</param>
+        /// <param name="max_pages">The maximum number of pages held in memory,
+        /// which must be at least one.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="page_size" /> or <paramref name="max_pages" /> is
+        /// zero.</exception>
+        /// <exception cref="std::system_error">If the first request failed
+        /// right away.</exception>
+        /// <exception cref="std::bad_alloc">If the memory required to build the
+        /// requests could not be alloctated.</exception>
+        paginated_listing(_In_ dataverse_connection& connection,
+            _In_ const const_narrow_string& resource,
+            _In_ const std::size_t page_size = default_page_size,
+            _In_ const std::size_t max_pages = default_max_pages);
+
+        /// <summary>
+        /// Initialise from move.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        paginated_listing(_Inout_ paginated_listing&& rhs) noexcept;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor blocks until all pending requests of the listing
+        /// have completed.
+        /// </remarks>
+        ~paginated_listing(void);
+
+        /// <summary>
+        /// Retrieves the next element of the listing.
+        /// </summary>
+        /// <remarks>
+        /// The method blocks if the page holding the next element has not yet
+        /// been received.
+        /// </remarks>
+        /// <param name="element">Receives a view of the next element. The view
+        /// refers to memory owned by the listing and is only valid until the
+        /// next call to <see cref="next" />.</param>
+        /// <returns><c>true</c> if <paramref name="element" /> has been set,
+        /// <c>false</c> if the listing has been enumerated completely.
+        /// </returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        /// <exception cref="std::runtime_error">If retrieving a page failed.
+        /// </exception>
+        bool next(_Out_ json_view& element);
+
+        /// <summary>
+        /// Answer the number of pages currently held in memory, including the
+        /// ones being received.
+        /// </summary>
+        /// <returns>The number of pages held by the listing.</returns>
+        /// <exception cref="std::system_error">If the method was called on an
+        /// object that has been moved.</exception>
+        std::size_t pages(void) const;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operant.</param>
+        /// <returns><c>*this</c>.</returns>
+        paginated_listing& operator =(_Inout_ paginated_listing&& rhs) noexcept;
+
+    private:
+
+        detail::paginated_listing_impl& check_not_disposed(void) const;
+
+        detail::paginated_listing_impl *_impl;
+    };
+
+} /* namespace dataverse */
+} /* namespace visus */
@@ -0,0 +1,65 @@
+﻿// <copyright file="transfer_progress.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+
+namespace visus {
+namespace dataverse {
+
+    /// <summary>
+    /// Describes the progress of a single transfer or of all transfers of a
+    /// connection.
+    /// </summary>
+    struct transfer_progress final {
+
+        /// <summary>
+        /// The number of bytes received so far.
+        /// </summary>
+        std::uint64_t bytes_received;
+
+        /// <summary>
+        /// The number of bytes sent so far.
+        /// </summary>
+        std::uint64_t bytes_sent;
+
+        /// <summary>
+        /// The number of bytes expected to be received, which is zero as
+        /// long as the size of the response is unknown.
+        /// </summary>
+        std::uint64_t total_receive;
+
+        /// <summary>
+        /// The number of bytes to be sent, which is zero if the size of the
+        /// request is unknown, e.g. because it is being streamed.
+        /// </summary>
+        std::uint64_t total_send;
+
+        /// <summary>
+        /// The estimated time in seconds until the transfer completes, which
+        /// is based on the sizes known so far and on the current
+        /// <see cref="rate" />. If the time cannot be estimated, e.g. because
+        /// nothing has been transferred since the last report, this is
+        /// negative.
+        /// </summary>
+        double eta;
+
+        /// <summary>
+        /// The current rate in bytes per second in both directions.
+        /// </summary>
+        double rate;
+
+        /// <summary>
+        /// The number of transfers described, which is one for a single
+        /// request.
+        /// </summary>
+        std::size_t transfers;
+    };
+
+} /* namespace dataverse */
+} /* namespace visus */
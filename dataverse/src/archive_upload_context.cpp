@@ -0,0 +1,69 @@
+﻿// <copyright file="archive_upload_context.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "archive_upload_context.h"
+
+#include <cassert>
+#include <memory>
+
+
+/*
+ * visus::dataverse::detail::archive_upload_context::forward_error
+ */
+void visus::dataverse::detail::archive_upload_context::forward_error(
+        _In_ const int error_code,
+        _In_z_ const char *message,
+        _In_z_ const char *category,
+        _In_ const narrow_string::code_page_type code_page,
+        _In_opt_ void *context) {
+    std::unique_ptr<archive_upload_context> that(
+        static_cast<archive_upload_context *>(context));
+    assert(that != nullptr);
+    assert(that->on_error != nullptr);
+
+    if (that->archive.error() == nullptr) {
+        that->on_error(error_code, message, category, code_page,
+            that->user_context);
+        return;
+    }
+
+    try {
+        std::rethrow_exception(that->archive.error());
+    } catch (std::system_error ex) {
+        invoke_handler(that->on_error, ex, that->user_context);
+    } catch (std::exception& ex) {
+        invoke_handler(that->on_error, ex, that->user_context);
+    } catch (...) {
+        invoke_handler(that->on_error, that->user_context);
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::archive_upload_context::forward_response
+ */
+void visus::dataverse::detail::archive_upload_context::forward_response(
+        _In_ const blob& response,
+        _In_opt_ void *context) {
+    std::unique_ptr<archive_upload_context> that(
+        static_cast<archive_upload_context *>(context));
+    assert(that != nullptr);
+    assert(that->on_response != nullptr);
+    that->on_response(response, that->user_context);
+}
+
+
+/*
+ * ...::detail::archive_upload_context::archive_upload_context
+ */
+visus::dataverse::detail::archive_upload_context::archive_upload_context(
+        _In_ const archive_compression compression,
+        _In_ const dataverse_connection::on_response_type on_response,
+        _In_ dataverse_connection::on_error_type on_error,
+        _In_opt_ void *context)
+    : archive(compression),
+        on_error(on_error),
+        on_response(on_response),
+        user_context(context) { }
@@ -0,0 +1,83 @@
+﻿// <copyright file="archive_upload_context.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "dataverse/dataverse_connection.h"
+
+#include "invoke_handler.h"
+#include "zip_stream.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// The context of an upload of many local files that are bundled into a
+    /// ZIP archive while they are being sent.
+    /// </summary>
+    /// <remarks>
+    /// The <see cref="archive" /> is passed to curl as the source of the file
+    /// field of the form, whereas the context itself is the context of the
+    /// request.
+    /// </remarks>
+    struct archive_upload_context final {
+
+        /// <summary>
+        /// Forwards the error to <see cref="on_error" /> and deletes the
+        /// <paramref name="context" />.
+        /// </summary>
+        /// <remarks>
+        /// If the transfer has been aborted, because the archive could not be
+        /// built, the reason for that is reported instead of the error of
+        /// curl.
+        /// </remarks>
+        static void forward_error(_In_ const int error_code,
+            _In_z_ const char *message,
+            _In_z_ const char *category,
+            _In_ const narrow_string::code_page_type code_page,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Forwards the response to <see cref="on_response" /> and deletes the
+        /// <paramref name="context" />.
+        /// </summary>
+        static void forward_response(_In_ const blob& response,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// The archive that is being sent.
+        /// </summary>
+        zip_stream archive;
+
+        /// <summary>
+        /// The error handler installed by the caller.
+        /// </summary>
+        dataverse_connection::on_error_type on_error;
+
+        /// <summary>
+        /// The final result handler installed by the caller.
+        /// </summary>
+        dataverse_connection::on_response_type on_response;
+
+        /// <summary>
+        /// The user-specified context pointer to be passed to
+        /// <see cref="on_error" /> and <see cref="on_response" />.
+        /// </summary>
+        void *user_context;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        archive_upload_context(_In_ const archive_compression compression,
+            _In_ const dataverse_connection::on_response_type on_response,
+            _In_ dataverse_connection::on_error_type on_error,
+            _In_opt_ void *context);
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
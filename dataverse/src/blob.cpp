@@ -14,7 +14,7 @@
  * visus::dataverse::blob::blob
  */
 visus::dataverse::blob::blob(_In_ const blob& rhs)
-        : _data(nullptr), _size(rhs._size) {
+        : _capacity(rhs._size), _data(nullptr), _size(rhs._size) {
     if (rhs._data != nullptr) {
         this->_data = new byte_type[this->_size];
         ::memcpy(this->_data, rhs._data, this->_size);
@@ -28,7 +28,8 @@ visus::dataverse::blob::blob(_In_ const blob& rhs)
  * visus::dataverse::blob::blob
  */
 visus::dataverse::blob::blob(_Inout_ blob&& rhs) noexcept
-        : _data(rhs._data), _size(rhs._size) {
+        : _capacity(rhs._capacity), _data(rhs._data), _size(rhs._size) {
+    rhs._capacity = 0;
     rhs._data = nullptr;
     rhs._size = 0;
     assert(rhs._data == nullptr);
@@ -73,6 +74,7 @@ _Ret_maybenull_ const void *visus::dataverse::blob::at(
  */
 void visus::dataverse::blob::clear(void) {
     delete[] this->_data;
+    this->_capacity = 0;
     this->_data = nullptr;
     this->_size = 0;
 }
@@ -104,19 +106,23 @@ visus::dataverse::blob::end(void) const noexcept {
  * visus::dataverse::blob::grow
  */
 bool visus::dataverse::blob::grow(_In_ const std::size_t size) {
-    const auto retval = (size > this->_size);
+    const auto retval = (size > this->_capacity);
 
     if (retval) {
         const auto existing = this->_data;
         this->_data = new byte_type[size];
+        this->_capacity = size;
 
         if (existing != nullptr) {
             ::memcpy(this->_data, existing, this->_size);
             delete[] existing;
-            this->_size = size;
         }
     }
 
+    if (size > this->_size) {
+        this->_size = size;
+    }
+
     return retval;
 }
 
@@ -169,12 +175,18 @@ visus::dataverse::blob::rend(void) const noexcept {
  * visus::dataverse::blob::reserve
  */
 bool visus::dataverse::blob::reserve(_In_ const std::size_t size) {
-    const auto retval = (size > this->_size);
+    const auto retval = (size > this->_capacity);
 
     if (retval) {
         delete[] this->_data;
+        this->_data = nullptr;
+        this->_capacity = 0;
+        this->_data = new byte_type[size];
+        this->_capacity = size;
+    }
+
+    if (size > this->_size) {
         this->_size = size;
-        this->_data = new byte_type[this->_size];
     }
 
     return retval;
@@ -185,16 +197,16 @@ bool visus::dataverse::blob::reserve(_In_ const std::size_t size) {
  * visus::dataverse::blob::resize
  */
 void visus::dataverse::blob::resize(_In_ const std::size_t size) {
-    if (this->_size != size) {
+    if (size > this->_capacity) {
         delete[] this->_data;
-        this->_size = size;
-
-        if (this->_size > 0) {
-            this->_data = new byte_type[this->_size];
-        } else {
-            this->_data = nullptr;
-        }
+        this->_data = nullptr;
+        this->_capacity = 0;
+        this->_size = 0;
+        this->_data = new byte_type[size];
+        this->_capacity = size;
     }
+
+    this->_size = size;
 }
 
 
@@ -202,22 +214,24 @@ void visus::dataverse::blob::resize(_In_ const std::size_t size) {
  * visus::dataverse::blob::truncate
  */
 void visus::dataverse::blob::truncate(_In_ const std::size_t size) {
-    if (this->_size != size) {
+    if (size > this->_capacity) {
+        // Grow geometrically such that appending to the blob piece by piece,
+        // which is what happens while receiving a response, does not
+        // reallocate for every chunk.
+        const auto capacity = (std::max)(size,
+            this->_capacity + this->_capacity / 2);
         const auto existing = this->_data;
+        this->_data = new byte_type[capacity];
+        this->_capacity = capacity;
 
-        if (size > 0) {
-            this->_data = new byte_type[size];
-        } else {
-            this->_data = nullptr;
-        }
-
-        if ((this->_data != nullptr) && (existing != nullptr)) {
-            ::memcpy(this->_data, existing, (std::min)(this->_size, size));
+        if (existing != nullptr) {
+            ::memcpy(this->_data, existing, this->_size);
         }
 
         delete[] existing;
-        this->_size = size;
     }
+
+    this->_size = size;
 }
 
 
@@ -227,18 +241,19 @@ void visus::dataverse::blob::truncate(_In_ const std::size_t size) {
 visus::dataverse::blob& visus::dataverse::blob::operator =(
         _In_ const blob& rhs) {
     if (this != std::addressof(rhs)) {
-        if ((this->_data != nullptr) && (this->_size != rhs._size)) {
+        if (rhs._size > this->_capacity) {
             delete[] this->_data;
             this->_data = nullptr;
+            this->_capacity = 0;
         }
 
         this->_size = rhs._size;
         if ((this->_data == nullptr) && (rhs._data != nullptr)) {
             this->_data = new byte_type[this->_size];
+            this->_capacity = this->_size;
         }
 
-        if (this->_data != nullptr) {
-            assert(rhs._data != nullptr);
+        if ((this->_data != nullptr) && (rhs._data != nullptr)) {
             ::memcpy(this->_data, rhs._data, this->_size);
         }
     }
@@ -256,6 +271,9 @@ visus::dataverse::blob& visus::dataverse::blob::operator =(
 visus::dataverse::blob& visus::dataverse::blob::operator =(
         _Inout_ blob&& rhs) noexcept {
     if (this != std::addressof(rhs)) {
+        delete[] this->_data;
+        this->_capacity = rhs._capacity;
+        rhs._capacity = 0;
         this->_data = rhs._data;
         rhs._data = nullptr;
         this->_size = rhs._size;
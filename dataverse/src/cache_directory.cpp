@@ -0,0 +1,218 @@
+﻿// <copyright file="cache_directory.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "cache_directory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+#include "dataverse/convert.h"
+
+#include "on_exit.h"
+
+
+/*
+ * visus::dataverse::detail::cache_directory::create
+ */
+std::wstring visus::dataverse::detail::cache_directory::create(
+        _In_ const std::wstring& directory) {
+    std::wstring retval(directory);
+
+    if (!retval.empty()) {
+#if defined(_WIN32)
+        if (!::CreateDirectoryW(retval.c_str(), nullptr)) {
+            const auto error = ::GetLastError();
+            if (error != ERROR_ALREADY_EXISTS) {
+                throw std::system_error(error, std::system_category());
+            }
+        }
+
+        if ((retval.back() != L'\\') && (retval.back() != L'/')) {
+            retval += L'\\';
+        }
+#else /* defined(_WIN32) */
+        if (::mkdir(convert<char>(retval, nullptr).c_str(), 0700) != 0) {
+            if (errno != EEXIST) {
+                throw std::system_error(errno, std::system_category());
+            }
+        }
+
+        if (retval.back() != L'/') {
+            retval += L'/';
+        }
+#endif /* defined(_WIN32) */
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::cache_directory::temporary
+ */
+std::wstring visus::dataverse::detail::cache_directory::temporary(
+        _In_ const std::wstring& path) {
+    // The process ID separates processes sharing the directory, and the
+    // counter separates all files written by this process, even if they are
+    // started on the same thread or by different connections.
+    static std::atomic<std::uint64_t> counter(0);
+
+    std::wstring retval(path);
+    retval += L'.';
+#if defined(_WIN32)
+    retval += std::to_wstring(::GetCurrentProcessId());
+#else /* defined(_WIN32) */
+    retval += std::to_wstring(::getpid());
+#endif /* defined(_WIN32) */
+    retval += L'.';
+    retval += std::to_wstring(counter++);
+    retval += L".tmp";
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::cache_directory::touch
+ */
+void visus::dataverse::detail::cache_directory::touch(
+        _In_ const std::wstring& path) noexcept {
+#if defined(_WIN32)
+    auto file = ::CreateFileW(path.c_str(), FILE_WRITE_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, 0, NULL);
+    if (file != INVALID_HANDLE_VALUE) {
+        FILETIME now;
+        ::GetSystemTimeAsFileTime(&now);
+        ::SetFileTime(file, nullptr, nullptr, &now);
+        ::CloseHandle(file);
+    }
+#else /* defined(_WIN32) */
+    try {
+        ::utimes(convert<char>(path, nullptr).c_str(), nullptr);
+    } catch (...) { /* This is only a hint for trimming the cache. */ }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::dataverse::detail::cache_directory::trim
+ */
+visus::dataverse::detail::cache_directory::usage_type
+visus::dataverse::detail::cache_directory::trim(
+        _In_ const std::wstring& directory,
+        _In_ const std::uint64_t capacity) noexcept {
+    typedef std::tuple<std::uint64_t, std::uint64_t, std::wstring> file_type;
+    std::vector<file_type> files;
+    usage_type retval { 0, 0, 0 };
+
+    if (directory.empty()) {
+        return retval;
+    }
+
+    try {
+        // Collect the last write time and the size of all complete files.
+        // Temporary files and their checkpoints belong to transfers in
+        // progress, possibly in other processes, and must not be touched.
+        auto is_complete = [](const std::wstring& name) {
+            static const std::wstring tmp(L".tmp");
+            static const std::wstring checkpoint(L".checkpoint");
+            auto ends_with = [&name](const std::wstring& suffix) {
+                return (name.size() >= suffix.size())
+                    && (name.compare(name.size() - suffix.size(),
+                    suffix.size(), suffix) == 0);
+            };
+            return (name != L".") && (name != L"..")
+                && !ends_with(tmp) && !ends_with(checkpoint);
+        };
+
+#if defined(_WIN32)
+        WIN32_FIND_DATAW data;
+        auto h = ::FindFirstFileW((directory + L"*").c_str(), &data);
+        if (h == INVALID_HANDLE_VALUE) {
+            return retval;
+        }
+        on_exit([h](void) { ::FindClose(h); });
+
+        do {
+            const std::wstring name(data.cFileName);
+            if (((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+                    && is_complete(name)) {
+                ULARGE_INTEGER time, length;
+                time.LowPart = data.ftLastWriteTime.dwLowDateTime;
+                time.HighPart = data.ftLastWriteTime.dwHighDateTime;
+                length.LowPart = data.nFileSizeLow;
+                length.HighPart = data.nFileSizeHigh;
+                files.emplace_back(time.QuadPart, length.QuadPart, name);
+                retval.size += length.QuadPart;
+            }
+        } while (::FindNextFileW(h, &data));
+
+#else /* defined(_WIN32) */
+        const auto d = convert<char>(directory, nullptr);
+        auto dir = ::opendir(d.c_str());
+        if (dir == nullptr) {
+            return retval;
+        }
+        on_exit([dir](void) { ::closedir(dir); });
+
+        while (auto entry = ::readdir(dir)) {
+            const std::string n(entry->d_name);
+            const auto name = convert<wchar_t>(n, nullptr);
+            struct stat s;
+
+            if (is_complete(name)
+                    && (::stat((d + n).c_str(), &s) == 0)
+                    && S_ISREG(s.st_mode)) {
+                files.emplace_back(static_cast<std::uint64_t>(s.st_mtime),
+                    static_cast<std::uint64_t>(s.st_size), name);
+                retval.size += s.st_size;
+            }
+        }
+#endif /* defined(_WIN32) */
+
+        // Remove the least recently used files from the front of the list
+        // until we are within budget and drop all of them from the list at
+        // once afterwards.
+        auto last = files.begin();
+        if (retval.size > capacity) {
+            std::sort(files.begin(), files.end());
+
+            for (; (last != files.end()) && (retval.size > capacity); ++last) {
+                const auto path = directory + std::get<2>(*last);
+#if defined(_WIN32)
+                const auto removed = (::DeleteFileW(path.c_str()) != FALSE);
+#else /* defined(_WIN32) */
+                const auto removed = (::unlink(convert<char>(path,
+                    nullptr).c_str()) == 0);
+#endif /* defined(_WIN32) */
+                // If another process has already removed the file, we still
+                // need to account for it being gone.
+                retval.size -= std::get<1>(*last);
+                if (removed) {
+                    ++retval.evictions;
+                }
+            }
+        }
+        files.erase(files.begin(), last);
+
+        retval.entries = files.size();
+    } catch (...) { /* The cache is a best effort. */ }
+
+    return retval;
+}
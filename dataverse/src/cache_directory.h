@@ -0,0 +1,85 @@
+﻿// <copyright file="cache_directory.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+
+#include "dataverse/api.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// Utilities for the directories of <see cref="disk_cache" /> and
+    /// <see cref="download_cache" />, which can be shared by multiple
+    /// processes.
+    /// </summary>
+    /// <remarks>
+    /// Files are written to a <see cref="temporary" /> name first and renamed
+    /// once they are complete. The last write time of a file is used as the
+    /// time it has been used the last time, which is why hits must
+    /// <see cref="touch" /> the file.
+    /// </remarks>
+    struct cache_directory final {
+
+        /// <summary>
+        /// The result of <see cref="trim" />.
+        /// </summary>
+        struct usage_type {
+            std::size_t entries;
+            std::uint64_t evictions;
+            std::uint64_t size;
+        };
+
+        /// <summary>
+        /// Creates the given directory if it does not exist.
+        /// </summary>
+        /// <returns>The path of the directory with a trailing separator, or
+        /// an empty string if <paramref name="directory" /> is empty.
+        /// </returns>
+        /// <exception cref="std::system_error">If the directory could not be
+        /// created.</exception>
+        static std::wstring create(_In_ const std::wstring& directory);
+
+        /// <summary>
+        /// Answer a unique location for writing the file that should be
+        /// stored at <paramref name="path" />.
+        /// </summary>
+        /// <remarks>
+        /// The name is unique across all processes and across all threads
+        /// and requests of this process.
+        /// </remarks>
+        static std::wstring temporary(_In_ const std::wstring& path);
+
+        /// <summary>
+        /// Marks the file at <paramref name="path" /> as recently used.
+        /// </summary>
+        static void touch(_In_ const std::wstring& path) noexcept;
+
+        /// <summary>
+        /// Removes the least recently used files from
+        /// <paramref name="directory" /> until their total size is not larger
+        /// than <paramref name="capacity" />.
+        /// </summary>
+        /// <remarks>
+        /// Temporary files and download checkpoints belong to transfers in
+        /// progress and are neither counted nor removed. The method is a best
+        /// effort and never fails.
+        /// </remarks>
+        /// <returns>The files remaining in the directory and the number of
+        /// files that have been removed.</returns>
+        static usage_type trim(_In_ const std::wstring& directory,
+            _In_ const std::uint64_t capacity) noexcept;
+
+        cache_directory(void) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
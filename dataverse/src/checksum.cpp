@@ -0,0 +1,52 @@
+﻿// <copyright file="checksum.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "dataverse/checksum.h"
+
+#include <cassert>
+#include <cstring>
+#include <system_error>
+
+#include "dataverse/convert.h"
+
+#include "hash_context.h"
+#include "io_context.h"
+
+
+/*
+ * visus::dataverse::file_checksum
+ */
+std::size_t visus::dataverse::file_checksum(
+        _Out_writes_to_opt_(cnt_dst, return) char *dst,
+        _In_ const std::size_t cnt_dst,
+        _In_z_ const wchar_t *path,
+        _In_z_ const char *algorithm) {
+    detail::hash_context hash(algorithm);
+    auto file = detail::io_context::open_file(path);
+    hash.update_file(file.get());
+
+    const auto checksum = hash.finish();
+    const auto retval = checksum.size() + 1;
+    assert(retval <= max_checksum_length);
+
+    if ((dst != nullptr) && (cnt_dst >= retval)) {
+        ::memcpy(dst, checksum.c_str(), retval);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::file_checksum
+ */
+std::size_t visus::dataverse::file_checksum(
+        _Out_writes_to_opt_(cnt_dst, return) char *dst,
+        _In_ const std::size_t cnt_dst,
+        _In_ const const_narrow_string& path,
+        _In_z_ const char *algorithm) {
+    const auto p = convert<wchar_t>(path);
+    return file_checksum(dst, cnt_dst, p.c_str(), algorithm);
+}
@@ -0,0 +1,57 @@
+﻿// <copyright file="coalesced_request.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <vector>
+
+#include "dataverse/dataverse_connection.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /* Forward declarations. */
+    struct io_context;
+
+
+    /// <summary>
+    /// Bookkeeping for a GET request in flight that other requests for the
+    /// same resource can attach to.
+    /// </summary>
+    struct coalesced_request final {
+
+        /// <summary>
+        /// The callbacks of a request that has been attached to the one in
+        /// flight instead of being sent.
+        /// </summary>
+        struct waiter final {
+            void *client_data;
+            void *on_api_response;
+            dataverse_connection::on_error_type on_error;
+            dataverse_connection::on_response_type on_response;
+        };
+
+        /// <summary>
+        /// The API key the request has been sent with. Requests must only be
+        /// coalesced if they use the same credentials.
+        /// </summary>
+        std::vector<char> api_key;
+
+        /// <summary>
+        /// The context that is actually being transferred.
+        /// </summary>
+        io_context *leader;
+
+        /// <summary>
+        /// The requests waiting for <see cref="leader" /> to complete.
+        /// </summary>
+        std::vector<waiter> waiters;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
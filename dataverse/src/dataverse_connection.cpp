@@ -16,10 +16,15 @@
 #include <fcntl.h>
 #endif /* defined(_WIN32) */
 
+#include "archive_upload_context.h"
 #include "dataverse_connection_impl.h"
+#include "direct_upload_batch.h"
 #include "direct_upload_context.h"
+#include "download_context.h"
 #include "file_properties.h"
+#include "hash_context.h"
 #include "io_context.h"
+#include "stream_upload_context.h"
 
 
 #define _CHECK_API_ON_RESPONSE if (on_api_response == nullptr) \
@@ -31,9 +36,84 @@
 #define _CHECK_ON_ERROR if (on_error == nullptr) \
     throw std::invalid_argument("The error handler must be valid.")
 
-#define _DATAVERSE_HASH_ALGORITHMA "MD5"
 
-#define _DATAVERSE_HASH_ALGORITHMW L"MD5"
+namespace {
+
+    /// <summary>
+    /// The type of the wide-string methods uploading multiple files directly
+    /// to S3.
+    /// </summary>
+    typedef visus::dataverse::dataverse_connection& (
+        visus::dataverse::dataverse_connection:: *direct_upload_type)(
+        const wchar_t *,
+        const wchar_t **,
+        const std::size_t,
+        const wchar_t *,
+        const wchar_t *,
+        const bool,
+        const visus::dataverse::dataverse_connection::on_response_type,
+        const visus::dataverse::dataverse_connection::on_error_type,
+        void *);
+
+    /// <summary>
+    /// Converts the narrow-string arguments of a direct upload of multiple
+    /// files and forwards them to the wide-string variant
+    /// <paramref name="upload" /> of <paramref name="that" />.
+    /// </summary>
+    visus::dataverse::dataverse_connection& narrow_direct_upload(
+            _In_ visus::dataverse::dataverse_connection& that,
+            _In_ const direct_upload_type upload,
+            _In_ const visus::dataverse::const_narrow_string& persistent_id,
+            _In_reads_(cnt) const visus::dataverse::const_narrow_string *paths,
+            _In_ const std::size_t cnt,
+            _In_ const visus::dataverse::const_narrow_string& mime_type,
+            _In_ const visus::dataverse::const_narrow_string& directory,
+            _In_ const bool restricted,
+            _In_ const visus::dataverse::dataverse_connection::on_response_type
+                on_response,
+            _In_ const visus::dataverse::dataverse_connection::on_error_type
+                on_error,
+            _In_opt_ void *context) {
+        using visus::dataverse::const_narrow_string;
+        using visus::dataverse::convert;
+
+        if ((paths == nullptr) && (cnt > 0)) {
+            throw std::invalid_argument("The paths of the files to be "
+                "uploaded must be valid.");
+        }
+
+        auto i = convert<wchar_t>(persistent_id);
+        auto m = (mime_type.value() != nullptr)
+            ? convert<wchar_t>(mime_type)
+            : std::wstring();
+        auto d = convert<wchar_t>(directory);
+
+        std::vector<std::wstring> files;
+        files.reserve(cnt);
+        std::transform(paths,
+            paths + cnt,
+            std::back_inserter(files),
+            [](const const_narrow_string& s) { return convert<wchar_t>(s); });
+
+        std::vector<const wchar_t *> file_ptrs;
+        file_ptrs.reserve(files.size());
+        std::transform(files.begin(),
+            files.end(),
+            std::back_inserter(file_ptrs),
+            [](const std::wstring& s) { return s.c_str(); });
+
+        return (that.*upload)(i.c_str(),
+            file_ptrs.data(),
+            file_ptrs.size(),
+            (mime_type.value() != nullptr) ? m.c_str() : nullptr,
+            d.c_str(),
+            restricted,
+            on_response,
+            on_error,
+            context);
+    }
+
+} /* namespace */
 
 
 /*
@@ -58,6 +138,14 @@ const wchar_t *const visus::dataverse::dataverse_connection::latest_version
     = L":latest";
 
 
+/*
+ * visus::dataverse::dataverse_connection::retained_memory
+ */
+std::size_t visus::dataverse::dataverse_connection::retained_memory(void) {
+    return detail::io_context::retained_memory();
+}
+
+
 /*
  * visus::dataverse::dataverse_connection::dataverse_connection
  */
@@ -82,6 +170,50 @@ visus::dataverse::dataverse_connection::~dataverse_connection(void) {
 }
 
 
+/*
+ * visus::dataverse::dataverse_connection::accept_encoding
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::accept_encoding(
+        _In_opt_z_ const wchar_t *encodings) {
+    auto& i = this->check_not_disposed();
+
+    if (encodings != nullptr) {
+        const auto len = ::wcslen(encodings);
+        i.accept_encoding.resize(len + 1);
+        to_ascii(i.accept_encoding.data(), i.accept_encoding.size(),
+            encodings, static_cast<int>(len));
+        i.accept_encoding.back() = 0;
+    } else {
+        i.accept_encoding.clear();
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::accept_encoding
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::accept_encoding(
+        _In_ const const_narrow_string& encodings) {
+    auto& i = this->check_not_disposed();
+
+    if (encodings != nullptr) {
+        const auto len = ::strlen(encodings);
+        i.accept_encoding.resize(len + 1);
+        to_ascii(i.accept_encoding.data(), i.accept_encoding.size(),
+            encodings, static_cast<int>(len), encodings.code_page());
+        i.accept_encoding.back() = 0;
+    } else {
+        i.accept_encoding.clear();
+    }
+
+    return *this;
+}
+
+
 /*
  * visus::dataverse::dataverse_connection::api_key
  */
@@ -184,269 +316,1141 @@ visus::dataverse::dataverse_connection::base_path(
 
 
 /*
- * visus::dataverse::dataverse_connection::data_set
+ * visus::dataverse::dataverse_connection::cached_download
  */
 visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::data_set(
-        _In_z_ const wchar_t *persistent_id,
+visus::dataverse::dataverse_connection::cached_download(
+        _In_ const std::uint64_t id,
+        _In_z_ const wchar_t *format,
+        _In_z_ const wchar_t *checksum_type,
+        _In_z_ const wchar_t *checksum,
+        _In_z_ const wchar_t *path,
         _In_ const on_response_type on_response,
         _In_ const on_error_type on_error,
         _In_opt_ void *context) {
-    const auto url = std::wstring(L"/datasets/:persistentId/?"
-        L"persistentId=") + persistent_id;
-    this->get(url.c_str(), on_response, nullptr, on_error, context);
-    return *this;
-}
+    using detail::download_cache;
+    _CHECK_ON_RESPONSE;
+    _CHECK_ON_ERROR;
 
+    if (checksum_type == nullptr) {
+        throw std::invalid_argument("The type of the checksum must be "
+            "valid.");
+    }
+    if (checksum == nullptr) {
+        throw std::invalid_argument("The checksum of the file must be "
+            "valid.");
+    }
+    if (path == nullptr) {
+        throw std::invalid_argument("The path of the output file must be "
+            "valid.");
+    }
 
-/*
- * visus::dataverse::dataverse_connection::data_set
- */
-visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::data_set(
-        _In_ const const_narrow_string& persistent_id,
-        _In_ const on_response_type on_response,
-            _In_ const on_error_type on_error,
-        _In_opt_ void *context) {
-    const auto url = std::wstring(L"/datasets/:persistentId/?"
-        L"persistentId=") + convert<wchar_t>(persistent_id);
-    this->get(url.c_str(), on_response, nullptr, on_error, context);
-    return *this;
-}
+    auto& i = this->check_not_disposed();
 
+    if (!i.downloads.enabled()) {
+        return this->download(id, format, path, false, on_response, on_error,
+            context);
+    }
 
-/*
- * visus::dataverse::dataverse_connection::download
- */
-visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::download(_In_ const std::uint64_t id,
-        _In_z_ const wchar_t *format,
-        _In_ const on_response_type on_response,
-        _In_ const on_error_type on_error,
-        _In_opt_ void *context) {
-    const auto url = std::wstring(L"/access/datafile/") + std::to_wstring(id)
-        + std::wstring(L"?format=") + std::wstring(format);
-    this->get(url.c_str(), on_response, nullptr, on_error, context);
-    return *this;
-}
+    const auto cached = i.downloads.path(id, format, checksum_type,
+        checksum);
 
+    if (i.downloads.lookup(cached, path)) {
+        // The file is already in place, so we only need to report this on
+        // the I/O thread like any other completed request.
+        auto ctx = detail::io_context::create(std::string(), on_response,
+            on_error, context);
+        ctx->cache_hit = true;
+        ctx->cached_response = std::make_shared<blob>();
+        i.process_cached(std::move(ctx));
+        return *this;
+    }
 
-/*
- * visus::dataverse::dataverse_connection::download
- */
-visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::download(_In_ const std::uint64_t id,
-        _In_ const const_narrow_string& format,
-        _In_ const on_response_type on_response,
-        _In_ const on_error_type on_error,
-        _In_opt_ void *context) {
-    const auto url = std::wstring(L"/access/datafile/") + std::to_wstring(id)
-        + std::wstring(L"?format=") + convert<wchar_t>(format);
-    this->get(url.c_str(), on_response, nullptr, on_error, context);
-    return *this;
-}
+    // Download into a temporary file in the cache, which is moved into place
+    // once it is complete. The data are hashed while they are written, and
+    // the download context reports a mismatch as error, in which case the
+    // temporary file is discarded rather than committed. The fill context
+    // must be passed to the API or freed in case of an error.
+    auto fill = new download_cache::fill_context();
+    fill->cache = &i.downloads;
+    fill->destination = path;
+    fill->on_error = on_error;
+    fill->on_response = on_response;
+    fill->path = cached;
+    fill->temporary = i.downloads.temporary(cached);
+    fill->user_context = context;
 
+    try {
+        this->download(id, format, checksum_type, checksum,
+            fill->temporary.c_str(), false, download_cache::complete,
+            download_cache::forward_error, fill);
+    } catch (...) {
+        delete fill;
+        throw;
+    }
 
-/*
- * visus::dataverse::dataverse_connection::files
- */
-visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::files(_In_z_ const std::uint64_t id,
-        _In_z_ const wchar_t *version,
-        _In_ const on_response_type on_response,
-        _In_ const on_error_type on_error,
-        _In_opt_ void *context) {
-    const auto url = std::wstring(L"/datasets/") + std::to_wstring(id)
-        + std::wstring(L"/versions/") + version
-        + std::wstring(L"/files");
-    this->get(url.c_str(), on_response, nullptr, on_error, context);
     return *this;
 }
 
 
 /*
- * visus::dataverse::dataverse_connection::download
+ * visus::dataverse::dataverse_connection::cached_download
  */
 visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::download(
-        _In_z_ const wchar_t *persistent_id,
-        _In_z_ const wchar_t *format,
-        _In_z_ const wchar_t *version,
+visus::dataverse::dataverse_connection::cached_download(
+        _In_ const std::uint64_t id,
+        _In_ const const_narrow_string& format,
+        _In_ const const_narrow_string& checksum_type,
+        _In_ const const_narrow_string& checksum,
+        _In_ const const_narrow_string& path,
         _In_ const on_response_type on_response,
         _In_ const on_error_type on_error,
         _In_opt_ void *context) {
-    const auto url = std::wstring(L"/access/datafile/:persistentId"
-        L"?persistentId=") + std::wstring(persistent_id)
-        + std::wstring(L"&version=") + std::wstring(version)
-        + std::wstring(L"&format=") + std::wstring(format);
-    this->get(url.c_str(), on_response, nullptr, on_error, context);
-    return *this;
+    if (checksum_type == nullptr) {
+        throw std::invalid_argument("The type of the checksum must be "
+            "valid.");
+    }
+    if (checksum == nullptr) {
+        throw std::invalid_argument("The checksum of the file must be "
+            "valid.");
+    }
+    if (path == nullptr) {
+        throw std::invalid_argument("The path of the output file must be "
+            "valid.");
+    }
+
+    const auto f = convert<wchar_t>(format);
+    const auto t = convert<wchar_t>(checksum_type);
+    const auto c = convert<wchar_t>(checksum);
+    const auto p = convert<wchar_t>(path);
+    return this->cached_download(id, f.c_str(), t.c_str(), c.c_str(),
+        p.c_str(), on_response, on_error, context);
 }
 
 
 /*
- * visus::dataverse::dataverse_connection::download
+ * visus::dataverse::dataverse_connection::checksum_algorithm
  */
 visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::download(
-        _In_ const const_narrow_string& persistent_id,
-        _In_ const const_narrow_string& format,
-        _In_ const const_narrow_string& version,
-        _In_ const on_response_type on_response,
-        _In_ const on_error_type on_error,
-        _In_opt_ void *context) {
-    const auto url = std::wstring(L"/access/datafile/:persistentId"
-        L"?persistentId=") + convert<wchar_t>(persistent_id)
-        + std::wstring(L"&version=") + convert<wchar_t>(version)
-        + std::wstring(L"&format=") + convert<wchar_t>(format);
-    this->get(url.c_str(), on_response, nullptr, on_error, context);
-    return *this;
-}
+visus::dataverse::dataverse_connection::checksum_algorithm(
+        _In_z_ const wchar_t *algorithm) {
+    auto& i = this->check_not_disposed();
 
+    if (algorithm == nullptr) {
+        throw std::invalid_argument("The hash algorithm must be valid.");
+    }
 
-/*
- * visus::dataverse::dataverse_connection::files
- */
-visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::files(_In_ const std::uint64_t id,
-        _In_ const const_narrow_string& version,
-        _In_ const on_response_type on_response,
-        _In_ const on_error_type on_error,
-        _In_opt_ void *context) {
-    const auto url = std::wstring(L"/datasets/") + std::to_wstring(id)
-        + std::wstring(L"/versions/") + convert<wchar_t>(version)
-        + std::wstring(L"/files");
-    this->get(url.c_str(), on_response, nullptr, on_error, context);
+    // Validate the algorithm right away and store the static canonical name,
+    // which can be shared by all uploads without copying it.
+    const auto a = to_ascii(algorithm);
+    i.checksum_algorithm = detail::hash_context::canonical_name(a.c_str());
     return *this;
 }
 
 
 /*
- * visus::dataverse::dataverse_connection::io_timeout
+ * visus::dataverse::dataverse_connection::checksum_algorithm
  */
 visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::io_timeout(_In_ const int millis) {
-    this->check_not_disposed().timeout = (std::max)(0, millis);
-    return *this;
-}
-
+visus::dataverse::dataverse_connection::checksum_algorithm(
+        _In_ const const_narrow_string& algorithm) {
+    if (algorithm.value() == nullptr) {
+        throw std::invalid_argument("The hash algorithm must be valid.");
+    }
 
-/*
- * visus::dataverse::dataverse_connection::io_timeout
- */
-int visus::dataverse::dataverse_connection::io_timeout(void) const {
-    return this->check_not_disposed().timeout;
+    const auto a = convert<wchar_t>(algorithm);
+    return this->checksum_algorithm(a.c_str());
 }
 
 
 /*
- * visus::dataverse::dataverse_connection::make_form
+ * visus::dataverse::dataverse_connection::checksum_algorithm
  */
-visus::dataverse::form_data visus::dataverse::dataverse_connection::make_form(
+_Ret_z_ const char *visus::dataverse::dataverse_connection::checksum_algorithm(
         void) const {
-    return form_data(detail::dataverse_connection_impl::make_curl().release());
+    return this->check_not_disposed().checksum_algorithm;
 }
 
 
 /*
- * visus::dataverse::dataverse_connection::replace
+ * visus::dataverse::dataverse_connection::coalesce_requests
  */
 visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::replace(_In_ const std::uint64_t id,
-        _In_z_ const wchar_t *path,
-        _In_ const on_response_type on_response,
-        _In_ const on_error_type on_error,
-        _In_opt_ void *context) {
-    const auto url = std::wstring(L"/files/") + std::to_wstring(id)
-        + L"/replace";
-    return this->post(url.c_str(),
-        std::move(this->make_form().add_file(L"file", path)),
-        on_response,
-        on_error,
-        context);
+visus::dataverse::dataverse_connection::coalesce_requests(
+        _In_ const bool enable) {
+    this->check_not_disposed().coalesce = enable;
+    return *this;
 }
 
 
 /*
- * visus::dataverse::dataverse_connection::replace
+ * visus::dataverse::dataverse_connection::coalesce_requests
  */
-visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::replace(_In_ const std::uint64_t id,
-        _In_ const const_narrow_string& path,
-        _In_ const on_response_type on_response,
-        _In_ const on_error_type on_error,
-        _In_opt_ void *context) {
-    const auto url = std::wstring(L"/files/") + std::to_wstring(id)
-        + L"/replace";
-    const auto f = const_narrow_string("file", dataversepp_code_page);
-    return this->post(url.c_str(),
-        std::move(this->make_form().add_file(f, path)),
-        on_response,
-        on_error,
-        context);
+bool visus::dataverse::dataverse_connection::coalesce_requests(
+        void) const {
+    return this->check_not_disposed().coalesce;
 }
 
 
 /*
- * visus::dataverse::dataverse_connection::upload
+ * visus::dataverse::dataverse_connection::data_set
  */
 visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::upload(
+visus::dataverse::dataverse_connection::data_set(
         _In_z_ const wchar_t *persistent_id,
-        _In_z_ const wchar_t *path,
         _In_ const on_response_type on_response,
         _In_ const on_error_type on_error,
         _In_opt_ void *context) {
-    const auto url = std::wstring(L"/datasets/:persistentId/add?"
+    const auto url = std::wstring(L"/datasets/:persistentId/?"
         L"persistentId=") + persistent_id;
-    return this->post(url.c_str(),
-        std::move(this->make_form().add_file(L"file", path)),
-        on_response,
-        on_error,
-        context);
+    this->get(url.c_str(), on_response, nullptr, on_error, context);
+    return *this;
 }
 
 
 /*
- * visus::dataverse::dataverse_connection::upload
+ * visus::dataverse::dataverse_connection::data_set
  */
 visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::upload(
+visus::dataverse::dataverse_connection::data_set(
         _In_ const const_narrow_string& persistent_id,
-        _In_ const const_narrow_string& path,
         _In_ const on_response_type on_response,
-        _In_ const on_error_type on_error,
+            _In_ const on_error_type on_error,
         _In_opt_ void *context) {
-    const auto url = std::string("/datasets/:persistentId/add?"
-        "persistentId=") + to_ascii(persistent_id);
-    const auto f = const_narrow_string("file", dataversepp_code_page);
-    return this->post(const_narrow_string(url.c_str(), dataversepp_code_page),
-        std::move(this->make_form().add_file(f, path)),
-        on_response,
-        on_error,
-        context);
+    const auto url = std::wstring(L"/datasets/:persistentId/?"
+        L"persistentId=") + convert<wchar_t>(persistent_id);
+    this->get(url.c_str(), on_response, nullptr, on_error, context);
+    return *this;
 }
 
 
 /*
- * visus::dataverse::dataverse_connection::upload
+ * visus::dataverse::dataverse_connection::direct_upload
  */
 visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::upload(
+visus::dataverse::dataverse_connection::direct_upload(
         _In_z_ const wchar_t *persistent_id,
-        _In_z_ const wchar_t *path,
+        _In_z_ const wchar_t *name,
+        _In_reads_bytes_(cnt) const byte_type *data,
+        _In_ const std::size_t cnt,
+        _In_opt_ const data_deleter_type data_deleter,
+        _In_opt_z_ const wchar_t *mime_type,
         _In_z_ const wchar_t *description,
         _In_z_ const wchar_t *directory,
-        const wchar_t **categories,
+        _In_reads_z_(cnt_cats) const wchar_t **categories,
         _In_ const std::size_t cnt_cats,
         _In_ const bool restricted,
         _In_ const on_response_type on_response,
         _In_ const on_error_type on_error,
         _In_opt_ void *context) {
-    // Note: We know that we do not use anything but 7-bit ASCII in the labels
-    // here, so we do not need to add a UTF-8 conversion for the names.
-    const auto url = std::wstring(L"/datasets/:persistentId/add?"
-        L"persistentId=") + persistent_id;
+    using detail::direct_upload_context;
+    _CHECK_ON_RESPONSE;
+    _CHECK_ON_ERROR;
+    auto impl = &this->check_not_disposed();
+
+    if ((data == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The data to be uploaded must be valid.");
+    }
+
+    // From here on, the context owns the data, i.e. it must be successfully
+    // passed to the API or freed in case of any error. If the context cannot
+    // be created, we must free the data ourselves.
+    direct_upload_context *ctx = nullptr;
+    try {
+        ctx = new direct_upload_context(impl, impl->checksum_algorithm,
+            on_response, on_error, context);
+    } catch (...) {
+        if ((data != nullptr) && (data_deleter != nullptr)) {
+            data_deleter(data);
+        }
+        throw;
+    }
+
+    ctx->data = data;
+    ctx->data_deleter = data_deleter;
+    ctx->data_size = cnt;
+
+    try {
+        ctx->description = nlohmann::json::object({
+            { "description", to_utf8(description) },
+            { "directoryLabel", to_utf8(directory) },
+            { "fileName", to_utf8(name) },
+            { "fileSize", static_cast<std::uint64_t>(cnt) },
+            { "restrict", restricted },
+            { "categories", nlohmann::json::array() },
+        });
+
+        if (categories != nullptr) {
+            auto& cats = ctx->description["categories"];
+            for (std::size_t i = 0; i < cnt_cats; ++i) {
+                cats.push_back(to_utf8(categories[i]));
+            }
+        }
+
+        if (mime_type != nullptr) {
+            ctx->description["mimeType"] = to_utf8(mime_type);
+        } else {
+            ctx->description["mimeType"] = to_utf8(L"application/octet-stream");
+        }
+
+        ctx->registration_url = impl->make_url(std::wstring(
+            L"/datasets/:persistentId/add?persistentId=")
+            + persistent_id);
+        ctx->upload_urls_url = impl->make_url(std::wstring(
+            L"/datasets/:persistentId/uploadurls?persistentId=")
+            + persistent_id);
+
+        // Hashing a large buffer takes a while, so we do it on a worker.
+        // As the data are hashed in advance, the upload itself only copies
+        // them from the buffer of the caller into the request.
+        impl->workers.submit([ctx](void) {
+            ctx->handle_errors([ctx](void) {
+                ctx->checksum->update(ctx->data,
+                    static_cast<std::size_t>(ctx->data_size));
+                detail::set_checksum(ctx->description, ctx->algorithm,
+                    ctx->checksum->finish());
+                ctx->checksum.reset();
+                direct_upload(ctx);
+            });
+        });
+    } catch (...) {
+        delete ctx;
+        throw;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::direct_upload
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::direct_upload(
+        _In_ const const_narrow_string& persistent_id,
+        _In_ const const_narrow_string& name,
+        _In_reads_bytes_(cnt) const byte_type *data,
+        _In_ const std::size_t cnt,
+        _In_opt_ const data_deleter_type data_deleter,
+        _In_ const const_narrow_string& mime_type,
+        _In_ const const_narrow_string& description,
+        _In_ const const_narrow_string& directory,
+        _In_reads_opt_(cnt_cats) const const_narrow_string *categories,
+        _In_ const std::size_t cnt_cats,
+        _In_ const bool restricted,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    auto i = convert<wchar_t>(persistent_id);
+    auto n = convert<wchar_t>(name);
+    auto m = (mime_type.value() != nullptr)
+        ? convert<wchar_t>(mime_type)
+        : std::wstring();
+    auto d = convert<wchar_t>(description);
+    auto f = convert<wchar_t>(directory);
+
+    std::vector<std::wstring> cats;
+    if (categories != nullptr) {
+        cats.reserve(cnt_cats);
+        std::transform(categories,
+            categories + cnt_cats,
+            std::back_inserter(cats),
+            [](const const_narrow_string& s) { return convert<wchar_t>(s); });
+    }
+
+    std::vector<const wchar_t *> cat_ptrs;
+    cat_ptrs.reserve(cats.size());
+    std::transform(cats.begin(),
+        cats.end(),
+        std::back_inserter(cat_ptrs),
+        [](const std::wstring& s) { return s.c_str(); });
+
+    return this->direct_upload(i.c_str(),
+        n.c_str(),
+        data,
+        cnt,
+        data_deleter,
+        (mime_type.value() != nullptr) ? m.c_str() : nullptr,
+        d.c_str(),
+        f.c_str(),
+        cat_ptrs.data(),
+        cat_ptrs.size(),
+        restricted,
+        on_response,
+        on_error,
+        context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::direct_upload_all
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::direct_upload_all(
+        _In_z_ const wchar_t *persistent_id,
+        _In_reads_(cnt) const wchar_t **paths,
+        _In_ const std::size_t cnt,
+        _In_opt_z_ const wchar_t *mime_type,
+        _In_z_ const wchar_t *directory,
+        _In_ const bool restricted,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    using detail::direct_upload_batch;
+    _CHECK_ON_RESPONSE;
+    _CHECK_ON_ERROR;
+    auto impl = &this->check_not_disposed();
+
+    if ((paths == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The paths of the files to be uploaded "
+            "must be valid.");
+    }
+
+    if (cnt == 0) {
+        return *this;
+    }
+
+    auto batch = new direct_upload_batch(cnt, impl->checksum_algorithm,
+        on_response, on_error, context);
+    batch->connection = impl;
+    batch->registration_url = impl->make_url(std::wstring(
+        L"/datasets/:persistentId/addFiles?persistentId=")
+        + persistent_id);
+
+    // This is performed once all files have been stored in S3.
+    batch->register_files = [](direct_upload_batch& b) {
+        const auto desc = b.descriptions.dump();
+
+        // Create the request, which uses the user-facing callbacks directly.
+        auto c = detail::io_context::create(b.registration_url,
+            b.on_response, b.on_error, b.user_context);
+
+        // Add the descriptions of all files as a JSON array.
+        c->form = form_data(c->curl.get());
+        c->form._curl = nullptr;    // Owned by context!
+        c->form.add_field("jsonData", desc.c_str());
+        c->option(CURLOPT_MIMEPOST, c->form._form);
+
+        b.connection->add_auth_header(c);
+        c->apply_headers();
+        b.connection->process(std::move(c));
+    };
+
+    this->direct_upload_files(batch, persistent_id, paths, cnt, mime_type,
+        directory, restricted);
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::direct_upload_all
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::direct_upload_all(
+        _In_ const const_narrow_string& persistent_id,
+        _In_reads_(cnt) const const_narrow_string *paths,
+        _In_ const std::size_t cnt,
+        _In_ const const_narrow_string& mime_type,
+        _In_ const const_narrow_string& directory,
+        _In_ const bool restricted,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    return narrow_direct_upload(*this,
+        &dataverse_connection::direct_upload_all,
+        persistent_id,
+        paths,
+        cnt,
+        mime_type,
+        directory,
+        restricted,
+        on_response,
+        on_error,
+        context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::direct_upload_files
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::direct_upload_files(
+        _In_z_ const wchar_t *persistent_id,
+        _In_reads_(cnt) const wchar_t **paths,
+        _In_ const std::size_t cnt,
+        _In_opt_z_ const wchar_t *mime_type,
+        _In_z_ const wchar_t *directory,
+        _In_ const bool restricted,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    _CHECK_ON_RESPONSE;
+    _CHECK_ON_ERROR;
+    auto& i = this->check_not_disposed();
+
+    if ((paths == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The paths of the files to be uploaded "
+            "must be valid.");
+    }
+
+    if (cnt == 0) {
+        return *this;
+    }
+
+    auto batch = new detail::direct_upload_batch(cnt, i.checksum_algorithm,
+        on_response, on_error, context);
+    this->direct_upload_files(batch, persistent_id, paths, cnt, mime_type,
+        directory, restricted);
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::direct_upload_files
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::direct_upload_files(
+        _In_ const const_narrow_string& persistent_id,
+        _In_reads_(cnt) const const_narrow_string *paths,
+        _In_ const std::size_t cnt,
+        _In_ const const_narrow_string& mime_type,
+        _In_ const const_narrow_string& directory,
+        _In_ const bool restricted,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    return narrow_direct_upload(*this,
+        &dataverse_connection::direct_upload_files,
+        persistent_id,
+        paths,
+        cnt,
+        mime_type,
+        directory,
+        restricted,
+        on_response,
+        on_error,
+        context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::direct_upload_parallelism
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::direct_upload_parallelism(
+        _In_ const std::size_t parallelism) {
+    this->check_not_disposed().upload_parallelism = (std::max)(parallelism,
+        static_cast<std::size_t>(1));
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::direct_upload_parallelism
+ */
+std::size_t visus::dataverse::dataverse_connection::direct_upload_parallelism(
+        void) const {
+    return this->check_not_disposed().upload_parallelism;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::direct_upload_part_size
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::direct_upload_part_size(
+        _In_ const std::uint64_t size) {
+    this->check_not_disposed().upload_part_size = size;
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::direct_upload_part_size
+ */
+std::uint64_t visus::dataverse::dataverse_connection::direct_upload_part_size(
+        void) const {
+    return this->check_not_disposed().upload_part_size;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::disk_cache
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::disk_cache(
+        _In_opt_z_ const wchar_t *directory,
+        _In_ const std::uint64_t capacity,
+        _In_ const int ttl) {
+    auto& i = this->check_not_disposed();
+    const auto d = (directory != nullptr) ? directory : L"";
+    i.persistent_cache.configure(d, capacity, std::chrono::milliseconds(ttl));
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::disk_cache
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::disk_cache(
+        _In_ const const_narrow_string& directory,
+        _In_ const std::uint64_t capacity,
+        _In_ const int ttl) {
+    if (directory == nullptr) {
+        auto d = static_cast<wchar_t *>(nullptr);
+        return this->disk_cache(d, capacity, ttl);
+    } else {
+        auto d = convert<wchar_t>(directory);
+        return this->disk_cache(d.c_str(), capacity, ttl);
+    }
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::disk_cache_statistics
+ */
+visus::dataverse::cache_statistics
+visus::dataverse::dataverse_connection::disk_cache_statistics(void) const {
+    return this->check_not_disposed().persistent_cache.statistics();
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::download_cache
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::download_cache(
+        _In_opt_z_ const wchar_t *directory,
+        _In_ const std::uint64_t capacity) {
+    auto& i = this->check_not_disposed();
+    const auto d = (directory != nullptr) ? directory : L"";
+    i.downloads.configure(d, capacity);
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::download_cache
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::download_cache(
+        _In_ const const_narrow_string& directory,
+        _In_ const std::uint64_t capacity) {
+    if (directory == nullptr) {
+        auto d = static_cast<wchar_t *>(nullptr);
+        return this->download_cache(d, capacity);
+    } else {
+        auto d = convert<wchar_t>(directory);
+        return this->download_cache(d.c_str(), capacity);
+    }
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::download_cache_statistics
+ */
+visus::dataverse::cache_statistics
+visus::dataverse::dataverse_connection::download_cache_statistics(
+        void) const {
+    return this->check_not_disposed().downloads.statistics();
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::download
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::download(_In_ const std::uint64_t id,
+        _In_z_ const wchar_t *format,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    const auto url = std::wstring(L"/access/datafile/") + std::to_wstring(id)
+        + std::wstring(L"?format=") + std::wstring(format);
+    this->get(url.c_str(), on_response, nullptr, on_error, context);
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::download
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::download(_In_ const std::uint64_t id,
+        _In_ const const_narrow_string& format,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    const auto url = std::wstring(L"/access/datafile/") + std::to_wstring(id)
+        + std::wstring(L"?format=") + convert<wchar_t>(format);
+    this->get(url.c_str(), on_response, nullptr, on_error, context);
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::download
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::download(_In_ const std::uint64_t id,
+        _In_z_ const wchar_t *format,
+        _In_z_ const wchar_t *path,
+        _In_ const bool resume,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    this->download(id, format, nullptr, nullptr, path, resume, on_response,
+        on_error, context);
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::download
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::download(_In_ const std::uint64_t id,
+        _In_ const const_narrow_string& format,
+        _In_ const const_narrow_string& path,
+        _In_ const bool resume,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path of the output file must be "
+            "valid.");
+    }
+
+    const auto f = convert<wchar_t>(format);
+    const auto p = convert<wchar_t>(path);
+    return this->download(id, f.c_str(), p.c_str(), resume, on_response,
+        on_error, context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::download
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::download(_In_ const std::uint64_t id,
+        _In_z_ const wchar_t *format,
+        _Out_writes_bytes_(capacity) byte_type *buffer,
+        _In_ const std::size_t capacity,
+        _In_ const bool truncate,
+        _In_ const on_buffer_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    _CHECK_ON_RESPONSE;
+    _CHECK_ON_ERROR;
+
+    if (buffer == nullptr) {
+        throw std::invalid_argument("The output buffer must be valid.");
+    }
+
+    auto& i = this->check_not_disposed();
+    const auto url = std::wstring(L"/access/datafile/") + std::to_wstring(id)
+        + std::wstring(L"?format=") + std::wstring(format);
+
+    // Prepare the request. Note that we cannot pass the user callback here,
+    // because it has a different signature. The context will choose the
+    // right one once the buffer has been installed.
+    auto ctx = detail::io_context::create(i.make_url(url), nullptr, on_error,
+        context);
+    ctx->prepare_response(buffer, capacity, truncate, on_response);
+    ctx->option(CURLOPT_FOLLOWLOCATION, 1L);
+
+    // Set the authentication header.
+    i.add_auth_header(ctx);
+    ctx->apply_headers();
+
+    // Send the request to asynchronous processing.
+    i.process(std::move(ctx));
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::download
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::download(_In_ const std::uint64_t id,
+        _In_ const const_narrow_string& format,
+        _Out_writes_bytes_(capacity) byte_type *buffer,
+        _In_ const std::size_t capacity,
+        _In_ const bool truncate,
+        _In_ const on_buffer_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    const auto f = convert<wchar_t>(format);
+    return this->download(id, f.c_str(), buffer, capacity, truncate,
+        on_response, on_error, context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::files
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::files(_In_z_ const std::uint64_t id,
+        _In_z_ const wchar_t *version,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    const auto url = std::wstring(L"/datasets/") + std::to_wstring(id)
+        + std::wstring(L"/versions/") + version
+        + std::wstring(L"/files");
+    this->get(url.c_str(), on_response, nullptr, on_error, context);
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::download
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::download(
+        _In_z_ const wchar_t *persistent_id,
+        _In_z_ const wchar_t *format,
+        _In_z_ const wchar_t *version,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    const auto url = std::wstring(L"/access/datafile/:persistentId"
+        L"?persistentId=") + std::wstring(persistent_id)
+        + std::wstring(L"&version=") + std::wstring(version)
+        + std::wstring(L"&format=") + std::wstring(format);
+    this->get(url.c_str(), on_response, nullptr, on_error, context);
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::download
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::download(
+        _In_ const const_narrow_string& persistent_id,
+        _In_ const const_narrow_string& format,
+        _In_ const const_narrow_string& version,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    const auto url = std::wstring(L"/access/datafile/:persistentId"
+        L"?persistentId=") + convert<wchar_t>(persistent_id)
+        + std::wstring(L"&version=") + convert<wchar_t>(version)
+        + std::wstring(L"&format=") + convert<wchar_t>(format);
+    this->get(url.c_str(), on_response, nullptr, on_error, context);
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::files
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::files(_In_ const std::uint64_t id,
+        _In_ const const_narrow_string& version,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    const auto url = std::wstring(L"/datasets/") + std::to_wstring(id)
+        + std::wstring(L"/versions/") + convert<wchar_t>(version)
+        + std::wstring(L"/files");
+    this->get(url.c_str(), on_response, nullptr, on_error, context);
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::io_timeout
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::io_timeout(_In_ const int millis) {
+    this->check_not_disposed().timeout = (std::max)(0, millis);
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::io_timeout
+ */
+int visus::dataverse::dataverse_connection::io_timeout(void) const {
+    return this->check_not_disposed().timeout;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::make_form
+ */
+visus::dataverse::form_data visus::dataverse::dataverse_connection::make_form(
+        void) const {
+    return form_data(detail::dataverse_connection_impl::make_curl().release());
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::progress
+ */
+visus::dataverse::transfer_progress
+visus::dataverse::dataverse_connection::progress(void) const {
+    return this->check_not_disposed().progress.progress();
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::progress_handler
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::progress_handler(
+        _In_opt_ const on_progress_type handler,
+        _In_ const int interval) {
+    if (interval < 0) {
+        throw std::invalid_argument("The progress interval must not be "
+            "negative.");
+    }
+
+    auto& impl = this->check_not_disposed();
+    impl.progress.configure(handler, std::chrono::milliseconds(interval));
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::replace
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::replace(_In_ const std::uint64_t id,
+        _In_z_ const wchar_t *path,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    const auto url = std::wstring(L"/files/") + std::to_wstring(id)
+        + L"/replace";
+    return this->post(url.c_str(),
+        std::move(this->make_form().add_file(L"file", path)),
+        on_response,
+        on_error,
+        context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::replace
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::replace(_In_ const std::uint64_t id,
+        _In_ const const_narrow_string& path,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    const auto url = std::wstring(L"/files/") + std::to_wstring(id)
+        + L"/replace";
+    const auto f = const_narrow_string("file", dataversepp_code_page);
+    return this->post(url.c_str(),
+        std::move(this->make_form().add_file(f, path)),
+        on_response,
+        on_error,
+        context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::response_cache
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::response_cache(
+        _In_ const std::size_t capacity,
+        _In_ const int ttl) {
+    this->check_not_disposed().cache.configure(capacity,
+        std::chrono::milliseconds(ttl));
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::response_cache_statistics
+ */
+visus::dataverse::cache_statistics
+visus::dataverse::dataverse_connection::response_cache_statistics(
+        void) const {
+    return this->check_not_disposed().cache.statistics();
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::resume_uploads
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::resume_uploads(void) {
+    this->check_not_disposed().resume();
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::upload
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::upload(
+        _In_z_ const wchar_t *persistent_id,
+        _In_z_ const wchar_t *path,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    const auto url = std::wstring(L"/datasets/:persistentId/add?"
+        L"persistentId=") + persistent_id;
+    return this->post(url.c_str(),
+        std::move(this->make_form().add_file(L"file", path)),
+        on_response,
+        on_error,
+        context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::upload
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::upload(
+        _In_ const const_narrow_string& persistent_id,
+        _In_ const const_narrow_string& path,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    const auto url = std::string("/datasets/:persistentId/add?"
+        "persistentId=") + to_ascii(persistent_id);
+    const auto f = const_narrow_string("file", dataversepp_code_page);
+    return this->post(const_narrow_string(url.c_str(), dataversepp_code_page),
+        std::move(this->make_form().add_file(f, path)),
+        on_response,
+        on_error,
+        context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::upload
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::upload(
+        _In_z_ const wchar_t *persistent_id,
+        _In_z_ const wchar_t *path,
+        _In_z_ const wchar_t *description,
+        _In_z_ const wchar_t *directory,
+        const wchar_t **categories,
+        _In_ const std::size_t cnt_cats,
+        _In_ const bool restricted,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    // Note: We know that we do not use anything but 7-bit ASCII in the labels
+    // here, so we do not need to add a UTF-8 conversion for the names.
+    const auto url = std::wstring(L"/datasets/:persistentId/add?"
+        L"persistentId=") + persistent_id;
+
+    auto json = nlohmann::json::object({
+        { "description", to_utf8(description) },
+        { "directoryLabel", to_utf8(directory) },
+        { "restrict", restricted },
+        { "categories", nlohmann::json::array() }
+    });
+
+    if (categories != nullptr) {
+        auto& cats = json["categories"];
+        for (std::size_t i = 0; i < cnt_cats; ++i) {
+            cats.push_back(to_utf8(categories[i]));
+        }
+    }
+
+    const auto dump = json.dump();
+    const auto desc = reinterpret_cast<const std::uint8_t *>(dump.data());
+    const auto size = dump.size();
+
+    return this->post(url.c_str(),
+        std::move(this->make_form()
+            .add_file(L"file", path)
+            .add_field(L"jsonData", desc, size)),
+        on_response,
+        on_error,
+        context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::upload
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::upload(
+        _In_ const const_narrow_string& persistent_id,
+        _In_ const const_narrow_string& path,
+        _In_ const const_narrow_string& description,
+        _In_ const const_narrow_string& directory,
+        _In_reads_opt_(cnt_cats) const const_narrow_string *categories,
+        _In_ const std::size_t cnt_cats,
+        _In_ const bool restricted,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    auto i = convert<wchar_t>(persistent_id);
+    auto p = convert<wchar_t>(path);
+    auto d = convert<wchar_t>(description);
+    auto f = convert<wchar_t>(directory);
+
+    std::vector<std::wstring> cats;
+    if (categories != nullptr) {
+        cats.reserve(cnt_cats);
+        std::transform(categories,
+            categories + cnt_cats,
+            std::back_inserter(cats),
+            [](const const_narrow_string& s) { return convert<wchar_t>(s); });
+    }
+
+    std::vector<const wchar_t *> cat_ptrs;
+    cat_ptrs.reserve(cats.size());
+    std::transform(cats.begin(),
+        cats.end(),
+        std::back_inserter(cat_ptrs),
+        [](const std::wstring& s ) { return s.c_str(); });
+
+    return this->upload(i.c_str(),
+        p.c_str(),
+        d.c_str(),
+        f.c_str(),
+        cat_ptrs.data(),
+        cat_ptrs.size(),
+        restricted,
+        on_response,
+        on_error,
+        context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::upload
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::upload(
+        _In_z_ const wchar_t *persistent_id,
+        _In_z_ const wchar_t *name,
+        _In_ const form_data::on_read_type producer,
+        _In_opt_ void *producer_context,
+        _In_z_ const wchar_t *description,
+        _In_z_ const wchar_t *directory,
+        _In_reads_z_(cnt_cats) const wchar_t **categories,
+        _In_ const std::size_t cnt_cats,
+        _In_ const bool restricted,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    using detail::stream_upload_context;
+    _CHECK_ON_RESPONSE;
+    _CHECK_ON_ERROR;
+    auto impl = &this->check_not_disposed();
+
+    if (producer == nullptr) {
+        throw std::invalid_argument("The producer of the data must be valid.");
+    }
 
     auto json = nlohmann::json::object({
         { "description", to_utf8(description) },
@@ -462,66 +1466,364 @@ visus::dataverse::dataverse_connection::upload(
         }
     }
 
-    const auto dump = json.dump();
-    const auto desc = reinterpret_cast<const std::uint8_t *>(dump.data());
-    const auto size = dump.size();
+    const auto desc = json.dump();
+    const auto url = impl->make_url(std::wstring(
+        L"/datasets/:persistentId/add?persistentId=") + persistent_id);
+
+    // The context must be passed to the API or freed in case of an error.
+    std::unique_ptr<stream_upload_context> ctx(new stream_upload_context(
+        impl->checksum_algorithm, producer, producer_context, on_response,
+        on_error, context));
+    ctx->connection = impl;
+
+    auto c = detail::io_context::create(url,
+        stream_upload_context::forward_response,
+        stream_upload_context::forward_error,
+        ctx.get());
+    c->progress.context = context;
+    ctx->curl = c->curl.get();
+
+    // The file is the only field of unknown size, which makes curl send the
+    // whole form using chunked transfer encoding.
+    c->form = form_data(c->curl.get());
+    c->form._curl = nullptr;    // Owned by context!
+    c->form.add_file(L"file", name, form_data::unknown_size,
+        stream_upload_context::read, nullptr, nullptr, ctx.get());
+    c->form.add_field("jsonData", desc.c_str());
+    c->option(CURLOPT_MIMEPOST, c->form._form);
+
+    impl->add_auth_header(c);
+    c->apply_headers();
+    impl->process(std::move(c));
+    ctx.release();
+
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::upload
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::upload(
+        _In_ const const_narrow_string& persistent_id,
+        _In_ const const_narrow_string& name,
+        _In_ const form_data::on_read_type producer,
+        _In_opt_ void *producer_context,
+        _In_ const const_narrow_string& description,
+        _In_ const const_narrow_string& directory,
+        _In_reads_opt_(cnt_cats) const const_narrow_string *categories,
+        _In_ const std::size_t cnt_cats,
+        _In_ const bool restricted,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    auto i = convert<wchar_t>(persistent_id);
+    auto n = convert<wchar_t>(name);
+    auto d = convert<wchar_t>(description);
+    auto f = convert<wchar_t>(directory);
+
+    std::vector<std::wstring> cats;
+    if (categories != nullptr) {
+        cats.reserve(cnt_cats);
+        std::transform(categories,
+            categories + cnt_cats,
+            std::back_inserter(cats),
+            [](const const_narrow_string& s) { return convert<wchar_t>(s); });
+    }
+
+    std::vector<const wchar_t *> cat_ptrs;
+    cat_ptrs.reserve(cats.size());
+    std::transform(cats.begin(),
+        cats.end(),
+        std::back_inserter(cat_ptrs),
+        [](const std::wstring& s) { return s.c_str(); });
+
+    return this->upload(i.c_str(),
+        n.c_str(),
+        producer,
+        producer_context,
+        d.c_str(),
+        f.c_str(),
+        cat_ptrs.data(),
+        cat_ptrs.size(),
+        restricted,
+        on_response,
+        on_error,
+        context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::upload_archive
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::upload_archive(
+        _In_z_ const wchar_t *persistent_id,
+        _In_reads_(cnt) const wchar_t **paths,
+        _In_reads_opt_(cnt) const wchar_t **directories,
+        _In_ const std::size_t cnt,
+        _In_ const archive_compression compression,
+        _In_z_ const wchar_t *description,
+        _In_reads_opt_(cnt_cats) const wchar_t **categories,
+        _In_ const std::size_t cnt_cats,
+        _In_ const bool restricted,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    using detail::archive_upload_context;
+    _CHECK_ON_RESPONSE;
+    _CHECK_ON_ERROR;
+    auto impl = &this->check_not_disposed();
+
+    if ((paths == nullptr) || (cnt == 0)) {
+        throw std::invalid_argument("The paths of the files to be uploaded "
+            "must be valid.");
+    }
+
+    // The context must be passed to the API or freed in case of an error.
+    std::unique_ptr<archive_upload_context> ctx(new archive_upload_context(
+        compression, on_response, on_error, context));
+
+    // Only the names of the entries are determined here. The files are not
+    // accessed before the archive reaches them on the I/O thread.
+    for (std::size_t i = 0; i < cnt; ++i) {
+        ctx->archive.add(paths[i],
+            (directories != nullptr) ? directories[i] : nullptr);
+    }
+
+    auto json = nlohmann::json::object({
+        { "description", to_utf8(description) },
+        { "restrict", restricted },
+        { "categories", nlohmann::json::array() }
+    });
+
+    if (categories != nullptr) {
+        auto& cats = json["categories"];
+        for (std::size_t i = 0; i < cnt_cats; ++i) {
+            cats.push_back(to_utf8(categories[i]));
+        }
+    }
+
+    const auto desc = json.dump();
+    const auto url = impl->make_url(std::wstring(
+        L"/datasets/:persistentId/add?persistentId=") + persistent_id);
+
+    auto c = detail::io_context::create(url,
+        archive_upload_context::forward_response,
+        archive_upload_context::forward_error,
+        ctx.get());
+    c->progress.context = context;
+
+    // The size of the archive is only known once it has been built, so it is
+    // sent using chunked transfer encoding. Dataverse recognises the archive
+    // by its name and unpacks it.
+    c->form = form_data(c->curl.get());
+    c->form._curl = nullptr;    // Owned by context!
+    c->form.add_file(L"file", L"archive.zip", form_data::unknown_size,
+        detail::zip_stream::read, nullptr, nullptr, &ctx->archive);
+    c->form.add_field("jsonData", desc.c_str());
+    c->option(CURLOPT_MIMEPOST, c->form._form);
+
+    impl->add_auth_header(c);
+    c->apply_headers();
+    impl->process(std::move(c));
+    ctx.release();
+
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::upload_archive
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::upload_archive(
+        _In_ const const_narrow_string& persistent_id,
+        _In_reads_(cnt) const const_narrow_string *paths,
+        _In_reads_opt_(cnt) const const_narrow_string *directories,
+        _In_ const std::size_t cnt,
+        _In_ const archive_compression compression,
+        _In_ const const_narrow_string& description,
+        _In_reads_opt_(cnt_cats) const const_narrow_string *categories,
+        _In_ const std::size_t cnt_cats,
+        _In_ const bool restricted,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    if ((paths == nullptr) || (cnt == 0)) {
+        throw std::invalid_argument("The paths of the files to be uploaded "
+            "must be valid.");
+    }
+
+    const auto convert_all = [](const const_narrow_string *strings,
+            const std::size_t cnt) {
+        std::vector<std::wstring> retval;
+        if (strings != nullptr) {
+            retval.reserve(cnt);
+            std::transform(strings,
+                strings + cnt,
+                std::back_inserter(retval),
+                [](const const_narrow_string& s) {
+                    return (s.value() != nullptr)
+                        ? convert<wchar_t>(s)
+                        : std::wstring();
+                });
+        }
+        return retval;
+    };
+
+    const auto pointers = [](const std::vector<std::wstring>& strings) {
+        std::vector<const wchar_t *> retval;
+        retval.reserve(strings.size());
+        std::transform(strings.begin(),
+            strings.end(),
+            std::back_inserter(retval),
+            [](const std::wstring& s) { return s.c_str(); });
+        return retval;
+    };
+
+    auto i = convert<wchar_t>(persistent_id);
+    auto d = convert<wchar_t>(description);
+    const auto files = convert_all(paths, cnt);
+    const auto dirs = convert_all(directories, cnt);
+    const auto cats = convert_all(categories, cnt_cats);
+    auto file_ptrs = pointers(files);
+    auto dir_ptrs = pointers(dirs);
+    auto cat_ptrs = pointers(cats);
+
+    return this->upload_archive(i.c_str(),
+        file_ptrs.data(),
+        (directories != nullptr) ? dir_ptrs.data() : nullptr,
+        file_ptrs.size(),
+        compression,
+        d.c_str(),
+        (categories != nullptr) ? cat_ptrs.data() : nullptr,
+        cat_ptrs.size(),
+        restricted,
+        on_response,
+        on_error,
+        context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::verified_download
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::verified_download(
+        _In_ const std::uint64_t id,
+        _In_z_ const wchar_t *format,
+        _In_z_ const wchar_t *checksum_type,
+        _In_z_ const wchar_t *checksum,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    _CHECK_ON_RESPONSE;
+    _CHECK_ON_ERROR;
+
+    if ((checksum_type == nullptr) || (checksum == nullptr)) {
+        throw std::invalid_argument("The expected checksum must be valid.");
+    }
+
+    auto& i = this->check_not_disposed();
+    const auto url = std::wstring(L"/access/datafile/") + std::to_wstring(id)
+        + std::wstring(L"?format=") + std::wstring(format);
+
+    auto ctx = detail::io_context::create(i.make_url(url), on_response,
+        on_error, context);
+    ctx->checksum.reset(new detail::hash_context(
+        to_ascii(checksum_type).c_str()));
+    ctx->expected_checksum = to_ascii(checksum);
+    ctx->option(CURLOPT_FOLLOWLOCATION, 1L);
+
+    // Note that we bypass the caches and coalescing, because the response
+    // must be hashed while it is being received.
+    i.add_auth_header(ctx);
+    ctx->apply_headers();
+    i.process(std::move(ctx));
+
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::verified_download
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::verified_download(
+        _In_ const std::uint64_t id,
+        _In_ const const_narrow_string& format,
+        _In_ const const_narrow_string& checksum_type,
+        _In_ const const_narrow_string& checksum,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    if ((checksum_type == nullptr) || (checksum == nullptr)) {
+        throw std::invalid_argument("The expected checksum must be valid.");
+    }
+
+    const auto f = convert<wchar_t>(format);
+    const auto t = convert<wchar_t>(checksum_type);
+    const auto c = convert<wchar_t>(checksum);
+    return this->verified_download(id, f.c_str(), t.c_str(), c.c_str(),
+        on_response, on_error, context);
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::verified_download
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::verified_download(
+        _In_ const std::uint64_t id,
+        _In_z_ const wchar_t *format,
+        _In_z_ const wchar_t *checksum_type,
+        _In_z_ const wchar_t *checksum,
+        _In_z_ const wchar_t *path,
+        _In_ const bool resume,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    if ((checksum_type == nullptr) || (checksum == nullptr)) {
+        throw std::invalid_argument("The expected checksum must be valid.");
+    }
 
-    return this->post(url.c_str(),
-        std::move(this->make_form()
-            .add_file(L"file", path)
-            .add_field(L"jsonData", desc, size)),
-        on_response,
-        on_error,
-        context);
+    this->download(id, format, checksum_type, checksum, path, resume,
+        on_response, on_error, context);
+    return *this;
 }
 
 
 /*
- * visus::dataverse::dataverse_connection::upload
+ * visus::dataverse::dataverse_connection::verified_download
  */
 visus::dataverse::dataverse_connection&
-visus::dataverse::dataverse_connection::upload(
-        _In_ const const_narrow_string& persistent_id,
+visus::dataverse::dataverse_connection::verified_download(
+        _In_ const std::uint64_t id,
+        _In_ const const_narrow_string& format,
+        _In_ const const_narrow_string& checksum_type,
+        _In_ const const_narrow_string& checksum,
         _In_ const const_narrow_string& path,
-        _In_ const const_narrow_string& description,
-        _In_ const const_narrow_string& directory,
-        _In_reads_opt_(cnt_cats) const const_narrow_string *categories,
-        _In_ const std::size_t cnt_cats,
-        _In_ const bool restricted,
+        _In_ const bool resume,
         _In_ const on_response_type on_response,
         _In_ const on_error_type on_error,
         _In_opt_ void *context) {
-    auto i = convert<wchar_t>(persistent_id);
-    auto p = convert<wchar_t>(path);
-    auto d = convert<wchar_t>(description);
-    auto f = convert<wchar_t>(directory);
-
-    std::vector<std::wstring> cats;
-    if (categories != nullptr) {
-        cats.reserve(cnt_cats);
-        std::transform(categories,
-            categories + cnt_cats,
-            std::back_inserter(cats),
-            [](const const_narrow_string& s) { return convert<wchar_t>(s); });
+    if ((checksum_type == nullptr) || (checksum == nullptr)) {
+        throw std::invalid_argument("The expected checksum must be valid.");
+    }
+    if (path == nullptr) {
+        throw std::invalid_argument("The path of the output file must be "
+            "valid.");
     }
 
-    std::vector<const wchar_t *> cat_ptrs;
-    cat_ptrs.reserve(cats.size());
-    std::transform(cats.begin(),
-        cats.end(),
-        std::back_inserter(cat_ptrs),
-        [](const std::wstring& s ) { return s.c_str(); });
-
-    return this->upload(i.c_str(),
-        p.c_str(),
-        d.c_str(),
-        f.c_str(),
-        cat_ptrs.data(),
-        cat_ptrs.size(),
-        restricted,
-        on_response,
-        on_error,
-        context);
+    const auto f = convert<wchar_t>(format);
+    const auto t = convert<wchar_t>(checksum_type);
+    const auto c = convert<wchar_t>(checksum);
+    const auto p = convert<wchar_t>(path);
+    this->download(id, f.c_str(), t.c_str(), c.c_str(), p.c_str(), resume,
+        on_response, on_error, context);
+    return *this;
 }
 
 
@@ -578,7 +1880,40 @@ void visus::dataverse::dataverse_connection::report_api_error(
         _In_ void *client_data, _In_z_ const char *error) {
     auto context = static_cast<detail::io_context *>(client_data);
     detail::invoke_handler(context->on_error, error, "API", utf8_code_page,
-        context->client_data);
+        context->user_data());
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::translate_json_response
+ */
+void visus::dataverse::dataverse_connection::translate_json_response(
+        _In_ const blob& response, _In_ void *client_data) {
+    _Analysis_assume_(client_data != nullptr);
+    const auto on_response = reinterpret_cast<on_json_response_type>(
+        get_on_api_response(client_data));
+    _Analysis_assume_(on_response != nullptr);
+    auto context = get_api_response_client_data(client_data);
+
+    try {
+        const json_view json(response);
+
+        if (json.at("/status").equals("ERROR")) {
+            const auto message = json.at("/message");
+            if (message.type() == json_view::value_type::string) {
+                report_api_error(client_data, message.to_string().c_str());
+            } else {
+                report_api_error(client_data, "The API reported an error.");
+            }
+        } else {
+            on_response(json, context);
+        }
+    } catch (...) {
+        // This should never happen unless an invalid end point was invoked.
+        get_on_error(client_data)(0, "The translation of an API response "
+            "failed with an unexpected exception.", "Unexpected Exception",
+            dataversepp_code_page, context);
+    }
 }
 
 
@@ -651,23 +1986,11 @@ void visus::dataverse::dataverse_connection::delete_resource(
  * visus::dataverse::dataverse_connection::direct_upload
  */
 void visus::dataverse::dataverse_connection::direct_upload(
-        _In_z_ const wchar_t *persistent_id,
-        _In_z_ const wchar_t *path,
-        _In_opt_z_ const wchar_t *mime_type,
-        _In_z_ const wchar_t *description,
-        _In_z_ const wchar_t *directory,
-        _In_reads_z_(cnt_cats) const wchar_t **categories,
-        _In_ const std::size_t cnt_cats,
-        _In_ const bool restricted,
-        _In_ const on_response_type on_response,
-        _In_opt_ const void *on_api_response,
-        _In_ const on_error_type on_error,
-        _In_opt_ void *context) {
+        _In_ detail::direct_upload_context *context) {
     using detail::direct_upload_context;
-    _CHECK_ON_RESPONSE;
-    _CHECK_ON_ERROR;
-
-    // TODO: on_api_response must be handled.
+    assert(context != nullptr);
+    assert(context->file || (context->data != nullptr)
+        || (context->data_size == 0));
 
     // This is performed once the request for the one-time upload URL succeeded.
     const auto on_upload_url = [](const blob& r, void *u) {
@@ -678,55 +2001,55 @@ void visus::dataverse::dataverse_connection::direct_upload(
             const auto url = ctx->upload_url(r);
             const auto size = ctx->description["fileSize"].get<std::uint64_t>();
 
+            if (ctx->multipart != nullptr) {
+                // The file is too large for a single PUT, so the server gave
+                // us URLs for its parts. From here on, the multipart upload
+                // is responsible for the context.
+                ctx->multipart->start(ctx->on_stored);
+                return;
+            }
+
             // Create an I/O context for posting the continuation.
             auto c = detail::io_context::create(url,
                     [](const blob& r, void *u) {
                 auto ctx = static_cast<direct_upload_context *>(u);
                 ctx->handle_errors([ctx](void) {
-                    const auto desc = ctx->description.dump();
-
-                    // Create the final request, which uses the user-facing
-                    // callbacks directly.
-                    auto c = detail::io_context::create(ctx->registration_url,
-                        ctx->on_response, ctx->on_error, ctx->user_context);
-
-                    // Add the previously compiled JSON data to the request.
-                    c->form = form_data(c->curl.get());
-                    c->form._curl = nullptr;    // Owned by context!
-                    c->form.add_field("jsonData", desc.c_str());
-                    c->option(CURLOPT_MIMEPOST, c->form._form);
-
-                    // This time, we need the Dataverse authentication.
-                    ctx->connection->add_auth_header(c);
-                    c->apply_headers();
-
-                    // Post the final request.
-                    ctx->connection->process(std::move(c));
-
-                    // We do not need the context anymore. Note that
-                    // 'handle_errors' will delete it in case of an exception
-                    // in the code above, so we do not have to care about this.
-                    delete ctx;
+                    const auto store = [](direct_upload_context *ctx) {
+                        detail::set_checksum(ctx->description, ctx->algorithm,
+                            ctx->file_hash());
+                        ctx->on_stored(ctx);
+                    };
+
+                    if (ctx->hash_available()) {
+                        // The hash has been computed before or while the file
+                        // was being uploaded, so it is now available.
+                        store(ctx);
+                    } else {
+                        // The file must be read again, which we must not do
+                        // on the I/O thread, because it would block all other
+                        // transfers of the connection.
+                        ctx->connection->workers.submit([ctx, store](void) {
+                            ctx->handle_errors([ctx, store](void) {
+                                store(ctx);
+                            });
+                        });
+                    }
                 });
             }, direct_upload_context::forward_error, ctx);
+            c->progress.context = ctx->progress_context;
 
             // This one is special, because it is an S3 request and not a
             // Dataverse API call.
             c->option(CURLOPT_UPLOAD, 1L);
             c->option(CURLOPT_PUT, 1L);
             c->option(CURLOPT_INFILESIZE_LARGE, size);
-#if defined(_WIN32)
-            c->option(CURLOPT_READFUNCTION, form_data::win32_read);
-#else /* defined(_WIN32) */
-            c->option(CURLOPT_READFUNCTION, form_data::posix_read);
-#endif /* defined(_WIN32) */
-            c->option(CURLOPT_READDATA, ctx->file.get());
-#if defined(_WIN32)
-            c->option(CURLOPT_SEEKFUNCTION, form_data::win32_seek);
-#else /* defined(_WIN32) */
-            c->option(CURLOPT_SEEKFUNCTION, form_data::posix_seek);
-#endif /* defined(_WIN32) */
-            c->option(CURLOPT_SEEKDATA, ctx->file.get());
+            // Read the file via the upload context, which computes the MD5
+            // hash on the fly unless it is already known, such that the file
+            // is only read once.
+            c->option(CURLOPT_READFUNCTION, direct_upload_context::read_file);
+            c->option(CURLOPT_READDATA, ctx);
+            c->option(CURLOPT_SEEKFUNCTION, direct_upload_context::seek_file);
+            c->option(CURLOPT_SEEKDATA, ctx);
 
             c->add_header("x-amz-tagging: dv-state=temp");
             c->apply_headers();
@@ -735,17 +2058,58 @@ void visus::dataverse::dataverse_connection::direct_upload(
         });
     };
 
+    if (context->on_stored == nullptr) {
+        context->on_stored = register_file;
+    }
+
+    // Begin the chain of operations by retrieving the upload URL. The server
+    // decides based on the size of the file whether it must be uploaded in
+    // parts. Note that this request must never be answered from a cache.
+    const auto url = context->upload_urls_url + "&size="
+        + std::to_string(context->description["fileSize"]
+            .get<std::uint64_t>());
+    auto c = detail::io_context::create(url, on_upload_url,
+        direct_upload_context::forward_error, context);
+    c->progress.context = context->progress_context;
+    c->option(CURLOPT_FOLLOWLOCATION, 1L);
+    context->connection->add_auth_header(c);
+    c->apply_headers();
+    context->connection->process(std::move(c));
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::direct_upload
+ */
+void visus::dataverse::dataverse_connection::direct_upload(
+        _In_z_ const wchar_t *persistent_id,
+        _In_z_ const wchar_t *path,
+        _In_opt_z_ const wchar_t *mime_type,
+        _In_z_ const wchar_t *description,
+        _In_z_ const wchar_t *directory,
+        _In_reads_z_(cnt_cats) const wchar_t **categories,
+        _In_ const std::size_t cnt_cats,
+        _In_ const bool restricted,
+        _In_ const on_response_type on_response,
+        _In_opt_ const void *on_api_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    using detail::direct_upload_context;
+    _CHECK_ON_RESPONSE;
+    _CHECK_ON_ERROR;
+
+    // TODO: on_api_response must be handled.
     // Allocate the upload context which helps us tracking the progress through
     // the individual stages of the process. From here on, the context must be
     // successfully passed to the API or freed in case of any error, wherefore
     // the following code must be enclosed in try/catch.
-    auto ctx = new direct_upload_context(this->_impl, on_response, on_error,
-        context);
+    auto ctx = new direct_upload_context(this->_impl,
+        this->_impl->checksum_algorithm, on_response, on_error, context);
 
     try {
         // This is the variant where we read ourselves, so we need to open the
-        // file and remember the handle in the context.
-        ctx->file = detail::io_context::open_file(path);
+        // file later on and remember its path in the context.
+        ctx->path = path;
 
         // Prepare as much of the description as we can right now.
         ctx->description = nlohmann::json::object({
@@ -770,19 +2134,31 @@ void visus::dataverse::dataverse_connection::direct_upload(
             ctx->description["mimeType"] = to_utf8(L"application/octet-stream");
         }
 
-        // Add metadata about the file itself (size, name, etc.).
-        ctx->description.update(detail::get_file_properties(path));
-
         // The URL we will later use to register the metadata.
         ctx->registration_url = this->_impl->make_url(std::wstring(
             L"/datasets/:persistentId/add?persistentId=")
             + persistent_id);
 
-        // Begin the chain of operations by retrieving the upload URL.
-        const auto url = std::wstring(L"/datasets/:persistentId/uploadsid/"
-            L"?persistentId=") + persistent_id;
-        this->get(url.c_str(), on_upload_url,
-            direct_upload_context::forward_error, ctx);
+        // The URL for the request of the one-time upload URL(s). The size of
+        // the file is added once it is known.
+        ctx->upload_urls_url = this->_impl->make_url(std::wstring(
+            L"/datasets/:persistentId/uploadurls?persistentId=")
+            + persistent_id);
+
+        // Anything that touches the file might block for a long time, so we
+        // do not do this on the caller's thread, but on a worker, which also
+        // begins the chain of operations by retrieving the upload URL.
+        this->_impl->workers.submit([ctx](void) {
+            ctx->handle_errors([ctx](void) {
+                // Add metadata about the file itself (size, name, etc.). The
+                // hash is not computed here, but while the file is being
+                // uploaded.
+                ctx->file = detail::io_context::open_file(ctx->path.c_str());
+                ctx->description.update(detail::get_file_properties(
+                    ctx->path.c_str(), nullptr));
+                direct_upload(ctx);
+            });
+        });
     } catch (...) {
         delete ctx;
         throw;
@@ -843,6 +2219,186 @@ void visus::dataverse::dataverse_connection::direct_upload(
 }
 
 
+/*
+ * visus::dataverse::dataverse_connection::direct_upload_files
+ */
+void visus::dataverse::dataverse_connection::direct_upload_files(
+        _In_ detail::direct_upload_batch *batch,
+        _In_z_ const wchar_t *persistent_id,
+        _In_reads_(cnt) const wchar_t **paths,
+        _In_ const std::size_t cnt,
+        _In_opt_z_ const wchar_t *mime_type,
+        _In_z_ const wchar_t *directory,
+        _In_ const bool restricted) {
+    using detail::direct_upload_batch;
+    using detail::direct_upload_context;
+    assert(batch != nullptr);
+    assert(paths != nullptr);
+    auto impl = &this->check_not_disposed();
+
+    // The batch deletes itself once all files have been reported, so it must
+    // only be freed here if the feeder could not be started.
+    try {
+        // Copy everything that is shared by all files, because the memory of
+        // the caller is only valid until we return.
+        const std::vector<std::wstring> files(paths, paths + cnt);
+        const auto description = nlohmann::json::object({
+            { "description", "" },
+            { "directoryLabel", to_utf8(directory) },
+            { "restrict", restricted },
+            { "categories", nlohmann::json::array() },
+            { "mimeType", (mime_type != nullptr)
+                ? to_utf8(mime_type)
+                : to_utf8(L"application/octet-stream") }
+        });
+        const auto registration_url = impl->make_url(std::wstring(
+            L"/datasets/:persistentId/add?persistentId=")
+            + persistent_id);
+        const auto upload_urls_url = impl->make_url(std::wstring(
+            L"/datasets/:persistentId/uploadurls?persistentId=")
+            + persistent_id);
+
+        // The feeder blocks whenever the maximum number of files is in flight
+        // or the queue of the hashing threads is full, so it must run on a
+        // worker rather than on the caller's thread.
+        impl->workers.submit([impl, batch, files, description,
+                registration_url, upload_urls_url](void) {
+            for (auto& f : files) {
+                batch->acquire();
+
+                direct_upload_context *ctx = nullptr;
+                try {
+                    ctx = new direct_upload_context(impl, batch->algorithm,
+                        direct_upload_batch::on_file_response,
+                        direct_upload_batch::on_file_error,
+                        batch);
+                    ctx->path = f;
+                    ctx->progress_context = batch->user_context;
+                    ctx->description = description;
+                    ctx->registration_url = registration_url;
+                    ctx->upload_urls_url = upload_urls_url;
+
+                    if (batch->register_files != nullptr) {
+                        ctx->on_stored = direct_upload_batch::on_file_stored;
+                    }
+
+                    impl->hashers.submit([ctx](void) {
+                        ctx->handle_errors([ctx](void) {
+                            // Hash the whole file on this thread. This is
+                            // faster than hashing while uploading if there
+                            // are many files, because all of them would be
+                            // hashed on the single curlm thread otherwise.
+                            ctx->file = detail::io_context::open_file(
+                                ctx->path.c_str());
+                            ctx->description.update(
+                                detail::get_file_properties(ctx->path.c_str(),
+                                ctx->algorithm));
+                            ctx->checksum.reset();
+                            direct_upload(ctx);
+                        });
+                    });
+                } catch (std::system_error ex) {
+                    delete ctx;
+                    detail::invoke_handler(direct_upload_batch::on_file_error,
+                        ex, batch);
+                } catch (std::exception& ex) {
+                    delete ctx;
+                    detail::invoke_handler(direct_upload_batch::on_file_error,
+                        ex, batch);
+                } catch (...) {
+                    delete ctx;
+                    detail::invoke_handler(direct_upload_batch::on_file_error,
+                        batch);
+                }
+            }
+        });
+    } catch (...) {
+        delete batch;
+        throw;
+    }
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::download
+ */
+void visus::dataverse::dataverse_connection::download(
+        _In_ const std::uint64_t id,
+        _In_z_ const wchar_t *format,
+        _In_opt_z_ const wchar_t *checksum_type,
+        _In_opt_z_ const wchar_t *checksum,
+        _In_z_ const wchar_t *path,
+        _In_ const bool resume,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    using detail::download_context;
+    _CHECK_ON_RESPONSE;
+    _CHECK_ON_ERROR;
+
+    if (path == nullptr) {
+        throw std::invalid_argument("The path of the output file must be "
+            "valid.");
+    }
+
+    auto& i = this->check_not_disposed();
+    const auto url = std::wstring(L"/access/datafile/") + std::to_wstring(id)
+        + std::wstring(L"?format=") + std::wstring(format);
+
+    // The download context tracks the progress and owns the output file. It
+    // must be passed to the API or freed in case of an error.
+    auto dl = new download_context(on_response, on_error, context);
+
+    try {
+        if (checksum != nullptr) {
+            dl->checksum.reset(new detail::hash_context(
+                to_ascii(checksum_type).c_str()));
+            dl->expected_checksum = to_ascii(checksum);
+        }
+
+        const auto offset = dl->open(path, resume);
+
+        // Prepare the request such that all output goes to the download
+        // context rather than into the response buffer.
+        auto ctx = detail::io_context::create(i.make_url(url),
+            download_context::complete, download_context::forward_error, dl);
+        ctx->progress.context = context;
+        dl->response = &ctx->response;
+        ctx->option(CURLOPT_FOLLOWLOCATION, 1L);
+        ctx->option(CURLOPT_HEADERFUNCTION, download_context::read_header);
+        ctx->option(CURLOPT_HEADERDATA, dl);
+        ctx->option(CURLOPT_WRITEFUNCTION, download_context::write_response);
+        ctx->option(CURLOPT_WRITEDATA, dl);
+
+        if (offset > 0) {
+            // Request only the missing part. Note that we do not use cURL's
+            // resume feature, because it fails if the server answers with the
+            // whole file, which is what we want if the file has changed.
+            const auto range = "Range: bytes=" + std::to_string(offset) + "-";
+            ctx->add_header(range.c_str());
+
+            // "If-Range" only works with strong entity tags. For weak ones,
+            // the download context checks the entity tag of the response.
+            auto& etag = dl->checkpoint.etag;
+            if (!etag.empty() && (etag.compare(0, 2, "W/") != 0)) {
+                const auto if_range = "If-Range: " + etag;
+                ctx->add_header(if_range.c_str());
+            }
+        }
+
+        // Set the authentication header.
+        i.add_auth_header(ctx);
+        ctx->apply_headers();
+
+        // Send the request to asynchronous processing.
+        i.process(std::move(ctx));
+    } catch (...) {
+        delete dl;
+        throw;
+    }
+}
+
+
 /*
  * visus::dataverse::dataverse_connection::get
  */
@@ -857,8 +2413,8 @@ void visus::dataverse::dataverse_connection::get(
     auto& i = this->check_not_disposed();
 
     // Prepare the request.
-    auto ctx = detail::io_context::create(i.make_url(resource),
-        on_response, on_error, context);
+    const auto url = i.make_url(resource);
+    auto ctx = detail::io_context::create(url, on_response, on_error, context);
     assert(ctx->curl != nullptr);
     assert(ctx->client_data == context);
     ctx->configure_on_api_response(const_cast<void *>(on_api_response));
@@ -869,11 +2425,24 @@ void visus::dataverse::dataverse_connection::get(
 
     // Set the authentication header.
     i.add_auth_header(ctx);
-    ctx->apply_headers();
 
+    // Answer the request from memory if we have a fresh response. Otherwise,
+    // the response might still be revalidated rather than being sent again.
+    const auto cached = i.cache.enabled() || i.persistent_cache.enabled();
+    if (cached && i.prepare_cached(*ctx, url)) {
+        i.process_cached(std::move(ctx));
+        return;
+    }
+
+    ctx->apply_headers();
 
-    // Send the request to asynchronous processing.
-    i.process(std::move(ctx));
+    // Send the request to asynchronous processing, possibly by attaching it
+    // to an identical one that is already in flight.
+    if (i.coalesce) {
+        i.process_coalesced(std::move(ctx), "GET", url);
+    } else {
+        i.process(std::move(ctx));
+    }
 }
 
 
@@ -899,6 +2468,56 @@ void visus::dataverse::dataverse_connection::get(
 }
 
 
+/*
+ * visus::dataverse::dataverse_connection::get
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::get(
+        _In_opt_z_ const wchar_t *resource,
+        _In_ json_sax_handler& handler,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    _CHECK_ON_RESPONSE;
+    _CHECK_ON_ERROR;
+    auto& i = this->check_not_disposed();
+
+    auto ctx = detail::io_context::create(i.make_url(resource),
+        on_response, on_error, context);
+    assert(ctx->curl != nullptr);
+    assert(ctx->client_data == context);
+    ctx->option(CURLOPT_FOLLOWLOCATION, 1L);
+    ctx->prepare_sax(handler);
+
+    i.add_auth_header(ctx);
+    ctx->apply_headers();
+
+    i.process(std::move(ctx));
+
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::dataverse_connection::get
+ */
+visus::dataverse::dataverse_connection&
+visus::dataverse::dataverse_connection::get(
+        _In_ const const_narrow_string& resource,
+        _In_ json_sax_handler& handler,
+        _In_ const on_response_type on_response,
+        _In_ const on_error_type on_error,
+        _In_opt_ void *context) {
+    if (resource == nullptr) {
+        auto r = static_cast<wchar_t *>(nullptr);
+        return this->get(r, handler, on_response, on_error, context);
+    } else {
+        auto r = convert<wchar_t>(resource);
+        return this->get(r.c_str(), handler, on_response, on_error, context);
+    }
+}
+
+
 /*
  * visus::dataverse::dataverse_connection::post
  */
@@ -995,8 +2614,9 @@ void visus::dataverse::dataverse_connection::post(
     assert(!form);
     ctx->configure_on_api_response(const_cast<void *>(on_api_response));
 
-    // Context has taken ownership of CURL object, so erase it from form.
-    form._curl = nullptr;
+    // Context has taken ownership of CURL object, so erase it from the form,
+    // which has been moved into the context along with the handle.
+    ctx->form._curl = nullptr;
 
     ctx->option(CURLOPT_MIMEPOST, ctx->form._form);
 
@@ -1253,8 +2873,44 @@ void visus::dataverse::dataverse_connection::put(
         context);
 }
 
+
+/*
+ * visus::dataverse::dataverse_connection::register_file
+ */
+void visus::dataverse::dataverse_connection::register_file(
+        _In_ detail::direct_upload_context *context) {
+    assert(context != nullptr);
+
+    context->handle_errors([context](void) {
+        const auto desc = context->description.dump();
+
+        // Create the final request, which uses the user-facing callbacks
+        // directly.
+        auto c = detail::io_context::create(context->registration_url,
+            context->on_response, context->on_error, context->user_context);
+        c->progress.context = context->progress_context;
+
+        // Add the previously compiled JSON data to the request.
+        c->form = form_data(c->curl.get());
+        c->form._curl = nullptr;    // Owned by context!
+        c->form.add_field("jsonData", desc.c_str());
+        c->option(CURLOPT_MIMEPOST, c->form._form);
+
+        // This time, we need the Dataverse authentication.
+        context->connection->add_auth_header(c);
+        c->apply_headers();
+
+        // Post the final request.
+        context->connection->process(std::move(c));
+
+        // We do not need the context anymore. Note that 'handle_errors' will
+        // delete it in case of an exception in the code above, so we do not
+        // have to care about this.
+        delete context;
+    });
+}
+
+
 #undef _CHECK_API_ON_RESPONSE
 #undef _CHECK_ON_RESPONSE
 #undef _CHECK_ON_ERROR
-#undef _DATAVERSE_HASH_ALGORITHMA
-#undef _DATAVERSE_HASH_ALGORITHMW
@@ -9,11 +9,13 @@
 #include <tchar.h>
 #endif /* defined(_WIN32) */
 
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 #include <string>
 
 #include "dataverse/convert.h"
+#include "dataverse/json_view.h"
 
 #include "curl_error_category.h"
 #include "curlm_error_category.h"
@@ -108,8 +110,17 @@ void visus::dataverse::detail::dataverse_connection_impl::secure_zero(
  */
 visus::dataverse::detail::dataverse_connection_impl::dataverse_connection_impl(
         void)
-    : curlm(::curl_multi_init(), &::curl_multi_cleanup),
-        timeout(1000) { }
+    : checksum_algorithm("MD5"),
+        coalesce(false),
+        curlm(::curl_multi_init(), &::curl_multi_cleanup),
+        resume_requested(false),
+        worker_state(curl_worker_state::stopped),
+        timeout(1000),
+        upload_parallelism(4),
+        upload_part_size(0),
+        workers(0, "Dataverse++ worker thread"),
+        hashers(0, "Dataverse++ hashing thread",
+            2 * (std::max)(std::thread::hardware_concurrency(), 1u)) { }
 
 
 /*
@@ -117,7 +128,15 @@ visus::dataverse::detail::dataverse_connection_impl::dataverse_connection_impl(
  */
 visus::dataverse::detail::dataverse_connection_impl::~dataverse_connection_impl(
         void) {
+    // Finish all blocking work first, because it might still need the
+    // credentials and hand requests to the curlm thread.
+    this->workers.shutdown();
+    this->hashers.shutdown();
+
     secure_zero(this->api_key);
+    for (auto& r : this->coalescing) {
+        secure_zero(r.second.api_key);
+    }
 
     // Ask the worker thread to stop: here, we can only switch from running to
     // stopping. If the thread is not running, we simply do nothing. Otherwise,
@@ -171,6 +190,168 @@ void visus::dataverse::detail::dataverse_connection_impl::add_auth_header(
 }
 
 
+/*
+ * visus::dataverse::detail::dataverse_connection_impl::add_pending
+ */
+void visus::dataverse::detail::dataverse_connection_impl::add_pending(void) {
+    std::vector<std::unique_ptr<io_context>> pending;
+    {
+        std::lock_guard<decltype(this->pending_lock)> l(this->pending_lock);
+        pending.swap(this->pending);
+    }
+
+    for (auto& p : pending) {
+        const auto status = ::curl_multi_add_handle(this->curlm.get(),
+            p->curl.get());
+        if (status == CURLM_OK) {
+            p.release();
+        } else {
+            std::system_error ex(status, curlm_category());
+            invoke_handler(p->on_error, ex, p->user_data());
+            io_context::recycle(std::move(p));
+        }
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::dataverse_connection_impl::complete
+ */
+void visus::dataverse::detail::dataverse_connection_impl::complete(
+        _In_ io_context& ctx, _In_ const CURLcode result) const {
+    assert(ctx.on_error != nullptr);
+    assert((ctx.on_response != nullptr)
+        || (ctx.on_buffer_response != nullptr));
+
+    if (ctx.cache_hit) {
+        // The response is in memory and shared with the cache, so there is
+        // no need to copy it to the response buffer of the context.
+        assert(ctx.cached_response != nullptr);
+        assert(ctx.on_response != nullptr);
+        ctx.on_response(*ctx.cached_response, ctx.client_data);
+
+    } else if (result == CURLE_OK) {
+        // Request succeeded, but we need to check the HTTP response
+        // to report API errors.
+        long code = 0;
+        const auto status = ::curl_easy_getinfo(ctx.curl.get(),
+            CURLINFO_RESPONSE_CODE, &code);
+        if (status == CURLE_OK) {
+            if ((code < 400) && !ctx.verify_checksum()) {
+                // The transfer succeeded, but the content is not what the
+                // caller expected.
+                ctx.on_error(ERROR_INVALID_DATA,
+                    "The checksum of the received data does not match the "
+                    "expected checksum.",
+                    "Integrity",
+                    dataversepp_code_page,
+                    ctx.user_data());
+            } else if (code < 400) {
+                // This was a total success.
+                ctx.invoke_on_response();
+            } else {
+                // cURL succeeded, but the request failed on a
+                // protocol or application level.
+                try {
+                    const json_view api_response(ctx.response);
+                    const auto msg = api_response.at("/message")
+                        .to_string();
+                    invoke_handler(ctx.on_error,
+                        msg.c_str(),
+                        "API",
+                        dataversepp_code_page,
+                        ctx.user_data());
+                } catch (...) {
+                    std::string msg("HTTP ");
+                    msg += std::to_string(code);
+                    invoke_handler(ctx.on_error,
+                        msg.c_str(),
+                        "HTTP",
+                        dataversepp_code_page,
+                        ctx.user_data());
+                }
+            }
+        } else {
+            // Failed to retrieve the HTTP code, which should not
+            // happen for the requests from our connection objects,
+            // but we still report that to the user.
+            std::system_error e(status, curl_category());
+            invoke_handler(ctx.on_error, e, ctx.user_data());
+        }
+
+    } else if ((result == CURLE_WRITE_ERROR)
+            && ctx.output_truncated) {
+        // The transfer was aborted, because the response did not
+        // fit into the caller-provided buffer. The caller decided
+        // before whether this is acceptable.
+        if (ctx.output_truncate) {
+            ctx.invoke_on_response();
+        } else {
+            std::system_error e(ERROR_INSUFFICIENT_BUFFER,
+                std::system_category());
+            invoke_handler(ctx.on_error, e, ctx.user_data());
+        }
+
+    } else if ((result == CURLE_WRITE_ERROR)
+            && ctx.sax.failed()) {
+        // The transfer was aborted, because the response was
+        // malformed or the SAX handler cancelled it.
+        ctx.invoke_on_sax_error();
+
+    } else {
+        // Request failed.
+        std::system_error e(result, curl_category());
+        invoke_handler(ctx.on_error, e, ctx.user_data());
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::dataverse_connection_impl::detach_waiters
+ */
+std::vector<visus::dataverse::detail::coalesced_request::waiter>
+visus::dataverse::detail::dataverse_connection_impl::detach_waiters(
+        _In_ const io_context *leader) {
+    std::vector<coalesced_request::waiter> retval;
+    std::lock_guard<decltype(this->coalescing_lock)> l(this->coalescing_lock);
+
+    // There are only few requests in flight, so we do not maintain a reverse
+    // mapping from the context to its key.
+    for (auto it = this->coalescing.begin(); it != this->coalescing.end();
+            ++it) {
+        if (it->second.leader == leader) {
+            retval = std::move(it->second.waiters);
+            secure_zero(it->second.api_key);
+            this->coalescing.erase(it);
+            break;
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::dataverse_connection_impl::is_metadata
+ */
+bool visus::dataverse::detail::dataverse_connection_impl::is_metadata(
+        _In_ const std::string& url) const noexcept {
+    static const std::string access("access/");
+
+    if (url.compare(0, this->base_path.size(), this->base_path) != 0) {
+        return false;
+    }
+
+    // Make sure to handle the base path with and without a trailing slash.
+    auto resource = this->base_path.size();
+    while ((resource < url.size()) && (url[resource] == '/')) {
+        ++resource;
+    }
+
+    return (url.compare(resource, access.size(), access) != 0);
+}
+
+
 /*
  * visus::dataverse::detail::dataverse_connection_impl::make_url
  */
@@ -193,31 +374,205 @@ std::string visus::dataverse::detail::dataverse_connection_impl::make_url(
 }
 
 
+/*
+ * visus::dataverse::detail::dataverse_connection_impl::prepare_cached
+ */
+bool visus::dataverse::detail::dataverse_connection_impl::prepare_cached(
+        _Inout_ io_context& request,
+        _In_ const std::string& url) {
+    static const std::string upload_urls("/uploadurls");
+    auto status = response_cache::lookup_result::miss;
+    std::string etag, last_modified;
+
+    // Only metadata are cached. Data files would evict everything else, and
+    // the pre-signed URLs for direct uploads must not be used twice. As the
+    // cache URL remains empty, the response will not be stored either.
+    if (!this->is_metadata(url)
+            || (url.find(upload_urls) != std::string::npos)) {
+        return false;
+    }
+
+    if (this->cache.enabled()) {
+        status = this->cache.lookup(url, this->api_key,
+            request.cached_response, etag, last_modified);
+    }
+
+    if ((status == response_cache::lookup_result::miss)
+            && this->persistent_cache.enabled()) {
+        status = this->persistent_cache.lookup(url, this->api_key,
+            request.cached_response, etag, last_modified);
+
+        if ((status == response_cache::lookup_result::fresh)
+                && this->cache.enabled()) {
+            // Keep the response in memory for the next request.
+            this->cache.store(url, this->api_key, *request.cached_response,
+                std::string(etag), std::string(last_modified));
+        }
+    }
+
+    request.cache_api_key = this->api_key;
+    request.cache_url = url;
+
+    switch (status) {
+        case response_cache::lookup_result::fresh:
+            request.cache_hit = true;
+            return true;
+
+        case response_cache::lookup_result::stale:
+            if (!etag.empty()) {
+                request.add_header(("If-None-Match: " + etag).c_str());
+            }
+            if (!last_modified.empty()) {
+                request.add_header(("If-Modified-Since: "
+                    + last_modified).c_str());
+            }
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::dataverse_connection_impl::pause
+ */
+void visus::dataverse::detail::dataverse_connection_impl::pause(
+        _In_ CURL *curl) {
+    assert(curl != nullptr);
+    if (std::find(this->paused.begin(), this->paused.end(), curl)
+            == this->paused.end()) {
+        this->paused.push_back(curl);
+    }
+}
+
+
 /*
  * visus::dataverse::detail::dataverse_connection_impl::process
  */
 void visus::dataverse::detail::dataverse_connection_impl::process(
         _Inout_ std::unique_ptr<io_context>&& request) {
     assert(request != nullptr);
-    check_code(::curl_multi_add_handle(this->curlm.get(), request->curl.get()));
 
-    auto expected = curl_worker_state::stopped;
-    if (this->worker_state.compare_exchange_strong(expected,
-            curl_worker_state::starting)) {
-        // If the worker thread was not running and not in a transitional state
-        // either, we are the ones who must start it.
-        this->curlm_worker = std::thread(&dataverse_connection_impl::run_curlm,
-            this);
+    if (!this->accept_encoding.empty() && this->is_metadata(request->url)) {
+        // Negotiate the content encoding for JSON responses. cURL transparently
+        // decodes the response before it reaches our write callbacks. Data
+        // files are excluded, because they are often compressed already and
+        // because Content-Length and Content-Range of ranged and resumed
+        // downloads refer to the encoded representation.
+        request->option(CURLOPT_ACCEPT_ENCODING, this->accept_encoding.data());
+    }
 
-    } else if (expected == curl_worker_state::stopping) {
-        // New work was being queued while the destructor of the connection
-        // object was running. This is an error in the application logic.
-        throw std::logic_error("New work has been queued to the asynchronous "
-            "web API while the connection object is being destructed.");
+    this->progress.attach(*request);
+    this->start_curlm();
+
+    // The multi handle must not be used by multiple threads at the same time,
+    // but requests are issued from the caller's thread, from workers and from
+    // callbacks on the curlm thread. Therefore, the curlm thread adds the
+    // request once it is awake. The io_context is owned by the processing
+    // thread from here on.
+    {
+        std::lock_guard<decltype(this->pending_lock)> l(this->pending_lock);
+        this->pending.push_back(std::move(request));
     }
 
-    // The io_context is now owned by the processing thread.
-    request.release();
+    ::curl_multi_wakeup(this->curlm.get());
+}
+
+
+/*
+ * visus::dataverse::detail::dataverse_connection_impl::process_cached
+ */
+void visus::dataverse::detail::dataverse_connection_impl::process_cached(
+        _Inout_ std::unique_ptr<io_context>&& request) {
+    assert(request != nullptr);
+    assert(request->cache_hit);
+
+    {
+        std::lock_guard<decltype(this->cached_lock)> l(this->cached_lock);
+        this->cached.push_back(std::move(request));
+    }
+
+    this->start_curlm();
+    ::curl_multi_wakeup(this->curlm.get());
+}
+
+
+/*
+ * ...::detail::dataverse_connection_impl::process_coalesced
+ */
+void visus::dataverse::detail::dataverse_connection_impl::process_coalesced(
+        _Inout_ std::unique_ptr<io_context>&& request,
+        _In_z_ const char *method,
+        _In_ const std::string& url) {
+    assert(request != nullptr);
+    assert(method != nullptr);
+    std::string key(method);
+    key += ' ';
+    key += url;
+
+    // Note: we must hold the lock until the request has been handed over to
+    // curlm. Otherwise, another thread could attach to a request that is
+    // never being sent.
+    std::lock_guard<decltype(this->coalescing_lock)> l(this->coalescing_lock);
+
+    const auto range = this->coalescing.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.api_key == this->api_key) {
+            // An identical request is in flight, so we only remember whom to
+            // report its outcome to and discard our own one.
+            coalesced_request::waiter waiter;
+            waiter.client_data = request->user_data();
+            waiter.on_api_response = request->on_api_response;
+            waiter.on_error = request->on_error;
+            waiter.on_response = request->on_response;
+            it->second.waiters.push_back(waiter);
+            io_context::recycle(std::move(request));
+            return;
+        }
+    }
+
+    auto it = this->coalescing.emplace(key, coalesced_request());
+    it->second.api_key = this->api_key;
+    it->second.leader = request.get();
+    request->coalesced = true;
+
+    try {
+        this->process(std::move(request));
+    } catch (...) {
+        secure_zero(it->second.api_key);
+        this->coalescing.erase(it);
+        throw;
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::dataverse_connection_impl::resume
+ */
+void visus::dataverse::detail::dataverse_connection_impl::resume(void) {
+    this->resume_requested.store(true);
+    ::curl_multi_wakeup(this->curlm.get());
+}
+
+
+/*
+ * visus::dataverse::detail::dataverse_connection_impl::resume_paused
+ */
+void visus::dataverse::detail::dataverse_connection_impl::resume_paused(
+        void) {
+    if (!this->resume_requested.exchange(false)) {
+        return;
+    }
+
+    // Continuing a transfer might call its read callback right away, which
+    // can pause it again, so we must not iterate over the live list.
+    std::vector<CURL *> paused;
+    paused.swap(this->paused);
+
+    for (auto p : paused) {
+        ::curl_easy_pause(p, CURLPAUSE_CONT);
+    }
 }
 
 
@@ -259,6 +614,8 @@ void visus::dataverse::detail::dataverse_connection_impl::run_curlm(void) {
 
         // Have cURL do its stuff as long as there is work left.
         do {
+            this->add_pending();
+            this->resume_paused();
             auto status = ::curl_multi_perform(this->curlm.get(), &remaining);
             if (remaining != 0) {
                 // If there is work left, wait for it to become ready.
@@ -289,63 +646,134 @@ void visus::dataverse::detail::dataverse_connection_impl::run_curlm(void) {
                 }
 
                 assert(ctx != nullptr);
-                assert(ctx->on_error != nullptr);
-                assert(ctx->on_response != nullptr);
-                if (msg->data.result == CURLE_OK) {
-                    // Request succeeded, but we need to check the HTTP response
-                    // to report API errors.
-                    long code = 0;
-                    const auto status = ::curl_easy_getinfo(msg->easy_handle,
-                        CURLINFO_RESPONSE_CODE, &code);
-                    if (status == CURLE_OK) {
-                        if (code < 400) {
-                            // This was a total success.
-                            ctx->on_response(ctx->response, ctx->client_data);
-                        } else {
-                            // cURL succeeded, but the request failed on a
-                            // protocol or application level.
-                            try {
-                                const auto response = std::string(
-                                    ctx->response.as<char>(),
-                                    ctx->response.size());
-                                const auto api_response = nlohmann::json::parse(
-                                    response);
-                                const auto msg = api_response["message"]
-                                    .get<std::string>();
-                                invoke_handler(ctx->on_error,
-                                    msg.c_str(),
-                                    "API",
-                                    dataversepp_code_page,
-                                    ctx->client_data);
-                            } catch (...) {
-                                std::string msg("HTTP ");
-                                msg += std::to_string(code);
-                                invoke_handler(ctx->on_error,
-                                    msg.c_str(),
-                                    "HTTP",
-                                    dataversepp_code_page,
-                                    ctx->client_data);
-                            }
-                        }
-                    } else {
-                        // Failed to retrieve the HTTP code, which should not
-                        // happen for the requests from our connection objects,
-                        // but we still report that to the user.
-                        std::system_error e(status, curl_category());
-                        invoke_handler(ctx->on_error, e, ctx->client_data);
-                    }
-
-                } else {
-                    // Request failed.
-                    std::system_error e(msg->data.result, curl_category());
-                    invoke_handler(ctx->on_error, e, ctx->client_data);
-                } /* if (msg->data.result == CURLE_OK) */
+
+                // A transfer that failed while it was paused cannot be
+                // resumed anymore.
+                this->paused.erase(std::remove(this->paused.begin(),
+                    this->paused.end(), msg->easy_handle), this->paused.end());
+
+                if (!ctx->cache_url.empty()) {
+                    this->update_cache(*ctx, msg->data.result);
+                }
+
+                // Take the requests that have been attached to this one
+                // before anyone can see the outcome, such that requests made
+                // from within the callbacks cause a new transfer.
+                auto waiters = ctx->coalesced
+                    ? this->detach_waiters(ctx.get())
+                    : std::vector<coalesced_request::waiter>();
+
+                this->complete(*ctx, msg->data.result);
+
+                // Report the very same outcome to all attached requests by
+                // re-targeting the context at their callbacks.
+                for (auto& w : waiters) {
+                    ctx->client_data = w.client_data;
+                    ctx->on_api_response = nullptr;
+                    ctx->on_error = w.on_error;
+                    ctx->on_response = w.on_response;
+                    ctx->configure_on_api_response(w.on_api_response);
+                    this->complete(*ctx, msg->data.result);
+                }
 
                 // Recycle the context including the cURL handle and input data.
                 io_context::recycle(std::move(ctx));
             } /* if (msg->msg == CURLMSG_DONE) */
         } /*  while ((msg = ::curl_multi_info_read(... */
+
+        // Deliver the responses that have been answered from the cache. We
+        // do that on this thread such that callers can rely on the callbacks
+        // not being invoked while they are still issuing the request.
+        {
+            std::vector<std::unique_ptr<io_context>> cached;
+            {
+                std::lock_guard<decltype(this->cached_lock)> l(
+                    this->cached_lock);
+                cached.swap(this->cached);
+            }
+
+            for (auto& c : cached) {
+                this->complete(*c, CURLE_OK);
+                io_context::recycle(std::move(c));
+            }
+        }
     } /* while (this->curlm_running.load()) */
 
     assert(this->worker_state.load() == curl_worker_state::stopping);
 }
+
+
+/*
+ * visus::dataverse::detail::dataverse_connection_impl::start_curlm
+ */
+void visus::dataverse::detail::dataverse_connection_impl::start_curlm(void) {
+    auto expected = curl_worker_state::stopped;
+    if (this->worker_state.compare_exchange_strong(expected,
+            curl_worker_state::starting)) {
+        // If the worker thread was not running and not in a transitional state
+        // either, we are the ones who must start it.
+        this->curlm_worker = std::thread(&dataverse_connection_impl::run_curlm,
+            this);
+
+    } else if (expected == curl_worker_state::stopping) {
+        // New work was being queued while the destructor of the connection
+        // object was running. This is an error in the application logic.
+        throw std::logic_error("New work has been queued to the asynchronous "
+            "web API while the connection object is being destructed.");
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::dataverse_connection_impl::update_cache
+ */
+void visus::dataverse::detail::dataverse_connection_impl::update_cache(
+        _Inout_ io_context& request,
+        _In_ const CURLcode result) {
+    assert(!request.cache_url.empty());
+    if (result != CURLE_OK) {
+        return;
+    }
+
+    long code = 0;
+    ::curl_easy_getinfo(request.curl.get(), CURLINFO_RESPONSE_CODE, &code);
+
+    if ((code == 304) && (request.cached_response != nullptr)) {
+        // The server confirmed our copy, so the callbacks get that one.
+        if (this->cache.enabled()) {
+            this->cache.refresh(request.cache_url, request.cache_api_key);
+        }
+        if (this->persistent_cache.enabled()) {
+            this->persistent_cache.refresh(request.cache_url,
+                request.cache_api_key);
+        }
+        request.cache_hit = true;
+
+    } else if (code == 200) {
+        auto header = [&request](const char *name) {
+            curl_header *h = nullptr;
+            return (::curl_easy_header(request.curl.get(), name, 0,
+                CURLH_HEADER, -1, &h) == CURLHE_OK)
+                ? std::string(h->value)
+                : std::string();
+        };
+
+        if (header("Cache-Control").find("no-store") != std::string::npos) {
+            return;
+        }
+
+        const auto etag = header("ETag");
+        const auto last_modified = header("Last-Modified");
+
+        if (this->persistent_cache.enabled()) {
+            this->persistent_cache.store(request.cache_url,
+                request.cache_api_key, request.response, etag,
+                last_modified);
+        }
+        if (this->cache.enabled()) {
+            this->cache.store(request.cache_url, request.cache_api_key,
+                request.response, std::string(etag),
+                std::string(last_modified));
+        }
+    }
+}
@@ -6,12 +6,15 @@
 #pragma once
 
 #include <atomic>
+#include <cinttypes>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <system_error>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <curl/curl.h>
@@ -19,10 +22,16 @@
 #include "dataverse/convert.h"
 #include "dataverse/event.h"
 
+#include "coalesced_request.h"
 #include "curl_error_category.h"
 #include "curl_worker_state.h"
 #include "curlm_error_category.h"
+#include "disk_cache.h"
+#include "download_cache.h"
 #include "errors.h"
+#include "response_cache.h"
+#include "thread_pool.h"
+#include "transfer_monitor.h"
 
 
 namespace visus {
@@ -84,12 +93,64 @@ namespace detail {
         /// </summary>
         static void secure_zero(_Inout_ string_list_type& list);
 
+        std::vector<char> accept_encoding;
         std::vector<char> api_key;
         std::string base_path;
+        response_cache cache;
+        std::vector<std::unique_ptr<io_context>> cached;
+        std::mutex cached_lock;
+        const char *checksum_algorithm;
+        bool coalesce;
+        std::unordered_multimap<std::string, coalesced_request> coalescing;
+        std::mutex coalescing_lock;
         curlm_type curlm;
+        download_cache downloads;
+
+        /// <summary>
+        /// The easy handles of the transfers that have been paused by their
+        /// read callback, which must only be accessed on the curlm thread.
+        /// </summary>
+        std::vector<CURL *> paused;
+
+        /// <summary>
+        /// The requests that have been issued, but not yet been added to
+        /// <see cref="curlm" />, because only the curlm thread may use the
+        /// multi handle.
+        /// </summary>
+        std::vector<std::unique_ptr<io_context>> pending;
+        std::mutex pending_lock;
+        disk_cache persistent_cache;
+
+        /// <summary>
+        /// Reports the progress of the requests to the user and aggregates it
+        /// for the whole connection.
+        /// </summary>
+        transfer_monitor progress;
+
+        /// <summary>
+        /// Indicates that the curlm thread should continue all
+        /// <see cref="paused" /> transfers.
+        /// </summary>
+        std::atomic<bool> resume_requested;
+
         std::atomic<curl_worker_state> worker_state;
         std::thread curlm_worker;
         int timeout;
+        std::size_t upload_parallelism;
+        std::uint64_t upload_part_size;
+
+        /// <summary>
+        /// The threads performing blocking work like file I/O, which must
+        /// neither happen on the caller's thread nor on the curlm thread.
+        /// </summary>
+        thread_pool workers;
+
+        /// <summary>
+        /// The threads computing the hashes of batches of files that are
+        /// uploaded, which are bounded such that a large batch cannot queue
+        /// an arbitrary amount of work.
+        /// </summary>
+        thread_pool hashers;
 
         /// <summary>
         /// Initialises a new instance.
@@ -106,6 +167,40 @@ namespace detail {
         /// </summary>
         void add_auth_header(_In_ std::unique_ptr<io_context>& ctx) const;
 
+        /// <summary>
+        /// Adds all <see cref="pending" /> requests to <see cref="curlm" />.
+        /// </summary>
+        /// <remarks>
+        /// This method must only be called on the curlm thread. Requests that
+        /// cannot be added are reported to their error handler.
+        /// </remarks>
+        void add_pending(void);
+
+        /// <summary>
+        /// Reports the outcome of the transfer of <paramref name="ctx" /> to
+        /// its callbacks.
+        /// </summary>
+        void complete(_In_ io_context& ctx, _In_ const CURLcode result) const;
+
+        /// <summary>
+        /// Removes the requests waiting for <paramref name="leader" /> from
+        /// <see cref="coalescing" /> and returns them.
+        /// </summary>
+        std::vector<coalesced_request::waiter> detach_waiters(
+            _In_ const io_context *leader);
+
+        /// <summary>
+        /// Answer whether <paramref name="url" /> addresses a metadata
+        /// endpoint of the API, i.e. an endpoint that answers with JSON rather
+        /// than with the contents of a data file.
+        /// </summary>
+        /// <remarks>
+        /// Everything below <see cref="base_path" /> except for the data
+        /// access API (<c>/access/</c>) is considered metadata. URLs outside
+        /// the API, e.g. pre-signed S3 URLs, are not.
+        /// </remarks>
+        bool is_metadata(_In_ const std::string& url) const noexcept;
+
         /// <summary>
         /// Makes an ASCII URL string from the given input.
         /// </summary>
@@ -123,15 +218,80 @@ namespace detail {
         /// </summary>
         std::string make_url(_In_ const const_narrow_string& resource) const;
 
+        /// <summary>
+        /// Remembers that the transfer of <paramref name="curl" /> has been
+        /// paused by its read callback.
+        /// </summary>
+        /// <remarks>
+        /// This method must only be called on the curlm thread, which is where
+        /// curl invokes the read callbacks.
+        /// </remarks>
+        void pause(_In_ CURL *curl);
+
+        /// <summary>
+        /// Looks up the response to the given request in <see cref="cache" />
+        /// and <see cref="persistent_cache" /> and prepares the request for
+        /// storing or revalidating the response.
+        /// </summary>
+        /// <remarks>
+        /// Only responses from metadata endpoints are cached, except for the
+        /// pre-signed URLs for direct uploads.
+        /// </remarks>
+        /// <returns><c>true</c> if the request can be answered from the cache
+        /// without a transfer, <c>false</c> if it must be sent.</returns>
+        bool prepare_cached(_Inout_ io_context& request,
+            _In_ const std::string& url);
+
         /// <summary>
         /// Process the given I/O using curlm.
         /// </summary>
         void process(_Inout_ std::unique_ptr<io_context>&& request);
 
+        /// <summary>
+        /// Hands a request that has been answered from the cache to the curlm
+        /// thread, which invokes its callbacks.
+        /// </summary>
+        void process_cached(_Inout_ std::unique_ptr<io_context>&& request);
+
+        /// <summary>
+        /// Attaches the given I/O to an identical one in flight or processes
+        /// it using curlm if there is none.
+        /// </summary>
+        void process_coalesced(_Inout_ std::unique_ptr<io_context>&& request,
+            _In_z_ const char *method,
+            _In_ const std::string& url);
+
+        /// <summary>
+        /// Asks the curlm thread to continue all <see cref="paused" />
+        /// transfers.
+        /// </summary>
+        void resume(void);
+
+        /// <summary>
+        /// Continues all <see cref="paused" /> transfers if this has been
+        /// requested via <see cref="resume" />.
+        /// </summary>
+        /// <remarks>
+        /// This method must only be called on the curlm thread.
+        /// </remarks>
+        void resume_paused(void);
+
         /// <summary>
         /// The entry point of the curlm thread.
         /// </summary>
         void run_curlm(void);
+
+        /// <summary>
+        /// Makes sure that the curlm thread is running.
+        /// </summary>
+        void start_curlm(void);
+
+        /// <summary>
+        /// Stores the response to the given request in the enabled caches or
+        /// substitutes the cached response if the server confirmed it.
+        /// </summary>
+        void update_cache(_Inout_ io_context& request,
+            _In_ const CURLcode result);
     };
 
 } /* namespace detail */
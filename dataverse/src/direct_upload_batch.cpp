@@ -0,0 +1,189 @@
+﻿// <copyright file="direct_upload_batch.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "direct_upload_batch.h"
+
+#include <cassert>
+
+#include "direct_upload_context.h"
+#include "invoke_handler.h"
+
+
+/*
+ * visus::dataverse::detail::direct_upload_batch::max_in_flight
+ */
+constexpr std::size_t
+visus::dataverse::detail::direct_upload_batch::max_in_flight;
+
+
+/*
+ * visus::dataverse::detail::direct_upload_batch::on_file_error
+ */
+void visus::dataverse::detail::direct_upload_batch::on_file_error(
+        _In_ const int error_code,
+        _In_z_ const char *message,
+        _In_z_ const char *category,
+        _In_ const narrow_string::code_page_type code_page,
+        _In_opt_ void *context) {
+    auto that = static_cast<direct_upload_batch *>(context);
+    assert(that != nullptr);
+    assert(that->on_error != nullptr);
+
+    if (that->register_files == nullptr) {
+        that->on_error(error_code, message, category, code_page,
+            that->user_context);
+
+    } else {
+        std::lock_guard<decltype(that->_lock)> l(that->_lock);
+        if (!that->_failed) {
+            try {
+                that->_error_category = category;
+                that->_error_message = message;
+            } catch (...) { /* We still know that something went wrong. */ }
+            that->_error_code = error_code;
+            that->_error_code_page = code_page;
+            that->_failed = true;
+        }
+    }
+
+    that->release();
+}
+
+
+/*
+ * visus::dataverse::detail::direct_upload_batch::on_file_response
+ */
+void visus::dataverse::detail::direct_upload_batch::on_file_response(
+        _In_ const blob& response,
+        _In_opt_ void *context) {
+    auto that = static_cast<direct_upload_batch *>(context);
+    assert(that != nullptr);
+    assert(that->on_response != nullptr);
+    that->on_response(response, that->user_context);
+    that->release();
+}
+
+
+/*
+ * visus::dataverse::detail::direct_upload_batch::on_file_stored
+ */
+void visus::dataverse::detail::direct_upload_batch::on_file_stored(
+        _In_ direct_upload_context *context) {
+    assert(context != nullptr);
+    auto that = static_cast<direct_upload_batch *>(context->user_context);
+    assert(that != nullptr);
+    assert(that->register_files != nullptr);
+
+    try {
+        std::lock_guard<decltype(that->_lock)> l(that->_lock);
+        that->descriptions.push_back(std::move(context->description));
+    } catch (std::exception& ex) {
+        // Release the context before the error handler might release the
+        // batch.
+        delete context;
+        invoke_handler(on_file_error, ex, that);
+        return;
+    }
+
+    delete context;
+    that->release();
+}
+
+
+/*
+ * visus::dataverse::detail::direct_upload_batch::direct_upload_batch
+ */
+visus::dataverse::detail::direct_upload_batch::direct_upload_batch(
+        _In_ const std::size_t cnt,
+        _In_z_ const char *algorithm,
+        _In_ const dataverse_connection::on_response_type on_response,
+        _In_ const dataverse_connection::on_error_type on_error,
+        _In_opt_ void *context)
+    : algorithm(algorithm),
+        connection(nullptr),
+        descriptions(nlohmann::json::array()),
+        on_error(on_error),
+        on_response(on_response),
+        register_files(nullptr),
+        user_context(context),
+        _error_code(0),
+        _error_code_page(dataversepp_code_page),
+        _failed(false),
+        _in_flight(0),
+        _remaining(cnt) { }
+
+
+/*
+ * visus::dataverse::detail::direct_upload_batch::acquire
+ */
+void visus::dataverse::detail::direct_upload_batch::acquire(void) {
+    std::unique_lock<decltype(this->_lock)> l(this->_lock);
+    assert(this->_in_flight < this->_remaining);
+    this->_not_full.wait(l, [this](void) {
+        return (this->_in_flight < max_in_flight);
+    });
+    ++this->_in_flight;
+}
+
+
+/*
+ * visus::dataverse::detail::direct_upload_batch::finish
+ */
+void visus::dataverse::detail::direct_upload_batch::finish(void) noexcept {
+    assert(this->register_files != nullptr);
+
+    if (this->_failed) {
+        // Do not register anything if a single file is missing, because the
+        // caller would need to find out which one otherwise. The objects
+        // that have been stored remain tagged as temporary in S3.
+        this->on_error(this->_error_code,
+            this->_error_message.c_str(),
+            this->_error_category.c_str(),
+            this->_error_code_page,
+            this->user_context);
+        return;
+    }
+
+    try {
+        this->register_files(*this);
+    } catch (std::system_error ex) {
+        invoke_handler(this->on_error, ex, this->user_context);
+    } catch (std::exception& ex) {
+        invoke_handler(this->on_error, ex, this->user_context);
+    } catch (...) {
+        invoke_handler(this->on_error, this->user_context);
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::direct_upload_batch::release
+ */
+void visus::dataverse::detail::direct_upload_batch::release(void) {
+    bool last = false;
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        assert(this->_in_flight > 0);
+        assert(this->_remaining > 0);
+        --this->_in_flight;
+        last = (--this->_remaining == 0);
+
+        // Notify while still holding the lock, because another file might
+        // complete as the last one and delete the batch right after we have
+        // released the lock.
+        this->_not_full.notify_one();
+    }
+
+    if (last) {
+        if (this->register_files != nullptr) {
+            this->finish();
+        }
+
+        // Nobody can wait for a slot anymore, because all files have been
+        // started and completed.
+        delete this;
+    }
+}
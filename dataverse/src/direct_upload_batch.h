@@ -0,0 +1,179 @@
+﻿// <copyright file="direct_upload_batch.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "dataverse/dataverse_connection.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /* Forward declarations. */
+    class dataverse_connection_impl;
+    struct direct_upload_context;
+
+    /// <summary>
+    /// Tracks a batch of direct uploads started by
+    /// <see cref="dataverse_connection::direct_upload_files" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>The batch limits the number of files that are being hashed or
+    /// uploaded at the same time and forwards the results of the individual
+    /// files to the callbacks of the user. Every file must first
+    /// <see cref="acquire" /> a slot and release it by reporting its result
+    /// via <see cref="on_file_error" /> or <see cref="on_file_response" />.
+    /// </para>
+    /// <para>If <see cref="register_files" /> is set, the files are not
+    /// registered individually. Instead, the files that have been stored
+    /// hand their descriptions to <see cref="on_file_stored" /> and all of
+    /// them are registered with a single request once the last file has
+    /// completed. In this case, the callbacks of the user are only invoked
+    /// once for the whole batch.</para>
+    /// <para>The batch deletes itself once the result of the last file has
+    /// been reported.</para>
+    /// </remarks>
+    struct direct_upload_batch final {
+
+        /// <summary>
+        /// The function registering all files of a batch with a single
+        /// request to <see cref="registration_url" />.
+        /// </summary>
+        typedef void (*register_files_type)(_In_ direct_upload_batch& batch);
+
+        /// <summary>
+        /// The maximum number of files that are being processed at the same
+        /// time.
+        /// </summary>
+        static constexpr std::size_t max_in_flight = 16;
+
+        /// <summary>
+        /// Forwards the error of a single file to <see cref="on_error" />,
+        /// releases its slot and deletes the <paramref name="context" /> if
+        /// this was the last file.
+        /// </summary>
+        /// <remarks>
+        /// If the files are registered together, the error is only recorded
+        /// if it is the first one.
+        /// </remarks>
+        static void on_file_error(_In_ const int error_code,
+            _In_z_ const char *message,
+            _In_z_ const char *category,
+            _In_ const narrow_string::code_page_type code_page,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Forwards the response for a single file to
+        /// <see cref="on_response" />, releases its slot and deletes the
+        /// <paramref name="context" /> if this was the last file.
+        /// </summary>
+        static void on_file_response(_In_ const blob& response,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Adds the description of a file that has been stored in S3 to
+        /// <see cref="descriptions" />, deletes the
+        /// <paramref name="context" /> and releases its slot.
+        /// </summary>
+        static void on_file_stored(_In_ direct_upload_context *context);
+
+        /// <summary>
+        /// The canonical name of the hash algorithm used for all files, which
+        /// is retrieved from the connection on the thread of the caller.
+        /// </summary>
+        const char *algorithm;
+
+        /// <summary>
+        /// The connection used for registering the files together.
+        /// </summary>
+        dataverse_connection_impl *connection;
+
+        /// <summary>
+        /// The descriptions of the files that have been stored, which are
+        /// only complete once the last file has completed.
+        /// </summary>
+        nlohmann::json descriptions;
+
+        /// <summary>
+        /// The error handler installed by the caller.
+        /// </summary>
+        dataverse_connection::on_error_type on_error;
+
+        /// <summary>
+        /// The result handler installed by the caller.
+        /// </summary>
+        dataverse_connection::on_response_type on_response;
+
+        /// <summary>
+        /// If not <c>nullptr</c>, the function registering all files with a
+        /// single request once all of them have been stored.
+        /// </summary>
+        register_files_type register_files;
+
+        /// <summary>
+        /// The URL where the descriptions of all files are posted to if they
+        /// are registered together.
+        /// </summary>
+        std::string registration_url;
+
+        /// <summary>
+        /// The user-specified context pointer to be passed to
+        /// <see cref="on_error" /> and <see cref="on_response" />.
+        /// </summary>
+        void *user_context;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        direct_upload_batch(_In_ const std::size_t cnt,
+            _In_z_ const char *algorithm,
+            _In_ const dataverse_connection::on_response_type on_response,
+            _In_ const dataverse_connection::on_error_type on_error,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Blocks the calling thread until another file can be started.
+        /// </summary>
+        void acquire(void);
+
+    private:
+
+        /// <summary>
+        /// Reports the first error of any file or registers all files with
+        /// a single request.
+        /// </summary>
+        void finish(void) noexcept;
+
+        /// <summary>
+        /// Releases the slot of a file that has completed and deletes the
+        /// batch if this was the last one.
+        /// </summary>
+        /// <remarks>
+        /// The batch must not be accessed anymore after this call.
+        /// </remarks>
+        void release(void);
+
+        std::string _error_category;
+        int _error_code;
+        narrow_string::code_page_type _error_code_page;
+        std::string _error_message;
+        bool _failed;
+        std::size_t _in_flight;
+        std::mutex _lock;
+        std::condition_variable _not_full;
+        std::size_t _remaining;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
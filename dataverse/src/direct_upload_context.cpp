@@ -5,10 +5,23 @@
 
 #include "direct_upload_context.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
 #if !defined(_WIN32)
 #include <fcntl.h>
 #endif /* !defined(_WIN32) */
 
+#include "file_properties.h"
+
+
+/*
+ * visus::dataverse::detail::direct_upload_context::invalid_hashed
+ */
+constexpr std::uint64_t
+visus::dataverse::detail::direct_upload_context::invalid_hashed;
+
 
 /*
  * visus::dataverse::detail::direct_upload_context::forward_error
@@ -28,15 +41,124 @@ void visus::dataverse::detail::direct_upload_context::forward_error(
 }
 
 
+/*
+ * visus::dataverse::detail::direct_upload_context::read_file
+ */
+std::size_t CALLBACK visus::dataverse::detail::direct_upload_context::read_file(
+        _Out_writes_bytes_(cnt *size) char *dst,
+        _In_ const size_t size,
+        _In_ const size_t cnt,
+        _In_opt_ void *context) {
+    auto that = static_cast<direct_upload_context *>(context);
+    assert(that != nullptr);
+
+    if (that->in_memory()) {
+        const auto retval = static_cast<std::size_t>((std::min)(
+            static_cast<std::uint64_t>(size * cnt),
+            that->data_size - that->data_position));
+        ::memcpy(dst, that->data + that->data_position, retval);
+        that->data_position += retval;
+        // In-memory data are hashed before the upload starts.
+        assert(that->checksum == nullptr);
+        return retval;
+    }
+
+#if defined(_WIN32)
+    auto retval = form_data::win32_read(dst, size, cnt, that->file.get());
+#else /* defined(_WIN32) */
+    auto handle = static_cast<std::intptr_t>(that->file.get());
+    auto retval = form_data::posix_read(dst, size, cnt,
+        reinterpret_cast<void *>(handle));
+#endif /* defined(_WIN32) */
+
+    if ((retval != CURL_READFUNC_ABORT)
+            && (that->checksum != nullptr)
+            && (that->hashed != invalid_hashed)) {
+        try {
+            that->checksum->update(dst, retval);
+            that->hashed += retval;
+        } catch (...) {
+            // If the hash failed, we will try again once the upload has
+            // completed, so there is no reason to abort the upload here.
+            that->hashed = invalid_hashed;
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::direct_upload_context::seek_file
+ */
+int CALLBACK visus::dataverse::detail::direct_upload_context::seek_file(
+        _In_opt_ void *context,
+        _In_ const std::streamoff offset,
+        _In_ const int origin) {
+    auto that = static_cast<direct_upload_context *>(context);
+    assert(that != nullptr);
+
+    if (that->in_memory()) {
+        if ((origin != SEEK_SET) || (offset < 0)
+                || (static_cast<std::uint64_t>(offset) > that->data_size)) {
+            return CURL_SEEKFUNC_CANTSEEK;
+        }
+
+        that->data_position = static_cast<std::uint64_t>(offset);
+        return CURL_SEEKFUNC_OK;
+    }
+
+#if defined(_WIN32)
+    auto retval = form_data::win32_seek(that->file.get(), offset, origin);
+#else /* defined(_WIN32) */
+    auto handle = static_cast<std::intptr_t>(that->file.get());
+    auto retval = form_data::posix_seek(reinterpret_cast<void *>(handle),
+        offset, origin);
+#endif /* defined(_WIN32) */
+
+    if ((retval == CURL_SEEKFUNC_OK) && (that->checksum != nullptr)) {
+        const auto rewind = (origin == SEEK_SET) && (offset == 0);
+
+        if (rewind) {
+            // curl restarts the upload, e.g. after a redirect, which we can
+            // easily handle by restarting the hash.
+            try {
+                that->checksum->reset();
+                that->hashed = 0;
+            } catch (...) {
+                that->hashed = invalid_hashed;
+            }
+
+        } else if ((origin != SEEK_SET)
+                || (static_cast<std::uint64_t>(offset) != that->hashed)) {
+            // Anything else than continuing where we stopped means that we
+            // cannot know the hash of the whole file from what we read.
+            that->hashed = invalid_hashed;
+        }
+    }
+
+    return retval;
+}
+
+
 /*
  * visus::dataverse::detail::direct_upload_context::direct_upload_context
  */
 visus::dataverse::detail::direct_upload_context::direct_upload_context(
         _In_ dataverse_connection_impl *connection,
+        _In_z_ const char *algorithm,
         _In_ const dataverse_connection::on_response_type on_response,
         _In_ dataverse_connection::on_error_type on_error,
         _In_opt_ void *context)
-    : connection(connection), on_error(on_error), on_response(on_response),
+    : algorithm(algorithm),
+        checksum(new hash_context(algorithm)),
+        connection(connection), data(nullptr), data_deleter(nullptr),
+        data_position(0), data_size(0), hashed(0), on_error(on_error),
+        on_response(on_response),
+        on_stored(nullptr),
+        parallelism(connection->upload_parallelism),
+        part_size(connection->upload_part_size),
+        progress_context(context),
         user_context(context) { }
 
 
@@ -44,7 +166,43 @@ visus::dataverse::detail::direct_upload_context::direct_upload_context(
  * visus::dataverse::detail::direct_upload_context::~direct_upload_context
  */
 visus::dataverse::detail::direct_upload_context::~direct_upload_context(
-    void) { }
+        void) {
+    if ((this->data != nullptr) && (this->data_deleter != nullptr)) {
+        this->data_deleter(this->data);
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::direct_upload_context::file_hash
+ */
+std::string visus::dataverse::detail::direct_upload_context::file_hash(void) {
+    if (this->checksum == nullptr) {
+        return this->description["checksum"]["@value"].get<std::string>();
+    }
+
+    if (this->hash_available()) {
+        return this->checksum->finish();
+    } else {
+        const auto properties = get_file_properties(this->path.c_str(),
+            this->algorithm);
+        return properties["checksum"]["@value"].get<std::string>();
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::direct_upload_context::hash_available
+ */
+bool visus::dataverse::detail::direct_upload_context::hash_available(
+        void) const {
+    if (this->checksum == nullptr) {
+        return true;
+    }
+
+    const auto size = this->description["fileSize"].get<std::uint64_t>();
+    return (this->hashed == size);
+}
 
 
 /*
@@ -52,17 +210,23 @@ visus::dataverse::detail::direct_upload_context::~direct_upload_context(
  */
 std::string visus::dataverse::detail::direct_upload_context::upload_url(
         _In_ const blob& response) {
-    const std::string utf8(response.as<char>(), response.size());
-    const auto json = nlohmann::json::parse(utf8);
+    const json_view json(response);
 
-    if (json["status"] != "OK") {
+    if (!json.at("/status").equals("OK")) {
         // We received an API error.
-        const auto msg = json["message"].get<std::string>();
+        const auto msg = json.at("/message").to_string();
         throw std::runtime_error(msg.c_str());
     }
 
     // Remmeber the storage identifier for later.
-    this->description["storageIdentifier"] = json["data"]["storageIdentifier"];
+    const auto data = json.at("/data");
+    this->description["storageIdentifier"] = data.at("/storageIdentifier")
+        .to_string();
+
+    if (multipart_upload::is_multipart(data)) {
+        this->multipart.reset(new multipart_upload(this, data));
+        return std::string();
+    }
 
-    return json["data"]["url"].get<std::string>();
+    return data.at("/url").to_string();
 }
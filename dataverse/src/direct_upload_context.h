@@ -5,6 +5,9 @@
 
 #pragma once
 
+#include <cinttypes>
+#include <limits>
+#include <memory>
 #include <string>
 #include <stdexcept>
 #include <system_error>
@@ -14,8 +17,10 @@
 #include "dataverse/dataverse_connection.h"
 
 #include "dataverse_connection_impl.h"
+#include "hash_context.h"
 #include "invoke_handler.h"
 #include "io_context.h"
+#include "multipart_upload.h"
 
 
 namespace visus {
@@ -28,6 +33,13 @@ namespace detail {
     /// </summary>
     struct direct_upload_context final {
 
+        /// <summary>
+        /// Marks <see cref="hashed" /> as invalid, i.e. as not describing a
+        /// contiguous prefix of the file anymore.
+        /// </summary>
+        static constexpr std::uint64_t invalid_hashed
+            = (std::numeric_limits<std::uint64_t>::max)();
+
         /// <summary>
         /// Forwards the error to <see cref="on_error" /> and deletes the
         /// <paramref name="context" />.
@@ -38,11 +50,79 @@ namespace detail {
             _In_ const narrow_string::code_page_type code_page,
             _In_opt_ void *context);
 
+        /// <summary>
+        /// Reads the next chunk of the file for the S3 upload and adds it to
+        /// the <see cref="checksum" /> on the fly.
+        /// </summary>
+        /// <remarks>
+        /// <para>The context pointer must be the
+        /// <see cref="direct_upload_context" /> rather than the file handle.
+        /// </para>
+        /// <para>In-memory uploads are copied directly from the buffer of
+        /// the caller into the buffer of curl.</para>
+        /// </remarks>
+        static std::size_t CALLBACK read_file(
+            _Out_writes_bytes_(cnt *size) char *dst,
+            _In_ const size_t size,
+            _In_ const size_t cnt,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Repositions the file for the S3 upload, which invalidates the
+        /// running <see cref="checksum" /> unless curl rewinds to the begin.
+        /// </summary>
+        static int CALLBACK seek_file(_In_opt_ void *context,
+            _In_ const std::streamoff offset,
+            _In_ const int origin);
+
+        /// <summary>
+        /// The canonical name of the hash algorithm used for the checksum of
+        /// the file, which is determined by the connection when the upload
+        /// is started by the caller.
+        /// </summary>
+        const char *algorithm;
+
+        /// <summary>
+        /// The hash of the file, which is computed while the file is being
+        /// uploaded to S3.
+        /// </summary>
+        /// <remarks>
+        /// If the hash has been computed before the upload started, this
+        /// is <c>nullptr</c> and the hash is already in
+        /// <see cref="description" />.
+        /// </remarks>
+        std::unique_ptr<hash_context> checksum;
+
         /// <summary>
         /// The connection to use for follow-up requests.
         /// </summary>
         dataverse_connection_impl *connection;
 
+        /// <summary>
+        /// The in-memory data to be uploaded instead of <see cref="file" />,
+        /// which are owned by the context if <see cref="data_deleter" /> is
+        /// set.
+        /// </summary>
+        const blob::byte_type *data;
+
+        /// <summary>
+        /// The callback releasing <see cref="data" /> when the context is
+        /// destroyed, which may be <c>nullptr</c> if the caller retains
+        /// ownership.
+        /// </summary>
+        dataverse_connection::data_deleter_type data_deleter;
+
+        /// <summary>
+        /// The position of the next byte of <see cref="data" /> to be read
+        /// for a single PUT.
+        /// </summary>
+        std::uint64_t data_position;
+
+        /// <summary>
+        /// The size of <see cref="data" /> in bytes.
+        /// </summary>
+        std::uint64_t data_size;
+
         /// <summary>
         /// The description posted when registering the file.
         /// </summary>
@@ -57,6 +137,18 @@ namespace detail {
         /// </remarks>
         io_context::file_type file;
 
+        /// <summary>
+        /// The number of bytes from the begin of the file that have been
+        /// added to <see cref="checksum" />.
+        /// </summary>
+        std::uint64_t hashed;
+
+        /// <summary>
+        /// The state of the transfer if the server requested a multipart
+        /// upload, or <c>nullptr</c> for a single PUT.
+        /// </summary>
+        std::unique_ptr<multipart_upload> multipart;
+
         /// <summary>
         /// The error handler installed by the caller.
         /// </summary>
@@ -67,11 +159,52 @@ namespace detail {
         /// </summary>
         dataverse_connection::on_response_type on_response;
 
+        /// <summary>
+        /// The continuation that is invoked once the file has been stored in
+        /// S3 and its checksum has been added to the description.
+        /// </summary>
+        /// <remarks>
+        /// If this is <c>nullptr</c> when the upload starts, the file is
+        /// registered on its own.
+        /// </remarks>
+        multipart_upload::on_stored_type on_stored;
+
+        /// <summary>
+        /// The maximum number of parts of a multipart upload that are
+        /// transferred at the same time.
+        /// </summary>
+        std::size_t parallelism;
+
+        /// <summary>
+        /// The minimum size of the parts of a multipart upload requested by
+        /// the user, or zero for using the size requested by the server.
+        /// </summary>
+        std::uint64_t part_size;
+
+        /// <summary>
+        /// The path to the file to be uploaded, which we need in case the
+        /// hash cannot be computed on the fly.
+        /// </summary>
+        std::wstring path;
+
+        /// <summary>
+        /// The context pointer passed to the progress handler of the
+        /// connection, which is the context of the user even if the file is
+        /// part of a batch.
+        /// </summary>
+        void *progress_context;
+
         /// <summary>
         /// The registration URL where the metadata need to be posted to.
         /// </summary>
         std::string registration_url;
 
+        /// <summary>
+        /// The URL of the request for the one-time upload URL(s), which lacks
+        /// the size of the file.
+        /// </summary>
+        std::string upload_urls_url;
+
         /// <summary>
         /// The user-specified context pointer to be passed to
         /// <see cref="on_error" /> and <see cref="on_response" />.
@@ -81,7 +214,16 @@ namespace detail {
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
+        /// <param name="connection">The connection performing the upload.
+        /// </param>
+        /// <param name="algorithm">The canonical name of the hash algorithm,
+        /// which must be a static string retrieved on the thread of the
+        /// caller rather than on a worker.</param>
+        /// <param name="on_response">The result handler.</param>
+        /// <param name="on_error">The error handler.</param>
+        /// <param name="context">The user-defined context pointer.</param>
         direct_upload_context(_In_ dataverse_connection_impl *connection,
+            _In_z_ const char *algorithm,
             _In_ const dataverse_connection::on_response_type on_response,
             _In_ dataverse_connection::on_error_type on_error,
             _In_opt_ void *context);
@@ -111,11 +253,42 @@ namespace detail {
             }
         }
 
+        /// <summary>
+        /// Answer the hash of the uploaded file using
+        /// <see cref="algorithm" />.
+        /// </summary>
+        /// <remarks>
+        /// If the hash has been computed in advance or if the whole file has
+        /// passed <see cref="read_file" /> in order, the hash is already
+        /// available. Otherwise, e.g. if curl sought in the file, the file is
+        /// hashed again, which is why the method should only be called on a
+        /// worker thread unless <see cref="hash_available" /> is <c>true</c>.
+        /// </remarks>
+        std::string file_hash(void);
+
+        /// <summary>
+        /// Answer whether <see cref="file_hash" /> can answer the hash without
+        /// reading the file again.
+        /// </summary>
+        bool hash_available(void) const;
+
+        /// <summary>
+        /// Answer whether the upload is read from <see cref="data" /> rather
+        /// than from <see cref="file" />.
+        /// </summary>
+        inline bool in_memory(void) const noexcept {
+            return !this->file;
+        }
+
         /// <summary>
         /// Process the response we received on the request for an upload URL by
         /// setting the remaining data in the description and returning the URL
         /// itself.
         /// </summary>
+        /// <remarks>
+        /// If the server requested a multipart upload, the method creates
+        /// <see cref="multipart" /> and returns an empty string.
+        /// </remarks>
         std::string upload_url(_In_ const blob& response);
     };
 
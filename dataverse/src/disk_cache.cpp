@@ -0,0 +1,421 @@
+﻿// <copyright file="disk_cache.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "disk_cache.h"
+
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <bcrypt.h>
+
+#include <wil/resource.h>
+#else /* defined(_WIN32) */
+#include <unistd.h>
+
+#include <openssl/evp.h>
+#endif /* defined(_WIN32) */
+
+#include "dataverse/convert.h"
+
+#include "cache_directory.h"
+#include "dataverse_connection_impl.h"
+#include "ntstatus_error_category.h"
+#include "on_exit.h"
+#include "openssl_error_category.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// The first line of every cache file, which allows for changing the
+    /// format later.
+    /// </summary>
+    static constexpr const char disk_cache_magic[] = "Dataverse++ cache 1\n";
+
+    /// <summary>
+    /// The number of digits of the validation time following the magic
+    /// string.
+    /// </summary>
+    static constexpr std::size_t disk_cache_time_digits = 20;
+
+    /// <summary>
+    /// Computes the SHA-256 hash of the given data as hex string.
+    /// </summary>
+    static std::string disk_cache_hash(_In_ const std::vector<char>& data) {
+        std::array<unsigned char, 32> hash;
+
+#if defined(_WIN32)
+        wil::unique_bcrypt_algorithm algorithm;
+        wil::unique_bcrypt_hash h;
+
+        {
+            auto status = ::BCryptOpenAlgorithmProvider(algorithm.addressof(),
+                BCRYPT_SHA256_ALGORITHM, nullptr, 0);
+            if (!NT_SUCCESS(status)) {
+                throw std::system_error(status, ntstatus_category());
+            }
+        }
+
+        {
+            auto status = ::BCryptCreateHash(algorithm.get(), h.addressof(),
+                nullptr, 0, nullptr, 0, 0);
+            if (!NT_SUCCESS(status)) {
+                throw std::system_error(status, ntstatus_category());
+            }
+        }
+
+        {
+            auto status = ::BCryptHashData(h.get(),
+                reinterpret_cast<PUCHAR>(const_cast<char *>(data.data())),
+                static_cast<ULONG>(data.size()), 0);
+            if (!NT_SUCCESS(status)) {
+                throw std::system_error(status, ntstatus_category());
+            }
+        }
+
+        {
+            auto status = ::BCryptFinishHash(h.get(), hash.data(),
+                static_cast<ULONG>(hash.size()), 0);
+            if (!NT_SUCCESS(status)) {
+                throw std::system_error(status, ntstatus_category());
+            }
+        }
+
+#else /* defined(_WIN32) */
+        unsigned int size = static_cast<unsigned int>(hash.size());
+        if (!::EVP_Digest(data.data(), data.size(), hash.data(), &size,
+                ::EVP_sha256(), nullptr)) {
+            throw std::system_error(::ERR_get_error(), openssl_category());
+        }
+#endif /* defined(_WIN32) */
+
+        static constexpr const char digits[] = "0123456789abcdef";
+        std::string retval(2 * hash.size(), '0');
+        for (std::size_t i = 0; i < hash.size(); ++i) {
+            retval[2 * i] = digits[hash[i] >> 4];
+            retval[2 * i + 1] = digits[hash[i] & 0x0f];
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Opens the given file.
+    /// </summary>
+    template<class TStream>
+    static TStream disk_cache_open(_In_ const std::wstring& path,
+            _In_ const std::ios::openmode mode) {
+#if defined(_WIN32)
+        return TStream(path, mode | std::ios::binary);
+#else /* defined(_WIN32) */
+        return TStream(convert<char>(path, nullptr), mode | std::ios::binary);
+#endif /* defined(_WIN32) */
+    }
+
+    /// <summary>
+    /// Formats the validation time such that it can be updated in place.
+    /// </summary>
+    static std::string disk_cache_time(
+            _In_ const std::chrono::system_clock::time_point time) {
+        typedef std::chrono::milliseconds millis_type;
+        const auto millis = std::chrono::duration_cast<millis_type>(
+            time.time_since_epoch()).count();
+        auto retval = std::to_string((std::max)(millis_type::rep(0), millis));
+        assert(retval.size() <= disk_cache_time_digits);
+        retval.insert(0, disk_cache_time_digits - retval.size(), '0');
+        return retval;
+    }
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
+
+
+/*
+ * visus::dataverse::detail::disk_cache::disk_cache
+ */
+visus::dataverse::detail::disk_cache::disk_cache(void)
+    : _capacity(0), _entries(0), _evictions(0), _hits(0), _misses(0),
+        _revalidations(0), _size(0), _ttl(0) { }
+
+
+/*
+ * visus::dataverse::detail::disk_cache::configure
+ */
+void visus::dataverse::detail::disk_cache::configure(
+        _In_ const std::wstring& directory,
+        _In_ const std::uint64_t capacity,
+        _In_ const duration_type ttl) {
+    auto d = cache_directory::create(directory);
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        this->_capacity = capacity;
+        this->_directory = std::move(d);
+        this->_ttl = (std::max)(duration_type::zero(), ttl);
+    }
+
+    this->trim(capacity);
+}
+
+
+/*
+ * visus::dataverse::detail::disk_cache::enabled
+ */
+bool visus::dataverse::detail::disk_cache::enabled(void) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return !this->_directory.empty();
+}
+
+
+/*
+ * visus::dataverse::detail::disk_cache::lookup
+ */
+visus::dataverse::detail::disk_cache::lookup_result
+visus::dataverse::detail::disk_cache::lookup(
+        _In_ const std::string& url,
+        _In_ const std::vector<char>& api_key,
+        _Out_ response_type& response,
+        _Out_ std::string& etag,
+        _Out_ std::string& last_modified) {
+    try {
+        const auto path = this->path(url, api_key);
+        auto stream = disk_cache_open<std::ifstream>(path, std::ios::in);
+        if (!stream.good()) {
+            ++this->_misses;
+            return lookup_result::miss;
+        }
+
+        // Check the header.
+        std::string magic(sizeof(disk_cache_magic) - 1, '\0');
+        std::string time(disk_cache_time_digits, '\0');
+        std::string u;
+        stream.read(&magic[0], magic.size());
+        stream.read(&time[0], time.size());
+        stream.ignore(1);
+        std::getline(stream, u);
+        std::getline(stream, etag);
+        std::getline(stream, last_modified);
+
+        if (!stream.good() || (magic != disk_cache_magic) || (u != url)) {
+            // Treat corrupted files and hash collisions as if there was no
+            // file at all. The file will be replaced once the response has
+            // been received.
+            ++this->_misses;
+            return lookup_result::miss;
+        }
+
+        // Decide from the header whether the body is needed at all.
+        const clock_type::time_point validated(std::chrono::milliseconds(
+            std::stoull(time)));
+        duration_type ttl;
+        {
+            std::lock_guard<decltype(this->_lock)> l(this->_lock);
+            ttl = this->_ttl;
+        }
+
+        const auto fresh = (clock_type::now() < validated + ttl);
+
+        if (!fresh && etag.empty() && last_modified.empty()) {
+            // The response can neither be used nor revalidated, so it only
+            // occupies space. The estimated size of the directory is
+            // corrected by the next trim.
+            stream.close();
+#if defined(_WIN32)
+            ::DeleteFileW(path.c_str());
+#else /* defined(_WIN32) */
+            ::unlink(convert<char>(path, nullptr).c_str());
+#endif /* defined(_WIN32) */
+            ++this->_misses;
+            return lookup_result::miss;
+        }
+
+        // Read the body.
+        {
+            const auto begin = stream.tellg();
+            stream.seekg(0, std::ios::end);
+            const auto end = stream.tellg();
+            stream.seekg(begin);
+
+            auto r = std::make_shared<blob>(static_cast<std::size_t>(
+                end - begin));
+            stream.read(r->as<char>(), r->size());
+            if (stream.fail()) {
+                ++this->_misses;
+                return lookup_result::miss;
+            }
+
+            response = std::move(r);
+        }
+
+        if (fresh) {
+            // Mark the file as recently used for trimming the directory.
+            cache_directory::touch(path);
+            ++this->_hits;
+            return lookup_result::fresh;
+        }
+
+        return lookup_result::stale;
+
+    } catch (...) {
+        response.reset();
+        ++this->_misses;
+        return lookup_result::miss;
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::disk_cache::refresh
+ */
+void visus::dataverse::detail::disk_cache::refresh(
+        _In_ const std::string& url,
+        _In_ const std::vector<char>& api_key) {
+    ++this->_revalidations;
+
+    try {
+        // Overwrite the time in place, which is cheaper than rewriting the
+        // whole response. Concurrent readers might see a torn time, in which
+        // case they only make an unnecessary request.
+        auto stream = disk_cache_open<std::fstream>(this->path(url, api_key),
+            std::ios::in | std::ios::out);
+        if (stream.good()) {
+            const auto time = disk_cache_time(clock_type::now());
+            stream.seekp(sizeof(disk_cache_magic) - 1);
+            stream.write(time.data(), time.size());
+        }
+    } catch (...) { /* The cache is a best effort. */ }
+}
+
+
+/*
+ * visus::dataverse::detail::disk_cache::statistics
+ */
+visus::dataverse::cache_statistics
+visus::dataverse::detail::disk_cache::statistics(void) const {
+    cache_statistics retval;
+    retval.entries = this->_entries.load();
+    retval.evictions = this->_evictions.load();
+    retval.hits = this->_hits.load();
+    retval.misses = this->_misses.load();
+    retval.revalidations = this->_revalidations.load();
+    retval.size = static_cast<std::size_t>(this->_size.load());
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::disk_cache::store
+ */
+void visus::dataverse::detail::disk_cache::store(
+        _In_ const std::string& url,
+        _In_ const std::vector<char>& api_key,
+        _In_ const blob& response,
+        _In_ const std::string& etag,
+        _In_ const std::string& last_modified) {
+    try {
+        const auto path = this->path(url, api_key);
+        const auto tmp = cache_directory::temporary(path);
+        std::uint64_t size = 0;
+
+        {
+            auto stream = disk_cache_open<std::ofstream>(tmp,
+                std::ios::out | std::ios::trunc);
+            const auto time = disk_cache_time(clock_type::now());
+            stream.write(disk_cache_magic, sizeof(disk_cache_magic) - 1);
+            stream.write(time.data(), time.size());
+            stream << '\n' << url << '\n' << etag << '\n' << last_modified
+                << '\n';
+            stream.write(response.as<char>(), response.size());
+            size = static_cast<std::uint64_t>(stream.tellp());
+            stream.close();
+
+            if (stream.fail()) {
+                throw std::system_error(errno, std::system_category());
+            }
+        }
+
+#if defined(_WIN32)
+        if (!::MoveFileExW(tmp.c_str(), path.c_str(),
+                MOVEFILE_REPLACE_EXISTING)) {
+            ::DeleteFileW(tmp.c_str());
+            return;
+        }
+#else /* defined(_WIN32) */
+        const auto t = convert<char>(tmp, nullptr);
+        if (std::rename(t.c_str(), convert<char>(path, nullptr).c_str())
+                != 0) {
+            ::unlink(t.c_str());
+            return;
+        }
+#endif /* defined(_WIN32) */
+
+        // Replacing an existing response overestimates the number and the
+        // size of the files, which is corrected by the next trim.
+        ++this->_entries;
+
+        std::uint64_t capacity;
+        {
+            std::lock_guard<decltype(this->_lock)> l(this->_lock);
+            capacity = this->_capacity;
+        }
+
+        if ((this->_size += size) > capacity) {
+            this->trim(capacity / 4 * 3);
+        }
+    } catch (...) { /* The cache is a best effort. */ }
+}
+
+
+/*
+ * visus::dataverse::detail::disk_cache::path
+ */
+std::wstring visus::dataverse::detail::disk_cache::path(
+        _In_ const std::string& url,
+        _In_ const std::vector<char>& api_key) const {
+    // Hash the URL together with the API key, such that responses for
+    // different users end up in different files and the API key cannot be
+    // recovered from the name of the file.
+    std::vector<char> key(url.begin(), url.end());
+    key.push_back('\n');
+    key.insert(key.end(), api_key.begin(), api_key.end());
+    on_exit([&key](void) { dataverse_connection_impl::secure_zero(key); });
+
+    const auto hash = disk_cache_hash(key);
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return this->_directory + std::wstring(hash.begin(), hash.end());
+}
+
+
+/*
+ * visus::dataverse::detail::disk_cache::trim
+ */
+void visus::dataverse::detail::disk_cache::trim(
+        _In_ const std::uint64_t capacity) noexcept {
+    std::wstring directory;
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        directory = this->_directory;
+    }
+
+    if (!directory.empty()) {
+        const auto usage = cache_directory::trim(directory, capacity);
+        this->_entries = usage.entries;
+        this->_evictions += usage.evictions;
+        this->_size = usage.size;
+    }
+}
@@ -0,0 +1,165 @@
+﻿// <copyright file="disk_cache.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dataverse/blob.h"
+#include "dataverse/cache_statistics.h"
+
+#include "response_cache.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// A cache of GET responses in a directory that can be shared by
+    /// multiple processes.
+    /// </summary>
+    /// <remarks>
+    /// <para>Every response is stored in its own file, which is named after
+    /// the SHA-256 hash of the URL and the API key the response has been
+    /// retrieved with. The file starts with a small header holding the time
+    /// the response has been validated the last time, the URL and the
+    /// validators of the response. Files are always written to a temporary
+    /// location first and then renamed, such that concurrent readers either
+    /// see the old or the new response, but never a partial one.</para>
+    /// <para>The size of the directory is limited by removing the files that
+    /// have not been used for the longest time. Expired responses without
+    /// validators are removed as soon as they are looked up.</para>
+    /// <para>The cache is a best effort: if the directory cannot be read or
+    /// written, requests are sent as if there was no cache.</para>
+    /// <para>All methods are thread-safe.</para>
+    /// </remarks>
+    class disk_cache final {
+
+    public:
+
+        /// <summary>
+        /// The type used to specify how long responses are fresh.
+        /// </summary>
+        typedef response_cache::duration_type duration_type;
+
+        /// <summary>
+        /// The outcome of a <see cref="lookup" />.
+        /// </summary>
+        typedef response_cache::lookup_result lookup_result;
+
+        /// <summary>
+        /// The type of a response read from the cache.
+        /// </summary>
+        typedef response_cache::response_type response_type;
+
+        /// <summary>
+        /// Initialises a new, disabled cache.
+        /// </summary>
+        disk_cache(void);
+
+        disk_cache(const disk_cache&) = delete;
+
+        /// <summary>
+        /// Sets the directory holding the cache, its maximum size in bytes and
+        /// the time responses remain fresh.
+        /// </summary>
+        /// <remarks>
+        /// The directory is created if it does not exist and trimmed to
+        /// <paramref name="capacity" /> right away. An empty path disables the
+        /// cache, but leaves the files on disk.
+        /// </remarks>
+        void configure(_In_ const std::wstring& directory,
+            _In_ const std::uint64_t capacity,
+            _In_ const duration_type ttl);
+
+        /// <summary>
+        /// Answer whether the cache should be used.
+        /// </summary>
+        bool enabled(void) const;
+
+        /// <summary>
+        /// Looks up the response to <paramref name="url" /> that has been
+        /// retrieved with the given API key.
+        /// </summary>
+        /// <param name="url">The URL of the request.</param>
+        /// <param name="api_key">The API key of the request.</param>
+        /// <param name="response">Receives the cached response if it is either
+        /// fresh or stale.</param>
+        /// <param name="etag">Receives the entity tag of the response.</param>
+        /// <param name="last_modified">Receives the modification date of the
+        /// response.</param>
+        /// <returns>Whether and how the cached response can be used.
+        /// </returns>
+        lookup_result lookup(_In_ const std::string& url,
+            _In_ const std::vector<char>& api_key,
+            _Out_ response_type& response,
+            _Out_ std::string& etag,
+            _Out_ std::string& last_modified);
+
+        /// <summary>
+        /// Marks the response to <paramref name="url" /> fresh again after the
+        /// server confirmed that it has not changed.
+        /// </summary>
+        void refresh(_In_ const std::string& url,
+            _In_ const std::vector<char>& api_key);
+
+        /// <summary>
+        /// Answer statistics about the use of the cache by this process.
+        /// </summary>
+        /// <remarks>
+        /// The number and the size of the entries are determined whenever the
+        /// directory is trimmed and updated by this process in between. They
+        /// are therefore only an estimate if other processes use the
+        /// directory, too.
+        /// </remarks>
+        cache_statistics statistics(void) const;
+
+        /// <summary>
+        /// Stores a response that has just been received.
+        /// </summary>
+        /// <remarks>
+        /// If the estimated size of the directory exceeds the capacity
+        /// afterwards, the least recently used files are removed until three
+        /// quarters of the capacity are left, such that the directory does
+        /// not need to be scanned for every response.
+        /// </remarks>
+        void store(_In_ const std::string& url,
+            _In_ const std::vector<char>& api_key,
+            _In_ const blob& response,
+            _In_ const std::string& etag,
+            _In_ const std::string& last_modified);
+
+        disk_cache& operator =(const disk_cache&) = delete;
+
+    private:
+
+        typedef std::chrono::system_clock clock_type;
+
+        std::wstring path(_In_ const std::string& url,
+            _In_ const std::vector<char>& api_key) const;
+
+        void trim(_In_ const std::uint64_t capacity) noexcept;
+
+        std::uint64_t _capacity;
+        std::wstring _directory;
+        std::atomic<std::size_t> _entries;
+        std::atomic<std::uint64_t> _evictions;
+        std::atomic<std::uint64_t> _hits;
+        mutable std::mutex _lock;
+        std::atomic<std::uint64_t> _misses;
+        std::atomic<std::uint64_t> _revalidations;
+        std::atomic<std::uint64_t> _size;
+        duration_type _ttl;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
@@ -0,0 +1,344 @@
+﻿// <copyright file="download_cache.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "download_cache.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif /* defined(__linux__) */
+#endif /* defined(_WIN32) */
+
+#include "dataverse/convert.h"
+
+#include "cache_directory.h"
+#include "download_checkpoint.h"
+#include "posix_handle.h"
+
+
+/*
+ * visus::dataverse::detail::download_cache::complete
+ */
+void visus::dataverse::detail::download_cache::complete(
+        _In_ const blob& response,
+        _In_opt_ void *context) {
+    std::unique_ptr<fill_context> that(static_cast<fill_context *>(context));
+    assert(that != nullptr);
+    assert(that->cache != nullptr);
+
+    // If we cannot move the file into the cache, we still can hand it out
+    // from its temporary location.
+    const auto cached = that->cache->commit(that->temporary, that->path);
+    const auto& source = cached ? that->path : that->temporary;
+    const auto error = materialise(source, that->destination);
+
+    if (cached) {
+        that->cache->evict();
+    } else {
+        download_checkpoint::erase(that->temporary);
+    }
+
+    if (error == 0) {
+        that->on_response(response, that->user_context);
+    } else {
+        std::system_error e(error, std::system_category());
+        that->on_error(error, e.what(), e.code().category().name(),
+            dataversepp_code_page, that->user_context);
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::download_cache::forward_error
+ */
+void visus::dataverse::detail::download_cache::forward_error(
+        _In_ const int error_code,
+        _In_z_ const char *message,
+        _In_z_ const char *category,
+        _In_ const narrow_string::code_page_type code_page,
+        _In_opt_ void *context) {
+    std::unique_ptr<fill_context> that(static_cast<fill_context *>(context));
+    assert(that != nullptr);
+
+    // A failed download is not resumed, so neither the partial file nor its
+    // checkpoint must stay in the cache.
+    download_checkpoint::erase(that->temporary);
+    download_checkpoint::erase(download_checkpoint::path(
+        that->temporary.c_str()));
+
+    that->on_error(error_code, message, category, code_page,
+        that->user_context);
+}
+
+
+/*
+ * visus::dataverse::detail::download_cache::materialise
+ */
+int visus::dataverse::detail::download_cache::materialise(
+        _In_ const std::wstring& source,
+        _In_ const std::wstring& destination) noexcept {
+#if defined(_WIN32)
+    ::DeleteFileW(destination.c_str());
+
+    if (::CreateHardLinkW(destination.c_str(), source.c_str(), nullptr)) {
+        return 0;
+    }
+
+    if (::CopyFileW(source.c_str(), destination.c_str(), FALSE)) {
+        return 0;
+    }
+
+    return ::GetLastError();
+
+#else /* defined(_WIN32) */
+    try {
+        const auto src = convert<char>(source, nullptr);
+        const auto dst = convert<char>(destination, nullptr);
+        ::unlink(dst.c_str());
+
+        posix_handle input(::open(src.c_str(), O_RDONLY));
+        if (!input) {
+            return errno;
+        }
+
+#if defined(FICLONE)
+        {
+            posix_handle output(::open(dst.c_str(),
+                O_WRONLY | O_CREAT | O_EXCL, 0644));
+            if (output && (::ioctl(output.get(), FICLONE, input.get()) == 0)) {
+                return 0;
+            }
+            if (output) {
+                ::unlink(dst.c_str());
+            }
+        }
+#endif /* defined(FICLONE) */
+
+        if (::link(src.c_str(), dst.c_str()) == 0) {
+            return 0;
+        }
+
+        posix_handle output(::open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+            0644));
+        if (!output) {
+            return errno;
+        }
+
+        std::vector<char> buffer(1024 * 1024);
+        while (true) {
+            const auto cnt = ::read(input.get(), buffer.data(), buffer.size());
+            if (cnt < 0) {
+                const auto retval = errno;
+                ::unlink(dst.c_str());
+                return retval;
+            }
+            if (cnt == 0) {
+                return 0;
+            }
+
+            ssize_t written = 0;
+            while (written < cnt) {
+                const auto w = ::write(output.get(), buffer.data() + written,
+                    cnt - written);
+                if (w < 0) {
+                    const auto retval = errno;
+                    ::unlink(dst.c_str());
+                    return retval;
+                }
+                written += w;
+            }
+        }
+    } catch (std::system_error& ex) {
+        return ex.code().value();
+    } catch (...) {
+        return ENOMEM;
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::dataverse::detail::download_cache::download_cache
+ */
+visus::dataverse::detail::download_cache::download_cache(void)
+    : _capacity(0), _entries(0), _evictions(0), _hits(0), _misses(0),
+        _size(0) { }
+
+
+/*
+ * visus::dataverse::detail::download_cache::configure
+ */
+void visus::dataverse::detail::download_cache::configure(
+        _In_ const std::wstring& directory,
+        _In_ const std::uint64_t capacity) {
+    auto d = cache_directory::create(directory);
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        this->_capacity = capacity;
+        this->_directory = std::move(d);
+    }
+
+    this->evict();
+}
+
+
+/*
+ * visus::dataverse::detail::download_cache::enabled
+ */
+bool visus::dataverse::detail::download_cache::enabled(void) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return !this->_directory.empty();
+}
+
+
+/*
+ * visus::dataverse::detail::download_cache::lookup
+ */
+bool visus::dataverse::detail::download_cache::lookup(
+        _In_ const std::wstring& path,
+        _In_ const std::wstring& destination) {
+    // Note: there is no point in checking whether the file exists first,
+    // because another process could remove it at any time. Therefore, we just
+    // try to use it.
+    if (materialise(path, destination) != 0) {
+        ++this->_misses;
+        return false;
+    }
+
+    // Mark the file as recently used for the eviction policy.
+    cache_directory::touch(path);
+
+    ++this->_hits;
+    return true;
+}
+
+
+/*
+ * visus::dataverse::detail::download_cache::path
+ */
+std::wstring visus::dataverse::detail::download_cache::path(
+        _In_ const std::uint64_t id,
+        _In_z_ const wchar_t *format,
+        _In_z_ const wchar_t *checksum_type,
+        _In_z_ const wchar_t *checksum) const {
+    assert(format != nullptr);
+    assert(checksum_type != nullptr);
+    assert(checksum != nullptr);
+
+    // Only retain characters that are safe in file names on all platforms.
+    auto append = [](std::wstring& dst, const wchar_t *str) {
+        for (; *str != 0; ++str) {
+            const auto c = *str;
+            const auto safe = ((c >= L'0') && (c <= L'9'))
+                || ((c >= L'A') && (c <= L'Z'))
+                || ((c >= L'a') && (c <= L'z'));
+            dst += safe ? c : L'_';
+        }
+    };
+
+    std::wstring retval;
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        retval = this->_directory;
+    }
+
+    append(retval, checksum_type);
+    retval += L'-';
+    append(retval, checksum);
+    retval += L'-';
+    retval += std::to_wstring(id);
+
+    if (*format != 0) {
+        retval += L'-';
+        append(retval, format);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::download_cache::statistics
+ */
+visus::dataverse::cache_statistics
+visus::dataverse::detail::download_cache::statistics(void) const {
+    cache_statistics retval;
+    retval.entries = this->_entries.load();
+    retval.evictions = this->_evictions.load();
+    retval.hits = this->_hits.load();
+    retval.misses = this->_misses.load();
+    retval.revalidations = 0;
+    retval.size = this->_size.load();
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::download_cache::temporary
+ */
+std::wstring visus::dataverse::detail::download_cache::temporary(
+        _In_ const std::wstring& path) const {
+    return cache_directory::temporary(path);
+}
+
+
+/*
+ * visus::dataverse::detail::download_cache::commit
+ */
+bool visus::dataverse::detail::download_cache::commit(
+        _In_ const std::wstring& temporary,
+        _In_ const std::wstring& path) noexcept {
+    // If another process has downloaded the same file in the meantime, we
+    // replace it with our copy, which has the same content.
+#if defined(_WIN32)
+    return (::MoveFileExW(temporary.c_str(), path.c_str(),
+        MOVEFILE_REPLACE_EXISTING) != FALSE);
+#else /* defined(_WIN32) */
+    try {
+        return (std::rename(convert<char>(temporary, nullptr).c_str(),
+            convert<char>(path, nullptr).c_str()) == 0);
+    } catch (...) {
+        return false;
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::dataverse::detail::download_cache::evict
+ */
+void visus::dataverse::detail::download_cache::evict(void) noexcept {
+    std::uint64_t capacity;
+    std::wstring directory;
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        capacity = this->_capacity;
+        directory = this->_directory;
+    }
+
+    if (!directory.empty()) {
+        const auto usage = cache_directory::trim(directory, capacity);
+        this->_entries = usage.entries;
+        this->_evictions += usage.evictions;
+        this->_size = static_cast<std::size_t>(usage.size);
+    }
+}
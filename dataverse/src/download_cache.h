@@ -0,0 +1,159 @@
+﻿// <copyright file="download_cache.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <mutex>
+#include <string>
+
+#include "dataverse/blob.h"
+#include "dataverse/cache_statistics.h"
+#include "dataverse/dataverse_connection.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// A directory of downloaded files that are identified by their database
+    /// ID, their format and their checksum.
+    /// </summary>
+    /// <remarks>
+    /// <para>As the checksum is part of the name, a cached file never needs to
+    /// be revalidated: if the file on the server changes, so does its
+    /// checksum. A file is handed out by reflinking, hard-linking or copying
+    /// it to the destination, in this order of preference.</para>
+    /// <para>Files are downloaded to a temporary name and renamed once they
+    /// are complete, such that multiple processes can share the directory.
+    /// The size of the directory is limited by removing the files that have
+    /// not been used for the longest time.</para>
+    /// </remarks>
+    class download_cache final {
+
+    public:
+
+        /// <summary>
+        /// The context of a download that fills the cache.
+        /// </summary>
+        struct fill_context final {
+            download_cache *cache;
+            std::wstring destination;
+            dataverse_connection::on_error_type on_error;
+            dataverse_connection::on_response_type on_response;
+            std::wstring path;
+            std::wstring temporary;
+            void *user_context;
+        };
+
+        /// <summary>
+        /// Moves the downloaded file into the cache, hands it out to the
+        /// destination and deletes the <see cref="fill_context" />.
+        /// </summary>
+        static void complete(_In_ const blob& response,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Removes the partial file, forwards the error to the user and
+        /// deletes the <see cref="fill_context" />.
+        /// </summary>
+        static void forward_error(_In_ const int error_code,
+            _In_z_ const char *message,
+            _In_z_ const char *category,
+            _In_ const narrow_string::code_page_type code_page,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Makes the file at <paramref name="source" /> available at
+        /// <paramref name="destination" />.
+        /// </summary>
+        /// <remarks>
+        /// The method tries to create a reflink first, which shares the data
+        /// on disk, but not modifications. If the file system does not
+        /// support this, a hard link is created. Only if this fails, too, the
+        /// file is copied. Any existing file at <paramref name="destination" />
+        /// is replaced.
+        /// </remarks>
+        /// <returns>Zero in case of success, the system error code that
+        /// prevented copying the file otherwise.</returns>
+        static int materialise(_In_ const std::wstring& source,
+            _In_ const std::wstring& destination) noexcept;
+
+        /// <summary>
+        /// Initialises a new, disabled cache.
+        /// </summary>
+        download_cache(void);
+
+        download_cache(const download_cache&) = delete;
+
+        /// <summary>
+        /// Sets the directory holding the cache and its maximum size in bytes.
+        /// </summary>
+        /// <remarks>
+        /// The directory is created if it does not exist. An empty path
+        /// disables the cache.
+        /// </remarks>
+        void configure(_In_ const std::wstring& directory,
+            _In_ const std::uint64_t capacity);
+
+        /// <summary>
+        /// Answer whether the cache should be used.
+        /// </summary>
+        bool enabled(void) const;
+
+        /// <summary>
+        /// Hands out the cached file at <paramref name="path" /> to
+        /// <paramref name="destination" /> if it exists.
+        /// </summary>
+        /// <returns><c>true</c> if the file was found and has been made
+        /// available at <paramref name="destination" />, <c>false</c> if it
+        /// needs to be downloaded.</returns>
+        bool lookup(_In_ const std::wstring& path,
+            _In_ const std::wstring& destination);
+
+        /// <summary>
+        /// Answer the location of the file with the given ID, format and
+        /// checksum of the given type in the cache.
+        /// </summary>
+        std::wstring path(_In_ const std::uint64_t id,
+            _In_z_ const wchar_t *format,
+            _In_z_ const wchar_t *checksum_type,
+            _In_z_ const wchar_t *checksum) const;
+
+        /// <summary>
+        /// Answer statistics about the use of the cache.
+        /// </summary>
+        cache_statistics statistics(void) const;
+
+        /// <summary>
+        /// Answer a unique location for downloading the file that should be
+        /// stored at <paramref name="path" />.
+        /// </summary>
+        std::wstring temporary(_In_ const std::wstring& path) const;
+
+        download_cache& operator =(const download_cache&) = delete;
+
+    private:
+
+        bool commit(_In_ const std::wstring& temporary,
+            _In_ const std::wstring& path) noexcept;
+
+        void evict(void) noexcept;
+
+        std::uint64_t _capacity;
+        std::wstring _directory;
+        std::atomic<std::size_t> _entries;
+        std::atomic<std::uint64_t> _evictions;
+        std::atomic<std::uint64_t> _hits;
+        mutable std::mutex _lock;
+        std::atomic<std::uint64_t> _misses;
+        std::atomic<std::size_t> _size;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
@@ -0,0 +1,201 @@
+﻿// <copyright file="download_checkpoint.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "download_checkpoint.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+#include <nlohmann/json.hpp>
+
+#include "dataverse/convert.h"
+
+
+/*
+ * visus::dataverse::detail::download_checkpoint::unknown_size
+ */
+constexpr std::uint64_t
+visus::dataverse::detail::download_checkpoint::unknown_size;
+
+
+/*
+ * visus::dataverse::detail::download_checkpoint::erase
+ */
+void visus::dataverse::detail::download_checkpoint::erase(
+        _In_ const std::wstring& path) noexcept {
+#if defined(_WIN32)
+    ::DeleteFileW(path.c_str());
+#else /* defined(_WIN32) */
+    try {
+        auto p = convert<char>(path, nullptr);
+        ::unlink(p.c_str());
+    } catch (...) { /* Nothing we could do about that. */ }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::dataverse::detail::download_checkpoint::path
+ */
+std::wstring visus::dataverse::detail::download_checkpoint::path(
+        _In_z_ const wchar_t *path) {
+    return std::wstring(path) + L".checkpoint";
+}
+
+
+/*
+ * visus::dataverse::detail::download_checkpoint::download_checkpoint
+ */
+visus::dataverse::detail::download_checkpoint::download_checkpoint(void)
+    : size(unknown_size) { }
+
+
+/*
+ * visus::dataverse::detail::download_checkpoint::add
+ */
+void visus::dataverse::detail::download_checkpoint::add(
+        _In_ const std::uint64_t begin,
+        _In_ const std::uint64_t end) {
+    if (begin >= end) {
+        return;
+    }
+
+    // Find the first range that could be merged with the new one, which is the
+    // first one that does not end before the new one begins.
+    auto it = std::lower_bound(this->ranges.begin(), this->ranges.end(), begin,
+        [](const range_type& r, const std::uint64_t v) {
+            return (r.second < v);
+    });
+
+    range_type merged(begin, end);
+    auto last = it;
+    while ((last != this->ranges.end()) && (last->first <= merged.second)) {
+        merged.first = (std::min)(merged.first, last->first);
+        merged.second = (std::max)(merged.second, last->second);
+        ++last;
+    }
+
+    it = this->ranges.erase(it, last);
+    this->ranges.insert(it, merged);
+}
+
+
+/*
+ * visus::dataverse::detail::download_checkpoint::clear
+ */
+void visus::dataverse::detail::download_checkpoint::clear(void) {
+    this->etag.clear();
+    this->ranges.clear();
+    this->size = unknown_size;
+}
+
+
+/*
+ * visus::dataverse::detail::download_checkpoint::complete
+ */
+bool visus::dataverse::detail::download_checkpoint::complete(
+        void) const noexcept {
+    return (this->size != unknown_size)
+        && (this->resume_offset() >= this->size);
+}
+
+
+/*
+ * visus::dataverse::detail::download_checkpoint::load
+ */
+bool visus::dataverse::detail::download_checkpoint::load(
+        _In_ const std::wstring& path) {
+    this->clear();
+
+    try {
+#if defined(_WIN32)
+        std::ifstream stream(path);
+#else /* defined(_WIN32) */
+        std::ifstream stream(convert<char>(path, nullptr));
+#endif /* defined(_WIN32) */
+        if (!stream.good()) {
+            return false;
+        }
+
+        const auto json = nlohmann::json::parse(stream);
+        this->etag = json["etag"].get<std::string>();
+        this->size = json["size"].get<std::uint64_t>();
+
+        for (auto& r : json["ranges"]) {
+            this->add(r.at(0).get<std::uint64_t>(),
+                r.at(1).get<std::uint64_t>());
+        }
+
+        return true;
+    } catch (...) {
+        // A corrupted checkpoint is as good as none.
+        this->clear();
+        return false;
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::download_checkpoint::resume_offset
+ */
+std::uint64_t visus::dataverse::detail::download_checkpoint::resume_offset(
+        void) const noexcept {
+    return (!this->ranges.empty() && (this->ranges.front().first == 0))
+        ? this->ranges.front().second
+        : 0;
+}
+
+
+/*
+ * visus::dataverse::detail::download_checkpoint::save
+ */
+void visus::dataverse::detail::download_checkpoint::save(
+        _In_ const std::wstring& path) const {
+    auto json = nlohmann::json::object({
+        { "etag", this->etag },
+        { "size", this->size },
+        { "ranges", nlohmann::json::array() }
+    });
+
+    for (auto& r : this->ranges) {
+        json["ranges"].push_back(nlohmann::json::array({ r.first, r.second }));
+    }
+
+    const auto tmp = path + L".tmp";
+
+    {
+#if defined(_WIN32)
+        std::ofstream stream(tmp, std::ios::trunc);
+#else /* defined(_WIN32) */
+        std::ofstream stream(convert<char>(tmp, nullptr), std::ios::trunc);
+#endif /* defined(_WIN32) */
+        stream << json.dump();
+        stream.close();
+
+        if (stream.fail()) {
+            throw std::system_error(errno, std::system_category());
+        }
+    }
+
+#if defined(_WIN32)
+    if (!::MoveFileExW(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+#else /* defined(_WIN32) */
+    if (std::rename(convert<char>(tmp, nullptr).c_str(),
+            convert<char>(path, nullptr).c_str()) != 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+}
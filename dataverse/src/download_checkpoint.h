@@ -0,0 +1,125 @@
+﻿// <copyright file="download_checkpoint.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dataverse/api.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// The persistent state of a resumable download, which is stored in a
+    /// small sidecar file next to the file being downloaded.
+    /// </summary>
+    /// <remarks>
+    /// The checkpoint remembers which byte ranges of the remote file have
+    /// already been written to the local file and which version of the
+    /// remote file (identified by its entity tag and its size) these ranges
+    /// belong to.
+    /// </remarks>
+    struct download_checkpoint final {
+
+        /// <summary>
+        /// A half-open range [first, second) of bytes in the file.
+        /// </summary>
+        typedef std::pair<std::uint64_t, std::uint64_t> range_type;
+
+        /// <summary>
+        /// The value of <see cref="size" /> if the size of the remote file is
+        /// not known.
+        /// </summary>
+        static constexpr std::uint64_t unknown_size
+            = (std::numeric_limits<std::uint64_t>::max)();
+
+        /// <summary>
+        /// Erases the checkpoint file at the given location if it exists.
+        /// </summary>
+        static void erase(_In_ const std::wstring& path) noexcept;
+
+        /// <summary>
+        /// Answer the location of the checkpoint file for the download to
+        /// <paramref name="path" />.
+        /// </summary>
+        static std::wstring path(_In_z_ const wchar_t *path);
+
+        /// <summary>
+        /// The entity tag of the remote file the <see cref="ranges" /> belong
+        /// to, or an empty string if the server did not provide one.
+        /// </summary>
+        std::string etag;
+
+        /// <summary>
+        /// The sorted, non-overlapping ranges that have already been
+        /// downloaded.
+        /// </summary>
+        std::vector<range_type> ranges;
+
+        /// <summary>
+        /// The total size of the remote file in bytes or
+        /// <see cref="unknown_size" />.
+        /// </summary>
+        std::uint64_t size;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        download_checkpoint(void);
+
+        /// <summary>
+        /// Marks the range [<paramref name="begin" />, <paramref name="end" />)
+        /// as downloaded and merges it with adjacent ranges.
+        /// </summary>
+        void add(_In_ const std::uint64_t begin, _In_ const std::uint64_t end);
+
+        /// <summary>
+        /// Forgets all progress, e.g. because the remote file has changed.
+        /// </summary>
+        void clear(void);
+
+        /// <summary>
+        /// Answer whether the whole remote file has been downloaded.
+        /// </summary>
+        bool complete(void) const noexcept;
+
+        /// <summary>
+        /// Loads the checkpoint from the given file.
+        /// </summary>
+        /// <returns><c>true</c> if a valid checkpoint was loaded,
+        /// <c>false</c> if the file does not exist or is not a valid
+        /// checkpoint. In the latter case, the state of the object is the same
+        /// as after <see cref="clear" />.</returns>
+        bool load(_In_ const std::wstring& path);
+
+        /// <summary>
+        /// Answer the offset from which the download must be continued, which
+        /// is the end of the range starting at zero.
+        /// </summary>
+        std::uint64_t resume_offset(void) const noexcept;
+
+        /// <summary>
+        /// Persists the checkpoint in the given file.
+        /// </summary>
+        /// <remarks>
+        /// The checkpoint is first written to a temporary file, which is then
+        /// moved over <paramref name="path" />, such that a crash while
+        /// writing cannot leave a corrupted checkpoint behind.
+        /// </remarks>
+        /// <exception cref="std::system_error">If the checkpoint could not be
+        /// written.</exception>
+        void save(_In_ const std::wstring& path) const;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
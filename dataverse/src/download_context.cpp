@@ -0,0 +1,565 @@
+﻿// <copyright file="download_context.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "download_context.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+#endif /* defined(_WIN32) */
+
+#include "dataverse/convert.h"
+
+#include "errors.h"
+#include "invoke_handler.h"
+
+
+/*
+ * visus::dataverse::detail::download_context::save_interval
+ */
+constexpr std::uint64_t
+visus::dataverse::detail::download_context::save_interval;
+
+
+/*
+ * visus::dataverse::detail::download_context::complete
+ */
+void visus::dataverse::detail::download_context::complete(
+        _In_ const blob& response,
+        _In_opt_ void *context) {
+    auto that = static_cast<download_context *>(context);
+    assert(that != nullptr);
+
+    if (!that->is_content()) {
+        // cURL succeeded, but we did not receive any part of the file, e.g.
+        // because of an unexpected redirect that was not followed.
+        auto msg = std::string("HTTP ") + std::to_string(that->status);
+        forward_error(0, msg.c_str(), "HTTP", dataversepp_code_page, that);
+        return;
+    }
+
+    if ((that->checkpoint.size != download_checkpoint::unknown_size)
+            && (that->offset != that->checkpoint.size)) {
+        // The transfer ended prematurely, so the checkpoint must be preserved
+        // for another attempt.
+        that->error = "The transfer ended before the whole file was received.";
+        forward_error(0, "", "", dataversepp_code_page, that);
+        return;
+    }
+
+    // Close the file before anyone is informed that it is ready and remove the
+    // checkpoint, because there is nothing left to resume. This also holds
+    // if the file is corrupt, because resuming would not repair it.
+    that->file = io_context::file_type();
+    download_checkpoint::erase(that->checkpoint_path);
+
+    if (that->checksum != nullptr) {
+        auto verified = false;
+        try {
+            verified = hash_context::equals(that->checksum->finish(),
+                that->expected_checksum);
+        } catch (...) { /* Report as mismatch. */ }
+
+        if (!verified) {
+            that->on_error(ERROR_INVALID_DATA,
+                "The checksum of the downloaded file does not match the "
+                "expected checksum.",
+                "Integrity",
+                dataversepp_code_page,
+                that->user_context);
+            delete that;
+            return;
+        }
+    }
+
+    that->on_response(response, that->user_context);
+    delete that;
+}
+
+
+/*
+ * visus::dataverse::detail::download_context::forward_error
+ */
+void visus::dataverse::detail::download_context::forward_error(
+        _In_ const int error_code,
+        _In_z_ const char *message,
+        _In_z_ const char *category,
+        _In_ const narrow_string::code_page_type code_page,
+        _In_opt_ void *context) {
+    auto that = static_cast<download_context *>(context);
+    assert(that != nullptr);
+    assert(that->on_error != nullptr);
+
+    if (that->status == 416) {
+        // The requested range is not satisfiable, which means that the remote
+        // file has shrunk and the checkpoint is useless.
+        that->checkpoint.clear();
+    }
+
+    // Remember how far we got such that the caller can resume the download.
+    that->save();
+    that->file = io_context::file_type();
+
+    if (that->error.empty()) {
+        that->on_error(error_code, message, category, code_page,
+            that->user_context);
+    } else {
+        that->on_error(0, that->error.c_str(), "Download",
+            dataversepp_code_page, that->user_context);
+    }
+
+    delete that;
+}
+
+
+/*
+ * visus::dataverse::detail::download_context::read_header
+ */
+std::size_t CALLBACK visus::dataverse::detail::download_context::read_header(
+        _In_reads_bytes_(cnt *size) char *data,
+        _In_ const std::size_t size,
+        _In_ const std::size_t cnt,
+        _In_opt_ void *context) {
+    static constexpr const char content_length[] = "content-length";
+    static constexpr const char content_range[] = "content-range";
+    static constexpr const char etag[] = "etag";
+    static constexpr const char http[] = "HTTP/";
+    auto that = static_cast<download_context *>(context);
+    const auto retval = size * cnt;
+
+    // Strip the line break, which cURL includes in the header data.
+    auto end = data + retval;
+    while ((end > data) && ((end[-1] == '\r') || (end[-1] == '\n'))) {
+        --end;
+    }
+
+    if (::strncmp(data, http, (std::min)(retval, sizeof(http) - 1)) == 0) {
+        // This is the status line of a new response, which might be the
+        // result of following a redirect. Reset everything we have learned
+        // from previous responses.
+        auto s = std::find(data, end, ' ');
+        that->status = (s != end) ? std::strtol(s, nullptr, 10) : 0;
+        that->etag.clear();
+        that->_content_begin = 0;
+        that->_content_length = download_checkpoint::unknown_size;
+        that->_content_total = download_checkpoint::unknown_size;
+        that->response->clear();
+        return retval;
+    }
+
+    if (data == end) {
+        // The empty line marks the end of the header, so we now know everything
+        // to decide whether the response matches what we expect.
+        if (that->is_content() && !that->check_headers()) {
+            return 0;
+        }
+        return retval;
+    }
+
+    auto colon = std::find(data, end, ':');
+    if (colon == end) {
+        // This is not a header we understand.
+        return retval;
+    }
+
+    std::string name(data, colon);
+    std::transform(name.begin(), name.end(), name.begin(),
+        [](const char c) { return static_cast<char>(std::tolower(c)); });
+
+    auto value = colon + 1;
+    while ((value < end) && std::isspace(static_cast<unsigned char>(*value))) {
+        ++value;
+    }
+
+    if (name == etag) {
+        that->etag.assign(value, end);
+
+    } else if (name == content_length) {
+        that->_content_length = std::strtoull(value, nullptr, 10);
+
+    } else if (name == content_range) {
+        // The value should have the form "bytes <first>-<last>/<total>", where
+        // the total might be '*' if it is unknown.
+        auto first = std::find(value, end, ' ');
+        if (first != end) {
+            that->_content_begin = std::strtoull(first + 1, nullptr, 10);
+        }
+
+        auto total = std::find(value, end, '/');
+        if ((total != end) && (total + 1 != end) && (total[1] != '*')) {
+            that->_content_total = std::strtoull(total + 1, nullptr, 10);
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::download_context::write_response
+ */
+std::size_t CALLBACK visus::dataverse::detail::download_context::write_response(
+        _In_reads_bytes_(cnt *size) const void *data,
+        _In_ const std::size_t size,
+        _In_ const std::size_t cnt,
+        _In_opt_ void *context) {
+    auto that = static_cast<download_context *>(context);
+    const auto retval = size * cnt;
+
+    if (!that->is_content()) {
+        // This is not the file, but most likely an error message, which must
+        // go to the I/O context such that it can be reported to the user.
+        const auto offset = that->response->size();
+        that->response->truncate(offset + retval);
+        ::memcpy(that->response->at(offset), data, retval);
+        return retval;
+    }
+
+    try {
+        that->write(data, retval);
+
+        if (that->checksum != nullptr) {
+            that->checksum->update(data, retval);
+        }
+    } catch (std::exception& ex) {
+        that->error = ex.what();
+        return 0;
+    }
+
+    that->checkpoint.add(that->range_begin, that->offset);
+
+    that->unsaved += retval;
+    if (that->unsaved >= save_interval) {
+        that->save();
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::download_context::download_context
+ */
+visus::dataverse::detail::download_context::download_context(
+        _In_ const dataverse_connection::on_response_type on_response,
+        _In_ const dataverse_connection::on_error_type on_error,
+        _In_opt_ void *context)
+    : offset(0),
+        on_error(on_error),
+        on_response(on_response),
+        range_begin(0),
+        response(nullptr),
+        status(0),
+        unsaved(0),
+        user_context(context),
+        _content_begin(0),
+        _content_length(download_checkpoint::unknown_size),
+        _content_total(download_checkpoint::unknown_size) { }
+
+
+/*
+ * visus::dataverse::detail::download_context::open
+ */
+std::uint64_t visus::dataverse::detail::download_context::open(
+        _In_z_ const wchar_t *path,
+        _In_ const bool resume) {
+    assert(path != nullptr);
+    this->checkpoint_path = download_checkpoint::path(path);
+    this->path = path;
+
+    if (!resume || !this->checkpoint.load(this->checkpoint_path)) {
+        this->checkpoint.clear();
+    }
+
+#if defined(_WIN32)
+    this->file.reset(::CreateFileW(path, GENERIC_WRITE, FILE_SHARE_READ,
+        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL));
+    if (!this->file) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+#else /* defined(_WIN32) */
+    auto p = convert<char>(path, -1, nullptr);
+    this->file = ::open(p.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (!this->file) {
+        throw std::system_error(errno, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+
+    auto retval = this->checkpoint.resume_offset();
+
+    if (this->checkpoint.complete() || (retval > this->file_size())) {
+        // If the checkpoint claims that the file is complete, we only got here
+        // because the previous attempt could not remove the checkpoint. As we
+        // cannot validate the file without a request, we start over. The same
+        // applies if the file is shorter than expected, i.e. if someone has
+        // tampered with it since the checkpoint was written.
+        retval = 0;
+    }
+
+    if (retval == 0) {
+        this->checkpoint.clear();
+        this->truncate(0);
+    }
+
+    this->offset = this->range_begin = retval;
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::download_context::save
+ */
+void visus::dataverse::detail::download_context::save(void) noexcept {
+    try {
+        this->checkpoint.save(this->checkpoint_path);
+        this->unsaved = 0;
+    } catch (...) {
+        // Failing to write the checkpoint only means that we cannot resume,
+        // so there is no reason to abort the download. We will retry with the
+        // next chunk.
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::download_context::check_headers
+ */
+bool visus::dataverse::detail::download_context::check_headers(void) {
+    assert(this->is_content());
+    auto total = download_checkpoint::unknown_size;
+
+    if (this->status == 200) {
+        // We received the whole file, either because we did not ask for a
+        // range or because the server found that the file has changed and
+        // ignored the range as requested by "If-Range". In any case, the data
+        // we already have are useless.
+        if ((this->range_begin > 0) || !this->checkpoint.ranges.empty()) {
+            try {
+                this->truncate(0);
+            } catch (std::exception& ex) {
+                this->error = ex.what();
+                return false;
+            }
+        }
+
+        this->checkpoint.clear();
+        this->offset = this->range_begin = 0;
+        total = this->_content_length;
+
+        if (this->checksum != nullptr) {
+            try {
+                this->checksum->reset();
+            } catch (std::exception& ex) {
+                this->error = ex.what();
+                return false;
+            }
+        }
+
+    } else {
+        total = this->_content_total;
+
+        if (this->_content_begin != this->range_begin) {
+            this->error = "The server did not return the requested range of "
+                "the file.";
+            return false;
+        }
+
+        const auto etag_changed = !this->checkpoint.etag.empty()
+            && (this->etag != this->checkpoint.etag);
+        const auto size_changed = (this->checkpoint.size
+            != download_checkpoint::unknown_size)
+            && (total != this->checkpoint.size);
+        if (etag_changed || size_changed) {
+            // The server did not evaluate "If-Range", e.g. because it only
+            // provides weak entity tags, but the file has changed anyway.
+            // The partial file must not be completed with data from the
+            // new version, so discard the progress and have the next attempt
+            // start over.
+            this->checkpoint.clear();
+            this->error = "The remote file has changed since the download was "
+                "interrupted. The checkpoint has been discarded such that the "
+                "next attempt will start from the beginning.";
+            return false;
+        }
+
+        if (this->checksum != nullptr) {
+            // The hash must cover the whole file, so we need to catch up with
+            // what the previous attempts have written.
+            try {
+                this->hash_existing();
+            } catch (std::exception& ex) {
+                this->error = ex.what();
+                return false;
+            }
+        }
+    }
+
+    // Remember the identity of the remote file for the next attempt.
+    this->checkpoint.etag = this->etag;
+    this->checkpoint.size = total;
+    this->save();
+
+    return true;
+}
+
+
+/*
+ * visus::dataverse::detail::download_context::file_size
+ */
+std::uint64_t visus::dataverse::detail::download_context::file_size(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER retval { 0 };
+    if (!::GetFileSizeEx(this->file.get(), &retval)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+    return retval.QuadPart;
+
+#else /* defined(_WIN32) */
+    struct stat s;
+    if (::fstat(this->file.get(), &s) != 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+    return s.st_size;
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::dataverse::detail::download_context::hash_existing
+ */
+void visus::dataverse::detail::download_context::hash_existing(void) {
+    assert(this->checksum != nullptr);
+    std::vector<std::uint8_t> buffer(1024 * 1024);
+    auto remaining = this->range_begin;
+
+    this->checksum->reset();
+
+#if defined(_WIN32)
+    // The output file is write-only, so we need a second handle, which must
+    // share write access with the first one.
+    wil::unique_hfile file(::CreateFileW(this->path.c_str(), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, NULL));
+    if (!file) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+    while (remaining > 0) {
+        const auto cnt = static_cast<DWORD>((std::min)(remaining,
+            static_cast<std::uint64_t>(buffer.size())));
+        DWORD read = 0;
+
+        if (!::ReadFile(file.get(), buffer.data(), cnt, &read, nullptr)) {
+            throw std::system_error(::GetLastError(), std::system_category());
+        }
+        if (read == 0) {
+            throw std::system_error(ERROR_HANDLE_EOF, std::system_category());
+        }
+
+        this->checksum->update(buffer.data(), read);
+        remaining -= read;
+    }
+
+#else /* defined(_WIN32) */
+    auto p = convert<char>(this->path.c_str(), -1, nullptr);
+    posix_handle file(::open(p.c_str(), O_RDONLY));
+    if (!file) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    while (remaining > 0) {
+        const auto cnt = static_cast<std::size_t>((std::min)(remaining,
+            static_cast<std::uint64_t>(buffer.size())));
+        const auto read = ::read(file.get(), buffer.data(), cnt);
+
+        if (read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::system_category());
+        }
+        if (read == 0) {
+            throw std::system_error(ENODATA, std::system_category());
+        }
+
+        this->checksum->update(buffer.data(), read);
+        remaining -= read;
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::dataverse::detail::download_context::truncate
+ */
+void visus::dataverse::detail::download_context::truncate(
+        _In_ const std::uint64_t size) {
+#if defined(_WIN32)
+    LARGE_INTEGER position;
+    position.QuadPart = size;
+    if (!::SetFilePointerEx(this->file.get(), position, nullptr, FILE_BEGIN)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+    if (!::SetEndOfFile(this->file.get())) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+#else /* defined(_WIN32) */
+    if (::ftruncate(this->file.get(), size) != 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::dataverse::detail::download_context::write
+ */
+void visus::dataverse::detail::download_context::write(
+        _In_reads_bytes_(cnt) const void *data,
+        _In_ const std::size_t cnt) {
+    auto cur = static_cast<const std::uint8_t *>(data);
+    auto rem = cnt;
+
+    while (rem > 0) {
+#if defined(_WIN32)
+        OVERLAPPED overlapped { 0 };
+        overlapped.Offset = static_cast<DWORD>(this->offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(this->offset >> 32);
+        DWORD written = 0;
+
+        if (!::WriteFile(this->file.get(), cur, static_cast<DWORD>(rem),
+                &written, &overlapped)) {
+            throw std::system_error(::GetLastError(), std::system_category());
+        }
+
+#else /* defined(_WIN32) */
+        auto written = ::pwrite(this->file.get(), cur, rem, this->offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::system_category());
+        }
+#endif /* defined(_WIN32) */
+
+        cur += written;
+        rem -= written;
+        this->offset += written;
+    }
+}
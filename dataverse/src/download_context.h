@@ -0,0 +1,235 @@
+﻿// <copyright file="download_context.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <system_error>
+
+#include "dataverse/blob.h"
+#include "dataverse/dataverse_connection.h"
+
+#include "download_checkpoint.h"
+#include "hash_context.h"
+#include "io_context.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// The context of a download that is written directly to a file and that
+    /// can be resumed from a <see cref="download_checkpoint" /> if it is
+    /// interrupted.
+    /// </summary>
+    struct download_context final {
+
+        /// <summary>
+        /// The number of bytes after which the checkpoint is persisted while
+        /// the download is in progress.
+        /// </summary>
+        static constexpr std::uint64_t save_interval = 16 * 1024 * 1024;
+
+        /// <summary>
+        /// Finalises the download, removes the checkpoint and forwards the
+        /// response to <see cref="on_response" /> before deleting the
+        /// <paramref name="context" />.
+        /// </summary>
+        static void complete(_In_ const blob& response,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Persists the checkpoint, forwards the error to
+        /// <see cref="on_error" /> and deletes the <paramref name="context" />.
+        /// </summary>
+        static void forward_error(_In_ const int error_code,
+            _In_z_ const char *message,
+            _In_z_ const char *category,
+            _In_ const narrow_string::code_page_type code_page,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// The header callback for cURL, which validates that the remote file
+        /// matches the checkpoint.
+        /// </summary>
+        static std::size_t CALLBACK read_header(
+            _In_reads_bytes_(cnt *size) char *data,
+            _In_ const std::size_t size,
+            _In_ const std::size_t cnt,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// The output callback for cURL, which writes the body to
+        /// <see cref="file" />.
+        /// </summary>
+        static std::size_t CALLBACK write_response(
+            _In_reads_bytes_(cnt *size) const void *data,
+            _In_ const std::size_t size,
+            _In_ const std::size_t cnt,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// The progress made so far.
+        /// </summary>
+        download_checkpoint checkpoint;
+
+        /// <summary>
+        /// The location of the sidecar file <see cref="checkpoint" /> is
+        /// persisted to.
+        /// </summary>
+        std::wstring checkpoint_path;
+
+        /// <summary>
+        /// If set, the hash of the file content received so far, which is
+        /// checked against <see cref="expected_checksum" /> once the download
+        /// is complete.
+        /// </summary>
+        std::unique_ptr<hash_context> checksum;
+
+        /// <summary>
+        /// The entity tag the server sent for the current response.
+        /// </summary>
+        std::string etag;
+
+        /// <summary>
+        /// If non-empty, the reason why the transfer was aborted from one of
+        /// the callbacks, which takes precedence over the error reported by
+        /// cURL.
+        /// </summary>
+        std::string error;
+
+        /// <summary>
+        /// The hex string of the hash that <see cref="checksum" /> must yield.
+        /// </summary>
+        std::string expected_checksum;
+
+        /// <summary>
+        /// The handle of the output file.
+        /// </summary>
+        io_context::file_type file;
+
+        /// <summary>
+        /// The offset in <see cref="file" /> where the next chunk of data will
+        /// be written to.
+        /// </summary>
+        std::uint64_t offset;
+
+        /// <summary>
+        /// The error handler installed by the caller.
+        /// </summary>
+        dataverse_connection::on_error_type on_error;
+
+        /// <summary>
+        /// The final result handler installed by the caller.
+        /// </summary>
+        dataverse_connection::on_response_type on_response;
+
+        /// <summary>
+        /// The location of the output file.
+        /// </summary>
+        std::wstring path;
+
+        /// <summary>
+        /// The offset where the transfer started, which is the begin of the
+        /// range that is currently being downloaded.
+        /// </summary>
+        std::uint64_t range_begin;
+
+        /// <summary>
+        /// The response buffer of the <see cref="io_context" /> performing the
+        /// transfer, which receives all bodies that are not part of the file,
+        /// most importantly API error messages.
+        /// </summary>
+        blob *response;
+
+        /// <summary>
+        /// The HTTP status code of the current response.
+        /// </summary>
+        long status;
+
+        /// <summary>
+        /// The number of bytes written since the last time the checkpoint was
+        /// persisted.
+        /// </summary>
+        std::uint64_t unsaved;
+
+        /// <summary>
+        /// The user-specified context pointer to be passed to
+        /// <see cref="on_error" /> and <see cref="on_response" />.
+        /// </summary>
+        void *user_context;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        download_context(
+            _In_ const dataverse_connection::on_response_type on_response,
+            _In_ const dataverse_connection::on_error_type on_error,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Opens the output file at <paramref name="path" /> and, if
+        /// <paramref name="resume" /> is set, loads the checkpoint of a
+        /// previous attempt.
+        /// </summary>
+        /// <returns>The offset from which the download must be continued.
+        /// </returns>
+        /// <exception cref="std::system_error">If the output file could not
+        /// be opened.</exception>
+        std::uint64_t open(_In_z_ const wchar_t *path, _In_ const bool resume);
+
+        /// <summary>
+        /// Persists the <see cref="checkpoint" /> without throwing.
+        /// </summary>
+        void save(void) noexcept;
+
+    private:
+
+        /// <summary>
+        /// Answer whether <see cref="status" /> indicates that the body of
+        /// the response is (part of) the file.
+        /// </summary>
+        inline bool is_content(void) const noexcept {
+            return (this->status == 200) || (this->status == 206);
+        }
+
+        /// <summary>
+        /// Answer the current size of <see cref="file" />.
+        /// </summary>
+        std::uint64_t file_size(void);
+
+        /// <summary>
+        /// Validates the headers of a response containing file content.
+        /// </summary>
+        bool check_headers(void);
+
+        /// <summary>
+        /// Restarts <see cref="checksum" /> with the first
+        /// <see cref="range_begin" /> bytes of the file, which have been
+        /// written by a previous attempt.
+        /// </summary>
+        void hash_existing(void);
+
+        /// <summary>
+        /// Sets the size of <see cref="file" /> to <paramref name="size" />.
+        /// </summary>
+        void truncate(_In_ const std::uint64_t size);
+
+        /// <summary>
+        /// Writes the given data at <see cref="offset" />.
+        /// </summary>
+        void write(_In_reads_bytes_(cnt) const void *data,
+            _In_ const std::size_t cnt);
+
+        std::uint64_t _content_begin;
+        std::uint64_t _content_length;
+        std::uint64_t _content_total;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
@@ -13,6 +13,9 @@
 
 
 #if !defined(_WIN32)
+#define ERROR_ARITHMETIC_OVERFLOW (ERANGE)
+#define ERROR_INSUFFICIENT_BUFFER (ENOBUFS)
+#define ERROR_INVALID_DATA (EBADMSG)
 #define ERROR_INVALID_HANDLE (EFAULT)
 #define ERROR_INVALID_STATE (ENOTRECOVERABLE)
 #define ERROR_NO_UNICODE_TRANSLATION (EINVAL)
@@ -12,32 +12,25 @@
 
 #include "file_properties.h"
 
-#include <array>
+#include <algorithm>
 #include <cerrno>
+#include <cstring>
+#include <memory>
 #include <system_error>
 #include <vector>
 
 #if defined(_WIN32)
-#include <bcrypt.h>
-#include <ntstatus.h>
-#include <wincrypt.h>
-#include <winerror.h>
-#include <winternl.h>
-
 #include <wil/resource.h>
 #else /* defined(_WIN32) */
+#include <fcntl.h>
 #include <unistd.h>
 
-#include <openssl/evp.h>
-
 #include <sys/stat.h>
 #endif /* defined(_WIN32) */
 
 #include "dataverse/convert.h"
 
-#include "ntstatus_error_category.h"
-#include "on_exit.h"
-#include "openssl_error_category.h"
+#include "hash_context.h"
 #include "posix_handle.h"
 
 
@@ -45,101 +38,47 @@ namespace visus {
 namespace dataverse {
 namespace detail {
 
+    /// <summary>
+    /// Computes the hash of the rest of the given file.
+    /// </summary>
+    /// <remarks>
+    /// The hash context is reused for all files hashed on the same thread
+    /// as long as the algorithm does not change, which saves allocating the
+    /// provider and the hash object each time.
+    /// </remarks>
 #if defined(_WIN32)
-    static nlohmann::json get_file_properties(_In_ wil::unique_hfile& file) {
-        wil::unique_bcrypt_algorithm algorithm;
-        nlohmann::json retval;
-        wil::unique_bcrypt_hash hash;
-        std::vector<UCHAR> hash_value;
-
-        // Open the MD5 provider.
-        {
-            auto status = ::BCryptOpenAlgorithmProvider(algorithm.addressof(),
-                BCRYPT_MD5_ALGORITHM, nullptr, 0);
-            if (!NT_SUCCESS(status)) {
-                throw std::system_error(status, detail::ntstatus_category());
-            }
-        }
-
-        // Determine the size of the hash and allocate space for it.
-        {
-            DWORD hash_length = 0;
-            DWORD len = 0;
-            auto status = ::BCryptGetProperty(algorithm.get(),
-                BCRYPT_HASH_LENGTH, reinterpret_cast<PUCHAR>(&hash_length),
-                sizeof(hash_length), &len, 0);
-            if (!NT_SUCCESS(status)) {
-                throw std::system_error(status, detail::ntstatus_category());
-            }
-
-            hash_value.resize(hash_length);
-        }
-
-        // Create the hash object.
-        {
-            auto status = ::BCryptCreateHash(algorithm.get(), hash.addressof(),
-                nullptr, 0, nullptr, 0, 0);
-            if (!NT_SUCCESS(status)) {
-                throw std::system_error(status, detail::ntstatus_category());
-            }
-        }
-
-        // Update the hash block by block.
-        {
-            std::vector<UCHAR> buffer(8 * retval.size());
-            const auto cnt_buffer = static_cast<DWORD>(buffer.size());
-            DWORD cnt_read = 0;
-
-            do {
-                if (!::ReadFile(file.get(), buffer.data(), cnt_buffer,
-                        &cnt_read, nullptr)) {
-                    auto error = ::GetLastError();
-                    if (error != ERROR_HANDLE_EOF) {
-                        throw std::system_error(error, std::system_category());
-                    }
-                }
-
-                auto status = ::BCryptHashData(hash.get(), buffer.data(),
-                    cnt_read, 0);
-
-                if (!NT_SUCCESS(status)) {
-                    throw std::system_error(status,
-                        detail::ntstatus_category());
-                }
-            } while (cnt_read > 0);
-        }
-
-        // Finalise the hash.
-        {
-            auto size = static_cast<ULONG>(hash_value.size());
-            auto status = ::BCryptFinishHash(hash.get(), hash_value.data(),
-                size, 0);
-            if (!NT_SUCCESS(status)) {
-                throw std::system_error(status, detail::ntstatus_category());
-            }
-        }
-
-        // Convert the hash to a hex string.
-        {
-            const DWORD cnt_input = static_cast<DWORD>(hash_value.size());
-            DWORD cnt_output = 0;
-            const auto flags = CRYPT_STRING_HEXRAW | CRYPT_STRING_NOCRLF;
-
-            if (!::CryptBinaryToStringA(hash_value.data(), cnt_input,
-                    flags, nullptr, &cnt_output)) {
-                throw std::system_error(::GetLastError(),
-                    std::system_category());
-            }
-
-            std::vector<char> output(cnt_output);
+    static std::string file_hash(_In_ HANDLE file,
+            _In_z_ const char *algorithm) {
+#else /* defined(_WIN32) */
+    static std::string file_hash(_In_ const int file,
+            _In_z_ const char *algorithm) {
+#endif /* defined(_WIN32) */
+        thread_local std::unique_ptr<hash_context> hash;
+        thread_local const char *hash_algorithm = nullptr;
+
+        // As the canonical names are static strings, we can compare the
+        // pointers.
+        const auto name = hash_context::canonical_name(algorithm);
+        if ((hash == nullptr) || (hash_algorithm != name)) {
+            hash.reset(new hash_context(name));
+            hash_algorithm = name;
+        } else {
+            // Discard anything left from a previous call that failed.
+            hash->reset();
+        }
+
+        hash->update_file(file);
+        return hash->finish();
+    }
 
-            if (!::CryptBinaryToStringA(hash_value.data(), cnt_input,
-                    flags, output.data(), &cnt_output)) {
-                throw std::system_error(::GetLastError(),
-                    std::system_category());
-            }
+#if defined(_WIN32)
+    static nlohmann::json get_file_properties(_In_ wil::unique_hfile& file,
+            _In_opt_z_ const char *algorithm) {
+        nlohmann::json retval;
 
-            retval["md5Hash"] = output.data();
+        // Compute the hash if requested.
+        if (algorithm != nullptr) {
+            set_checksum(retval, algorithm, file_hash(file.get(), algorithm));
         }
 
         // Determine the total size of the file.
@@ -186,18 +125,19 @@ namespace detail {
  * nlohmann::json visus::dataverse::detail::get_file_properties
  */
 nlohmann::json visus::dataverse::detail::get_file_properties(
-        _In_z_ const wchar_t *path) {
+        _In_z_ const wchar_t *path,
+        _In_opt_z_ const char *algorithm) {
 #if defined(_WIN32)
     wil::unique_hfile file(::CreateFileW(path, GENERIC_READ, FILE_SHARE_READ,
-        nullptr, OPEN_EXISTING, 0, NULL));
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL));
     if (!file) {
         throw std::system_error(::GetLastError(), std::system_category());
     }
 
-    return get_file_properties(file);
+    return get_file_properties(file, algorithm);
 #else /* defined(_WIN32) */
-    auto s = convert<char>(path, 0, nullptr);
-    return get_file_properties(make_narrow_string(s, nullptr));
+    auto s = convert<char>(path, -1, nullptr);
+    return get_file_properties(make_narrow_string(s, nullptr), algorithm);
 #endif /* defined(_WIN32) */
     
 }
@@ -207,77 +147,34 @@ nlohmann::json visus::dataverse::detail::get_file_properties(
  * nlohmann::json visus::dataverse::detail::get_file_properties
  */
 nlohmann::json visus::dataverse::detail::get_file_properties(
-        _In_ const const_narrow_string& path) {
+        _In_ const const_narrow_string& path,
+        _In_opt_z_ const char *algorithm) {
 #if defined(_WIN32)
     wil::unique_hfile file(::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ,
-        nullptr, OPEN_EXISTING, 0, NULL));
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL));
     if (!file) {
         throw std::system_error(::GetLastError(), std::system_category());
     }
 
-    return get_file_properties(file);
+    return get_file_properties(file, algorithm);
 
 #else /* defined(_WIN32) */
     nlohmann::json retval;
 
-    // Compute the hash.
-    {
-        std::array<unsigned char, 8 * EVP_MAX_MD_SIZE> buffer;
-        int cnt_read = 0;
-        EVP_MD_CTX *ctx;
-        std::array<unsigned char, EVP_MAX_MD_SIZE> hash;
-        unsigned int hash_length = hash.size();
-        std::stringstream ss;
-
-        posix_handle file(::open(path.value(), O_RDONLY));
-        if (!file) {
-            throw std::system_error(errno, std::system_category());
-        }
-
-        auto md = ::EVP_get_digestbyname("MD5");
-        if (md == nullptr) {
-            throw std::system_error(::ERR_get_error(), openssl_category());
-        }
-
-        if (!::EVP_MD_CTX_init(ctx)) {
-            throw std::system_error(::ERR_get_error(), openssl_category());
-        }
-
-        on_exit([ctx](void) { ::EVP_MD_CTX_free(ctx); });
-
-        if (!::EVP_DigestInit_ex(ctx, md, nullptr)) {
-            throw std::system_error(::ERR_get_error(), openssl_category());
-        }
-
-        do {
-            cnt_read = ::read(file, buffer.data(), buffer.size());
-            if (cnt_read < 0) {
-                throw std::system_error(errno, std::system_category());
-            }
-
-            if (!::EVP_DigestUpdate(ctx, buffer.data(), cnt_read)) {
-                throw std::system_error(::ERR_get_error(), openssl_category());
-            }
-        } while (cnt_read > 0);
-
-        if (!::EVP_DigestFinal_ex(ctx, hash.data(), &hash_length)) {
-            throw std::system_error(::ERR_get_error(), openssl_category());
-        }
-
-        for (decltype(hash_length) i = 0; i < hash_length; ++i) {
-            ss << std::hex
-                << std::setw(2)
-                << std::setfill('0')
-                << static_cast<int>(hash[i]);
-        }
+    posix_handle file(::open(path.value(), O_RDONLY));
+    if (!file) {
+        throw std::system_error(errno, std::system_category());
+    }
 
-        retval["md5Hash"] = ss.str();
+    // Compute the hash if requested.
+    if (algorithm != nullptr) {
+        set_checksum(retval, algorithm, file_hash(file, algorithm));
     }
 
     // Determine the file size.
     {
         struct stat s;
-        if (::stat(path.value(), &s) == 1) {
+        if (::fstat(file, &s) != 0) {
             throw std::system_error(errno, std::system_category());
         }
 
@@ -299,3 +196,23 @@ nlohmann::json visus::dataverse::detail::get_file_properties(
     return retval;
 #endif /* defined(_WIN32) */
 }
+
+
+/*
+ * void visus::dataverse::detail::set_checksum
+ */
+void visus::dataverse::detail::set_checksum(
+        _Inout_ nlohmann::json& description,
+        _In_z_ const char *algorithm,
+        _In_ const std::string& value) {
+    const auto name = hash_context::canonical_name(algorithm);
+
+    description["checksum"] = nlohmann::json::object({
+        { "@type", name },
+        { "@value", value }
+    });
+
+    if (std::strcmp(name, "MD5") == 0) {
+        description["md5Hash"] = value;
+    }
+}
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <string>
+
 #include <nlohmann/json.hpp>
 
 #include "dataverse/narrow_string.h"
@@ -19,22 +21,53 @@ namespace detail {
     /// the specified location.
     /// </summary>
     /// <param name="path">The path to the file.</param>
+    /// <param name="algorithm">The hash algorithm to compute the checksum of
+    /// the file with, which requires reading the whole file. If this is
+    /// <c>nullptr</c>, only the size and the name are determined.</param>
     /// <returns>A JSON object holding the relevant information to be merged
     /// into the description of a direct upload.</returns>
+    /// <exception cref="std::invalid_argument">If
+    /// <paramref name="algorithm" /> is not supported.</exception>
     /// <exception cref="std::system_error">If any of the required properties
     /// could not be determined.</exception>
-    nlohmann::json get_file_properties(_In_ const wchar_t *path);
+    nlohmann::json get_file_properties(_In_z_ const wchar_t *path,
+        _In_opt_z_ const char *algorithm);
 
     /// <summary>
     /// Gets the file properties required for a direct upload for the file at
     /// the specified location.
     /// </summary>
     /// <param name="path">The path to the file.</param>
+    /// <param name="algorithm">The hash algorithm to compute the checksum of
+    /// the file with, which requires reading the whole file. If this is
+    /// <c>nullptr</c>, only the size and the name are determined.</param>
     /// <returns>A JSON object holding the relevant information to be merged
     /// into the description of a direct upload.</returns>
+    /// <exception cref="std::invalid_argument">If
+    /// <paramref name="algorithm" /> is not supported.</exception>
     /// <exception cref="std::system_error">If any of the required properties
     /// could not be determined.</exception>
-    nlohmann::json get_file_properties(_In_ const const_narrow_string& path);
+    nlohmann::json get_file_properties(_In_ const const_narrow_string& path,
+        _In_opt_z_ const char *algorithm);
+
+    /// <summary>
+    /// Sets the checksum of a file in the description of a direct upload.
+    /// </summary>
+    /// <remarks>
+    /// The checksum is set as &quot;checksum&quot; object, which supports
+    /// all algorithms. MD5 hashes are additionally set as
+    /// &quot;md5Hash&quot;, which is the only field older versions of
+    /// Dataverse understand.
+    /// </remarks>
+    /// <param name="description">The description to add the checksum to.
+    /// </param>
+    /// <param name="algorithm">The name of the hash algorithm.</param>
+    /// <param name="value">The checksum as hex string.</param>
+    /// <exception cref="std::invalid_argument">If
+    /// <paramref name="algorithm" /> is not supported.</exception>
+    void set_checksum(_Inout_ nlohmann::json& description,
+        _In_z_ const char *algorithm,
+        _In_ const std::string& value);
 
 } /* namespace detail */
 } /* namespace dataverse */
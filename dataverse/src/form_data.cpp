@@ -24,6 +24,21 @@
 
 #include "curl_error_category.h"
 #include "errors.h"
+#include "mime_buffer.h"
+
+
+/*
+ * visus::dataverse::form_data::unknown_size
+ */
+constexpr std::size_t visus::dataverse::form_data::unknown_size;
+
+
+/*
+ * visus::dataverse::form_data::pause_read
+ */
+constexpr std::size_t visus::dataverse::form_data::pause_read;
+static_assert(visus::dataverse::form_data::pause_read == CURL_READFUNC_PAUSE,
+    "pause_read matches CURL_READFUNC_PAUSE");
 
 
 /*
@@ -237,6 +252,32 @@ visus::dataverse::form_data& visus::dataverse::form_data::add_field(
 }
 
 
+/*
+ * visus::dataverse::form_data::add_field
+ */
+visus::dataverse::form_data& visus::dataverse::form_data::add_field(
+        _In_z_ const wchar_t *name,
+        _In_reads_bytes_(cnt) const byte_type *data,
+        _In_ const std::size_t cnt,
+        _In_opt_ const data_deleter_type deleter) {
+    // A field is a file without a name as far as curl is concerned.
+    return this->add_file(name, nullptr, data, cnt, deleter);
+}
+
+
+/*
+ * visus::dataverse::form_data::add_field
+ */
+visus::dataverse::form_data& visus::dataverse::form_data::add_field(
+        _In_ const const_narrow_string& name,
+        _In_reads_bytes_(cnt) const byte_type *data,
+        _In_ const std::size_t cnt,
+        _In_opt_ const data_deleter_type deleter) {
+    auto n = convert<wchar_t>(name);
+    return this->add_field(n.c_str(), data, cnt, deleter);
+}
+
+
 /*
  * visus::dataverse::form_data::add_file
  */
@@ -294,6 +335,39 @@ visus::dataverse::form_data& visus::dataverse::form_data::add_file(
         _In_opt_ on_seek_type on_seek,
         _In_opt_ on_close_type on_close,
         _In_opt_ void *context) {
+    return this->add_file(name, nullptr, size, on_read, on_seek, on_close,
+        context);
+}
+
+
+/*
+ * visus::dataverse::form_data::add_file
+ */
+visus::dataverse::form_data& visus::dataverse::form_data::add_file(
+        _In_ const const_narrow_string& name,
+        _In_ const std::size_t size,
+        _In_ on_read_type on_read,
+        _In_opt_ on_seek_type on_seek,
+        _In_opt_ on_close_type on_close,
+        _In_opt_ void *context) {
+    // Note: the direct to_utf8 would do the same internally, so there is no
+    // performance penalty in being lazy here ...
+    auto n = convert<wchar_t>(name);
+    return this->add_file(n.c_str(), size, on_read, on_seek, on_close, context);
+}
+
+
+/*
+ * visus::dataverse::form_data::add_file
+ */
+visus::dataverse::form_data& visus::dataverse::form_data::add_file(
+        _In_z_ const wchar_t *name,
+        _In_opt_z_ const wchar_t *file_name,
+        _In_ const std::size_t size,
+        _In_ on_read_type on_read,
+        _In_opt_ on_seek_type on_seek,
+        _In_opt_ on_close_type on_close,
+        _In_opt_ void *context) {
     this->check_not_disposed();
 
     auto field = ::curl_mime_addpart(this->_form);
@@ -309,8 +383,20 @@ visus::dataverse::form_data& visus::dataverse::form_data::add_file(
         }
     }
 
+    if (file_name != nullptr) {
+        auto n = to_utf8(file_name);
+        auto status = ::curl_mime_filename(field, n.c_str());
+        if (status != CURLE_OK) {
+            throw std::system_error(status, detail::curl_category());
+        }
+    }
+
     {
-        auto status = ::curl_mime_data_cb(field, size, on_read, on_seek,
+        // curl uses chunked transfer encoding for data of unknown size.
+        const auto s = (size == unknown_size)
+            ? static_cast<curl_off_t>(-1)
+            : static_cast<curl_off_t>(size);
+        auto status = ::curl_mime_data_cb(field, s, on_read, on_seek,
             on_close, context);
         if (status != CURLE_OK) {
             throw std::system_error(status, detail::curl_category());
@@ -326,15 +412,71 @@ visus::dataverse::form_data& visus::dataverse::form_data::add_file(
  */
 visus::dataverse::form_data& visus::dataverse::form_data::add_file(
         _In_ const const_narrow_string& name,
+        _In_ const const_narrow_string& file_name,
         _In_ const std::size_t size,
         _In_ on_read_type on_read,
         _In_opt_ on_seek_type on_seek,
         _In_opt_ on_close_type on_close,
         _In_opt_ void *context) {
-    // Note: the direct to_utf8 would do the same internally, so there is no
-    // performance penalty in being lazy here ...
     auto n = convert<wchar_t>(name);
-    return this->add_file(n.c_str(), size, on_read, on_seek, on_close, context);
+    auto f = (file_name.value() != nullptr)
+        ? convert<wchar_t>(file_name)
+        : std::wstring();
+    return this->add_file(n.c_str(),
+        (file_name.value() != nullptr) ? f.c_str() : nullptr,
+        size, on_read, on_seek, on_close, context);
+}
+
+
+/*
+ * visus::dataverse::form_data::add_file
+ */
+visus::dataverse::form_data& visus::dataverse::form_data::add_file(
+        _In_z_ const wchar_t *name,
+        _In_opt_z_ const wchar_t *file_name,
+        _In_reads_bytes_(cnt) const byte_type *data,
+        _In_ const std::size_t cnt,
+        _In_opt_ const data_deleter_type deleter) {
+    // From here on, the buffer owns the data and frees them unless curl has
+    // taken ownership of the buffer.
+    std::unique_ptr<detail::mime_buffer> buffer;
+    try {
+        buffer.reset(new detail::mime_buffer(data, cnt, deleter));
+    } catch (...) {
+        if ((data != nullptr) && (deleter != nullptr)) {
+            deleter(data);
+        }
+        throw;
+    }
+
+    if ((data == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The data of the field must be valid.");
+    }
+
+    this->add_file(name, file_name, cnt, detail::mime_buffer::read,
+        detail::mime_buffer::seek, detail::mime_buffer::free, buffer.get());
+    buffer.release();
+
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::form_data::add_file
+ */
+visus::dataverse::form_data& visus::dataverse::form_data::add_file(
+        _In_ const const_narrow_string& name,
+        _In_ const const_narrow_string& file_name,
+        _In_reads_bytes_(cnt) const byte_type *data,
+        _In_ const std::size_t cnt,
+        _In_opt_ const data_deleter_type deleter) {
+    auto n = convert<wchar_t>(name);
+    auto f = (file_name.value() != nullptr)
+        ? convert<wchar_t>(file_name)
+        : std::wstring();
+    return this->add_file(n.c_str(),
+        (file_name.value() != nullptr) ? f.c_str() : nullptr,
+        data, cnt, deleter);
 }
 
 
@@ -0,0 +1,440 @@
+﻿// <copyright file="hash_context.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "hash_context.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif /* !defined(_WIN32) */
+
+#include "ntstatus_error_category.h"
+#include "on_exit.h"
+#include "openssl_error_category.h"
+
+
+/*
+ * visus::dataverse::detail::hash_context::file_buffer_size
+ */
+constexpr std::size_t
+visus::dataverse::detail::hash_context::file_buffer_size;
+
+
+/*
+ * visus::dataverse::detail::hash_context::small_file_size
+ */
+constexpr std::size_t
+visus::dataverse::detail::hash_context::small_file_size;
+
+
+/*
+ * visus::dataverse::detail::hash_context::file_window_size
+ */
+constexpr std::uint64_t
+visus::dataverse::detail::hash_context::file_window_size;
+
+
+/*
+ * visus::dataverse::detail::hash_context::canonical_name
+ */
+_Ret_z_ const char *visus::dataverse::detail::hash_context::canonical_name(
+        _In_z_ const char *algorithm) {
+    if (algorithm == nullptr) {
+        throw std::invalid_argument("The hash algorithm must be valid.");
+    }
+
+    // Normalise the name such that we accept Dataverse's names as well as the
+    // ones used by OpenSSL.
+    std::string name;
+    for (auto a = algorithm; *a != 0; ++a) {
+        if (*a != '-') {
+            name += static_cast<char>(std::toupper(
+                static_cast<unsigned char>(*a)));
+        }
+    }
+
+    if (name == "MD5") {
+        return "MD5";
+    } else if (name == "SHA1") {
+        return "SHA-1";
+    } else if (name == "SHA256") {
+        return "SHA-256";
+    } else if (name == "SHA512") {
+        return "SHA-512";
+    } else {
+        throw std::invalid_argument("The hash algorithm is not supported.");
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::hash_context::equals
+ */
+bool visus::dataverse::detail::hash_context::equals(
+        _In_ const std::string& lhs,
+        _In_ const std::string& rhs) noexcept {
+    return (lhs.size() == rhs.size()) && std::equal(lhs.begin(), lhs.end(),
+        rhs.begin(), [](const char l, const char r) {
+            return (std::tolower(static_cast<unsigned char>(l))
+                == std::tolower(static_cast<unsigned char>(r)));
+        });
+}
+
+
+/*
+ * visus::dataverse::detail::hash_context::hash_context
+ */
+visus::dataverse::detail::hash_context::hash_context(
+        _In_z_ const char *algorithm) {
+    const std::string name = canonical_name(algorithm);
+
+    // Note that both, CNG and OpenSSL, select the fastest implementation for
+    // the CPU at runtime, e.g. using the SHA extensions of x64 and ARMv8, so
+    // we do not need to care about this here.
+#if defined(_WIN32)
+    LPCWSTR id = nullptr;
+    if (name == "MD5") {
+        id = BCRYPT_MD5_ALGORITHM;
+    } else if (name == "SHA-1") {
+        id = BCRYPT_SHA1_ALGORITHM;
+    } else if (name == "SHA-256") {
+        id = BCRYPT_SHA256_ALGORITHM;
+    } else {
+        assert(name == "SHA-512");
+        id = BCRYPT_SHA512_ALGORITHM;
+    }
+
+    {
+        auto status = ::BCryptOpenAlgorithmProvider(
+            this->_algorithm.addressof(), id, nullptr,
+            BCRYPT_HASH_REUSABLE_FLAG);
+        if (!NT_SUCCESS(status)) {
+            throw std::system_error(status, ntstatus_category());
+        }
+    }
+
+    {
+        ULONG size = 0;
+        auto status = ::BCryptGetProperty(this->_algorithm.get(),
+            BCRYPT_HASH_LENGTH,
+            reinterpret_cast<PUCHAR>(&this->_size),
+            sizeof(this->_size),
+            &size,
+            0);
+        if (!NT_SUCCESS(status)) {
+            throw std::system_error(status, ntstatus_category());
+        }
+    }
+
+    {
+        auto status = ::BCryptCreateHash(this->_algorithm.get(),
+            this->_hash.addressof(), nullptr, 0, nullptr, 0,
+            BCRYPT_HASH_REUSABLE_FLAG);
+        if (!NT_SUCCESS(status)) {
+            throw std::system_error(status, ntstatus_category());
+        }
+    }
+
+#else /* defined(_WIN32) */
+    if (name == "MD5") {
+        this->_digest = ::EVP_md5();
+    } else if (name == "SHA-1") {
+        this->_digest = ::EVP_sha1();
+    } else if (name == "SHA-256") {
+        this->_digest = ::EVP_sha256();
+    } else {
+        assert(name == "SHA-512");
+        this->_digest = ::EVP_sha512();
+    }
+
+    this->_context = ::EVP_MD_CTX_new();
+    if (this->_context == nullptr) {
+        throw std::system_error(::ERR_get_error(), openssl_category());
+    }
+
+    try {
+        this->reset();
+    } catch (...) {
+        ::EVP_MD_CTX_free(this->_context);
+        throw;
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::dataverse::detail::hash_context::~hash_context
+ */
+visus::dataverse::detail::hash_context::~hash_context(void) noexcept {
+#if !defined(_WIN32)
+    ::EVP_MD_CTX_free(this->_context);
+#endif /* !defined(_WIN32) */
+}
+
+
+/*
+ * visus::dataverse::detail::hash_context::finish
+ */
+std::string visus::dataverse::detail::hash_context::finish(void) {
+#if defined(_WIN32)
+    std::vector<unsigned char> hash(this->_size);
+
+    // As the hash is reusable, finishing it also restarts it.
+    auto status = ::BCryptFinishHash(this->_hash.get(), hash.data(),
+        static_cast<ULONG>(hash.size()), 0);
+    if (!NT_SUCCESS(status)) {
+        throw std::system_error(status, ntstatus_category());
+    }
+
+    const auto size = hash.size();
+
+#else /* defined(_WIN32) */
+    std::array<unsigned char, EVP_MAX_MD_SIZE> hash;
+    unsigned int size = static_cast<unsigned int>(hash.size());
+
+    if (!::EVP_DigestFinal_ex(this->_context, hash.data(), &size)) {
+        throw std::system_error(::ERR_get_error(), openssl_category());
+    }
+
+    this->reset();
+#endif /* defined(_WIN32) */
+
+    static constexpr const char digits[] = "0123456789abcdef";
+    std::string retval(2 * size, '0');
+    for (std::size_t i = 0; i < size; ++i) {
+        retval[2 * i] = digits[hash[i] >> 4];
+        retval[2 * i + 1] = digits[hash[i] & 0x0f];
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::hash_context::reset
+ */
+void visus::dataverse::detail::hash_context::reset(void) {
+#if defined(_WIN32)
+    // Finishing a reusable hash is the only way to restart it.
+    std::vector<unsigned char> hash(this->_size);
+    auto status = ::BCryptFinishHash(this->_hash.get(), hash.data(),
+        static_cast<ULONG>(hash.size()), 0);
+    if (!NT_SUCCESS(status)) {
+        throw std::system_error(status, ntstatus_category());
+    }
+
+#else /* defined(_WIN32) */
+    if (!::EVP_DigestInit_ex(this->_context, this->_digest, nullptr)) {
+        throw std::system_error(::ERR_get_error(), openssl_category());
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::dataverse::detail::hash_context::update
+ */
+void visus::dataverse::detail::hash_context::update(
+        _In_reads_bytes_(cnt) const void *data,
+        _In_ const std::size_t cnt) {
+    assert((data != nullptr) || (cnt == 0));
+#if defined(_WIN32)
+    // BCrypt only accepts 32-bit sizes, so very large buffers must be split.
+    auto d = static_cast<PUCHAR>(const_cast<void *>(data));
+    auto remaining = cnt;
+
+    do {
+        const auto c = static_cast<ULONG>((std::min)(remaining,
+            static_cast<std::size_t>(MAXULONG)));
+        auto status = ::BCryptHashData(this->_hash.get(), d, c, 0);
+        if (!NT_SUCCESS(status)) {
+            throw std::system_error(status, ntstatus_category());
+        }
+
+        d += c;
+        remaining -= c;
+    } while (remaining > 0);
+
+#else /* defined(_WIN32) */
+    if (!::EVP_DigestUpdate(this->_context, data, cnt)) {
+        throw std::system_error(::ERR_get_error(), openssl_category());
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+#if defined(_WIN32)
+/*
+ * visus::dataverse::detail::hash_context::update_file
+ */
+std::uint64_t visus::dataverse::detail::hash_context::update_file(
+        _In_ HANDLE file) {
+    std::uint64_t retval = 0;
+    auto buffer = file_buffer();
+
+    DWORD cnt_read = 0;
+    do {
+        if (!::ReadFile(file, buffer, static_cast<DWORD>(file_buffer_size),
+                &cnt_read, nullptr)) {
+            auto error = ::GetLastError();
+            if (error != ERROR_HANDLE_EOF) {
+                throw std::system_error(error, std::system_category());
+            }
+            cnt_read = 0;
+        }
+
+        this->update(buffer, cnt_read);
+        retval += cnt_read;
+    } while (cnt_read > 0);
+
+    return retval;
+}
+
+#else /* defined(_WIN32) */
+/*
+ * visus::dataverse::detail::hash_context::update_file
+ */
+std::uint64_t visus::dataverse::detail::hash_context::update_file(
+        _In_ const int file) {
+    struct stat info;
+    if (::fstat(file, &info) != 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    auto offset = ::lseek(file, 0, SEEK_CUR);
+    const auto page_size = ::sysconf(_SC_PAGESIZE);
+
+    // Map regular files into memory, which saves copying the data from the
+    // page cache into a buffer. As the offset of a mapping must be aligned to
+    // pages, this only works if the file is at such a position, which is the
+    // case if it has just been opened.
+    // Small files are not worth the cost of creating and tearing down a
+    // mapping, which is higher than copying them once.
+    if (S_ISREG(info.st_mode) && (offset >= 0) && (page_size > 0)
+            && ((offset % page_size) == 0)
+            && (info.st_size - offset
+                > static_cast<off_t>(small_file_size))) {
+        const auto begin = offset;
+
+        while (offset < info.st_size) {
+            const auto size = static_cast<std::size_t>((std::min)(
+                file_window_size,
+                static_cast<std::uint64_t>(info.st_size - offset)));
+            auto data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file,
+                offset);
+            if (data == MAP_FAILED) {
+                if (offset == begin) {
+                    // The file system does not support mapping, so fall back
+                    // to reading the file below.
+                    break;
+                } else {
+                    throw std::system_error(errno, std::system_category());
+                }
+            }
+            on_exit([=](void) { ::munmap(data, size); });
+
+            // This is only a hint, so we do not care whether it works.
+            ::madvise(data, size, MADV_SEQUENTIAL);
+
+            this->update(data, size);
+            offset += size;
+        }
+
+        if (offset > begin) {
+            if (::lseek(file, offset, SEEK_SET) < 0) {
+                throw std::system_error(errno, std::system_category());
+            }
+            return static_cast<std::uint64_t>(offset - begin);
+        }
+    }
+
+    // If we cannot map the file, read it in large blocks into a page-aligned
+    // buffer.
+    std::uint64_t retval = 0;
+    auto buffer = file_buffer();
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+    ::posix_fadvise(file, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif /* defined(POSIX_FADV_SEQUENTIAL) */
+
+    while (true) {
+        auto cnt_read = ::read(file, buffer, file_buffer_size);
+        if (cnt_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::system_category());
+        }
+
+        if (cnt_read == 0) {
+            break;
+        }
+
+        this->update(buffer, static_cast<std::size_t>(cnt_read));
+        retval += cnt_read;
+    }
+
+    return retval;
+}
+#endif /* defined(_WIN32) */
+
+
+/*
+ * visus::dataverse::detail::hash_context::file_buffer
+ */
+_Ret_valid_ void *visus::dataverse::detail::hash_context::file_buffer(void) {
+#if defined(_WIN32)
+    // VirtualAlloc gives us page-aligned memory, which allows the system to
+    // transfer the data without an intermediate copy.
+    struct deleter {
+        void operator ()(void *buffer) const noexcept {
+            ::VirtualFree(buffer, 0, MEM_RELEASE);
+        }
+    };
+#else /* defined(_WIN32) */
+    struct deleter {
+        void operator ()(void *buffer) const noexcept {
+            ::free(buffer);
+        }
+    };
+#endif /* defined(_WIN32) */
+
+    thread_local std::unique_ptr<void, deleter> retval;
+
+    if (retval == nullptr) {
+#if defined(_WIN32)
+        retval.reset(::VirtualAlloc(nullptr, file_buffer_size,
+            MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+        if (retval == nullptr) {
+            throw std::system_error(::GetLastError(), std::system_category());
+        }
+#else /* defined(_WIN32) */
+        const auto page_size = ::sysconf(_SC_PAGESIZE);
+        const auto alignment = (page_size > 0)
+            ? static_cast<std::size_t>(page_size)
+            : sizeof(void *);
+        void *buffer = nullptr;
+        auto status = ::posix_memalign(&buffer, alignment, file_buffer_size);
+        if (status != 0) {
+            throw std::system_error(status, std::system_category());
+        }
+        retval.reset(buffer);
+#endif /* defined(_WIN32) */
+    }
+
+    return retval.get();
+}
@@ -0,0 +1,178 @@
+﻿// <copyright file="hash_context.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <string>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <bcrypt.h>
+
+#include <wil/resource.h>
+#else /* defined(_WIN32) */
+#include <openssl/evp.h>
+#endif /* defined(_WIN32) */
+
+#include "dataverse/api.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// Incrementally computes a cryptographic hash of data that become
+    /// available chunk by chunk.
+    /// </summary>
+    /// <remarks>
+    /// The context can be reused for another hash once the current one has
+    /// been retrieved via <see cref="finish" />.
+    /// </remarks>
+    class hash_context final {
+
+    public:
+
+        /// <summary>
+        /// Answer the name Dataverse uses for the given hash algorithm.
+        /// </summary>
+        /// <param name="algorithm">The name of the algorithm, which is not
+        /// case-sensitive and where the hyphen is optional, e.g.
+        /// &quot;sha256&quot;.</param>
+        /// <returns>The name of the algorithm as used by Dataverse, i.e.
+        /// &quot;MD5&quot;, &quot;SHA-1&quot;, &quot;SHA-256&quot; or
+        /// &quot;SHA-512&quot;, which is a static string.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="algorithm" /> is not supported.</exception>
+        static _Ret_z_ const char *canonical_name(
+            _In_z_ const char *algorithm);
+
+        /// <summary>
+        /// Answer whether the two given hex strings represent the same hash,
+        /// regardless of the case of the digits.
+        /// </summary>
+        static bool equals(_In_ const std::string& lhs,
+            _In_ const std::string& rhs) noexcept;
+
+        /// <summary>
+        /// The size of the buffer used by <see cref="update_file" /> if the
+        /// file cannot be mapped into memory.
+        /// </summary>
+        static constexpr std::size_t file_buffer_size = 4 * 1024 * 1024;
+
+        /// <summary>
+        /// Files up to this size are read by <see cref="update_file" /> with a
+        /// single call rather than being mapped into memory.
+        /// </summary>
+        static constexpr std::size_t small_file_size = 1024 * 1024;
+
+        /// <summary>
+        /// The size of the window that <see cref="update_file" /> maps into
+        /// memory at once.
+        /// </summary>
+        static constexpr std::uint64_t file_window_size
+            = 256 * 1024 * 1024;
+
+        /// <summary>
+        /// Initialises a new context for the given algorithm.
+        /// </summary>
+        /// <param name="algorithm">The name of the algorithm as used by
+        /// Dataverse, i.e. &quot;MD5&quot;, &quot;SHA-1&quot;,
+        /// &quot;SHA-256&quot; or &quot;SHA-512&quot;. The name is not
+        /// case-sensitive and the hyphen is optional.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="algorithm" /> is not supported.</exception>
+        /// <exception cref="std::system_error">If the hash could not be
+        /// initialised.</exception>
+        explicit hash_context(_In_z_ const char *algorithm);
+
+        hash_context(const hash_context&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~hash_context(void) noexcept;
+
+        /// <summary>
+        /// Answer the hash of all data passed to <see cref="update" /> as
+        /// lower-case hex string and reset the context.
+        /// </summary>
+        /// <exception cref="std::system_error">If the hash could not be
+        /// computed.</exception>
+        std::string finish(void);
+
+        /// <summary>
+        /// Discards all data hashed so far.
+        /// </summary>
+        /// <exception cref="std::system_error">If the hash could not be
+        /// restarted.</exception>
+        void reset(void);
+
+        /// <summary>
+        /// Adds the given data to the hash.
+        /// </summary>
+        /// <exception cref="std::system_error">If the data could not be
+        /// hashed.</exception>
+        void update(_In_reads_bytes_(cnt) const void *data,
+            _In_ const std::size_t cnt);
+
+#if defined(_WIN32)
+        /// <summary>
+        /// Adds everything from the current position to the end of the given
+        /// file to the hash.
+        /// </summary>
+        /// <remarks>
+        /// The file is read sequentially in large blocks into a page-aligned
+        /// buffer that is reused by all calls on the same thread. The
+        /// position of the file is at its end afterwards.
+        /// </remarks>
+        /// <returns>The number of bytes that have been hashed.</returns>
+        /// <exception cref="std::system_error">If the file could not be read
+        /// or if the data could not be hashed.</exception>
+        std::uint64_t update_file(_In_ HANDLE file);
+#else /* defined(_WIN32) */
+        /// <summary>
+        /// Adds everything from the current position to the end of the given
+        /// file to the hash.
+        /// </summary>
+        /// <remarks>
+        /// Large regular files are mapped into memory window by window and
+        /// hashed directly from the page cache. Anything else is read
+        /// sequentially in large blocks into a page-aligned buffer that is
+        /// reused by all calls on the same thread, such that hashing many
+        /// small files does not pay for mapping or allocating memory each
+        /// time. The position of the file is at its end afterwards.
+        /// </remarks>
+        /// <returns>The number of bytes that have been hashed.</returns>
+        /// <exception cref="std::system_error">If the file could not be read
+        /// or if the data could not be hashed.</exception>
+        std::uint64_t update_file(_In_ const int file);
+#endif /* defined(_WIN32) */
+
+        hash_context& operator =(const hash_context&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Answer the page-aligned buffer of <see cref="file_buffer_size" />
+        /// bytes that is used for reading files on the calling thread.
+        /// </summary>
+        static _Ret_valid_ void *file_buffer(void);
+
+#if defined(_WIN32)
+        wil::unique_bcrypt_algorithm _algorithm;
+        wil::unique_bcrypt_hash _hash;
+        ULONG _size;
+#else /* defined(_WIN32) */
+        EVP_MD_CTX *_context;
+        const EVP_MD *_digest;
+#endif /* defined(_WIN32) */
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
@@ -23,13 +23,28 @@ visus::dataverse::detail::io_context::create(_In_opt_ CURL *curl) {
     } else {
         // If we can reuse a context, make sure that it is cleared.
         retval = std::move(cache.back());
+        retval->cache_api_key.clear();
+        retval->cache_hit = false;
+        retval->cache_url.clear();
+        retval->cached_response.reset();
+        retval->checksum.reset();
+        retval->coalesced = false;
+        retval->expected_checksum.clear();
         retval->file = std::move(file_type());
         retval->form = std::move(form_data());
         retval->headers.reset();
         retval->on_api_response = nullptr;
+        retval->on_buffer_response = nullptr;
         retval->on_error = nullptr;
         retval->on_response = nullptr;
-        retval->response.clear();
+        retval->output = nullptr;
+        retval->output_capacity = 0;
+        retval->output_size = 0;
+        retval->output_truncate = false;
+        retval->output_truncated = false;
+        retval->response.truncate(0);
+        retval->sax.reset(nullptr);
+        retval->url.clear();
         cache.pop_back();
     }
 
@@ -67,7 +82,9 @@ visus::dataverse::detail::io_context::create(_In_opt_ CURL *curl,
     retval->on_api_response = nullptr;
     retval->on_error = on_error;
     retval->on_response = on_response;
-    retval->option(CURLOPT_URL, url.c_str());
+    retval->progress.context = client_data;
+    retval->url = url;
+    retval->option(CURLOPT_URL, retval->url.c_str());
     return retval;
 }
 
@@ -104,7 +121,7 @@ visus::dataverse::detail::io_context::open_file(_In_z_ const wchar_t *path) {
         throw std::system_error(::GetLastError(), std::system_category());
     }
 #else /* defined(_WIN32) */
-    auto p = convert<char>(path, 0, nullptr);
+    auto p = convert<char>(path, -1, nullptr);
     file_type retval(::open(p.c_str(), O_RDONLY));
     if (!retval) {
         throw std::system_error(errno, std::system_category());
@@ -145,14 +162,111 @@ std::size_t CALLBACK visus::dataverse::detail::io_context::read_request(
 void visus::dataverse::detail::io_context::recycle(
         _Inout_ std::unique_ptr<io_context>&& context) {
     if (context != nullptr) {
+        if (context->progress.monitor != nullptr) {
+            context->progress.monitor->detach(*context);
+        }
         context->delete_request();
+        // Release the form right away, because it might hold or reference
+        // large data of the user, which must not be kept alive in the pool.
+        context->form = form_data();
         context->curl = dataverse_connection_impl::make_curl();
+        context->cached_response.reset();
+        context->checksum.reset();
+        dataverse_connection_impl::secure_zero(context->cache_api_key);
+
+        if (context->response.capacity() > max_retained_capacity) {
+            context->response.clear();
+        }
+        if (context->sax.capacity() > max_retained_capacity) {
+            context->sax.release();
+        }
+
         std::lock_guard<decltype(lock)> l(lock);
         cache.push_back(std::move(context));
     }
 }
 
 
+/*
+ * visus::dataverse::detail::io_context::retained_memory
+ */
+std::size_t visus::dataverse::detail::io_context::retained_memory(void) {
+    std::lock_guard<decltype(lock)> l(lock);
+    std::size_t retval = 0;
+
+    for (auto& c : cache) {
+        retval += c->response.capacity();
+        retval += c->sax.capacity();
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::io_context::write_output
+ */
+std::size_t CALLBACK visus::dataverse::detail::io_context::write_output(
+        _In_reads_bytes_(cnt *element_size) const void *data,
+        _In_ const std::size_t size,
+        _In_ const std::size_t cnt,
+        _In_ void *context) {
+    auto that = static_cast<io_context *>(context);
+    const auto retval = cnt * size;
+
+    // Only the actual content goes into the caller's buffer. Error messages
+    // must go to the response, because this is where the I/O thread expects
+    // them when reporting API errors.
+    long code = 0;
+    ::curl_easy_getinfo(that->curl.get(), CURLINFO_RESPONSE_CODE, &code);
+    if (code >= 300) {
+        return write_response(data, size, cnt, context);
+    }
+
+    assert(that->output_size <= that->output_capacity);
+    const auto available = that->output_capacity - that->output_size;
+    const auto cnt_copy = (std::min)(retval, available);
+    ::memcpy(that->output + that->output_size, data, cnt_copy);
+    that->output_size += cnt_copy;
+
+    if (cnt_copy < retval) {
+        // The response does not fit, so there is no need to receive the rest
+        // of it. Abort the transfer and let the I/O thread decide whether
+        // this is an error.
+        that->output_truncated = true;
+        return 0;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::io_context::write_sax
+ */
+std::size_t CALLBACK visus::dataverse::detail::io_context::write_sax(
+        _In_reads_bytes_(cnt *element_size) const void *data,
+        _In_ const std::size_t size,
+        _In_ const std::size_t cnt,
+        _In_ void *context) {
+    auto that = static_cast<io_context *>(context);
+    const auto retval = cnt * size;
+
+    // Error messages are not meant for the handler, but for the I/O thread.
+    long code = 0;
+    ::curl_easy_getinfo(that->curl.get(), CURLINFO_RESPONSE_CODE, &code);
+    if (code >= 300) {
+        return write_response(data, size, cnt, context);
+    }
+
+    // If the document is malformed or the handler does not want to see the
+    // rest of it, abort the transfer and let the I/O thread report that.
+    return that->sax.feed(static_cast<const char *>(data), retval)
+        ? retval
+        : 0;
+}
+
+
 /*
  * visus::dataverse::detail::io_context::write_response
  */
@@ -165,6 +279,20 @@ std::size_t CALLBACK visus::dataverse::detail::io_context::write_response(
     const auto offset = that->response.size();
     const auto retval = cnt * size;
 
+    if (that->checksum != nullptr) {
+        // Hash the content while it is still hot in the cache. Redirects and
+        // error messages must not contribute to the hash.
+        long code = 0;
+        ::curl_easy_getinfo(that->curl.get(), CURLINFO_RESPONSE_CODE, &code);
+        if (code < 300) {
+            try {
+                that->checksum->update(data, retval);
+            } catch (...) {
+                return 0;
+            }
+        }
+    }
+
     that->response.truncate(retval + offset);
     ::memcpy(that->response.at(offset), data, retval);
 
@@ -177,12 +305,20 @@ std::size_t CALLBACK visus::dataverse::detail::io_context::write_response(
  */
 visus::dataverse::detail::io_context::io_context(void)
     : api_data(nullptr),
+        cache_hit(false),
         client_data(nullptr),
+        coalesced(false),
         curl(std::move(dataverse_connection_impl::make_curl())),
         headers(nullptr, &::curl_slist_free_all),
         on_api_response(nullptr),
+        on_buffer_response(nullptr),
         on_error(nullptr),
         on_response(nullptr),
+        output(nullptr),
+        output_capacity(0),
+        output_size(0),
+        output_truncate(false),
+        output_truncated(false),
         request(nullptr),
         request_deleter(nullptr),
         request_remaining(0),
@@ -263,6 +399,49 @@ void visus::dataverse::detail::io_context::delete_request(void) {
 }
 
 
+/*
+ * visus::dataverse::detail::io_context::invoke_on_response
+ */
+void visus::dataverse::detail::io_context::invoke_on_response(void) {
+    if (this->on_buffer_response != nullptr) {
+        this->on_buffer_response(this->output, this->output_size,
+            this->output_truncated, this->client_data);
+    } else if (this->sax.handler() != nullptr) {
+        if (this->sax.finish()) {
+            // The handler has seen everything, so there is no content left,
+            // but there might be the body of a redirect.
+            this->response.truncate(0);
+            assert(this->on_response != nullptr);
+            this->on_response(this->response, this->client_data);
+        } else {
+            this->invoke_on_sax_error();
+        }
+    } else {
+        assert(this->on_response != nullptr);
+        this->on_response(this->response, this->client_data);
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::io_context::invoke_on_sax_error
+ */
+void visus::dataverse::detail::io_context::invoke_on_sax_error(void) {
+    assert(this->sax.failed());
+    if (this->sax.exception()) {
+        // Forward the exception the handler raised while parsing.
+        const auto e = this->sax.exception();
+        this->handle_errors([&e](void) { std::rethrow_exception(e); });
+    } else {
+        invoke_handler(this->on_error,
+            this->sax.error(),
+            "JSON",
+            dataversepp_code_page,
+            this->user_data());
+    }
+}
+
+
 /*
  * visus::dataverse::detail::io_context::prepare_request
  */
@@ -295,6 +474,7 @@ void visus::dataverse::detail::io_context::prepare_request(
         _In_opt_ const dataverse_connection::data_deleter_type deleter) {
     this->delete_request();
     this->request = data;
+    this->request_deleter = deleter;
     this->request_size = cnt;
     this->request_remaining = cnt;
 
@@ -304,6 +484,62 @@ void visus::dataverse::detail::io_context::prepare_request(
 }
 
 
+/*
+ * visus::dataverse::detail::io_context::prepare_response
+ */
+void visus::dataverse::detail::io_context::prepare_response(
+        _Out_writes_bytes_(capacity) byte_type *buffer,
+        _In_ const std::size_t capacity,
+        _In_ const bool truncate,
+        _In_ const dataverse_connection::on_buffer_response_type callback) {
+    this->on_buffer_response = callback;
+    this->output = buffer;
+    this->output_capacity = capacity;
+    this->output_size = 0;
+    this->output_truncate = truncate;
+    this->output_truncated = false;
+
+    this->option(CURLOPT_WRITEFUNCTION, &detail::io_context::write_output);
+    this->option(CURLOPT_WRITEDATA, this);
+}
+
+
+/*
+ * visus::dataverse::detail::io_context::prepare_sax
+ */
+void visus::dataverse::detail::io_context::prepare_sax(
+        _In_ json_sax_handler& handler) {
+    this->sax.reset(&handler);
+
+    this->option(CURLOPT_WRITEFUNCTION, &detail::io_context::write_sax);
+    this->option(CURLOPT_WRITEDATA, this);
+}
+
+
+/*
+ * visus::dataverse::detail::io_context::verify_checksum
+ */
+bool visus::dataverse::detail::io_context::verify_checksum(void) {
+    if (this->checksum == nullptr) {
+        return true;
+    }
+
+    try {
+        return hash_context::equals(this->checksum->finish(),
+            this->expected_checksum);
+    } catch (...) {
+        return false;
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::io_context::max_retained_capacity
+ */
+constexpr std::size_t
+visus::dataverse::detail::io_context::max_retained_capacity;
+
+
 /*
  * visus::dataverse::detail::io_context::cache
  */
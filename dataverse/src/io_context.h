@@ -24,8 +24,12 @@
 #include "dataverse/dataverse_connection.h"
 
 #include "dataverse_connection_impl.h"
+#include "hash_context.h"
 #include "invoke_handler.h"
+#include "json_sax_parser.h"
 #include "posix_handle.h"
+#include "response_cache.h"
+#include "transfer_monitor.h"
 
 
 namespace visus {
@@ -51,6 +55,18 @@ namespace detail {
         typedef posix_handle file_type;
 #endif /* defined(_WIN32) */
 
+        /// <summary>
+        /// The maximum capacity of the <see cref="response" /> buffer a context
+        /// retains when it is returned to the pool.
+        /// </summary>
+        /// <remarks>
+        /// Pooled contexts keep their response buffer such that receiving the
+        /// typical API response does not require any heap allocations.
+        /// Buffers that have grown beyond this limit, for instance because a
+        /// file has been downloaded into memory, are released, though.
+        /// </remarks>
+        static constexpr std::size_t max_retained_capacity = 1024 * 1024;
+
         /// <summary>
         /// Creates or reuses a context without configuring it except for the
         /// output callback.
@@ -105,6 +121,32 @@ namespace detail {
         /// </summary>
         static void recycle(_Inout_ std::unique_ptr<io_context>&& context);
 
+        /// <summary>
+        /// Answer the number of bytes the response buffers of all pooled
+        /// contexts retain.
+        /// </summary>
+        static std::size_t retained_memory(void);
+
+        /// <summary>
+        /// The I/O callback passed to cURL for writing the response to the
+        /// caller-provided <see cref="output" /> buffer.
+        /// </summary>
+        static std::size_t CALLBACK write_output(
+            _In_reads_bytes_(cnt *element_size) const void *data,
+            _In_ const std::size_t size,
+            _In_ const std::size_t cnt,
+            _In_ void *context);
+
+        /// <summary>
+        /// The I/O callback passed to cURL for feeding the response to the
+        /// incremental JSON parser <see cref="sax" />.
+        /// </summary>
+        static std::size_t CALLBACK write_sax(
+            _In_reads_bytes_(cnt *element_size) const void *data,
+            _In_ const std::size_t size,
+            _In_ const std::size_t cnt,
+            _In_ void *context);
+
         /// <summary>
         /// The I/O callback passed to cURL for writing the response to our
         /// buffer.
@@ -121,16 +163,57 @@ namespace detail {
         /// </summary>
         void *api_data;
 
+        /// <summary>
+        /// The API key the response in the cache belongs to.
+        /// </summary>
+        std::vector<char> cache_api_key;
+
+        /// <summary>
+        /// Indicates that <see cref="cached_response" /> is the response to
+        /// the request, which is therefore not transferred.
+        /// </summary>
+        bool cache_hit;
+
+        /// <summary>
+        /// The URL under which the response is cached, which is empty if the
+        /// response should not be cached.
+        /// </summary>
+        std::string cache_url;
+
+        /// <summary>
+        /// The response from the cache if it is either fresh or needs to be
+        /// revalidated.
+        /// </summary>
+        response_cache::response_type cached_response;
+
+        /// <summary>
+        /// If set, the hash of the content received so far, which is checked
+        /// against <see cref="expected_checksum" /> once the transfer is
+        /// complete.
+        /// </summary>
+        std::unique_ptr<hash_context> checksum;
+
         /// <summary>
         /// The user data to be passed to the final callback.
         /// </summary>
         void *client_data;
 
+        /// <summary>
+        /// Indicates that other requests might be waiting for the response
+        /// to this one.
+        /// </summary>
+        bool coalesced;
+
         /// <summary>
         /// The library handle used for the request.
         /// </summary>
         dataverse_connection_impl::curl_type curl;
 
+        /// <summary>
+        /// The hex string of the hash that <see cref="checksum" /> must yield.
+        /// </summary>
+        std::string expected_checksum;
+
         /// <summary>
         /// The file to be uploaded, if any.
         /// </summary>
@@ -158,6 +241,12 @@ namespace detail {
         /// </remarks>
         void *on_api_response;
 
+        /// <summary>
+        /// The user-provided callback if the response is written to the
+        /// caller-provided <see cref="output" /> buffer.
+        /// </summary>
+        dataverse_connection::on_buffer_response_type on_buffer_response;
+
         /// <summary>
         /// The user-provided error callback.
         /// </summary>
@@ -168,6 +257,41 @@ namespace detail {
         /// </summary>
         dataverse_connection::on_response_type on_response;
 
+        /// <summary>
+        /// A caller-provided buffer that receives the response instead of
+        /// <see cref="response" />, if any.
+        /// </summary>
+        byte_type *output;
+
+        /// <summary>
+        /// The size of <see cref="output" /> in bytes.
+        /// </summary>
+        std::size_t output_capacity;
+
+        /// <summary>
+        /// The number of valid bytes in <see cref="output" />.
+        /// </summary>
+        std::size_t output_size;
+
+        /// <summary>
+        /// Indicates whether a response that does not fit into
+        /// <see cref="output" /> should be truncated rather than being
+        /// reported as an error.
+        /// </summary>
+        bool output_truncate;
+
+        /// <summary>
+        /// Indicates that the transfer has been aborted, because the response
+        /// did not fit into <see cref="output" />.
+        /// </summary>
+        bool output_truncated;
+
+        /// <summary>
+        /// The progress of the transfer, which is reported to the progress
+        /// handler of the connection if one is installed.
+        /// </summary>
+        transfer_state progress;
+
         /// <summary>
         /// A pointer to the caller-provided request data.
         /// </summary>
@@ -195,6 +319,21 @@ namespace detail {
         /// </summary>
         blob response;
 
+        /// <summary>
+        /// The incremental parser that processes the response while it is
+        /// being received if the user provided a SAX handler.
+        /// </summary>
+        /// <remarks>
+        /// The parser is retained along with the context such that its token
+        /// buffers can be reused.
+        /// </remarks>
+        json_sax_parser sax;
+
+        /// <summary>
+        /// The URL the request has been created for.
+        /// </summary>
+        std::string url;
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -231,6 +370,19 @@ namespace detail {
         /// </summary>
         void delete_request(void);
 
+        /// <summary>
+        /// Invokes <see cref="on_buffer_response" /> if the response was
+        /// written to <see cref="output" /> or <see cref="on_response" />
+        /// otherwise.
+        /// </summary>
+        void invoke_on_response(void);
+
+        /// <summary>
+        /// Reports the error that stopped <see cref="sax" /> to
+        /// <see cref="on_error" />.
+        /// </summary>
+        void invoke_on_sax_error(void);
+
         /// <summary>
         /// Runs <paramref name="function" /> in a try/catch and, in case of an
         /// error, invokes the error handler.
@@ -240,11 +392,11 @@ namespace detail {
             try {
                 function();
             } catch (std::system_error ex) {
-                invoke_handler(this->on_error, ex, this->client_data);
+                invoke_handler(this->on_error, ex, this->user_data());
             } catch (std::exception &ex) {
-                invoke_handler(this->on_error, ex, this->client_data);
+                invoke_handler(this->on_error, ex, this->user_data());
             } catch (...) {
-                invoke_handler(this->on_error, this->client_data);
+                invoke_handler(this->on_error, this->user_data());
             }
         }
 
@@ -269,6 +421,43 @@ namespace detail {
             _In_ const std::size_t cnt,
             _In_opt_ const dataverse_connection::data_deleter_type deleter);
 
+        /// <summary>
+        /// Prepares the I/O context for writing the response directly into
+        /// the specified caller-provided buffer.
+        /// </summary>
+        void prepare_response(_Out_writes_bytes_(capacity) byte_type *buffer,
+            _In_ const std::size_t capacity,
+            _In_ const bool truncate,
+            _In_ const dataverse_connection::on_buffer_response_type callback);
+
+        /// <summary>
+        /// Prepares the I/O context for feeding the response to the given
+        /// SAX handler while it is being received.
+        /// </summary>
+        void prepare_sax(_In_ json_sax_handler& handler);
+
+        /// <summary>
+        /// Answer the context pointer the user passed along with the request.
+        /// </summary>
+        /// <remarks>
+        /// If the response is translated by the API, <see cref="client_data" />
+        /// is the context itself and the user's pointer has been moved to
+        /// <see cref="api_data" /> by <see cref="configure_on_api_response" />.
+        /// Error handlers must always receive the user's pointer, though.
+        /// </remarks>
+        inline void *user_data(void) const noexcept {
+            return (this->on_api_response != nullptr)
+                ? this->api_data
+                : this->client_data;
+        }
+
+        /// <summary>
+        /// Answer whether the content received matches the
+        /// <see cref="expected_checksum" />, which is always the case if no
+        /// <see cref="checksum" /> has been requested.
+        /// </summary>
+        bool verify_checksum(void);
+
     private:
 
         static std::vector<std::unique_ptr<io_context>> cache;
@@ -0,0 +1,518 @@
+﻿// <copyright file="json_sax_parser.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "json_sax_parser.h"
+
+#include <cassert>
+#include <cstring>
+#include <system_error>
+
+#include "dataverse/json_view.h"
+
+#include "errors.h"
+
+
+namespace {
+
+    /// <summary>
+    /// Answer whether <paramref name="c" /> is JSON whitespace.
+    /// </summary>
+    inline bool is_space(_In_ const char c) noexcept {
+        return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+    }
+
+    /// <summary>
+    /// Answer whether <paramref name="c" /> can be part of a number or a
+    /// literal.
+    /// </summary>
+    inline bool is_scalar(_In_ const char c) noexcept {
+        return ((c >= '0') && (c <= '9'))
+            || ((c >= 'a') && (c <= 'z'))
+            || ((c >= 'A') && (c <= 'Z'))
+            || (c == '+') || (c == '-') || (c == '.');
+    }
+
+    constexpr const char *cancelled = "The JSON handler cancelled parsing.";
+    constexpr const char *invalid_scalar = "The JSON document contains an "
+        "invalid number or literal.";
+    constexpr const char *invalid_string = "The JSON document contains an "
+        "invalid escape sequence.";
+    constexpr const char *unexpected_character = "The JSON document contains "
+        "an unexpected character.";
+    constexpr const char *unexpected_end = "The JSON document ended "
+        "unexpectedly.";
+
+} /* namespace */
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::json_sax_parser
+ */
+visus::dataverse::detail::json_sax_parser::json_sax_parser(void) noexcept
+    : _error(nullptr), _escape(false), _handler(nullptr), _is_key(false),
+        _state(state::value) { }
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::capacity
+ */
+std::size_t visus::dataverse::detail::json_sax_parser::capacity(
+        void) const noexcept {
+    return this->_stack.capacity()
+        + this->_token.capacity()
+        + this->_unescaped.capacity();
+}
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::feed
+ */
+bool visus::dataverse::detail::json_sax_parser::feed(
+        _In_reads_bytes_(cnt) const char *data,
+        _In_ const std::size_t cnt) noexcept {
+    assert(this->_handler != nullptr);
+    if (this->failed()) {
+        return false;
+    }
+
+    try {
+        return this->parse(data, cnt);
+    } catch (...) {
+        // Most likely, the handler threw, but it could also be an allocation
+        // failure while buffering a token.
+        this->_exception = std::current_exception();
+        return this->fail(cancelled);
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::finish
+ */
+bool visus::dataverse::detail::json_sax_parser::finish(void) noexcept {
+    if (this->failed()) {
+        return false;
+    }
+
+    try {
+        if ((this->_state == state::scalar) && this->_stack.empty()) {
+            // A number or literal at the top level is only terminated by the
+            // end of the document.
+            if (!this->emit_scalar(this->_token.data(), this->_token.size())) {
+                return false;
+            }
+        }
+    } catch (...) {
+        this->_exception = std::current_exception();
+        return this->fail(cancelled);
+    }
+
+    return (this->_state == state::done) || this->fail(unexpected_end);
+}
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::release
+ */
+void visus::dataverse::detail::json_sax_parser::release(void) noexcept {
+    std::vector<char>().swap(this->_stack);
+    std::vector<char>().swap(this->_token);
+    std::vector<char>().swap(this->_unescaped);
+}
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::reset
+ */
+void visus::dataverse::detail::json_sax_parser::reset(
+        _In_opt_ json_sax_handler *handler) noexcept {
+    this->_error = nullptr;
+    this->_escape = false;
+    this->_exception = nullptr;
+    this->_handler = handler;
+    this->_is_key = false;
+    this->_stack.clear();
+    this->_state = state::value;
+    this->_token.clear();
+}
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::emit_scalar
+ */
+bool visus::dataverse::detail::json_sax_parser::emit_scalar(
+        _In_reads_(cnt) const char *data,
+        _In_ const std::size_t cnt) {
+    assert(this->_handler != nullptr);
+    const json_view view(data, cnt);
+    bool retval = false;
+
+    // Convert the value first such that we do not mistake exceptions from
+    // the handler for conversion errors.
+    auto type = view.type();
+    bool boolean = false;
+    double number_float = 0.0;
+    std::int64_t number_integer = 0;
+    std::uint64_t number_unsigned = 0;
+
+    try {
+        switch (type) {
+            case json_view::value_type::null:
+                if ((cnt != 4) || (::memcmp(data, "null", 4) != 0)) {
+                    return this->fail(invalid_scalar);
+                }
+                break;
+
+            case json_view::value_type::boolean:
+                boolean = view.to_boolean();
+                break;
+
+            case json_view::value_type::number:
+                if ((::memchr(data, '.', cnt) != nullptr)
+                        || (::memchr(data, 'e', cnt) != nullptr)
+                        || (::memchr(data, 'E', cnt) != nullptr)) {
+                    number_float = view.to_double();
+                    type = json_view::value_type::invalid;
+                } else {
+                    try {
+                        if (*data == '-') {
+                            number_integer = view.to_int64();
+                        } else {
+                            number_unsigned = view.to_uint64();
+                        }
+                    } catch (std::system_error ex) {
+                        if (ex.code().value() != ERROR_ARITHMETIC_OVERFLOW) {
+                            throw;
+                        }
+
+                        // Integers that do not fit into 64 bits are reported
+                        // as floating-point numbers like most parsers do.
+                        number_float = view.to_double();
+                        type = json_view::value_type::invalid;
+                    }
+                }
+                break;
+
+            default:
+                return this->fail(invalid_scalar);
+        }
+    } catch (std::system_error) {
+        return this->fail(invalid_scalar);
+    }
+
+    switch (type) {
+        case json_view::value_type::null:
+            retval = this->_handler->null();
+            break;
+
+        case json_view::value_type::boolean:
+            retval = this->_handler->boolean(boolean);
+            break;
+
+        case json_view::value_type::number:
+            retval = (*data == '-')
+                ? this->_handler->number_integer(number_integer)
+                : this->_handler->number_unsigned(number_unsigned);
+            break;
+
+        default:
+            retval = this->_handler->number_float(number_float, data, cnt);
+            break;
+    }
+
+    this->_token.clear();
+    return retval ? this->end_value() : this->fail(cancelled);
+}
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::emit_string
+ */
+bool visus::dataverse::detail::json_sax_parser::emit_string(
+        _In_reads_(cnt) const char *data,
+        _In_ const std::size_t cnt) {
+    assert(this->_handler != nullptr);
+    assert(cnt >= 2);
+    auto str = data + 1;
+    auto len = cnt - 2;
+
+    if (::memchr(str, '\\', len) != nullptr) {
+        // Only strings with escape sequences need to be copied.
+        const json_view view(data, cnt);
+        try {
+            this->_unescaped.resize(view.to_string(nullptr, 0));
+            len = view.to_string(this->_unescaped.data(),
+                this->_unescaped.size()) - 1;
+            str = this->_unescaped.data();
+        } catch (std::system_error) {
+            return this->fail(invalid_string);
+        }
+    }
+
+    bool retval = false;
+    if (this->_is_key) {
+        retval = this->_handler->key(str, len);
+        this->_state = state::colon;
+    } else {
+        retval = this->_handler->string(str, len);
+        this->end_value();
+    }
+
+    this->_token.clear();
+    return retval || this->fail(cancelled);
+}
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::end_container
+ */
+bool visus::dataverse::detail::json_sax_parser::end_container(
+        _In_ const char bracket) {
+    assert(this->_handler != nullptr);
+    const auto opening = (bracket == ']') ? '[' : '{';
+
+    if (this->_stack.empty() || (this->_stack.back() != opening)) {
+        return this->fail(unexpected_character);
+    }
+
+    this->_stack.pop_back();
+
+    const auto retval = (bracket == ']')
+        ? this->_handler->end_array()
+        : this->_handler->end_object();
+    return retval ? this->end_value() : this->fail(cancelled);
+}
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::end_value
+ */
+bool visus::dataverse::detail::json_sax_parser::end_value(void) noexcept {
+    this->_state = this->_stack.empty() ? state::done : state::separator;
+    return true;
+}
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::fail
+ */
+bool visus::dataverse::detail::json_sax_parser::fail(
+        _In_z_ const char *error) noexcept {
+    this->_error = error;
+    return false;
+}
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::parse
+ */
+bool visus::dataverse::detail::json_sax_parser::parse(
+        _In_reads_bytes_(cnt) const char *data,
+        _In_ const std::size_t cnt) {
+    auto cur = data;
+    const auto end = data + cnt;
+
+    // Tokens that start in this chunk are emitted from the chunk itself if
+    // they also end in it. Only tokens that cross the chunk boundary are
+    // copied into '_token'.
+    const char *begin = nullptr;
+
+    while (cur < end) {
+        switch (this->_state) {
+            case state::string: {
+                auto c = cur;
+                for (; c < end; ++c) {
+                    if (this->_escape) {
+                        this->_escape = false;
+                    } else if (*c == '\\') {
+                        this->_escape = true;
+                    } else if (*c == '"') {
+                        break;
+                    }
+                }
+
+                if (c == end) {
+                    // The string continues in the next chunk.
+                    if (begin != nullptr) {
+                        this->_token.assign(begin, end);
+                    } else {
+                        this->_token.insert(this->_token.end(), cur, end);
+                    }
+                    return true;
+                }
+
+                ++c;    // Include the closing quotation mark.
+                const auto ok = (begin != nullptr)
+                    ? this->emit_string(begin, c - begin)
+                    : (this->_token.insert(this->_token.end(), cur, c),
+                        this->emit_string(this->_token.data(),
+                            this->_token.size()));
+                if (!ok) {
+                    return false;
+                }
+
+                begin = nullptr;
+                cur = c;
+                } continue;
+
+            case state::scalar: {
+                auto c = cur;
+                while ((c < end) && is_scalar(*c)) {
+                    ++c;
+                }
+
+                if (c == end) {
+                    // The scalar might continue in the next chunk.
+                    if (begin != nullptr) {
+                        this->_token.assign(begin, end);
+                    } else {
+                        this->_token.insert(this->_token.end(), cur, end);
+                    }
+                    return true;
+                }
+
+                const auto ok = (begin != nullptr)
+                    ? this->emit_scalar(begin, c - begin)
+                    : (this->_token.insert(this->_token.end(), cur, c),
+                        this->emit_scalar(this->_token.data(),
+                            this->_token.size()));
+                if (!ok) {
+                    return false;
+                }
+
+                begin = nullptr;
+                cur = c;
+                } continue;
+
+            default:
+                break;
+        }
+
+        if (is_space(*cur)) {
+            ++cur;
+            continue;
+        }
+
+        const auto c = *cur;
+        switch (this->_state) {
+            case state::first_element:
+                if (c == ']') {
+                    if (!this->end_container(c)) {
+                        return false;
+                    }
+                    ++cur;
+                    continue;
+                }
+                /* Fall through. */
+
+            case state::value:
+                if (!this->start_value(c)) {
+                    return false;
+                }
+
+                if (this->_state == state::string) {
+                    begin = cur++;
+                } else if (this->_state == state::scalar) {
+                    begin = cur;
+                } else {
+                    ++cur;
+                }
+                continue;
+
+            case state::first_member:
+                if (c == '}') {
+                    if (!this->end_container(c)) {
+                        return false;
+                    }
+                    ++cur;
+                    continue;
+                }
+                /* Fall through. */
+
+            case state::key:
+                if (c != '"') {
+                    return this->fail(unexpected_character);
+                }
+
+                this->_escape = false;
+                this->_is_key = true;
+                this->_state = state::string;
+                begin = cur++;
+                continue;
+
+            case state::colon:
+                if (c != ':') {
+                    return this->fail(unexpected_character);
+                }
+
+                this->_state = state::value;
+                ++cur;
+                continue;
+
+            case state::separator:
+                if (c == ',') {
+                    this->_state = (this->_stack.back() == '{')
+                        ? state::key
+                        : state::value;
+                } else if ((c == ']') || (c == '}')) {
+                    if (!this->end_container(c)) {
+                        return false;
+                    }
+                } else {
+                    return this->fail(unexpected_character);
+                }
+
+                ++cur;
+                continue;
+
+            default:
+                // There must be nothing but whitespace after the document.
+                return this->fail(unexpected_character);
+        }
+    }
+
+    if (begin != nullptr) {
+        // A token started right at the end of the chunk.
+        assert(this->_token.empty());
+        this->_token.assign(begin, end);
+    }
+
+    return true;
+}
+
+
+/*
+ * visus::dataverse::detail::json_sax_parser::start_value
+ */
+bool visus::dataverse::detail::json_sax_parser::start_value(
+        _In_ const char c) {
+    assert(this->_handler != nullptr);
+
+    switch (c) {
+        case '[':
+            this->_stack.push_back(c);
+            this->_state = state::first_element;
+            return this->_handler->start_array() || this->fail(cancelled);
+
+        case '{':
+            this->_stack.push_back(c);
+            this->_state = state::first_member;
+            return this->_handler->start_object() || this->fail(cancelled);
+
+        case '"':
+            this->_escape = false;
+            this->_is_key = false;
+            this->_state = state::string;
+            return true;
+
+        default:
+            if (!is_scalar(c)) {
+                return this->fail(unexpected_character);
+            }
+
+            this->_state = state::scalar;
+            return true;
+    }
+}
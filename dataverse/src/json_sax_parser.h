@@ -0,0 +1,158 @@
+﻿// <copyright file="json_sax_parser.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <vector>
+
+#include "dataverse/json_sax_handler.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// An incremental JSON parser that forwards the document it is fed in
+    /// arbitrary chunks to a <see cref="json_sax_handler" />.
+    /// </summary>
+    /// <remarks>
+    /// The parser only buffers tokens that cross the boundary of a chunk.
+    /// Strings without escape sequences that are completely contained in a
+    /// chunk are passed to the handler without being copied. The buffers are
+    /// retained when the parser is reset, so a pooled parser does not need
+    /// to allocate memory for typical documents.
+    /// </remarks>
+    class json_sax_parser final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance without a handler.
+        /// </summary>
+        json_sax_parser(void) noexcept;
+
+        /// <summary>
+        /// Answer the number of bytes the internal buffers of the parser
+        /// occupy.
+        /// </summary>
+        std::size_t capacity(void) const noexcept;
+
+        /// <summary>
+        /// Answer the description of the error that stopped the parser.
+        /// </summary>
+        /// <returns>The error message or <c>nullptr</c> if the parser has not
+        /// failed.</returns>
+        inline _Ret_maybenull_z_ const char *error(void) const noexcept {
+            return this->_error;
+        }
+
+        /// <summary>
+        /// Answer the exception that the handler raised, if any.
+        /// </summary>
+        /// <remarks>
+        /// Exceptions must not propagate through the parser into the network
+        /// layer, so they are captured and stop the parser instead.
+        /// </remarks>
+        inline const std::exception_ptr& exception(void) const noexcept {
+            return this->_exception;
+        }
+
+        /// <summary>
+        /// Answer whether the document was malformed or the handler cancelled
+        /// parsing.
+        /// </summary>
+        inline bool failed(void) const noexcept {
+            return (this->_error != nullptr);
+        }
+
+        /// <summary>
+        /// Parses the next chunk of the document.
+        /// </summary>
+        /// <param name="data">The next part of the UTF-8 text.</param>
+        /// <param name="cnt">The length of <paramref name="data" /> in bytes.
+        /// </param>
+        /// <returns><c>true</c> if parsing can continue, <c>false</c> if the
+        /// parser failed.</returns>
+        bool feed(_In_reads_bytes_(cnt) const char *data,
+            _In_ const std::size_t cnt) noexcept;
+
+        /// <summary>
+        /// Indicates that the whole document has been fed to the parser.
+        /// </summary>
+        /// <returns><c>true</c> if the document was complete and valid,
+        /// <c>false</c> otherwise.</returns>
+        bool finish(void) noexcept;
+
+        /// <summary>
+        /// Answer the handler receiving the events.
+        /// </summary>
+        inline _Ret_maybenull_ json_sax_handler *handler(void) const noexcept {
+            return this->_handler;
+        }
+
+        /// <summary>
+        /// Frees the internal buffers of the parser.
+        /// </summary>
+        void release(void) noexcept;
+
+        /// <summary>
+        /// Prepares the parser for a new document.
+        /// </summary>
+        /// <param name="handler">The handler receiving the events, which must
+        /// live until the document has been parsed. If <c>nullptr</c>, the
+        /// parser is disabled.</param>
+        void reset(_In_opt_ json_sax_handler *handler) noexcept;
+
+    private:
+
+        /// <summary>
+        /// Identifies what the parser expects next.
+        /// </summary>
+        enum class state {
+            value,
+            first_element,
+            first_member,
+            key,
+            colon,
+            separator,
+            string,
+            scalar,
+            done
+        };
+
+        bool emit_scalar(_In_reads_(cnt) const char *data,
+            _In_ const std::size_t cnt);
+
+        bool emit_string(_In_reads_(cnt) const char *data,
+            _In_ const std::size_t cnt);
+
+        bool end_container(_In_ const char bracket);
+
+        bool end_value(void) noexcept;
+
+        bool fail(_In_z_ const char *error) noexcept;
+
+        bool parse(_In_reads_bytes_(cnt) const char *data,
+            _In_ const std::size_t cnt);
+
+        bool start_value(_In_ const char c);
+
+        const char *_error;
+        bool _escape;
+        std::exception_ptr _exception;
+        json_sax_handler *_handler;
+        bool _is_key;
+        std::vector<char> _stack;
+        state _state;
+        std::vector<char> _token;
+        std::vector<char> _unescaped;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
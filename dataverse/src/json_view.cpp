@@ -0,0 +1,780 @@
+﻿// <copyright file="json_view.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "dataverse/json_view.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <system_error>
+
+#include "errors.h"
+
+
+namespace {
+
+    /// <summary>
+    /// Answer whether <paramref name="c" /> is JSON whitespace.
+    /// </summary>
+    inline bool is_space(_In_ const char c) noexcept {
+        return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+    }
+
+    /// <summary>
+    /// Answer the first non-whitespace character at or after
+    /// <paramref name="cur" />.
+    /// </summary>
+    inline const char *skip_space(_In_ const char *cur,
+            _In_ const char *end) noexcept {
+        while ((cur < end) && is_space(*cur)) {
+            ++cur;
+        }
+        return cur;
+    }
+
+    /// <summary>
+    /// Skips the string starting at <paramref name="cur" />, which must be a
+    /// quotation mark.
+    /// </summary>
+    /// <returns>The position after the closing quotation mark or
+    /// <c>nullptr</c> if the string is not terminated.</returns>
+    const char *skip_string(_In_ const char *cur,
+            _In_ const char *end) noexcept {
+        assert(*cur == '"');
+        for (++cur; cur < end; ++cur) {
+            if (*cur == '\\') {
+                ++cur;
+            } else if (*cur == '"') {
+                return cur + 1;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /// <summary>
+    /// Skips the array or object starting at <paramref name="cur" />.
+    /// </summary>
+    /// <returns>The position after the closing bracket or <c>nullptr</c> if
+    /// the container is not terminated.</returns>
+    const char *skip_container(_In_ const char *cur,
+            _In_ const char *end) noexcept {
+        // We only need to track the nesting and strings, which might contain
+        // brackets, to find the end of a container.
+        std::size_t depth = 0;
+
+        while (cur < end) {
+            switch (*cur) {
+                case '"':
+                    cur = skip_string(cur, end);
+                    if (cur == nullptr) {
+                        return nullptr;
+                    }
+                    continue;
+
+                case '[':
+                case '{':
+                    ++depth;
+                    break;
+
+                case ']':
+                case '}':
+                    if (--depth == 0) {
+                        return cur + 1;
+                    }
+                    break;
+            }
+
+            ++cur;
+        }
+
+        return nullptr;
+    }
+
+    /// <summary>
+    /// Skips the value starting at <paramref name="cur" /> without
+    /// interpreting it.
+    /// </summary>
+    /// <returns>The position after the value or <c>nullptr</c> if the value
+    /// is not terminated.</returns>
+    const char *skip_value(_In_ const char *cur,
+            _In_ const char *end) noexcept {
+        if (cur >= end) {
+            return nullptr;
+        }
+
+        switch (*cur) {
+            case '"':
+                return skip_string(cur, end);
+
+            case '[':
+            case '{':
+                return skip_container(cur, end);
+
+            case ',':
+            case ':':
+            case ']':
+            case '}':
+                return nullptr;
+
+            default:
+                // This is a number or a literal, which end at the next
+                // delimiter.
+                while ((cur < end) && !is_space(*cur) && (*cur != ',')
+                        && (*cur != ']') && (*cur != '}')) {
+                    ++cur;
+                }
+                return cur;
+        }
+    }
+
+    /// <summary>
+    /// Parses four hexadecimal digits of a Unicode escape sequence.
+    /// </summary>
+    bool parse_hex4(_In_ const char *cur, _In_ const char *end,
+            _Out_ std::uint32_t& code_point) noexcept {
+        code_point = 0;
+
+        if (end - cur < 4) {
+            return false;
+        }
+
+        for (auto i = 0; i < 4; ++i, ++cur) {
+            code_point <<= 4;
+            if ((*cur >= '0') && (*cur <= '9')) {
+                code_point |= *cur - '0';
+            } else if ((*cur >= 'a') && (*cur <= 'f')) {
+                code_point |= *cur - 'a' + 10;
+            } else if ((*cur >= 'A') && (*cur <= 'F')) {
+                code_point |= *cur - 'A' + 10;
+            } else {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// <summary>
+    /// Decodes the next character of the raw string content at
+    /// <paramref name="cur" /> into <paramref name="dst" />, resolving any
+    /// escape sequence.
+    /// </summary>
+    /// <returns>The number of UTF-8 code units written to
+    /// <paramref name="dst" />, or -1 if the escape sequence is invalid.
+    /// </returns>
+    int decode(_Inout_ const char *& cur, _In_ const char *end,
+            _Out_writes_(4) char *dst) noexcept {
+        assert(cur < end);
+        if (*cur != '\\') {
+            *dst = *cur++;
+            return 1;
+        }
+
+        if (++cur >= end) {
+            return -1;
+        }
+
+        switch (*cur++) {
+            case '"': *dst = '"'; return 1;
+            case '\\': *dst = '\\'; return 1;
+            case '/': *dst = '/'; return 1;
+            case 'b': *dst = '\b'; return 1;
+            case 'f': *dst = '\f'; return 1;
+            case 'n': *dst = '\n'; return 1;
+            case 'r': *dst = '\r'; return 1;
+            case 't': *dst = '\t'; return 1;
+            case 'u': break;
+            default: return -1;
+        }
+
+        std::uint32_t cp;
+        if (!parse_hex4(cur, end, cp)) {
+            return -1;
+        }
+        cur += 4;
+
+        if ((cp >= 0xD800) && (cp <= 0xDBFF)) {
+            // This is a high surrogate, which must be followed by an escaped
+            // low surrogate.
+            std::uint32_t low;
+            if ((end - cur < 6) || (cur[0] != '\\') || (cur[1] != 'u')
+                    || !parse_hex4(cur + 2, end, low)
+                    || (low < 0xDC00) || (low > 0xDFFF)) {
+                return -1;
+            }
+            cur += 6;
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        } else if ((cp >= 0xDC00) && (cp <= 0xDFFF)) {
+            return -1;
+        }
+
+        if (cp < 0x80) {
+            dst[0] = static_cast<char>(cp);
+            return 1;
+        } else if (cp < 0x800) {
+            dst[0] = static_cast<char>(0xC0 | (cp >> 6));
+            dst[1] = static_cast<char>(0x80 | (cp & 0x3F));
+            return 2;
+        } else if (cp < 0x10000) {
+            dst[0] = static_cast<char>(0xE0 | (cp >> 12));
+            dst[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            dst[2] = static_cast<char>(0x80 | (cp & 0x3F));
+            return 3;
+        } else {
+            dst[0] = static_cast<char>(0xF0 | (cp >> 18));
+            dst[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            dst[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            dst[3] = static_cast<char>(0x80 | (cp & 0x3F));
+            return 4;
+        }
+    }
+
+    /// <summary>
+    /// Compares the raw string content [<paramref name="raw" />,
+    /// <paramref name="raw_end" />) with the unescaped string
+    /// <paramref name="str" />.
+    /// </summary>
+    bool raw_equals(_In_ const char *raw, _In_ const char *raw_end,
+            _In_reads_(cnt) const char *str,
+            _In_ const std::size_t cnt) noexcept {
+        auto size = static_cast<std::size_t>(raw_end - raw);
+
+        if (::memchr(raw, '\\', size) == nullptr) {
+            // Fast path if there are no escape sequences.
+            return (size == cnt) && (::memcmp(raw, str, cnt) == 0);
+        }
+
+        const auto str_end = str + cnt;
+        char buffer[4];
+        while (raw < raw_end) {
+            const auto n = decode(raw, raw_end, buffer);
+            if ((n < 0) || (str_end - str < n)
+                    || (::memcmp(buffer, str, n) != 0)) {
+                return false;
+            }
+            str += n;
+        }
+
+        return (str == str_end);
+    }
+
+    /// <summary>
+    /// Unescapes the raw string content [<paramref name="raw" />,
+    /// <paramref name="raw_end" />) into <paramref name="dst" />.
+    /// </summary>
+    /// <returns>The required size of <paramref name="dst" /> including the
+    /// terminating null or zero if the content is invalid.</returns>
+    std::size_t raw_unescape(_In_ const char *raw, _In_ const char *raw_end,
+            _Out_writes_opt_(cnt) char *dst,
+            _In_ const std::size_t cnt) noexcept {
+        std::size_t retval = 0;
+        char buffer[4];
+
+        while (raw < raw_end) {
+            const auto n = decode(raw, raw_end, buffer);
+            if (n < 0) {
+                return 0;
+            }
+
+            if ((dst != nullptr) && (retval + n < cnt)) {
+                ::memcpy(dst + retval, buffer, n);
+            }
+            retval += n;
+        }
+
+        if ((dst != nullptr) && (cnt > 0)) {
+            dst[(std::min)(retval, cnt - 1)] = 0;
+        }
+
+        return retval + 1;
+    }
+
+    /// <summary>
+    /// Compares the reference token [<paramref name="token" />,
+    /// <paramref name="token_end" />) of a JSON pointer, which might contain
+    /// the escape sequences &quot;~0&quot; and &quot;~1&quot;, with the
+    /// raw name [<paramref name="raw" />, <paramref name="raw_end" />) of a
+    /// member, which might contain JSON escape sequences.
+    /// </summary>
+    bool token_equals(_In_ const char *token, _In_ const char *token_end,
+            _In_ const char *raw, _In_ const char *raw_end) noexcept {
+        char buffer[4];
+
+        while ((token < token_end) && (raw < raw_end)) {
+            const auto n = decode(raw, raw_end, buffer);
+            if (n < 0) {
+                return false;
+            }
+
+            for (auto i = 0; i < n; ++i, ++token) {
+                if (token >= token_end) {
+                    return false;
+                }
+
+                auto c = *token;
+                if ((c == '~') && (token + 1 < token_end)) {
+                    c = (*++token == '1') ? '/' : '~';
+                }
+
+                if (c != buffer[i]) {
+                    return false;
+                }
+            }
+        }
+
+        return (token == token_end) && (raw == raw_end);
+    }
+
+    /// <summary>
+    /// Throws a <see cref="std::system_error" /> indicating that a value
+    /// does not have the expected type.
+    /// </summary>
+    [[noreturn]] void throw_invalid_data(void) {
+        throw std::system_error(ERROR_INVALID_DATA, std::system_category());
+    }
+
+} /* namespace */
+
+
+/*
+ * visus::dataverse::json_view::json_view
+ */
+visus::dataverse::json_view::json_view(
+        _In_reads_bytes_(cnt) const char *data,
+        _In_ const std::size_t cnt) noexcept
+        : _data(nullptr), _end(nullptr), _key(nullptr), _key_size(0),
+        _size(0) {
+    if (data != nullptr) {
+        this->_end = data + cnt;
+        this->_data = skip_space(data, this->_end);
+
+        if (this->_data == this->_end) {
+            this->_data = nullptr;
+        }
+    }
+}
+
+
+/*
+ * visus::dataverse::json_view::at
+ */
+visus::dataverse::json_view visus::dataverse::json_view::at(
+        _In_opt_z_ const char *pointer) const noexcept {
+    if ((pointer == nullptr) || (*pointer == 0)) {
+        return *this;
+    }
+
+    if (*pointer != '/') {
+        return json_view();
+    }
+
+    auto retval = *this;
+    while ((*pointer == '/') && retval) {
+        const auto token = ++pointer;
+        while ((*pointer != 0) && (*pointer != '/')) {
+            ++pointer;
+        }
+
+        if (retval.type() == value_type::array) {
+            // The token must be a non-negative decimal index.
+            if (token == pointer) {
+                return json_view();
+            }
+
+            std::size_t index = 0;
+            for (auto t = token; t < pointer; ++t) {
+                if ((*t < '0') || (*t > '9')) {
+                    return json_view();
+                }
+                index = 10 * index + (*t - '0');
+            }
+
+            retval = retval.element(index);
+
+        } else if (retval.type() == value_type::object) {
+            auto child = retval.first();
+            while (child && !token_equals(token, pointer, child._key,
+                    child._key + child._key_size)) {
+                child = child.next();
+            }
+
+            retval = child;
+
+        } else {
+            return json_view();
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::json_view::element
+ */
+visus::dataverse::json_view visus::dataverse::json_view::element(
+        _In_ const std::size_t index) const noexcept {
+    if (this->type() != value_type::array) {
+        return json_view();
+    }
+
+    auto retval = this->first();
+    for (std::size_t i = 0; (i < index) && retval; ++i) {
+        retval = retval.next();
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::json_view::equals
+ */
+bool visus::dataverse::json_view::equals(_In_reads_(cnt) const char *str,
+        _In_ const std::size_t cnt) const noexcept {
+    if (this->type() != value_type::string) {
+        return false;
+    }
+
+    const auto len = this->length();
+    if (len < 2) {
+        return false;
+    }
+
+    return raw_equals(this->_data + 1, this->_data + len - 1, str, cnt);
+}
+
+
+/*
+ * visus::dataverse::json_view::first
+ */
+visus::dataverse::json_view visus::dataverse::json_view::first(
+        void) const noexcept {
+    const auto type = this->type();
+    if ((type != value_type::array) && (type != value_type::object)) {
+        return json_view();
+    }
+
+    auto cur = skip_space(this->_data + 1, this->_end);
+    if ((cur >= this->_end) || (*cur == ']') || (*cur == '}')) {
+        return json_view();
+    }
+
+    const char *key = nullptr;
+    std::size_t key_size = 0;
+
+    if (type == value_type::object) {
+        if (*cur != '"') {
+            return json_view();
+        }
+
+        const auto key_end = skip_string(cur, this->_end);
+        if (key_end == nullptr) {
+            return json_view();
+        }
+
+        key = cur + 1;
+        key_size = key_end - key - 1;
+
+        cur = skip_space(key_end, this->_end);
+        if ((cur >= this->_end) || (*cur != ':')) {
+            return json_view();
+        }
+
+        cur = skip_space(cur + 1, this->_end);
+    }
+
+    const auto value_end = skip_value(cur, this->_end);
+    if (value_end == nullptr) {
+        return json_view();
+    }
+
+    return json_view(cur, this->_end, key, key_size, value_end - cur);
+}
+
+
+/*
+ * visus::dataverse::json_view::key
+ */
+std::size_t visus::dataverse::json_view::key(
+        _Out_writes_opt_(cnt) char *dst,
+        _In_ const std::size_t cnt) const noexcept {
+    if (this->_key == nullptr) {
+        if ((dst != nullptr) && (cnt > 0)) {
+            *dst = 0;
+        }
+        return 0;
+    }
+
+    return raw_unescape(this->_key, this->_key + this->_key_size, dst, cnt);
+}
+
+
+/*
+ * visus::dataverse::json_view::length
+ */
+std::size_t visus::dataverse::json_view::length(void) const noexcept {
+    if ((this->_size == 0) && (this->_data != nullptr)) {
+        const auto end = skip_value(this->_data, this->_end);
+        return (end != nullptr) ? (end - this->_data) : 0;
+    } else {
+        return this->_size;
+    }
+}
+
+
+/*
+ * visus::dataverse::json_view::member
+ */
+visus::dataverse::json_view visus::dataverse::json_view::member(
+        _In_reads_(cnt) const char *name,
+        _In_ const std::size_t cnt) const noexcept {
+    if (this->type() != value_type::object) {
+        return json_view();
+    }
+
+    auto retval = this->first();
+    while (retval && !raw_equals(retval._key, retval._key + retval._key_size,
+            name, cnt)) {
+        retval = retval.next();
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::json_view::next
+ */
+visus::dataverse::json_view visus::dataverse::json_view::next(
+        void) const noexcept {
+    const auto len = this->length();
+    if (len == 0) {
+        return json_view();
+    }
+
+    auto cur = skip_space(this->_data + len, this->_end);
+    if ((cur >= this->_end) || (*cur != ',')) {
+        return json_view();
+    }
+
+    cur = skip_space(cur + 1, this->_end);
+    if (cur >= this->_end) {
+        return json_view();
+    }
+
+    const char *key = nullptr;
+    std::size_t key_size = 0;
+
+    if (*cur == '"') {
+        // The next sibling is either a string element of an array or the
+        // name of the next member of an object. We can only tell by looking
+        // for the colon after it.
+        const auto str_end = skip_string(cur, this->_end);
+        if (str_end == nullptr) {
+            return json_view();
+        }
+
+        const auto colon = skip_space(str_end, this->_end);
+        if ((colon < this->_end) && (*colon == ':')) {
+            key = cur + 1;
+            key_size = str_end - key - 1;
+            cur = skip_space(colon + 1, this->_end);
+        } else {
+            return json_view(cur, this->_end, nullptr, 0, str_end - cur);
+        }
+    }
+
+    const auto value_end = skip_value(cur, this->_end);
+    if (value_end == nullptr) {
+        return json_view();
+    }
+
+    return json_view(cur, this->_end, key, key_size, value_end - cur);
+}
+
+
+/*
+ * visus::dataverse::json_view::size
+ */
+std::size_t visus::dataverse::json_view::size(void) const noexcept {
+    std::size_t retval = 0;
+
+    for (auto c = this->first(); c; c = c.next()) {
+        ++retval;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::json_view::to_boolean
+ */
+bool visus::dataverse::json_view::to_boolean(void) const {
+    const auto len = this->length();
+
+    if ((len == 4) && (::memcmp(this->_data, "true", 4) == 0)) {
+        return true;
+    } else if ((len == 5) && (::memcmp(this->_data, "false", 5) == 0)) {
+        return false;
+    } else {
+        throw_invalid_data();
+    }
+}
+
+
+/*
+ * visus::dataverse::json_view::to_double
+ */
+double visus::dataverse::json_view::to_double(void) const {
+    if (this->type() != value_type::number) {
+        throw_invalid_data();
+    }
+
+    std::istringstream stream(std::string(this->_data, this->length()));
+    stream.imbue(std::locale::classic());
+
+    double retval;
+    stream >> retval;
+
+    if (stream.fail() || !stream.eof()) {
+        throw_invalid_data();
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::json_view::to_int64
+ */
+std::int64_t visus::dataverse::json_view::to_int64(void) const {
+    if (this->type() != value_type::number) {
+        throw_invalid_data();
+    }
+
+    if (*this->_data != '-') {
+        const auto retval = this->to_uint64();
+        if (retval > static_cast<std::uint64_t>(
+                (std::numeric_limits<std::int64_t>::max)())) {
+            throw std::system_error(ERROR_ARITHMETIC_OVERFLOW,
+                std::system_category());
+        }
+        return static_cast<std::int64_t>(retval);
+    }
+
+    // Parse the magnitude, which might be one larger than the maximum
+    // positive value.
+    json_view magnitude(*this);
+    ++magnitude._data;
+    magnitude._size = this->length() - 1;
+    const auto retval = magnitude.to_uint64();
+
+    const auto limit = static_cast<std::uint64_t>(
+        (std::numeric_limits<std::int64_t>::max)()) + 1;
+    if (retval > limit) {
+        throw std::system_error(ERROR_ARITHMETIC_OVERFLOW,
+            std::system_category());
+    }
+
+    return (retval == limit)
+        ? (std::numeric_limits<std::int64_t>::min)()
+        : -static_cast<std::int64_t>(retval);
+}
+
+
+/*
+ * visus::dataverse::json_view::to_string
+ */
+std::size_t visus::dataverse::json_view::to_string(
+        _Out_writes_opt_(cnt) char *dst,
+        _In_ const std::size_t cnt) const {
+    if (this->type() != value_type::string) {
+        throw_invalid_data();
+    }
+
+    const auto len = this->length();
+    if (len < 2) {
+        throw_invalid_data();
+    }
+
+    const auto retval = raw_unescape(this->_data + 1, this->_data + len - 1,
+        dst, cnt);
+    if (retval == 0) {
+        throw_invalid_data();
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::json_view::to_uint64
+ */
+std::uint64_t visus::dataverse::json_view::to_uint64(void) const {
+    const auto len = this->length();
+    if ((len == 0) || (*this->_data < '0') || (*this->_data > '9')) {
+        throw_invalid_data();
+    }
+
+    const auto max = (std::numeric_limits<std::uint64_t>::max)();
+    std::uint64_t retval = 0;
+
+    for (auto c = this->_data, end = this->_data + len; c < end; ++c) {
+        if ((*c < '0') || (*c > '9')) {
+            throw_invalid_data();
+        }
+
+        const auto digit = static_cast<std::uint64_t>(*c - '0');
+        if (retval > (max - digit) / 10) {
+            throw std::system_error(ERROR_ARITHMETIC_OVERFLOW,
+                std::system_category());
+        }
+
+        retval = 10 * retval + digit;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::json_view::type
+ */
+visus::dataverse::json_view::value_type visus::dataverse::json_view::type(
+        void) const noexcept {
+    if (this->_data == nullptr) {
+        return value_type::invalid;
+    }
+
+    switch (*this->_data) {
+        case 'n': return value_type::null;
+        case 't': return value_type::boolean;
+        case 'f': return value_type::boolean;
+        case '"': return value_type::string;
+        case '[': return value_type::array;
+        case '{': return value_type::object;
+        case '-': return value_type::number;
+        default:
+            return ((*this->_data >= '0') && (*this->_data <= '9'))
+                ? value_type::number
+                : value_type::invalid;
+    }
+}
+
+
+/*
+ * visus::dataverse::json_view::json_view
+ */
+visus::dataverse::json_view::json_view(_In_ const char *data,
+        _In_ const char *end,
+        _In_opt_ const char *key,
+        _In_ const std::size_t key_size,
+        _In_ const std::size_t size) noexcept
+    : _data(data), _end(end), _key(key), _key_size(key_size), _size(size) { }
@@ -0,0 +1,88 @@
+﻿// <copyright file="mime_buffer.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "mime_buffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include <curl/curl.h>
+
+
+/*
+ * visus::dataverse::detail::mime_buffer::free
+ */
+void visus::dataverse::detail::mime_buffer::free(_In_opt_ void *context) {
+    delete static_cast<mime_buffer *>(context);
+}
+
+
+/*
+ * visus::dataverse::detail::mime_buffer::read
+ */
+std::size_t CALLBACK visus::dataverse::detail::mime_buffer::read(
+        _Out_writes_bytes_(cnt *size) char *dst,
+        _In_ const size_t size,
+        _In_ const size_t cnt,
+        _In_opt_ void *context) {
+    auto that = static_cast<mime_buffer *>(context);
+    assert(that != nullptr);
+    assert(that->position <= that->size);
+
+    const auto retval = (std::min)(size * cnt, that->size - that->position);
+    ::memcpy(dst, that->data + that->position, retval);
+    that->position += retval;
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::mime_buffer::seek
+ */
+int CALLBACK visus::dataverse::detail::mime_buffer::seek(
+        _In_opt_ void *context,
+        _In_ const std::streamoff offset,
+        _In_ const int origin) {
+    auto that = static_cast<mime_buffer *>(context);
+    assert(that != nullptr);
+
+    std::streamoff position = 0;
+    switch (origin) {
+        case SEEK_SET:
+            position = offset;
+            break;
+
+        case SEEK_CUR:
+            position = static_cast<std::streamoff>(that->position) + offset;
+            break;
+
+        case SEEK_END:
+            position = static_cast<std::streamoff>(that->size) + offset;
+            break;
+
+        default:
+            return CURL_SEEKFUNC_FAIL;
+    }
+
+    if ((position < 0) || (static_cast<std::size_t>(position) > that->size)) {
+        return CURL_SEEKFUNC_FAIL;
+    }
+
+    that->position = static_cast<std::size_t>(position);
+    return CURL_SEEKFUNC_OK;
+}
+
+
+/*
+ * visus::dataverse::detail::mime_buffer::~mime_buffer
+ */
+visus::dataverse::detail::mime_buffer::~mime_buffer(void) noexcept {
+    if ((this->data != nullptr) && (this->deleter != nullptr)) {
+        this->deleter(this->data);
+    }
+}
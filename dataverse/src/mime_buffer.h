@@ -0,0 +1,93 @@
+﻿// <copyright file="mime_buffer.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+#include <ios>
+
+#include "dataverse/form_data.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// The source of a part of a <see cref="form_data" /> that references
+    /// the memory of the caller rather than a copy of it.
+    /// </summary>
+    /// <remarks>
+    /// Instances are passed to <c>curl_mime_data_cb</c>, which owns them
+    /// from then on and frees them via <see cref="free" /> along with the
+    /// form.
+    /// </remarks>
+    struct mime_buffer final {
+
+        /// <summary>
+        /// Deletes the <see cref="mime_buffer" /> passed as
+        /// <paramref name="context" />.
+        /// </summary>
+        static void free(_In_opt_ void *context);
+
+        /// <summary>
+        /// Copies the next chunk of the <see cref="data" /> to curl's buffer.
+        /// </summary>
+        static std::size_t CALLBACK read(
+            _Out_writes_bytes_(cnt *size) char *dst,
+            _In_ const size_t size,
+            _In_ const size_t cnt,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Repositions the read pointer, e.g. if curl needs to send the form
+        /// again.
+        /// </summary>
+        static int CALLBACK seek(_In_opt_ void *context,
+            _In_ const std::streamoff offset,
+            _In_ const int origin);
+
+        /// <summary>
+        /// The data of the part.
+        /// </summary>
+        const form_data::byte_type *data;
+
+        /// <summary>
+        /// The callback releasing <see cref="data" />, which is
+        /// <c>nullptr</c> if the caller retains ownership.
+        /// </summary>
+        form_data::data_deleter_type deleter;
+
+        /// <summary>
+        /// The position of the next byte to be read.
+        /// </summary>
+        std::size_t position;
+
+        /// <summary>
+        /// The size of <see cref="data" /> in bytes.
+        /// </summary>
+        std::size_t size;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline mime_buffer(_In_reads_bytes_(size) const form_data::byte_type *data,
+                _In_ const std::size_t size,
+                _In_opt_ const form_data::data_deleter_type deleter) noexcept
+            : data(data), deleter(deleter), position(0), size(size) { }
+
+        mime_buffer(const mime_buffer&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~mime_buffer(void) noexcept;
+
+        mime_buffer& operator =(const mime_buffer&) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
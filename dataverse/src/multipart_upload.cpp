@@ -0,0 +1,527 @@
+﻿// <copyright file="multipart_upload.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "multipart_upload.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+#include <nlohmann/json.hpp>
+
+#include "direct_upload_context.h"
+#include "file_properties.h"
+#include "invoke_handler.h"
+#include "io_context.h"
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::multipart_upload
+ */
+visus::dataverse::detail::multipart_upload::multipart_upload(
+        _In_ direct_upload_context *context,
+        _In_ const json_view& data)
+    : _context(context),
+        _error_code(0),
+        _error_code_page(dataversepp_code_page),
+        _failed(false),
+        _in_flight(0),
+        _next(0),
+        _on_stored(nullptr),
+        _pending(2) {
+    assert(context != nullptr);
+    const auto& base_path = context->connection->base_path;
+    const auto size = context->description["fileSize"].get<std::uint64_t>();
+
+    this->_abort_url = absolute_url(base_path,
+        data.member("abort").to_string());
+    this->_complete_url = absolute_url(base_path,
+        data.member("complete").to_string());
+
+    // The server determines the minimum size of the parts, but we can use
+    // larger ones if the user asked so, because S3 does not require all of
+    // the part numbers to be used.
+    const auto part_size = (std::max)(data.member("partSize").to_uint64(),
+        context->part_size);
+    if (part_size == 0) {
+        throw std::runtime_error("The server requested a multipart upload "
+            "without specifying the size of the parts.");
+    }
+
+    const auto urls = data.member("urls");
+    const auto cnt = (std::max)((size + part_size - 1) / part_size,
+        static_cast<std::uint64_t>(1));
+    if (cnt > urls.size()) {
+        throw std::runtime_error("The server did not provide enough URLs for "
+            "the parts of a multipart upload.");
+    }
+
+    this->_parts.resize(static_cast<std::size_t>(cnt));
+    for (std::size_t i = 0; i < this->_parts.size(); ++i) {
+        auto& p = this->_parts[i];
+        p.curl = nullptr;
+        p.offset = i * part_size;
+        p.position = 0;
+        p.size = (std::min)(part_size, size - p.offset);
+        p.upload = this;
+        p.url = urls.member(std::to_string(i + 1).c_str()).to_string();
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::start
+ */
+void visus::dataverse::detail::multipart_upload::start(
+        _In_ const on_stored_type on_stored) noexcept {
+    assert(on_stored != nullptr);
+    this->_on_stored = on_stored;
+
+    if (this->_context->checksum == nullptr) {
+        // The hash has been computed before the upload started.
+        try {
+            this->_hash = this->_context->file_hash();
+        } catch (std::exception& ex) {
+            invoke_handler(record_error, ex, this);
+        }
+
+        this->step();
+        this->pump();
+        return;
+    }
+
+    // Parts complete in any order, so we cannot hash the file on the fly
+    // like a single upload does. Instead, a worker hashes the file at the
+    // same time, which only reads from the page cache once the parts have
+    // read the same range or vice versa.
+    this->_context->checksum.reset();
+
+    try {
+        auto that = this;
+        this->_context->connection->workers.submit([that](void) {
+            try {
+                const auto properties = get_file_properties(
+                    that->_context->path.c_str(), that->_context->algorithm);
+                that->_hash = properties["checksum"]["@value"]
+                    .get<std::string>();
+            } catch (std::system_error& ex) {
+                invoke_handler(record_error, ex, that);
+            } catch (std::exception& ex) {
+                invoke_handler(record_error, ex, that);
+            } catch (...) {
+                invoke_handler(record_error, that);
+            }
+
+            that->step();
+        });
+    } catch (std::exception& ex) {
+        invoke_handler(record_error, ex, this);
+        this->step();
+    }
+
+    this->pump();
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::absolute_url
+ */
+std::string visus::dataverse::detail::multipart_upload::absolute_url(
+        _In_ const std::string& base_path,
+        _In_ const std::string& url) {
+    if (url.find("://") != std::string::npos) {
+        return url;
+    }
+
+    // Keep only the scheme and the authority of the base path, which might
+    // include the path of the API.
+    const auto scheme = base_path.find("://");
+    const auto path = (scheme != std::string::npos)
+        ? base_path.find('/', scheme + 3)
+        : std::string::npos;
+    return base_path.substr(0, path) + url;
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::on_aborted
+ */
+void visus::dataverse::detail::multipart_upload::on_aborted(
+        _In_ const blob&,
+        _In_opt_ void *context) {
+    auto that = static_cast<multipart_upload *>(context);
+    assert(that != nullptr);
+    that->report();
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::on_aborted_error
+ */
+void visus::dataverse::detail::multipart_upload::on_aborted_error(
+        _In_ const int,
+        _In_z_ const char *,
+        _In_z_ const char *,
+        _In_ const narrow_string::code_page_type,
+        _In_opt_ void *context) {
+    auto that = static_cast<multipart_upload *>(context);
+    assert(that != nullptr);
+    // The user is only interested in the original error, and there is
+    // nothing else we could do about the parts on the server.
+    that->report();
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::on_completed
+ */
+void visus::dataverse::detail::multipart_upload::on_completed(
+        _In_ const blob&,
+        _In_opt_ void *context) {
+    auto that = static_cast<multipart_upload *>(context);
+    assert(that != nullptr);
+    auto ctx = that->_context;
+
+    try {
+        set_checksum(ctx->description, ctx->algorithm, that->_hash);
+    } catch (std::exception& ex) {
+        // The file is complete on the server, so we cannot abort anymore.
+        invoke_handler(direct_upload_context::forward_error, ex, ctx);
+        return;
+    }
+
+    // Note that the continuation is responsible for the context, which owns
+    // this upload, so we must not do anything afterwards.
+    that->_on_stored(ctx);
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::on_completed_error
+ */
+void visus::dataverse::detail::multipart_upload::on_completed_error(
+        _In_ const int error_code,
+        _In_z_ const char *message,
+        _In_z_ const char *category,
+        _In_ const narrow_string::code_page_type code_page,
+        _In_opt_ void *context) {
+    auto that = static_cast<multipart_upload *>(context);
+    assert(that != nullptr);
+    record_error(error_code, message, category, code_page, that);
+    that->abort();
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::on_part_error
+ */
+void visus::dataverse::detail::multipart_upload::on_part_error(
+        _In_ const int error_code,
+        _In_z_ const char *message,
+        _In_z_ const char *category,
+        _In_ const narrow_string::code_page_type code_page,
+        _In_opt_ void *context) {
+    auto part = static_cast<part_type *>(context);
+    assert(part != nullptr);
+    auto that = part->upload;
+    assert(that->_in_flight > 0);
+
+    record_error(error_code, message, category, code_page, that);
+    --that->_in_flight;
+    that->pump();
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::on_part_response
+ */
+void visus::dataverse::detail::multipart_upload::on_part_response(
+        _In_ const blob&,
+        _In_opt_ void *context) {
+    auto part = static_cast<part_type *>(context);
+    assert(part != nullptr);
+    auto that = part->upload;
+    assert(that->_in_flight > 0);
+
+    // S3 identifies the part by its ETag, which we need for completing the
+    // upload. The handle is still valid while the callback is running.
+    curl_header *header = nullptr;
+    if (::curl_easy_header(part->curl, "ETag", 0, CURLH_HEADER, -1, &header)
+            == CURLHE_OK) {
+        part->etag = header->value;
+        part->etag.erase(std::remove(part->etag.begin(), part->etag.end(),
+            '"'), part->etag.end());
+    }
+    part->curl = nullptr;
+
+    if (part->etag.empty()) {
+        record_error(0, "The storage did not return an ETag for a part of "
+            "a multipart upload.", "S3", dataversepp_code_page, that);
+    }
+
+    --that->_in_flight;
+    that->pump();
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::read_part
+ */
+std::size_t CALLBACK visus::dataverse::detail::multipart_upload::read_part(
+        _Out_writes_bytes_(cnt *size) char *dst,
+        _In_ const size_t size,
+        _In_ const size_t cnt,
+        _In_opt_ void *context) {
+    auto part = static_cast<part_type *>(context);
+    assert(part != nullptr);
+    auto& file = part->upload->_context->file;
+
+    const auto offset = part->offset + part->position;
+    const auto c = static_cast<std::size_t>((std::min)(
+        static_cast<std::uint64_t>(size * cnt),
+        part->size - part->position));
+    if (c == 0) {
+        return 0;
+    }
+
+    if (part->upload->_context->in_memory()) {
+        ::memcpy(dst, part->upload->_context->data + offset, c);
+        part->position += c;
+        return c;
+    }
+
+#if defined(_WIN32)
+    // Positional reads do not depend on the file pointer, so the parts do
+    // not interfere with each other.
+    OVERLAPPED overlapped { 0 };
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+    DWORD retval = 0;
+    if (!::ReadFile(file.get(), dst, static_cast<DWORD>(c), &retval,
+            &overlapped)) {
+        return CURL_READFUNC_ABORT;
+    }
+
+#else /* defined(_WIN32) */
+    ssize_t retval = 0;
+    do {
+        retval = ::pread(file.get(), dst, c, static_cast<off_t>(offset));
+    } while ((retval < 0) && (errno == EINTR));
+
+    if (retval < 0) {
+        return CURL_READFUNC_ABORT;
+    }
+#endif /* defined(_WIN32) */
+
+    if (retval == 0) {
+        // The file has been truncated since we determined its size.
+        return CURL_READFUNC_ABORT;
+    }
+
+    part->position += retval;
+    return static_cast<std::size_t>(retval);
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::record_error
+ */
+void visus::dataverse::detail::multipart_upload::record_error(
+        _In_ const int error_code,
+        _In_z_ const char *message,
+        _In_z_ const char *category,
+        _In_ const narrow_string::code_page_type code_page,
+        _In_opt_ void *context) {
+    auto that = static_cast<multipart_upload *>(context);
+    assert(that != nullptr);
+
+    std::lock_guard<decltype(that->_lock)> l(that->_lock);
+    if (!that->_failed) {
+        try {
+            that->_error_category = category;
+            that->_error_message = message;
+        } catch (...) { /* We still know that something went wrong. */ }
+        that->_error_code = error_code;
+        that->_error_code_page = code_page;
+        that->_failed = true;
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::seek_part
+ */
+int CALLBACK visus::dataverse::detail::multipart_upload::seek_part(
+        _In_opt_ void *context,
+        _In_ const std::streamoff offset,
+        _In_ const int origin) {
+    auto part = static_cast<part_type *>(context);
+    assert(part != nullptr);
+
+    // curl only seeks from the begin, e.g. for rewinding the body when
+    // following a redirect.
+    if ((origin != SEEK_SET) || (offset < 0)
+            || (static_cast<std::uint64_t>(offset) > part->size)) {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+
+    part->position = static_cast<std::uint64_t>(offset);
+    return CURL_SEEKFUNC_OK;
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::abort
+ */
+void visus::dataverse::detail::multipart_upload::abort(void) noexcept {
+    assert(this->_failed);
+    try {
+        auto c = io_context::create(this->_abort_url, on_aborted,
+            on_aborted_error, this);
+        c->progress.context = this->_context->progress_context;
+        c->option(CURLOPT_CUSTOMREQUEST, "DELETE");
+        this->_context->connection->add_auth_header(c);
+        c->apply_headers();
+        this->_context->connection->process(std::move(c));
+    } catch (...) {
+        this->report();
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::complete
+ */
+void visus::dataverse::detail::multipart_upload::complete(void) noexcept {
+    assert(!this->_failed);
+    try {
+        // The body maps the part numbers to their ETags.
+        auto body = nlohmann::json::object();
+        for (std::size_t i = 0; i < this->_parts.size(); ++i) {
+            body[std::to_string(i + 1)] = this->_parts[i].etag;
+        }
+
+        const auto b = body.dump();
+        std::unique_ptr<blob::byte_type[]> data(new blob::byte_type[b.size()]);
+        std::memcpy(data.get(), b.data(), b.size());
+
+        auto c = io_context::create(this->_complete_url, on_completed,
+            on_completed_error, this);
+        c->progress.context = this->_context->progress_context;
+        c->option(CURLOPT_UPLOAD, 1L);
+        c->prepare_request(data.release(), b.size(), [](const void *d) {
+            delete[] static_cast<const blob::byte_type *>(d);
+        });
+        this->_context->connection->add_auth_header(c);
+        c->add_header("Content-Type: application/json");
+        c->apply_headers();
+        this->_context->connection->process(std::move(c));
+
+    } catch (std::system_error& ex) {
+        invoke_handler(record_error, ex, this);
+        this->abort();
+    } catch (std::exception& ex) {
+        invoke_handler(record_error, ex, this);
+        this->abort();
+    } catch (...) {
+        invoke_handler(record_error, this);
+        this->abort();
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::pump
+ */
+void visus::dataverse::detail::multipart_upload::pump(void) noexcept {
+    while (!this->_failed
+            && (this->_in_flight < this->_context->parallelism)
+            && (this->_next < this->_parts.size())) {
+        this->start_part();
+    }
+
+    if (this->_in_flight == 0) {
+        // Either all parts have been transferred or there was an error and
+        // we stopped starting new ones.
+        this->step();
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::report
+ */
+void visus::dataverse::detail::multipart_upload::report(void) noexcept {
+    assert(this->_failed);
+    // This deletes the context, which owns us.
+    direct_upload_context::forward_error(this->_error_code,
+        this->_error_message.c_str(),
+        this->_error_category.c_str(),
+        this->_error_code_page,
+        this->_context);
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::start_part
+ */
+void visus::dataverse::detail::multipart_upload::start_part(void) noexcept {
+    assert(this->_next < this->_parts.size());
+    auto& part = this->_parts[this->_next];
+
+    try {
+        auto c = io_context::create(part.url, on_part_response,
+            on_part_error, &part);
+        c->progress.context = this->_context->progress_context;
+        c->option(CURLOPT_UPLOAD, 1L);
+        c->option(CURLOPT_INFILESIZE_LARGE, part.size);
+        c->option(CURLOPT_READFUNCTION, read_part);
+        c->option(CURLOPT_READDATA, &part);
+        c->option(CURLOPT_SEEKFUNCTION, seek_part);
+        c->option(CURLOPT_SEEKDATA, &part);
+        c->apply_headers();
+
+        part.curl = c->curl.get();
+        part.position = 0;
+        this->_context->connection->process(std::move(c));
+
+        // The callbacks of the part can only be invoked once we return to
+        // the curlm thread, so it is safe to count the part only now.
+        ++this->_in_flight;
+        ++this->_next;
+
+    } catch (std::system_error& ex) {
+        invoke_handler(record_error, ex, this);
+    } catch (std::exception& ex) {
+        invoke_handler(record_error, ex, this);
+    } catch (...) {
+        invoke_handler(record_error, this);
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::multipart_upload::step
+ */
+void visus::dataverse::detail::multipart_upload::step(void) noexcept {
+    if (--this->_pending == 0) {
+        if (this->_failed) {
+            this->abort();
+        } else {
+            this->complete();
+        }
+    }
+}
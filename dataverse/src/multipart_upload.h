@@ -0,0 +1,213 @@
+﻿// <copyright file="multipart_upload.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <ios>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "dataverse/blob.h"
+#include "dataverse/json_view.h"
+#include "dataverse/narrow_string.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /* Forward declarations. */
+    struct direct_upload_context;
+
+    /// <summary>
+    /// Transfers a file of a direct upload to S3 in multiple parts if
+    /// Dataverse requested a multipart upload.
+    /// </summary>
+    /// <remarks>
+    /// <para>Up to <see cref="direct_upload_context::parallelism" /> parts are
+    /// uploaded at the same time, each of them reading its range of the file
+    /// with positional reads, such that the parts do not interfere. As the
+    /// parts complete in any order, the hash of the file cannot be computed
+    /// while uploading, but is computed on a worker thread at the same time.
+    /// </para>
+    /// <para>Once all parts and the hash are available, the upload is
+    /// completed with the ETags of the parts and the continuation passed to
+    /// <see cref="start" /> is invoked. If anything fails, the upload is
+    /// aborted on the server and the first error is reported to the
+    /// callback of the context, which is deleted afterwards.</para>
+    /// <para>The instance is owned by its <see cref="direct_upload_context" />
+    /// and all transfers of parts are started on the curlm thread.</para>
+    /// </remarks>
+    class multipart_upload final {
+
+    public:
+
+        /// <summary>
+        /// The continuation that is invoked once the file has been stored
+        /// completely and its hash has been added to the description.
+        /// </summary>
+        typedef void (*on_stored_type)(_In_ direct_upload_context *context);
+
+        /// <summary>
+        /// Answer whether <paramref name="data" /> from the response to the
+        /// request for the upload URLs describes a multipart upload.
+        /// </summary>
+        static inline bool is_multipart(_In_ const json_view& data) noexcept {
+            return data.member("urls").valid();
+        }
+
+        /// <summary>
+        /// Initialises a new instance from the <paramref name="data" /> of
+        /// the response to the request for the upload URLs.
+        /// </summary>
+        /// <exception cref="std::system_error">If the response does not hold
+        /// the expected information.</exception>
+        /// <exception cref="std::runtime_error">If the response does not hold
+        /// enough URLs for the parts.</exception>
+        multipart_upload(_In_ direct_upload_context *context,
+            _In_ const json_view& data);
+
+        multipart_upload(const multipart_upload&) = delete;
+
+        /// <summary>
+        /// Starts transferring the parts and computing the hash.
+        /// </summary>
+        /// <remarks>
+        /// The method must be called on the curlm thread. Afterwards, the
+        /// upload is responsible for the context, i.e. the caller must not
+        /// access or delete it anymore.
+        /// </remarks>
+        void start(_In_ const on_stored_type on_stored) noexcept;
+
+        multipart_upload& operator =(const multipart_upload&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The state of a single part.
+        /// </summary>
+        struct part_type {
+            CURL *curl;
+            std::string etag;
+            std::uint64_t offset;
+            std::uint64_t position;
+            std::uint64_t size;
+            multipart_upload *upload;
+            std::string url;
+        };
+
+        /// <summary>
+        /// Makes the abort and complete URLs, which are relative to the
+        /// server, absolute using the base path of the connection.
+        /// </summary>
+        static std::string absolute_url(_In_ const std::string& base_path,
+            _In_ const std::string& url);
+
+        static void on_aborted(_In_ const blob& response,
+            _In_opt_ void *context);
+
+        static void on_aborted_error(_In_ const int error_code,
+            _In_z_ const char *message,
+            _In_z_ const char *category,
+            _In_ const narrow_string::code_page_type code_page,
+            _In_opt_ void *context);
+
+        static void on_completed(_In_ const blob& response,
+            _In_opt_ void *context);
+
+        static void on_completed_error(_In_ const int error_code,
+            _In_z_ const char *message,
+            _In_z_ const char *category,
+            _In_ const narrow_string::code_page_type code_page,
+            _In_opt_ void *context);
+
+        static void on_part_error(_In_ const int error_code,
+            _In_z_ const char *message,
+            _In_z_ const char *category,
+            _In_ const narrow_string::code_page_type code_page,
+            _In_opt_ void *context);
+
+        static void on_part_response(_In_ const blob& response,
+            _In_opt_ void *context);
+
+        static std::size_t CALLBACK read_part(
+            _Out_writes_bytes_(cnt *size) char *dst,
+            _In_ const size_t size,
+            _In_ const size_t cnt,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Remembers the given error if it is the first one, which marks the
+        /// upload as failed.
+        /// </summary>
+        static void record_error(_In_ const int error_code,
+            _In_z_ const char *message,
+            _In_z_ const char *category,
+            _In_ const narrow_string::code_page_type code_page,
+            _In_opt_ void *context);
+
+        static int CALLBACK seek_part(_In_opt_ void *context,
+            _In_ const std::streamoff offset,
+            _In_ const int origin);
+
+        /// <summary>
+        /// Asks the server to discard the parts and reports the error.
+        /// </summary>
+        void abort(void) noexcept;
+
+        /// <summary>
+        /// Asks the server to assemble the parts.
+        /// </summary>
+        void complete(void) noexcept;
+
+        /// <summary>
+        /// Starts as many parts as allowed and proceeds to the next step once
+        /// no part is in flight anymore.
+        /// </summary>
+        void pump(void) noexcept;
+
+        /// <summary>
+        /// Reports the recorded error and deletes the context along with the
+        /// upload.
+        /// </summary>
+        void report(void) noexcept;
+
+        /// <summary>
+        /// Starts the transfer of the next part.
+        /// </summary>
+        void start_part(void) noexcept;
+
+        /// <summary>
+        /// Marks the end of either the transfer of the parts or the hashing
+        /// and completes or aborts the upload after the second one.
+        /// </summary>
+        void step(void) noexcept;
+
+        std::string _abort_url;
+        std::string _complete_url;
+        direct_upload_context *_context;
+        int _error_code;
+        std::string _error_category;
+        narrow_string::code_page_type _error_code_page;
+        std::string _error_message;
+        std::atomic<bool> _failed;
+        std::string _hash;
+        std::size_t _in_flight;
+        std::mutex _lock;
+        std::size_t _next;
+        on_stored_type _on_stored;
+        std::vector<part_type> _parts;
+        std::atomic<int> _pending;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
@@ -0,0 +1,330 @@
+﻿// <copyright file="paginated_listing.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "dataverse/paginated_listing.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+
+#include "errors.h"
+#include "paginated_listing_impl.h"
+
+
+/*
+ * visus::dataverse::paginated_listing::default_max_pages
+ */
+constexpr std::size_t visus::dataverse::paginated_listing::default_max_pages;
+
+
+/*
+ * visus::dataverse::paginated_listing::default_page_size
+ */
+constexpr std::size_t visus::dataverse::paginated_listing::default_page_size;
+
+
+/*
+ * visus::dataverse::paginated_listing::paginated_listing
+ */
+visus::dataverse::paginated_listing::paginated_listing(
+        _In_ dataverse_connection& connection,
+        _In_z_ const wchar_t *resource,
+        _In_ const std::size_t page_size,
+        _In_ const std::size_t max_pages) : _impl(nullptr) {
+    if (resource == nullptr) {
+        throw std::invalid_argument("The resource to be listed must be "
+            "valid.");
+    }
+    if (page_size < 1) {
+        throw std::invalid_argument("A page must hold at least one element.");
+    }
+    if (max_pages < 1) {
+        throw std::invalid_argument("The listing must be allowed to hold at "
+            "least one page.");
+    }
+
+    std::unique_ptr<detail::paginated_listing_impl> impl(
+        new detail::paginated_listing_impl(connection, resource, page_size,
+        max_pages));
+
+    {
+        std::lock_guard<decltype(impl->lock)> l(impl->lock);
+        impl->prefetch();
+    }
+
+    this->_impl = impl.release();
+}
+
+
+/*
+ * visus::dataverse::paginated_listing::paginated_listing
+ */
+visus::dataverse::paginated_listing::paginated_listing(
+        _In_ dataverse_connection& connection,
+        _In_ const const_narrow_string& resource,
+        _In_ const std::size_t page_size,
+        _In_ const std::size_t max_pages)
+    : paginated_listing(connection,
+        (resource == nullptr)
+            ? static_cast<const wchar_t *>(nullptr)
+            : convert<wchar_t>(resource).c_str(),
+        page_size,
+        max_pages) { }
+
+
+/*
+ * visus::dataverse::paginated_listing::paginated_listing
+ */
+visus::dataverse::paginated_listing::paginated_listing(
+        _Inout_ paginated_listing&& rhs) noexcept : _impl(rhs._impl) {
+    rhs._impl = nullptr;
+}
+
+
+/*
+ * visus::dataverse::paginated_listing::~paginated_listing
+ */
+visus::dataverse::paginated_listing::~paginated_listing(void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::dataverse::paginated_listing::next
+ */
+bool visus::dataverse::paginated_listing::next(_Out_ json_view& element) {
+    auto& i = this->check_not_disposed();
+
+    if (i.current) {
+        // Fast path: the next element is on the current page, so we do not
+        // need to synchronise with the I/O thread.
+        i.current = i.current.next();
+        if (i.current) {
+            element = i.current;
+            return true;
+        }
+    }
+
+    std::unique_lock<decltype(i.lock)> l(i.lock);
+
+    // We are done with the current page, so its memory can be used for
+    // prefetching another one.
+    i.current_page.clear();
+
+    while (true) {
+        if (!i.error.empty()) {
+            throw std::runtime_error(i.error);
+        }
+
+        if (i.next_page >= i.end_page) {
+            element = json_view();
+            return false;
+        }
+
+        auto it = i.pages.find(i.next_page);
+        if (it != i.pages.end()) {
+            i.current_page = std::move(it->second);
+            i.pages.erase(it);
+            ++i.next_page;
+            i.prefetch();
+
+            i.current = json_view(i.current_page).at("/data").first();
+            if (i.current) {
+                element = i.current;
+                return true;
+            } else {
+                // This was an empty page, which marks the end of the listing.
+                continue;
+            }
+        }
+
+        i.prefetch();
+        i.changed.wait(l);
+    }
+}
+
+
+/*
+ * visus::dataverse::paginated_listing::pages
+ */
+std::size_t visus::dataverse::paginated_listing::pages(void) const {
+    auto& i = this->check_not_disposed();
+    std::lock_guard<decltype(i.lock)> l(i.lock);
+    return i.in_flight + i.pages.size() + (i.current_page.empty() ? 0 : 1);
+}
+
+
+/*
+ * visus::dataverse::paginated_listing::operator =
+ */
+visus::dataverse::paginated_listing&
+visus::dataverse::paginated_listing::operator =(
+        _Inout_ paginated_listing&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::dataverse::paginated_listing::check_not_disposed
+ */
+visus::dataverse::detail::paginated_listing_impl&
+visus::dataverse::paginated_listing::check_not_disposed(void) const {
+    if (this->_impl == nullptr) {
+        throw std::system_error(ERROR_INVALID_STATE, std::system_category());
+    } else {
+        return *this->_impl;
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::paginated_listing_impl::on_page
+ */
+void visus::dataverse::detail::paginated_listing_impl::on_page(
+        _In_ const blob& response,
+        _In_ void *context) {
+    assert(context != nullptr);
+    std::unique_ptr<page_request> request(static_cast<page_request *>(
+        context));
+    auto that = request->listing;
+
+    // Inspect the page before synchronising with the caller.
+    const json_view json(response);
+    const auto data = json.at("/data");
+    const auto cnt = data.size();
+    std::string error;
+
+    if (json.at("/status").equals("ERROR")) {
+        error = json.at("/message").to_string();
+        if (error.empty()) {
+            error = "The API reported an error while listing the resource.";
+        }
+    } else if (data.type() != json_view::value_type::array) {
+        error = "The response does not contain a listing.";
+    }
+
+    std::lock_guard<decltype(that->lock)> l(that->lock);
+    assert(that->in_flight > 0);
+    --that->in_flight;
+
+    if (request->index < that->end_page) {
+        if (!error.empty()) {
+            if (that->error.empty()) {
+                that->error = std::move(error);
+            }
+        } else {
+            if (cnt < that->page_size) {
+                // A short page is the last one.
+                that->end_page = request->index + 1;
+            }
+
+            that->pages.emplace(request->index, response);
+        }
+    }
+
+    // Note: this must be the last access to 'that', because the caller might
+    // be waiting to destroy the listing.
+    that->changed.notify_all();
+}
+
+
+/*
+ * visus::dataverse::detail::paginated_listing_impl::on_page_error
+ */
+void visus::dataverse::detail::paginated_listing_impl::on_page_error(
+        _In_ const int,
+        _In_z_ const char *message,
+        _In_z_ const char *category,
+        _In_ const narrow_string::code_page_type,
+        _In_ void *context) {
+    assert(context != nullptr);
+    std::unique_ptr<page_request> request(static_cast<page_request *>(
+        context));
+    auto that = request->listing;
+
+    std::lock_guard<decltype(that->lock)> l(that->lock);
+    assert(that->in_flight > 0);
+    --that->in_flight;
+
+    if ((request->index < that->end_page) && that->error.empty()) {
+        that->error = (message != nullptr) ? message : category;
+    }
+
+    that->changed.notify_all();
+}
+
+
+/*
+ * visus::dataverse::detail::paginated_listing_impl::paginated_listing_impl
+ */
+visus::dataverse::detail::paginated_listing_impl::paginated_listing_impl(
+        _In_ dataverse_connection& connection,
+        _In_z_ const wchar_t *resource,
+        _In_ const std::size_t page_size,
+        _In_ const std::size_t max_pages)
+    : connection(connection),
+        end_page((std::numeric_limits<std::size_t>::max)()),
+        in_flight(0),
+        max_pages(max_pages),
+        next_page(0),
+        next_request(0),
+        page_size(page_size),
+        resource(resource) {
+    // Prepare the resource such that we only need to append the parameters.
+    this->resource += (this->resource.find(L'?') == std::wstring::npos)
+        ? L'?'
+        : L'&';
+}
+
+
+/*
+ * visus::dataverse::detail::paginated_listing_impl::~paginated_listing_impl
+ */
+visus::dataverse::detail::paginated_listing_impl::~paginated_listing_impl(
+        void) {
+    // The callbacks of pending requests refer to us, so we must wait for them.
+    std::unique_lock<decltype(this->lock)> l(this->lock);
+    this->changed.wait(l, [this](void) { return (this->in_flight == 0); });
+}
+
+
+/*
+ * visus::dataverse::detail::paginated_listing_impl::prefetch
+ */
+void visus::dataverse::detail::paginated_listing_impl::prefetch(void) {
+    auto held = this->in_flight + this->pages.size()
+        + (this->current_page.empty() ? 0 : 1);
+
+    while ((held < this->max_pages) && (this->next_request < this->end_page)
+            && this->error.empty()) {
+        const auto url = this->resource
+            + L"limit=" + std::to_wstring(this->page_size)
+            + L"&offset=" + std::to_wstring(this->next_request
+                * this->page_size);
+
+        std::unique_ptr<page_request> request(new page_request());
+        request->index = this->next_request;
+        request->listing = this;
+
+        // The callbacks cannot run before we release the lock, so it is safe
+        // to account for the request after it has been issued.
+        this->connection.get(url.c_str(), on_page, on_page_error,
+            request.get());
+        request.release();
+
+        ++this->in_flight;
+        ++this->next_request;
+        ++held;
+    }
+}
@@ -0,0 +1,151 @@
+﻿// <copyright file="paginated_listing_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "dataverse/blob.h"
+#include "dataverse/dataverse_connection.h"
+#include "dataverse/json_view.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// The shared state of a <see cref="paginated_listing" />, which the
+    /// caller and the I/O thread of the connection access concurrently.
+    /// </summary>
+    struct paginated_listing_impl final {
+
+        /// <summary>
+        /// The context passed along with the request for a single page.
+        /// </summary>
+        struct page_request {
+            std::size_t index;
+            paginated_listing_impl *listing;
+        };
+
+        /// <summary>
+        /// The callback receiving a page.
+        /// </summary>
+        static void on_page(_In_ const blob& response, _In_ void *context);
+
+        /// <summary>
+        /// The callback receiving the error if a page could not be retrieved.
+        /// </summary>
+        static void on_page_error(_In_ const int code,
+            _In_z_ const char *message,
+            _In_z_ const char *category,
+            _In_ const narrow_string::code_page_type code_page,
+            _In_ void *context);
+
+        /// <summary>
+        /// Signals that a page has been received or that a request failed.
+        /// </summary>
+        std::condition_variable changed;
+
+        /// <summary>
+        /// The connection used to retrieve the pages.
+        /// </summary>
+        dataverse_connection& connection;
+
+        /// <summary>
+        /// The current element in <see cref="current_page" />.
+        /// </summary>
+        json_view current;
+
+        /// <summary>
+        /// The page the caller is iterating, which is not accessed by the I/O
+        /// thread.
+        /// </summary>
+        blob current_page;
+
+        /// <summary>
+        /// The index of the first page that is known to be past the end of
+        /// the listing.
+        /// </summary>
+        std::size_t end_page;
+
+        /// <summary>
+        /// The error message if retrieving a page failed.
+        /// </summary>
+        std::string error;
+
+        /// <summary>
+        /// The number of page requests that have not yet completed.
+        /// </summary>
+        std::size_t in_flight;
+
+        /// <summary>
+        /// Protects all members that are accessed by the I/O thread.
+        /// </summary>
+        std::mutex lock;
+
+        /// <summary>
+        /// The maximum number of pages held in memory.
+        /// </summary>
+        std::size_t max_pages;
+
+        /// <summary>
+        /// The index of the page that the caller will iterate next.
+        /// </summary>
+        std::size_t next_page;
+
+        /// <summary>
+        /// The index of the next page to be requested.
+        /// </summary>
+        std::size_t next_request;
+
+        /// <summary>
+        /// The number of elements requested per page.
+        /// </summary>
+        std::size_t page_size;
+
+        /// <summary>
+        /// Pages that have been received, but that the caller has not yet
+        /// started iterating, by their index.
+        /// </summary>
+        /// <remarks>
+        /// Prefetched requests might complete out of order.
+        /// </remarks>
+        std::map<std::size_t, blob> pages;
+
+        /// <summary>
+        /// The resource being listed.
+        /// </summary>
+        std::wstring resource;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        paginated_listing_impl(_In_ dataverse_connection& connection,
+            _In_z_ const wchar_t *resource,
+            _In_ const std::size_t page_size,
+            _In_ const std::size_t max_pages);
+
+        /// <summary>
+        /// Finalises the instance after all pending requests completed.
+        /// </summary>
+        ~paginated_listing_impl(void);
+
+        /// <summary>
+        /// Requests as many pages as the memory budget allows.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="lock" />.
+        /// </remarks>
+        void prefetch(void);
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
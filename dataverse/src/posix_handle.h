@@ -3,6 +3,8 @@
 // </copyright>
 // <author>Christoph Müller</author>
 
+#pragma once
+
 #include <fcntl.h>
 
 #if defined(_WIN32)
@@ -0,0 +1,224 @@
+﻿// <copyright file="response_cache.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "response_cache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+
+#include "dataverse_connection_impl.h"
+
+
+/*
+ * visus::dataverse::detail::response_cache::response_cache
+ */
+visus::dataverse::detail::response_cache::response_cache(void)
+        : _capacity(0), _size(0), _ttl(0) {
+    ::memset(&this->_statistics, 0, sizeof(this->_statistics));
+}
+
+
+/*
+ * visus::dataverse::detail::response_cache::~response_cache
+ */
+visus::dataverse::detail::response_cache::~response_cache(void) {
+    for (auto& e : this->_lru) {
+        dataverse_connection_impl::secure_zero(e.api_key);
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::response_cache::configure
+ */
+void visus::dataverse::detail::response_cache::configure(
+        _In_ const std::size_t capacity,
+        _In_ const duration_type ttl) {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    this->_capacity = capacity;
+    this->_ttl = (std::max)(duration_type::zero(), ttl);
+    this->evict(0);
+}
+
+
+/*
+ * visus::dataverse::detail::response_cache::enabled
+ */
+bool visus::dataverse::detail::response_cache::enabled(void) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return (this->_capacity > 0);
+}
+
+
+/*
+ * visus::dataverse::detail::response_cache::lookup
+ */
+visus::dataverse::detail::response_cache::lookup_result
+visus::dataverse::detail::response_cache::lookup(
+        _In_ const std::string& url,
+        _In_ const std::vector<char>& api_key,
+        _Out_ response_type& response,
+        _Out_ std::string& etag,
+        _Out_ std::string& last_modified) {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+
+    auto it = this->_index.find(url);
+    if ((it == this->_index.end()) || (it->second->api_key != api_key)) {
+        // Responses retrieved with other credentials must not be disclosed,
+        // so they count as a miss and will be replaced.
+        ++this->_statistics.misses;
+        return lookup_result::miss;
+    }
+
+    // Move the entry to the front of the LRU list.
+    this->_lru.splice(this->_lru.begin(), this->_lru, it->second);
+    const auto& entry = this->_lru.front();
+    response = entry.response;
+
+    if (clock_type::now() < entry.expires) {
+        ++this->_statistics.hits;
+        return lookup_result::fresh;
+    }
+
+    if (entry.etag.empty() && entry.last_modified.empty()) {
+        // Without validators, the server cannot confirm the response, so we
+        // need to retrieve it again.
+        response.reset();
+        ++this->_statistics.misses;
+        return lookup_result::miss;
+    }
+
+    etag = entry.etag;
+    last_modified = entry.last_modified;
+    return lookup_result::stale;
+}
+
+
+/*
+ * visus::dataverse::detail::response_cache::refresh
+ */
+void visus::dataverse::detail::response_cache::refresh(
+        _In_ const std::string& url,
+        _In_ const std::vector<char>& api_key) {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    ++this->_statistics.revalidations;
+
+    auto it = this->_index.find(url);
+    if ((it != this->_index.end()) && (it->second->api_key == api_key)) {
+        it->second->expires = clock_type::now() + this->_ttl;
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::response_cache::statistics
+ */
+visus::dataverse::cache_statistics
+visus::dataverse::detail::response_cache::statistics(void) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    auto retval = this->_statistics;
+    retval.entries = this->_index.size();
+    retval.size = this->_size;
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::response_cache::store
+ */
+void visus::dataverse::detail::response_cache::store(
+        _In_ const std::string& url,
+        _In_ const std::vector<char>& api_key,
+        _In_ const blob& response,
+        _In_ std::string&& etag,
+        _In_ std::string&& last_modified) {
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        // Any previous response is outdated, even if the new one cannot be
+        // stored.
+        this->remove(url);
+
+        const auto usable = (this->_ttl != duration_type::zero())
+            || !etag.empty() || !last_modified.empty();
+        if ((response.size() > this->_capacity) || !usable) {
+            // The response does not fit or it could never be used, because it
+            // is never fresh and cannot be revalidated.
+            return;
+        }
+    }
+
+    // Copy the response only if it will be stored, and do so without holding
+    // the lock.
+    auto r = std::make_shared<const blob>(response);
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    // Check again, because the cache might have been reconfigured or another
+    // response to the same URL might have been stored in the meantime.
+    this->remove(url);
+
+    if (response.size() > this->_capacity) {
+        return;
+    }
+
+    this->_statistics.evictions += this->evict(response.size());
+
+    this->_lru.emplace_front();
+    auto& entry = this->_lru.front();
+    entry.api_key = api_key;
+    entry.etag = std::move(etag);
+    entry.expires = clock_type::now() + this->_ttl;
+    entry.last_modified = std::move(last_modified);
+    entry.response = std::move(r);
+    entry.url = url;
+
+    this->_index[url] = this->_lru.begin();
+    this->_size += response.size();
+}
+
+
+/*
+ * visus::dataverse::detail::response_cache::evict
+ */
+std::size_t visus::dataverse::detail::response_cache::evict(
+        _In_ const std::size_t capacity) {
+    // Note: the caller must hold the lock!
+    std::size_t retval = 0;
+
+    while (!this->_lru.empty() && (this->_size + capacity > this->_capacity)) {
+        this->remove(std::prev(this->_lru.end()));
+        ++retval;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::response_cache::remove
+ */
+void visus::dataverse::detail::response_cache::remove(
+        _In_ list_type::iterator it) {
+    // Note: the caller must hold the lock!
+    assert(this->_size >= it->response->size());
+    this->_size -= it->response->size();
+    dataverse_connection_impl::secure_zero(it->api_key);
+    this->_index.erase(it->url);
+    this->_lru.erase(it);
+}
+
+
+/*
+ * visus::dataverse::detail::response_cache::remove
+ */
+void visus::dataverse::detail::response_cache::remove(
+        _In_ const std::string& url) {
+    // Note: the caller must hold the lock!
+    auto it = this->_index.find(url);
+    if (it != this->_index.end()) {
+        this->remove(it->second);
+    }
+}
@@ -0,0 +1,179 @@
+﻿// <copyright file="response_cache.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dataverse/blob.h"
+#include "dataverse/cache_statistics.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// A bounded in-memory cache of GET responses, which are evicted in
+    /// least-recently-used order.
+    /// </summary>
+    /// <remarks>
+    /// <para>Responses are considered fresh for a configurable time after
+    /// they have been received or revalidated. Stale responses are kept along
+    /// with their validators such that the server can confirm that they are
+    /// still valid instead of sending them again.</para>
+    /// <para>All methods are thread-safe.</para>
+    /// </remarks>
+    class response_cache final {
+
+    public:
+
+        /// <summary>
+        /// The type used to specify how long responses are fresh.
+        /// </summary>
+        typedef std::chrono::milliseconds duration_type;
+
+        /// <summary>
+        /// Possible outcomes of a <see cref="lookup" />.
+        /// </summary>
+        enum class lookup_result {
+            /// <summary>
+            /// There is no usable response in the cache.
+            /// </summary>
+            miss,
+
+            /// <summary>
+            /// The cached response is fresh and can be used without asking
+            /// the server.
+            /// </summary>
+            fresh,
+
+            /// <summary>
+            /// The cached response must be revalidated by the server using the
+            /// validators provided.
+            /// </summary>
+            stale
+        };
+
+        /// <summary>
+        /// The cached body of a response, which is shared with requests
+        /// revalidating it.
+        /// </summary>
+        typedef std::shared_ptr<const blob> response_type;
+
+        /// <summary>
+        /// Initialises a new, disabled cache.
+        /// </summary>
+        response_cache(void);
+
+        response_cache(const response_cache&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~response_cache(void);
+
+        /// <summary>
+        /// Sets the maximum size of all responses in bytes and the time they
+        /// remain fresh.
+        /// </summary>
+        /// <remarks>
+        /// Entries exceeding the new capacity are evicted immediately. A
+        /// capacity of zero disables the cache.
+        /// </remarks>
+        void configure(_In_ const std::size_t capacity,
+            _In_ const duration_type ttl);
+
+        /// <summary>
+        /// Answer whether the cache should be used.
+        /// </summary>
+        bool enabled(void) const;
+
+        /// <summary>
+        /// Looks up the response to <paramref name="url" /> that has been
+        /// retrieved with the given API key.
+        /// </summary>
+        /// <param name="url">The URL of the request.</param>
+        /// <param name="api_key">The API key of the request, which must match
+        /// the one the response has been received with.</param>
+        /// <param name="response">Receives the cached response if it is either
+        /// fresh or stale.</param>
+        /// <param name="etag">Receives the entity tag of a stale response.
+        /// </param>
+        /// <param name="last_modified">Receives the modification date of a
+        /// stale response.</param>
+        /// <returns>Whether and how the cached response can be used.
+        /// </returns>
+        lookup_result lookup(_In_ const std::string& url,
+            _In_ const std::vector<char>& api_key,
+            _Out_ response_type& response,
+            _Out_ std::string& etag,
+            _Out_ std::string& last_modified);
+
+        /// <summary>
+        /// Marks the response to <paramref name="url" /> fresh again after the
+        /// server confirmed that it has not changed.
+        /// </summary>
+        void refresh(_In_ const std::string& url,
+            _In_ const std::vector<char>& api_key);
+
+        /// <summary>
+        /// Answer statistics about the use of the cache.
+        /// </summary>
+        cache_statistics statistics(void) const;
+
+        /// <summary>
+        /// Stores a response that has just been received.
+        /// </summary>
+        /// <remarks>
+        /// Responses that are larger than the whole cache are not stored.
+        /// </remarks>
+        void store(_In_ const std::string& url,
+            _In_ const std::vector<char>& api_key,
+            _In_ const blob& response,
+            _In_ std::string&& etag,
+            _In_ std::string&& last_modified);
+
+        response_cache& operator =(const response_cache&) = delete;
+
+    private:
+
+        typedef std::chrono::steady_clock clock_type;
+
+        struct entry_type {
+            std::vector<char> api_key;
+            std::string etag;
+            clock_type::time_point expires;
+            std::string last_modified;
+            response_type response;
+            std::string url;
+        };
+
+        typedef std::list<entry_type> list_type;
+
+        std::size_t evict(_In_ const std::size_t capacity);
+
+        void remove(_In_ const std::string& url);
+
+        void remove(_In_ list_type::iterator it);
+
+        std::size_t _capacity;
+        std::unordered_map<std::string, list_type::iterator> _index;
+        list_type _lru;
+        mutable std::mutex _lock;
+        std::size_t _size;
+        cache_statistics _statistics;
+        duration_type _ttl;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
@@ -0,0 +1,147 @@
+﻿// <copyright file="stream_upload_context.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "stream_upload_context.h"
+
+#include <cassert>
+
+#include <curl/curl.h>
+
+#include "dataverse/json_view.h"
+
+
+/*
+ * visus::dataverse::detail::stream_upload_context::forward_error
+ */
+void visus::dataverse::detail::stream_upload_context::forward_error(
+        _In_ const int error_code,
+        _In_z_ const char *message,
+        _In_z_ const char *category,
+        _In_ const narrow_string::code_page_type code_page,
+        _In_opt_ void *context) {
+    std::unique_ptr<stream_upload_context> that(
+        static_cast<stream_upload_context *>(context));
+    assert(that != nullptr);
+    assert(that->on_error != nullptr);
+
+    if (that->error == nullptr) {
+        that->on_error(error_code, message, category, code_page,
+            that->user_context);
+        return;
+    }
+
+    try {
+        std::rethrow_exception(that->error);
+    } catch (std::system_error& ex) {
+        invoke_handler(that->on_error, ex, that->user_context);
+    } catch (std::exception& ex) {
+        invoke_handler(that->on_error, ex, that->user_context);
+    } catch (...) {
+        invoke_handler(that->on_error, that->user_context);
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::stream_upload_context::forward_response
+ */
+void visus::dataverse::detail::stream_upload_context::forward_response(
+        _In_ const blob& response,
+        _In_opt_ void *context) {
+    std::unique_ptr<stream_upload_context> that(
+        static_cast<stream_upload_context *>(context));
+    assert(that != nullptr);
+
+    try {
+        // If Dataverse accepted the file and computed its checksum using
+        // the same algorithm as we did, make sure that it received what the
+        // producer gave us. API errors are forwarded to the user as they
+        // are, like for any other upload.
+        const json_view json(response);
+        const auto checksum = json.at("/data/files/0/dataFile/checksum");
+
+        if (json.at("/status").equals("OK")
+                && checksum.at("/type").equals(that->algorithm)) {
+            const auto expected = that->checksum.finish();
+            if (!checksum.at("/value").equals(expected.c_str())) {
+                throw std::runtime_error("The checksum reported by Dataverse "
+                    "does not match the data that have been streamed.");
+            }
+        }
+
+        that->on_response(response, that->user_context);
+
+    } catch (std::system_error ex) {
+        invoke_handler(that->on_error, ex, that->user_context);
+    } catch (std::exception& ex) {
+        invoke_handler(that->on_error, ex, that->user_context);
+    } catch (...) {
+        invoke_handler(that->on_error, that->user_context);
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::stream_upload_context::read
+ */
+std::size_t CALLBACK visus::dataverse::detail::stream_upload_context::read(
+        _Out_writes_bytes_(cnt *size) char *dst,
+        _In_ const size_t size,
+        _In_ const size_t cnt,
+        _In_opt_ void *context) {
+    auto that = static_cast<stream_upload_context *>(context);
+    assert(that != nullptr);
+
+    try {
+        const auto retval = that->producer(dst, size, cnt,
+            that->producer_context);
+
+        if (retval == form_data::pause_read) {
+            // The producer has nothing to send yet. The connection resumes
+            // the transfer on request of the user.
+            assert(that->connection != nullptr);
+            assert(that->curl != nullptr);
+            that->connection->pause(that->curl);
+            return CURL_READFUNC_PAUSE;
+        }
+
+        // Anything else beyond the buffer is not data, but a request to
+        // stop, which also covers curl's own abort code.
+        if (retval > size * cnt) {
+            return CURL_READFUNC_ABORT;
+        }
+
+        that->checksum.update(dst, retval);
+        return retval;
+
+    } catch (...) {
+        // Neither the producer nor the hash may throw into curl, and the
+        // data cannot be produced again, so the upload must be aborted. We
+        // remember why, because curl only reports that it has been aborted.
+        that->error = std::current_exception();
+        return CURL_READFUNC_ABORT;
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::stream_upload_context::stream_upload_context
+ */
+visus::dataverse::detail::stream_upload_context::stream_upload_context(
+        _In_z_ const char *algorithm,
+        _In_ const form_data::on_read_type producer,
+        _In_opt_ void *producer_context,
+        _In_ const dataverse_connection::on_response_type on_response,
+        _In_ dataverse_connection::on_error_type on_error,
+        _In_opt_ void *context)
+    : algorithm(algorithm),
+        checksum(algorithm),
+        connection(nullptr),
+        curl(nullptr),
+        on_error(on_error),
+        on_response(on_response),
+        producer(producer),
+        producer_context(producer_context),
+        user_context(context) { }
@@ -0,0 +1,146 @@
+﻿// <copyright file="stream_upload_context.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+
+#include "dataverse/dataverse_connection.h"
+#include "dataverse/form_data.h"
+
+#include "dataverse_connection_impl.h"
+#include "hash_context.h"
+#include "invoke_handler.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// The context of an upload whose content is streamed from a producer
+    /// callback of the user.
+    /// </summary>
+    /// <remarks>
+    /// The context is passed to curl as the source of the file field of the
+    /// form and as the context of the request. It hashes the data on the fly,
+    /// because the producer cannot be asked for the data again, and verifies
+    /// the hash against the checksum Dataverse reports once the file has been
+    /// added.
+    /// </remarks>
+    struct stream_upload_context final {
+
+        /// <summary>
+        /// Forwards the error to <see cref="on_error" /> and deletes the
+        /// <paramref name="context" />.
+        /// </summary>
+        /// <remarks>
+        /// If the upload has been aborted, because the
+        /// <see cref="producer" /> threw, its exception is reported instead of
+        /// the error of curl.
+        /// </remarks>
+        static void forward_error(_In_ const int error_code,
+            _In_z_ const char *message,
+            _In_z_ const char *category,
+            _In_ const narrow_string::code_page_type code_page,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Verifies the checksum in the response of Dataverse, forwards the
+        /// response to <see cref="on_response" /> and deletes the
+        /// <paramref name="context" />.
+        /// </summary>
+        static void forward_response(_In_ const blob& response,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Obtains the next chunk of data from the <see cref="producer" /> and
+        /// adds it to the <see cref="checksum" />.
+        /// </summary>
+        /// <remarks>
+        /// If the producer returns <see cref="form_data::pause_read" />, the
+        /// transfer is paused and registered with the <see cref="connection" />,
+        /// which continues it once the user calls
+        /// <see cref="dataverse_connection::resume_uploads" />.
+        /// </remarks>
+        static std::size_t CALLBACK read(
+            _Out_writes_bytes_(cnt *size) char *dst,
+            _In_ const size_t size,
+            _In_ const size_t cnt,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// The canonical name of the hash algorithm used for
+        /// <see cref="checksum" />.
+        /// </summary>
+        const char *algorithm;
+
+        /// <summary>
+        /// The hash of the data produced so far.
+        /// </summary>
+        hash_context checksum;
+
+        /// <summary>
+        /// The connection that performs the upload, which continues the
+        /// transfer if it has been paused.
+        /// </summary>
+        dataverse_connection_impl *connection;
+
+        /// <summary>
+        /// The easy handle of the upload, which is needed for pausing it.
+        /// </summary>
+        CURL *curl;
+
+        /// <summary>
+        /// The exception thrown by the <see cref="producer" /> or while
+        /// hashing its data, which aborted the upload.
+        /// </summary>
+        std::exception_ptr error;
+
+        /// <summary>
+        /// The error handler installed by the caller.
+        /// </summary>
+        dataverse_connection::on_error_type on_error;
+
+        /// <summary>
+        /// The final result handler installed by the caller.
+        /// </summary>
+        dataverse_connection::on_response_type on_response;
+
+        /// <summary>
+        /// The callback of the user producing the content of the file.
+        /// </summary>
+        form_data::on_read_type producer;
+
+        /// <summary>
+        /// The user-specified context pointer to be passed to
+        /// <see cref="producer" />.
+        /// </summary>
+        void *producer_context;
+
+        /// <summary>
+        /// The user-specified context pointer to be passed to
+        /// <see cref="on_error" /> and <see cref="on_response" />.
+        /// </summary>
+        void *user_context;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        stream_upload_context(_In_z_ const char *algorithm,
+            _In_ const form_data::on_read_type producer,
+            _In_opt_ void *producer_context,
+            _In_ const dataverse_connection::on_response_type on_response,
+            _In_ dataverse_connection::on_error_type on_error,
+            _In_opt_ void *context);
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
@@ -0,0 +1,145 @@
+﻿// <copyright file="thread_pool.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include "thread_name.h"
+
+
+/*
+ * visus::dataverse::detail::thread_pool::thread_pool
+ */
+visus::dataverse::detail::thread_pool::thread_pool(
+        _In_ const std::size_t threads,
+        _In_z_ const char *name,
+        _In_ const std::size_t capacity)
+    : _state(std::make_shared<state>()) {
+    this->_state->capacity = capacity;
+    this->_state->idle = 0;
+    this->_state->max_threads = threads;
+    this->_state->name = name;
+    this->_state->stopping = false;
+
+    if (this->_state->max_threads == 0) {
+        this->_state->max_threads = (std::max)(
+            std::thread::hardware_concurrency(), 1u);
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::thread_pool::~thread_pool
+ */
+visus::dataverse::detail::thread_pool::~thread_pool(void) {
+    this->shutdown();
+}
+
+
+/*
+ * visus::dataverse::detail::thread_pool::shutdown
+ */
+void visus::dataverse::detail::thread_pool::shutdown(void) {
+    {
+        std::lock_guard<decltype(this->_state->lock)> l(this->_state->lock);
+        this->_state->stopping = true;
+    }
+
+    this->_state->not_empty.notify_all();
+    this->_state->not_full.notify_all();
+
+    // The workers only exit once the queue is empty. Note that we cannot
+    // hold the lock while joining, because the workers need it.
+    for (auto& t : this->_threads) {
+        if (t.get_id() == std::this_thread::get_id()) {
+            // The pool is being destroyed by one of its own tasks, which is
+            // the only case where we cannot wait for the thread. The worker
+            // keeps the shared state alive until it has left run().
+            t.detach();
+        } else if (t.joinable()) {
+            t.join();
+        }
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::thread_pool::submit
+ */
+void visus::dataverse::detail::thread_pool::submit(_In_ task_type&& task) {
+    auto& s = *this->_state;
+
+    {
+        std::unique_lock<decltype(s.lock)> l(s.lock);
+        if (s.capacity > 0) {
+            s.not_full.wait(l, [&s](void) {
+                return (s.stopping || (s.queue.size() < s.capacity));
+            });
+        }
+
+        if (s.stopping) {
+            throw std::logic_error("New work has been queued to a thread pool "
+                "that is being destructed.");
+        }
+
+        s.queue.push_back(std::move(task));
+
+        // Start another worker if all existing ones are busy and we have not
+        // yet reached the limit.
+        if ((s.idle < s.queue.size())
+                && (this->_threads.size() < s.max_threads)) {
+            this->_threads.emplace_back(&thread_pool::run, this->_state);
+            ++s.idle;
+        }
+    }
+
+    s.not_empty.notify_one();
+}
+
+
+/*
+ * visus::dataverse::detail::thread_pool::run
+ */
+void visus::dataverse::detail::thread_pool::run(
+        _In_ std::shared_ptr<state> shared) {
+    assert(shared != nullptr);
+    auto& s = *shared;
+    set_thread_name(s.name);
+
+    std::unique_lock<decltype(s.lock)> l(s.lock);
+    while (true) {
+        s.not_empty.wait(l, [&s](void) {
+            return (s.stopping || !s.queue.empty());
+        });
+
+        if (s.queue.empty()) {
+            // We only get here if the pool is being shut down and there is no
+            // work left.
+            assert(s.stopping);
+            --s.idle;
+            return;
+        }
+
+        auto task = std::move(s.queue.front());
+        s.queue.pop_front();
+        --s.idle;
+        l.unlock();
+        s.not_full.notify_one();
+
+        try {
+            task();
+        } catch (...) {
+            assert(false);
+        }
+
+        // Note that the task might have destroyed the pool, so we must not
+        // touch anything but the shared state from here on.
+        l.lock();
+        ++s.idle;
+    }
+}
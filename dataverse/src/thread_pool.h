@@ -0,0 +1,118 @@
+﻿// <copyright file="thread_pool.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dataverse/api.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// A pool of worker threads that run blocking work, e.g. file I/O, off
+    /// the threads of the caller and off the curlm thread.
+    /// </summary>
+    /// <remarks>
+    /// The worker threads are only started once work is submitted, so a pool
+    /// that is never used does not cost any threads.
+    /// </remarks>
+    class thread_pool final {
+
+    public:
+
+        /// <summary>
+        /// The type of work items that can be submitted to the pool.
+        /// </summary>
+        typedef std::function<void(void)> task_type;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="threads">The maximum number of worker threads. If
+        /// zero, the number of hardware threads is used.</param>
+        /// <param name="name">The debug name of the worker threads.</param>
+        /// <param name="capacity">The maximum number of tasks waiting for a
+        /// worker. If this is zero, the queue is unbounded. Otherwise,
+        /// <see cref="submit" /> blocks while the queue is full.</param>
+        thread_pool(_In_ const std::size_t threads,
+            _In_z_ const char *name,
+            _In_ const std::size_t capacity = 0);
+
+        thread_pool(const thread_pool&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor runs all work that has already been submitted.
+        /// </remarks>
+        ~thread_pool(void);
+
+        /// <summary>
+        /// Runs all work that has been submitted so far, waits for the
+        /// workers to exit and refuses any further work.
+        /// </summary>
+        void shutdown(void);
+
+        /// <summary>
+        /// Queues the given work for execution on one of the workers.
+        /// </summary>
+        /// <remarks>
+        /// <para>The task must not throw. Any exception escaping it is
+        /// swallowed.</para>
+        /// <para>If the pool is bounded, the method blocks until there is
+        /// space in the queue. Tasks must therefore never submit to a
+        /// bounded pool they are running on.</para>
+        /// </remarks>
+        /// <exception cref="std::logic_error">If the pool has been shut down.
+        /// </exception>
+        /// <exception cref="std::system_error">If a worker thread could not
+        /// be started.</exception>
+        void submit(_In_ task_type&& task);
+
+        thread_pool& operator =(const thread_pool&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The state shared between the pool and its workers.
+        /// </summary>
+        /// <remarks>
+        /// The workers own the state together with the pool, because a task
+        /// may destroy the pool, in which case its worker is detached and
+        /// must still be able to leave <see cref="run" /> safely.
+        /// </remarks>
+        struct state {
+            std::size_t capacity;
+            std::size_t idle;
+            std::mutex lock;
+            std::size_t max_threads;
+            const char *name;
+            std::condition_variable not_empty;
+            std::condition_variable not_full;
+            std::deque<task_type> queue;
+            bool stopping;
+        };
+
+        static void run(_In_ std::shared_ptr<state> shared);
+
+        std::shared_ptr<state> _state;
+        std::vector<std::thread> _threads;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
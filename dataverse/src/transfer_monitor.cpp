@@ -0,0 +1,231 @@
+﻿// <copyright file="transfer_monitor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "transfer_monitor.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "io_context.h"
+
+
+/*
+ * visus::dataverse::detail::transfer_state::transfer_state
+ */
+visus::dataverse::detail::transfer_state::transfer_state(void) noexcept
+        : context(nullptr), handler(nullptr), interval(0), reported_bytes(0),
+        monitor(nullptr) {
+    ::memset(&this->progress, 0, sizeof(this->progress));
+}
+
+
+/*
+ * visus::dataverse::detail::transfer_monitor::on_transfer
+ */
+int CALLBACK visus::dataverse::detail::transfer_monitor::on_transfer(
+        _In_opt_ void *context,
+        _In_ const curl_off_t total_receive,
+        _In_ const curl_off_t received,
+        _In_ const curl_off_t total_send,
+        _In_ const curl_off_t sent) {
+    auto request = static_cast<io_context *>(context);
+    assert(request != nullptr);
+    auto& state = request->progress;
+    auto that = state.monitor;
+    assert(that != nullptr);
+
+    if (state.handler == nullptr) {
+        // This cannot happen for attached requests, but we do not want to
+        // crash the curlm thread if it does.
+        return 0;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const auto due = (now - state.reported_time >= state.interval);
+    transfer_progress current = state.progress;
+    transfer_progress connection;
+
+    current.bytes_received = static_cast<std::uint64_t>(received);
+    current.bytes_sent = static_cast<std::uint64_t>(sent);
+    current.total_receive = static_cast<std::uint64_t>(total_receive);
+    current.total_send = static_cast<std::uint64_t>(total_send);
+
+    if (due) {
+        typedef std::chrono::duration<double> seconds_type;
+        const auto bytes = current.bytes_received + current.bytes_sent;
+        const auto elapsed = std::chrono::duration_cast<seconds_type>(
+            now - state.reported_time).count();
+        current.rate = (elapsed > 0.0)
+            ? static_cast<double>(bytes - state.reported_bytes) / elapsed
+            : 0.0;
+        estimate(current);
+        state.reported_bytes = bytes;
+        state.reported_time = now;
+    }
+
+    {
+        // Add what changed since the last call to the connection.
+        std::lock_guard<decltype(that->_lock)> l(that->_lock);
+        auto& p = that->_progress;
+        p.bytes_received += current.bytes_received
+            - state.progress.bytes_received;
+        p.bytes_sent += current.bytes_sent - state.progress.bytes_sent;
+        p.total_receive += current.total_receive
+            - state.progress.total_receive;
+        p.total_send += current.total_send - state.progress.total_send;
+        p.rate += current.rate - state.progress.rate;
+
+        if (due) {
+            connection = p;
+        }
+    }
+
+    state.progress = current;
+
+    if (due) {
+        estimate(connection);
+
+        try {
+            state.handler(current, connection, state.context);
+        } catch (...) {
+            // Exceptions must not pass curl, and a broken progress handler
+            // is no reason to fail the transfer.
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * visus::dataverse::detail::transfer_monitor::transfer_monitor
+ */
+visus::dataverse::detail::transfer_monitor::transfer_monitor(void)
+        : _handler(nullptr), _interval(1000) {
+    ::memset(&this->_progress, 0, sizeof(this->_progress));
+}
+
+
+/*
+ * visus::dataverse::detail::transfer_monitor::attach
+ */
+void visus::dataverse::detail::transfer_monitor::attach(
+        _Inout_ io_context& request) {
+    auto& state = request.progress;
+    assert(state.monitor == nullptr);
+
+    {
+        // Requests are issued from any thread, so the handler must be read
+        // under the lock. The request keeps its copy until it is detached.
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        if (this->_handler == nullptr) {
+            return;
+        }
+
+        state.handler = this->_handler;
+        state.interval = this->_interval;
+        ++this->_progress.transfers;
+    }
+
+    state.monitor = this;
+    state.reported_bytes = 0;
+    state.reported_time = std::chrono::steady_clock::now();
+    ::memset(&state.progress, 0, sizeof(state.progress));
+    state.progress.eta = -1.0;
+    state.progress.transfers = 1;
+
+    request.option(CURLOPT_XFERINFOFUNCTION, on_transfer);
+    request.option(CURLOPT_XFERINFODATA, &request);
+    request.option(CURLOPT_NOPROGRESS, 0L);
+}
+
+
+/*
+ * visus::dataverse::detail::transfer_monitor::configure
+ */
+void visus::dataverse::detail::transfer_monitor::configure(
+        _In_opt_ const dataverse_connection::on_progress_type handler,
+        _In_ const std::chrono::milliseconds interval) {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    this->_handler = handler;
+    this->_interval = interval;
+}
+
+
+/*
+ * visus::dataverse::detail::transfer_monitor::detach
+ */
+void visus::dataverse::detail::transfer_monitor::detach(
+        _Inout_ io_context& request) {
+    auto& state = request.progress;
+    if (state.monitor != this) {
+        return;
+    }
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        auto& p = this->_progress;
+        const auto& s = state.progress;
+        if (s.total_receive > s.bytes_received) {
+            p.total_receive -= s.total_receive - s.bytes_received;
+        }
+        if (s.total_send > s.bytes_sent) {
+            p.total_send -= s.total_send - s.bytes_sent;
+        }
+        p.rate -= s.rate;
+        --p.transfers;
+
+        if (p.transfers == 0) {
+            // Prevent rounding errors from accumulating over time.
+            p.rate = 0.0;
+        }
+    }
+
+    state.handler = nullptr;
+    state.monitor = nullptr;
+}
+
+
+/*
+ * visus::dataverse::detail::transfer_monitor::progress
+ */
+visus::dataverse::transfer_progress
+visus::dataverse::detail::transfer_monitor::progress(void) const {
+    transfer_progress retval;
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        retval = this->_progress;
+    }
+
+    estimate(retval);
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::transfer_monitor::estimate
+ */
+void visus::dataverse::detail::transfer_monitor::estimate(
+        _Inout_ transfer_progress& progress) noexcept {
+    const auto receive = (progress.total_receive > progress.bytes_received)
+        ? progress.total_receive - progress.bytes_received
+        : 0;
+    const auto send = (progress.total_send > progress.bytes_sent)
+        ? progress.total_send - progress.bytes_sent
+        : 0;
+
+    if ((progress.total_receive == 0) && (progress.total_send == 0)) {
+        // Nothing is known about the size, so we can only tell if there is
+        // nothing to transfer at all.
+        progress.eta = (progress.transfers == 0) ? 0.0 : -1.0;
+    } else if ((receive + send) == 0) {
+        progress.eta = 0.0;
+    } else if (progress.rate > 0.0) {
+        progress.eta = static_cast<double>(receive + send) / progress.rate;
+    } else {
+        progress.eta = -1.0;
+    }
+}
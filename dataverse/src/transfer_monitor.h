@@ -0,0 +1,165 @@
+﻿// <copyright file="transfer_monitor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <mutex>
+
+#include <curl/curl.h>
+
+#include "dataverse/dataverse_connection.h"
+#include "dataverse/transfer_progress.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /* Forward declarations. */
+    class transfer_monitor;
+    struct io_context;
+
+
+    /// <summary>
+    /// The progress of a single request as tracked by the
+    /// <see cref="transfer_monitor" />.
+    /// </summary>
+    struct transfer_state final {
+
+        /// <summary>
+        /// The user-defined context pointer passed to the progress handler,
+        /// which is the context of the operation that issued the request.
+        /// </summary>
+        void *context;
+
+        /// <summary>
+        /// The handler of the user, which has been copied from the
+        /// <see cref="monitor" /> when the request was attached.
+        /// </summary>
+        dataverse_connection::on_progress_type handler;
+
+        /// <summary>
+        /// The minimum time between two reports, which has been copied from
+        /// the <see cref="monitor" /> when the request was attached.
+        /// </summary>
+        std::chrono::milliseconds interval;
+
+        /// <summary>
+        /// The number of bytes transferred in both directions when the
+        /// progress was last reported.
+        /// </summary>
+        std::uint64_t reported_bytes;
+
+        /// <summary>
+        /// The point in time when the progress was last reported or the
+        /// transfer started.
+        /// </summary>
+        std::chrono::steady_clock::time_point reported_time;
+
+        /// <summary>
+        /// The monitor the request is attached to, which is <c>nullptr</c>
+        /// if the progress is not tracked.
+        /// </summary>
+        transfer_monitor *monitor;
+
+        /// <summary>
+        /// The progress as of the last call of curl.
+        /// </summary>
+        transfer_progress progress;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        transfer_state(void) noexcept;
+    };
+
+
+    /// <summary>
+    /// Reports the progress of the requests of a connection to the handler of
+    /// the user and aggregates it for the whole connection.
+    /// </summary>
+    /// <remarks>
+    /// <para>Requests are attached when they are handed to the curlm thread
+    /// and detached when their context is recycled. The handler of the user
+    /// is called from curl's transfer callback on the curlm thread, but at
+    /// most once per interval and request.</para>
+    /// <para>The handler and the interval are copied into the
+    /// <see cref="transfer_state" /> of a request when it is attached, such
+    /// that they can be changed via <see cref="configure" /> at any time
+    /// without affecting requests in flight.</para>
+    /// </remarks>
+    class transfer_monitor final {
+
+    public:
+
+        /// <summary>
+        /// The transfer callback installed in curl, which receives the
+        /// <see cref="io_context" /> of the request.
+        /// </summary>
+        static int CALLBACK on_transfer(_In_opt_ void *context,
+            _In_ const curl_off_t total_receive,
+            _In_ const curl_off_t received,
+            _In_ const curl_off_t total_send,
+            _In_ const curl_off_t sent);
+
+        /// <summary>
+        /// Initialises a new instance without handler.
+        /// </summary>
+        transfer_monitor(void);
+
+        transfer_monitor(const transfer_monitor&) = delete;
+
+        /// <summary>
+        /// Installs the transfer callback in the given request if a handler
+        /// has been set.
+        /// </summary>
+        void attach(_Inout_ io_context& request);
+
+        /// <summary>
+        /// Sets the handler of the user and the minimum time between two
+        /// reports for the same request for all requests that are attached
+        /// from now on.
+        /// </summary>
+        void configure(
+            _In_opt_ const dataverse_connection::on_progress_type handler,
+            _In_ const std::chrono::milliseconds interval);
+
+        /// <summary>
+        /// Removes the given request from the aggregated progress if it has
+        /// been attached.
+        /// </summary>
+        /// <remarks>
+        /// Bytes that have been expected, but not transferred, are removed
+        /// from the totals, such that failed requests do not stall the
+        /// estimate for the connection.
+        /// </remarks>
+        void detach(_Inout_ io_context& request);
+
+        /// <summary>
+        /// Answer the aggregated progress of all requests.
+        /// </summary>
+        transfer_progress progress(void) const;
+
+        transfer_monitor& operator =(const transfer_monitor&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Computes the <see cref="transfer_progress::eta" /> from the
+        /// transferred bytes, the totals and the rate.
+        /// </summary>
+        static void estimate(_Inout_ transfer_progress& progress) noexcept;
+
+        dataverse_connection::on_progress_type _handler;
+        std::chrono::milliseconds _interval;
+        mutable std::mutex _lock;
+        transfer_progress _progress;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
@@ -0,0 +1,651 @@
+﻿// <copyright file="zip_stream.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "zip_stream.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+#endif /* !defined(_WIN32) */
+
+#include <curl/curl.h>
+
+#include "dataverse/convert.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// The largest size or offset that can be stored in an archive without
+    /// ZIP64 extensions.
+    /// </summary>
+    static constexpr std::uint64_t max_zip_size = 0xFFFFFFFF;
+
+    /// <summary>
+    /// Makes sure that the given size or offset can be stored in the archive.
+    /// </summary>
+    static void check_zip_size(_In_ const std::uint64_t value) {
+        if (value > max_zip_size) {
+            throw std::runtime_error("The archive exceeds 4 GiB, which "
+                "requires ZIP64 extensions that are not supported.");
+        }
+    }
+
+    /// <summary>
+    /// Continues the CRC-32 checksum <paramref name="crc" /> with the given
+    /// data.
+    /// </summary>
+    static std::uint32_t update_crc32(_In_ std::uint32_t crc,
+            _In_reads_bytes_(cnt) const void *data,
+            _In_ std::size_t cnt) {
+#if defined(DATAVERSE_WITH_ZLIB)
+        typedef std::numeric_limits<uInt> limits_type;
+        auto d = static_cast<const Bytef *>(data);
+
+        while (cnt > 0) {
+            const auto n = static_cast<uInt>((std::min)(cnt,
+                static_cast<std::size_t>((limits_type::max)())));
+            crc = static_cast<std::uint32_t>(::crc32(crc, d, n));
+            d += n;
+            cnt -= n;
+        }
+
+        return crc;
+#else /* defined(DATAVERSE_WITH_ZLIB) */
+        static const auto table = [](void) {
+            std::array<std::uint32_t, 256> retval;
+
+            for (std::uint32_t i = 0; i < retval.size(); ++i) {
+                auto c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+                }
+                retval[i] = c;
+            }
+
+            return retval;
+        }();
+        auto d = static_cast<const std::uint8_t *>(data);
+
+        crc = ~crc;
+        for (std::size_t i = 0; i < cnt; ++i) {
+            crc = table[(crc ^ d[i]) & 0xFF] ^ (crc >> 8);
+        }
+
+        return ~crc;
+#endif /* defined(DATAVERSE_WITH_ZLIB) */
+    }
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
+
+
+/*
+ * visus::dataverse::detail::zip_stream::max_entries
+ */
+constexpr std::size_t visus::dataverse::detail::zip_stream::max_entries;
+
+
+/*
+ * visus::dataverse::detail::zip_stream::chunk_size
+ */
+constexpr std::size_t visus::dataverse::detail::zip_stream::chunk_size;
+
+
+/*
+ * visus::dataverse::detail::zip_stream::read
+ */
+std::size_t CALLBACK visus::dataverse::detail::zip_stream::read(
+        _Out_writes_bytes_(cnt *size) char *dst,
+        _In_ const size_t size,
+        _In_ const size_t cnt,
+        _In_opt_ void *context) {
+    auto that = static_cast<zip_stream *>(context);
+    assert(that != nullptr);
+
+    try {
+        return that->read(dst, size * cnt);
+    } catch (...) {
+        // Remember why the archive is incomplete, because curl only reports
+        // that the transfer has been aborted.
+        that->_error = std::current_exception();
+        return CURL_READFUNC_ABORT;
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::zip_stream
+ */
+visus::dataverse::detail::zip_stream::zip_stream(
+        _In_ const archive_compression compression)
+    : _buffer_position(0),
+        _checksum(0),
+        _compression(compression),
+        _current(0),
+        _input(chunk_size),
+        _position(0),
+        _processed(0),
+        _state(state_type::header) {
+    switch (this->_compression) {
+        case archive_compression::store:
+            break;
+
+#if defined(DATAVERSE_WITH_ZLIB)
+        case archive_compression::deflate:
+            // ZIP archives hold raw deflate streams without zlib header.
+            ::memset(&this->_deflate, 0, sizeof(this->_deflate));
+            if (::deflateInit2(&this->_deflate, Z_DEFAULT_COMPRESSION,
+                    Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw std::bad_alloc();
+            }
+            break;
+#endif /* defined(DATAVERSE_WITH_ZLIB) */
+
+        default:
+            throw std::invalid_argument("The requested compression of the "
+                "archive is not supported.");
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::~zip_stream
+ */
+visus::dataverse::detail::zip_stream::~zip_stream(void) {
+#if defined(DATAVERSE_WITH_ZLIB)
+    if (this->_compression == archive_compression::deflate) {
+        ::deflateEnd(&this->_deflate);
+    }
+#endif /* defined(DATAVERSE_WITH_ZLIB) */
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::add
+ */
+void visus::dataverse::detail::zip_stream::add(_In_z_ const wchar_t *path,
+        _In_opt_z_ const wchar_t *directory) {
+#if defined(_WIN32)
+    static const wchar_t *const separators = L"/\\";
+#else /* defined(_WIN32) */
+    static const wchar_t *const separators = L"/";
+#endif /* defined(_WIN32) */
+
+    if (path == nullptr) {
+        throw std::invalid_argument("The path of the file to be archived must "
+            "be valid.");
+    }
+    if (this->_entries.size() >= max_entries) {
+        throw std::range_error("An archive cannot hold more than 65535 "
+            "files.");
+    }
+
+    // The name of the entry is the path of the folder in the archive, which
+    // always uses forward slashes, followed by the name of the file.
+    std::wstring name;
+    if (directory != nullptr) {
+        name = directory;
+        std::replace(name.begin(), name.end(), L'\\', L'/');
+
+        const auto begin = name.find_first_not_of(L'/');
+        name.erase(0, (std::min)(begin, name.size()));
+
+        if (!name.empty() && (name.back() != L'/')) {
+            name += L'/';
+        }
+    }
+
+    {
+        const std::wstring p(path);
+        const auto separator = p.find_last_of(separators);
+        if (separator == std::wstring::npos) {
+            name += p;
+        } else {
+            name += p.substr(separator + 1);
+        }
+    }
+
+    entry e;
+    e.checksum = 0;
+    e.compressed = 0;
+    e.date = 0;
+    e.name = to_utf8(name.c_str());
+    e.offset = 0;
+    e.path = path;
+    e.size = 0;
+    e.time = 0;
+
+    if ((e.name.empty()) || (e.name.back() == '/')) {
+        throw std::invalid_argument("The path to be archived must designate "
+            "a file.");
+    }
+    if (e.name.size() > 0xFFFF) {
+        throw std::invalid_argument("The name of the entry in the archive is "
+            "too long.");
+    }
+
+    this->_entries.push_back(std::move(e));
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::read
+ */
+std::size_t visus::dataverse::detail::zip_stream::read(
+        _Out_writes_bytes_(cnt) char *dst,
+        _In_ const std::size_t cnt) {
+    while ((this->_buffer_position == this->_buffer.size())
+            && (this->_state != state_type::done)) {
+        this->_buffer.clear();
+        this->_buffer_position = 0;
+
+        switch (this->_state) {
+            case state_type::header:
+                this->produce_header();
+                break;
+
+            case state_type::data:
+                this->produce_data();
+                break;
+
+            case state_type::directory:
+                this->append_directory();
+                this->_state = state_type::done;
+                break;
+
+            default:
+                assert(false);
+                break;
+        }
+    }
+
+    const auto retval = (std::min)(cnt,
+        this->_buffer.size() - this->_buffer_position);
+    ::memcpy(dst, this->_buffer.data() + this->_buffer_position, retval);
+    this->_buffer_position += retval;
+
+    return retval;
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::append
+ */
+void visus::dataverse::detail::zip_stream::append(
+        _In_ const std::uint16_t value) {
+    const std::uint8_t bytes[] = {
+        static_cast<std::uint8_t>(value & 0xFF),
+        static_cast<std::uint8_t>((value >> 8) & 0xFF)
+    };
+    this->append(bytes, sizeof(bytes));
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::append
+ */
+void visus::dataverse::detail::zip_stream::append(
+        _In_ const std::uint32_t value) {
+    const std::uint8_t bytes[] = {
+        static_cast<std::uint8_t>(value & 0xFF),
+        static_cast<std::uint8_t>((value >> 8) & 0xFF),
+        static_cast<std::uint8_t>((value >> 16) & 0xFF),
+        static_cast<std::uint8_t>((value >> 24) & 0xFF)
+    };
+    this->append(bytes, sizeof(bytes));
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::append
+ */
+void visus::dataverse::detail::zip_stream::append(
+        _In_reads_bytes_(cnt) const void *data,
+        _In_ const std::size_t cnt) {
+    auto d = static_cast<const char *>(data);
+    this->_buffer.insert(this->_buffer.end(), d, d + cnt);
+    this->_position += cnt;
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::append_directory
+ */
+void visus::dataverse::detail::zip_stream::append_directory(void) {
+    const auto deflate = (this->_compression == archive_compression::deflate);
+    const auto count = static_cast<std::uint16_t>(this->_entries.size());
+    const auto offset = this->_position;
+    check_zip_size(offset);
+
+    for (auto& e : this->_entries) {
+        this->append(static_cast<std::uint32_t>(0x02014b50));
+        this->append(static_cast<std::uint16_t>(20));   // Made by.
+        this->append(static_cast<std::uint16_t>(20));   // Needed.
+        this->append(static_cast<std::uint16_t>(deflate ? 0x0808 : 0x0800));
+        this->append(static_cast<std::uint16_t>(deflate ? 8 : 0));
+        this->append(e.time);
+        this->append(e.date);
+        this->append(e.checksum);
+        this->append(static_cast<std::uint32_t>(e.compressed));
+        this->append(static_cast<std::uint32_t>(e.size));
+        this->append(static_cast<std::uint16_t>(e.name.size()));
+        this->append(static_cast<std::uint16_t>(0));    // Extra field.
+        this->append(static_cast<std::uint16_t>(0));    // Comment.
+        this->append(static_cast<std::uint16_t>(0));    // Disk.
+        this->append(static_cast<std::uint16_t>(0));    // Internal attributes.
+        this->append(static_cast<std::uint32_t>(0));    // External attributes.
+        this->append(static_cast<std::uint32_t>(e.offset));
+        this->append(e.name.data(), e.name.size());
+    }
+
+    const auto size = this->_position - offset;
+    check_zip_size(this->_position);
+
+    this->append(static_cast<std::uint32_t>(0x06054b50));
+    this->append(static_cast<std::uint16_t>(0));    // This disk.
+    this->append(static_cast<std::uint16_t>(0));    // Disk of the directory.
+    this->append(count);
+    this->append(count);
+    this->append(static_cast<std::uint32_t>(size));
+    this->append(static_cast<std::uint32_t>(offset));
+    this->append(static_cast<std::uint16_t>(0));    // Comment.
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::append_header
+ */
+void visus::dataverse::detail::zip_stream::append_header(
+        _In_ const entry& entry) {
+    // Names are always UTF-8 (bit 11). Deflated entries are followed by a
+    // data descriptor (bit 3), because their sizes are not yet known.
+    const auto deflate = (this->_compression == archive_compression::deflate);
+
+    this->append(static_cast<std::uint32_t>(0x04034b50));
+    this->append(static_cast<std::uint16_t>(20));
+    this->append(static_cast<std::uint16_t>(deflate ? 0x0808 : 0x0800));
+    this->append(static_cast<std::uint16_t>(deflate ? 8 : 0));
+    this->append(entry.time);
+    this->append(entry.date);
+
+    if (deflate) {
+        this->append(static_cast<std::uint32_t>(0));
+        this->append(static_cast<std::uint32_t>(0));
+        this->append(static_cast<std::uint32_t>(0));
+    } else {
+        this->append(entry.checksum);
+        this->append(static_cast<std::uint32_t>(entry.compressed));
+        this->append(static_cast<std::uint32_t>(entry.size));
+    }
+
+    this->append(static_cast<std::uint16_t>(entry.name.size()));
+    this->append(static_cast<std::uint16_t>(0));
+    this->append(entry.name.data(), entry.name.size());
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::read_file
+ */
+std::size_t visus::dataverse::detail::zip_stream::read_file(
+        _Out_writes_bytes_(cnt) void *dst,
+        _In_ const std::size_t cnt) {
+#if defined(_WIN32)
+    DWORD retval = 0;
+    if (!::ReadFile(this->_file.get(), dst, static_cast<DWORD>(cnt), &retval,
+            nullptr)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+#else /* defined(_WIN32) */
+    ssize_t retval = 0;
+    do {
+        retval = ::read(this->_file.get(), dst, cnt);
+    } while ((retval < 0) && (errno == EINTR));
+
+    if (retval < 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+
+    return static_cast<std::size_t>(retval);
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::open_file
+ */
+void visus::dataverse::detail::zip_stream::open_file(_Inout_ entry& entry) {
+    // Other processes may still write to the file, which is detected while
+    // it is being archived.
+#if defined(_WIN32)
+    this->_file.reset(::CreateFileW(entry.path.c_str(), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, 0, NULL));
+    if (!this->_file) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(this->_file.get(), &size)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+    FILETIME time, local;
+    if (!::GetFileTime(this->_file.get(), nullptr, nullptr, &time)
+            || !::FileTimeToLocalFileTime(&time, &local)
+            || !::FileTimeToDosDateTime(&local, &entry.date, &entry.time)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+    entry.size = static_cast<std::uint64_t>(size.QuadPart);
+
+#else /* defined(_WIN32) */
+    const auto path = convert<char>(entry.path.c_str(), -1, nullptr);
+    this->_file = ::open(path.c_str(), O_RDONLY);
+    if (!this->_file) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    struct stat s;
+    if (::fstat(this->_file.get(), &s) != 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    std::tm t;
+    if ((::localtime_r(&s.st_mtime, &t) == nullptr) || (t.tm_year < 80)) {
+        // MS-DOS time stamps start in 1980.
+        entry.date = (1 << 5) | 1;
+        entry.time = 0;
+    } else {
+        entry.date = static_cast<std::uint16_t>(((t.tm_year - 80) << 9)
+            | ((t.tm_mon + 1) << 5) | t.tm_mday);
+        entry.time = static_cast<std::uint16_t>((t.tm_hour << 11)
+            | (t.tm_min << 5) | (t.tm_sec / 2));
+    }
+
+    entry.size = static_cast<std::uint64_t>(s.st_size);
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::produce_data
+ */
+void visus::dataverse::detail::zip_stream::produce_data(void) {
+    assert(this->_current < this->_entries.size());
+    auto& e = this->_entries[this->_current];
+
+    const auto cnt = this->read_file(this->_input.data(), this->_input.size());
+    this->_checksum = update_crc32(this->_checksum, this->_input.data(), cnt);
+    this->_processed += cnt;
+
+    if (this->_compression == archive_compression::store) {
+        this->append(this->_input.data(), cnt);
+
+        if (cnt == 0) {
+            // The header has been written before, so the file must still be
+            // what we have seen back then.
+            if ((this->_processed != e.size)
+                    || (this->_checksum != e.checksum)) {
+                throw std::runtime_error("The file \"" + to_utf8(e.path.c_str())
+                    + "\" changed while it was being archived.");
+            }
+
+            this->_file = file_type();
+            ++this->_current;
+            this->_state = state_type::header;
+        }
+
+        return;
+    }
+
+#if defined(DATAVERSE_WITH_ZLIB)
+    assert(this->_compression == archive_compression::deflate);
+    const auto flush = (cnt == 0) ? Z_FINISH : Z_NO_FLUSH;
+    this->_deflate.next_in = reinterpret_cast<Bytef *>(this->_input.data());
+    this->_deflate.avail_in = static_cast<uInt>(cnt);
+
+    do {
+        const auto offset = this->_buffer.size();
+        this->_buffer.resize(offset + chunk_size);
+        this->_deflate.next_out = reinterpret_cast<Bytef *>(
+            this->_buffer.data() + offset);
+        this->_deflate.avail_out = static_cast<uInt>(chunk_size);
+
+        if (::deflate(&this->_deflate, flush) == Z_STREAM_ERROR) {
+            throw std::runtime_error("Compressing the archive failed.");
+        }
+
+        const auto produced = chunk_size - this->_deflate.avail_out;
+        this->_buffer.resize(offset + produced);
+        this->_position += produced;
+        e.compressed += produced;
+    } while (this->_deflate.avail_out == 0);
+
+    if (cnt == 0) {
+        e.checksum = this->_checksum;
+        e.size = this->_processed;
+        check_zip_size(e.compressed);
+        check_zip_size(e.size);
+
+        this->append(static_cast<std::uint32_t>(0x08074b50));
+        this->append(e.checksum);
+        this->append(static_cast<std::uint32_t>(e.compressed));
+        this->append(static_cast<std::uint32_t>(e.size));
+
+        ::deflateReset(&this->_deflate);
+        this->_file = file_type();
+        ++this->_current;
+        this->_state = state_type::header;
+    }
+#endif /* defined(DATAVERSE_WITH_ZLIB) */
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::produce_header
+ */
+void visus::dataverse::detail::zip_stream::produce_header(void) {
+    if (this->_current >= this->_entries.size()) {
+        this->_state = state_type::directory;
+        return;
+    }
+
+    auto& e = this->_entries[this->_current];
+    check_zip_size(this->_position);
+    e.offset = this->_position;
+    this->open_file(e);
+    this->_checksum = 0;
+    this->_processed = 0;
+
+    if (this->_compression != archive_compression::store) {
+        // The checksum and the sizes follow in the data descriptor.
+        this->append_header(e);
+        this->_state = state_type::data;
+        return;
+    }
+
+    check_zip_size(e.size);
+    e.compressed = e.size;
+
+    if (e.size <= this->_input.size()) {
+        // Small files are read at once, which gives us the checksum for the
+        // header without reading the file twice.
+        std::size_t cnt = 0;
+        std::size_t last = 0;
+        do {
+            last = this->read_file(this->_input.data() + cnt,
+                this->_input.size() - cnt);
+            cnt += last;
+        } while ((last > 0) && (cnt < this->_input.size()));
+
+        if (cnt != e.size) {
+            throw std::runtime_error("The file \"" + to_utf8(e.path.c_str())
+                + "\" changed while it was being archived.");
+        }
+
+        e.checksum = update_crc32(0, this->_input.data(), cnt);
+        this->append_header(e);
+        this->append(this->_input.data(), cnt);
+
+        this->_file = file_type();
+        ++this->_current;
+
+    } else {
+        // Large files are read twice, because their header must contain the
+        // checksum. The data are verified to be the same while they are sent.
+        std::uint64_t cnt = 0;
+        std::size_t last = 0;
+        e.checksum = 0;
+        while ((last = this->read_file(this->_input.data(),
+                this->_input.size())) > 0) {
+            e.checksum = update_crc32(e.checksum, this->_input.data(), last);
+            cnt += last;
+        }
+
+        if (cnt != e.size) {
+            throw std::runtime_error("The file \"" + to_utf8(e.path.c_str())
+                + "\" changed while it was being archived.");
+        }
+
+        this->rewind_file();
+        this->append_header(e);
+        this->_state = state_type::data;
+    }
+}
+
+
+/*
+ * visus::dataverse::detail::zip_stream::rewind_file
+ */
+void visus::dataverse::detail::zip_stream::rewind_file(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER offset;
+    offset.QuadPart = 0;
+    if (!::SetFilePointerEx(this->_file.get(), offset, nullptr, FILE_BEGIN)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+#else /* defined(_WIN32) */
+    if (::lseek(this->_file.get(), 0, SEEK_SET) == static_cast<off_t>(-1)) {
+        throw std::system_error(errno, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+}
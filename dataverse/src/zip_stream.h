@@ -0,0 +1,215 @@
+﻿// <copyright file="zip_stream.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <exception>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+
+#include <wil/resource.h>
+#endif /* defined(_WIN32) */
+
+#if defined(DATAVERSE_WITH_ZLIB)
+#include <zlib.h>
+#endif /* defined(DATAVERSE_WITH_ZLIB) */
+
+#include "dataverse/api.h"
+#include "dataverse/archive_compression.h"
+
+#include "posix_handle.h"
+
+
+namespace visus {
+namespace dataverse {
+namespace detail {
+
+    /// <summary>
+    /// Builds a ZIP archive of local files while it is being read, such that
+    /// the archive never exists as a whole, neither in memory nor on disk.
+    /// </summary>
+    /// <remarks>
+    /// <para>The files are only opened once the archive reaches them, and at
+    /// most one file is open at any time.</para>
+    /// <para>Deflated entries are followed by a data descriptor, because
+    /// their checksum and compressed size are only known once the whole file
+    /// has been read. Some readers, most notably Java's
+    /// <c>ZipInputStream</c>, do not support data descriptors for stored
+    /// entries. Therefore, the stream computes the checksum of stored files
+    /// before it writes their header. Small files are read once into memory
+    /// for that, larger ones are read twice.</para>
+    /// <para>The stream does not write ZIP64 extensions. Archives with more
+    /// than 65535 entries or more than 4 GiB of data cannot be created.
+    /// </para>
+    /// </remarks>
+    class zip_stream final {
+
+    public:
+
+        /// <summary>
+        /// The maximum number of entries in the archive.
+        /// </summary>
+        static constexpr std::size_t max_entries = 0xFFFF;
+
+        /// <summary>
+        /// A curl read callback that reads the next bytes of the archive from
+        /// the <see cref="zip_stream" /> passed as
+        /// <paramref name="context" />.
+        /// </summary>
+        /// <remarks>
+        /// If building the archive fails, the callback aborts the transfer
+        /// and remembers the reason, which can be obtained via
+        /// <see cref="error" />.
+        /// </remarks>
+        static std::size_t CALLBACK read(
+            _Out_writes_bytes_(cnt *size) char *dst,
+            _In_ const size_t size,
+            _In_ const size_t cnt,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Initialises a new, empty archive.
+        /// </summary>
+        /// <param name="compression">Determines how the files are stored.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="compression" /> is not supported by the build.
+        /// </exception>
+        explicit zip_stream(_In_ const archive_compression compression);
+
+        zip_stream(const zip_stream&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~zip_stream(void);
+
+        /// <summary>
+        /// Adds the file at the given location to the archive.
+        /// </summary>
+        /// <remarks>
+        /// The file is not accessed before it is being read.
+        /// </remarks>
+        /// <param name="path">The path to the file.</param>
+        /// <param name="directory">The folder in the archive the file is
+        /// placed in. If this is <c>nullptr</c> or empty, the file is placed
+        /// at root level.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::range_error">If the archive already holds
+        /// <see cref="max_entries" /> files.</exception>
+        void add(_In_z_ const wchar_t *path,
+            _In_opt_z_ const wchar_t *directory);
+
+        /// <summary>
+        /// Answer the reason why reading the archive failed, if any.
+        /// </summary>
+        /// <returns>The exception that made the stream abort or
+        /// <c>nullptr</c>.</returns>
+        inline const std::exception_ptr& error(void) const noexcept {
+            return this->_error;
+        }
+
+        /// <summary>
+        /// Reads the next bytes of the archive.
+        /// </summary>
+        /// <param name="dst">The buffer receiving the data.</param>
+        /// <param name="cnt">The size of <paramref name="dst" /> in bytes.
+        /// </param>
+        /// <returns>The number of bytes written to <paramref name="dst" />,
+        /// which is zero once the archive is complete.</returns>
+        /// <exception cref="std::system_error">If a file could not be read.
+        /// </exception>
+        /// <exception cref="std::runtime_error">If a file changed while it
+        /// was archived or if the archive exceeds the limits of the format.
+        /// </exception>
+        std::size_t read(_Out_writes_bytes_(cnt) char *dst,
+            _In_ const std::size_t cnt);
+
+        zip_stream& operator =(const zip_stream&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Describes a file in the archive.
+        /// </summary>
+        struct entry {
+            std::uint32_t checksum;
+            std::uint64_t compressed;
+            std::uint16_t date;
+            std::string name;
+            std::uint64_t offset;
+            std::wstring path;
+            std::uint64_t size;
+            std::uint16_t time;
+        };
+
+#if defined(_WIN32)
+        /// <summary>
+        /// The type of a file handle.
+        /// </summary>
+        typedef wil::unique_hfile file_type;
+#else  /* defined(_WIN32) */
+        typedef posix_handle file_type;
+#endif /* defined(_WIN32) */
+
+        /// <summary>
+        /// The part of the archive that is produced next.
+        /// </summary>
+        enum class state_type {
+            header,
+            data,
+            directory,
+            done
+        };
+
+        static constexpr std::size_t chunk_size = 64 * 1024;
+
+        void append(_In_ const std::uint16_t value);
+
+        void append(_In_ const std::uint32_t value);
+
+        void append(_In_reads_bytes_(cnt) const void *data,
+            _In_ const std::size_t cnt);
+
+        void append_directory(void);
+
+        void append_header(_In_ const entry& entry);
+
+        std::size_t read_file(_Out_writes_bytes_(cnt) void *dst,
+            _In_ const std::size_t cnt);
+
+        void open_file(_Inout_ entry& entry);
+
+        void produce_data(void);
+
+        void produce_header(void);
+
+        void rewind_file(void);
+
+        std::vector<char> _buffer;
+        std::size_t _buffer_position;
+        std::uint32_t _checksum;
+        archive_compression _compression;
+        std::size_t _current;
+#if defined(DATAVERSE_WITH_ZLIB)
+        z_stream _deflate;
+#endif /* defined(DATAVERSE_WITH_ZLIB) */
+        std::vector<entry> _entries;
+        std::exception_ptr _error;
+        file_type _file;
+        std::vector<char> _input;
+        std::uint64_t _position;
+        std::uint64_t _processed;
+        state_type _state;
+    };
+
+} /* namespace detail */
+} /* namespace dataverse */
+} /* namespace visus */
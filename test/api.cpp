@@ -5,13 +5,16 @@
 
 #include "CppUnitTest.h"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <chrono>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
 #include "dataverse/dataverse_connection.h"
+#include "dataverse/paginated_listing.h"
 
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
@@ -470,6 +473,59 @@ namespace test {
             }
         }
 
+        TEST_METHOD(list_files_paginated) {
+            const auto data_set = this->create_test_data_set(L"Paginated Listing Test");
+            const auto file = create_test_file();
+            const std::size_t cnt_files = 5;
+            std::uint64_t data_set_id;
+            std::wstring data_set_persistent_id;
+            std::vector<std::uint64_t> file_ids;
+
+            {
+                auto future = this->_connection.post(L"/dataverses/visus/datasets", data_set);
+                const auto json = future.get();
+                Assert::AreEqual(visus::dataverse::to_utf8(L"OK"), json["status"].get<std::string>(), L"Response status", LINE_INFO());
+                data_set_id = json["data"]["id"].get<std::uint64_t>();
+                data_set_persistent_id = visus::dataverse::convert<wchar_t>(json["data"]["persistentId"].get<std::string>(), CP_UTF8);
+            }
+
+            for (std::size_t i = 0; i < cnt_files; ++i) {
+                auto future = this->_connection.upload(data_set_persistent_id, file.first, file.second);
+                const auto json = future.get();
+                Assert::AreEqual(visus::dataverse::to_utf8(L"OK"), json["status"].get<std::string>(), L"Upload status", LINE_INFO());
+                file_ids.push_back(json["data"]["files"][0]["dataFile"]["id"].get<std::uint64_t>());
+            }
+
+            std::sort(file_ids.begin(), file_ids.end());
+
+            // Page sizes that split the files unevenly, that divide them
+            // evenly, such that only an empty page ends the listing, and that
+            // fit all of them on a single page.
+            for (const std::size_t page_size : { std::size_t(2), std::size_t(5), std::size_t(10) }) {
+                auto listing = visus::dataverse::paginated_listing::files(this->_connection, data_set_id, visus::dataverse::dataverse_connection::draught_version, page_size);
+                std::vector<std::uint64_t> listed_ids;
+                visus::dataverse::json_view element;
+
+                while (listing.next(element)) {
+                    listed_ids.push_back(element.at("/dataFile/id").to_uint64());
+                }
+
+                Assert::AreEqual(cnt_files, listed_ids.size(), L"All pages concatenated", LINE_INFO());
+                std::sort(listed_ids.begin(), listed_ids.end());
+                Assert::IsTrue(file_ids == listed_ids, L"Each file listed once", LINE_INFO());
+                Assert::IsFalse(listing.next(element), L"Listing stays at its end", LINE_INFO());
+            }
+
+            {
+                std::wstring resource(L"/datasets/");
+                resource += std::to_wstring(data_set_id);
+                resource += L"/versions/:draft";
+
+                auto future = this->_connection.erase(resource);
+                future.get();
+            }
+        }
+
 #if false
         // TODO: This does not work. Why?!
         TEST_METHOD(erase_file_manually) {
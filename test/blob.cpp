@@ -133,6 +133,30 @@ namespace test {
             Assert::AreEqual(std::uint8_t(1), *b.as<std::uint8_t>(0), L"Data unchanged at 0", LINE_INFO());
         }
 
+        TEST_METHOD(capacity) {
+            visus::dataverse::blob b { std::uint8_t(1), std::uint8_t(2) };
+
+            Assert::AreEqual(std::size_t(2), b.capacity(), L"Capacity after ctor", LINE_INFO());
+            b.truncate(0);
+            Assert::AreEqual(std::size_t(0), b.size(), L"Size after truncate", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), b.capacity(), L"Capacity retained after truncate", LINE_INFO());
+            Assert::IsNotNull(b.data(), L"Pointer retained after truncate", LINE_INFO());
+            Assert::IsTrue(b.empty(), L"Empty after truncate", LINE_INFO());
+            Assert::IsFalse(bool(b), L"Status after truncate", LINE_INFO());
+
+            const auto data = b.data();
+            b.truncate(2);
+            Assert::AreEqual(data, b.data(), L"Allocation reused", LINE_INFO());
+            Assert::IsTrue(bool(b), L"Status after growing", LINE_INFO());
+
+            b.truncate(3);
+            Assert::AreEqual(std::size_t(3), b.size(), L"Size after growing", LINE_INFO());
+            Assert::IsTrue(b.capacity() >= b.size(), L"Capacity after growing", LINE_INFO());
+
+            b.clear();
+            Assert::AreEqual(std::size_t(0), b.capacity(), L"Capacity after clear", LINE_INFO());
+        }
+
         TEST_METHOD(as) {
             visus::dataverse::blob b { std::int16_t(1), std::int16_t(2) };
 
@@ -0,0 +1,68 @@
+﻿// <copyright file="blob_view.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "CppUnitTest.h"
+
+#include <cstring>
+#include <string>
+
+#include "dataverse/blob_view.h"
+#include "dataverse/json_view.h"
+
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace test {
+
+    TEST_CLASS(blob_view) {
+
+    public:
+
+        TEST_METHOD(default_ctor) {
+            visus::dataverse::blob_view v;
+
+            Assert::IsNull(v.data(), L"Data of default-initialised view is nullptr", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), v.size(), L"Size of default-initialised view is zero", LINE_INFO());
+            Assert::IsTrue(v.empty(), L"Default-initialised view is empty", LINE_INFO());
+        }
+
+        TEST_METHOD(blob_ctor) {
+            visus::dataverse::blob b { std::uint8_t(1), std::uint8_t(2), std::uint8_t(3) };
+            visus::dataverse::blob_view v(b);
+
+            Assert::IsTrue(v.data() == b.data(), L"View refers to blob", LINE_INFO());
+            Assert::AreEqual(b.size(), v.size(), L"View spans blob", LINE_INFO());
+            Assert::AreEqual(std::uint8_t(2), v[1], L"Element access", LINE_INFO());
+        }
+
+        TEST_METHOD(slice) {
+            const std::string text("{\"a\": 1}trailer");
+            visus::dataverse::blob_view v(text);
+
+            auto s = v.slice(8);
+            Assert::AreEqual(std::string("trailer"), s.to_string(), L"Slice to end", LINE_INFO());
+            Assert::IsTrue(s.data() == text.data() + 8, L"Slice does not copy", LINE_INFO());
+
+            s = v.slice(8, 3);
+            Assert::AreEqual(std::string("tra"), s.to_string(), L"Slice with size", LINE_INFO());
+
+            s = v.slice(12, 100);
+            Assert::AreEqual(std::size_t(3), s.size(), L"Size is clamped", LINE_INFO());
+
+            s = v.slice(100);
+            Assert::IsTrue(s.empty(), L"Offset is clamped", LINE_INFO());
+            Assert::IsNull(v.as<char>(100), L"Out of range offset", LINE_INFO());
+
+            Assert::IsTrue(v.slice(8) == visus::dataverse::blob_view(std::string("trailer")), L"Equality", LINE_INFO());
+            Assert::IsTrue(v.slice(8) != v.slice(9), L"Inequality", LINE_INFO());
+
+            visus::dataverse::json_view json(v.slice(0, 8));
+            Assert::AreEqual(std::uint64_t(1), json.at("/a").to_uint64(), L"JSON in slice", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
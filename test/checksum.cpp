@@ -0,0 +1,67 @@
+﻿// <copyright file="checksum.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "CppUnitTest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "dataverse/checksum.h"
+#include "dataverse/dataverse_connection.h"
+
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace test {
+
+    TEST_CLASS(checksum) {
+
+    public:
+
+        TEST_METHOD(file_checksum) {
+            const auto path = "checksum_test.bin";
+            {
+                std::ofstream file(path, std::ios::binary | std::ios::trunc);
+                file << "abc";
+            }
+
+            const auto p = visus::dataverse::make_narrow_string(path, nullptr);
+            Assert::AreEqual(std::string("900150983cd24fb0d6963f7d28e17f72"), visus::dataverse::file_checksum(p, "MD5"), L"MD5", LINE_INFO());
+            Assert::AreEqual(std::string("a9993e364706816aba3e25717850c26c9cd0d89d"), visus::dataverse::file_checksum(p, "SHA-1"), L"SHA-1", LINE_INFO());
+            Assert::AreEqual(std::string("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"), visus::dataverse::file_checksum(p, "sha256"), L"SHA-256", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&p](void) { visus::dataverse::file_checksum(p, "CRC32"); }, L"Unsupported algorithm", LINE_INFO());
+
+            std::remove(path);
+            Assert::ExpectException<std::system_error>([&p](void) { visus::dataverse::file_checksum(p, "MD5"); }, L"Missing file", LINE_INFO());
+        }
+
+        TEST_METHOD(empty_file) {
+            const auto path = L"checksum_empty.bin";
+            {
+                std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            }
+
+            Assert::AreEqual(std::string("d41d8cd98f00b204e9800998ecf8427e"), visus::dataverse::file_checksum(path), L"MD5 of empty file", LINE_INFO());
+            ::_wremove(path);
+        }
+
+        TEST_METHOD(connection_algorithm) {
+            visus::dataverse::dataverse_connection dataverse;
+            Assert::AreEqual("MD5", dataverse.checksum_algorithm(), L"Default algorithm", LINE_INFO());
+
+            dataverse.checksum_algorithm(L"sha256");
+            Assert::AreEqual("SHA-256", dataverse.checksum_algorithm(), L"Canonical name", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&dataverse](void) { dataverse.checksum_algorithm(L"CRC32"); }, L"Unsupported algorithm", LINE_INFO());
+            Assert::AreEqual("SHA-256", dataverse.checksum_algorithm(), L"Unchanged after error", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
@@ -0,0 +1,121 @@
+﻿// <copyright file="download_checkpoint.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "CppUnitTest.h"
+
+#include <fstream>
+#include <string>
+
+#include "download_checkpoint.h"
+
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace test {
+
+    TEST_CLASS(download_checkpoint) {
+
+    public:
+
+        TEST_METHOD(merge_ranges) {
+            typedef visus::dataverse::detail::download_checkpoint::range_type range_type;
+            visus::dataverse::detail::download_checkpoint checkpoint;
+
+            Assert::IsTrue(checkpoint.ranges.empty(), L"New checkpoint has no ranges", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), checkpoint.resume_offset(), L"New checkpoint resumes at zero", LINE_INFO());
+
+            checkpoint.add(10, 10);
+            Assert::IsTrue(checkpoint.ranges.empty(), L"Empty range is ignored", LINE_INFO());
+
+            checkpoint.add(30, 40);
+            checkpoint.add(10, 20);
+            Assert::AreEqual(std::size_t(2), checkpoint.ranges.size(), L"Disjoint ranges are kept apart", LINE_INFO());
+            Assert::IsTrue(checkpoint.ranges[0] == range_type(10, 20), L"Ranges are sorted", LINE_INFO());
+            Assert::IsTrue(checkpoint.ranges[1] == range_type(30, 40), L"Ranges are sorted", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), checkpoint.resume_offset(), L"Gap at start resumes at zero", LINE_INFO());
+
+            checkpoint.add(20, 30);
+            Assert::AreEqual(std::size_t(1), checkpoint.ranges.size(), L"Adjacent ranges are merged", LINE_INFO());
+            Assert::IsTrue(checkpoint.ranges[0] == range_type(10, 40), L"Merged range", LINE_INFO());
+
+            checkpoint.add(35, 50);
+            Assert::AreEqual(std::size_t(1), checkpoint.ranges.size(), L"Overlapping ranges are merged", LINE_INFO());
+            Assert::IsTrue(checkpoint.ranges[0] == range_type(10, 50), L"Merged range", LINE_INFO());
+
+            checkpoint.add(60, 70);
+            checkpoint.add(0, 65);
+            Assert::AreEqual(std::size_t(1), checkpoint.ranges.size(), L"Range spanning multiple ranges", LINE_INFO());
+            Assert::IsTrue(checkpoint.ranges[0] == range_type(0, 70), L"Merged range", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(70), checkpoint.resume_offset(), L"Resume after first range", LINE_INFO());
+        }
+
+        TEST_METHOD(complete) {
+            visus::dataverse::detail::download_checkpoint checkpoint;
+            checkpoint.add(0, 100);
+            Assert::IsFalse(checkpoint.complete(), L"Incomplete for unknown size", LINE_INFO());
+
+            checkpoint.size = 200;
+            Assert::IsFalse(checkpoint.complete(), L"Incomplete if data are missing", LINE_INFO());
+
+            checkpoint.add(150, 200);
+            Assert::IsFalse(checkpoint.complete(), L"Incomplete if there is a gap", LINE_INFO());
+
+            checkpoint.add(100, 150);
+            Assert::IsTrue(checkpoint.complete(), L"Complete", LINE_INFO());
+
+            checkpoint.clear();
+            Assert::IsTrue(checkpoint.ranges.empty(), L"Clear removes ranges", LINE_INFO());
+            Assert::AreEqual(visus::dataverse::detail::download_checkpoint::unknown_size, checkpoint.size, L"Clear resets size", LINE_INFO());
+            Assert::IsFalse(checkpoint.complete(), L"Cleared checkpoint is incomplete", LINE_INFO());
+        }
+
+        TEST_METHOD(resume) {
+            const auto path = visus::dataverse::detail::download_checkpoint::path(L"download_checkpoint_test.bin");
+            Assert::AreEqual(std::wstring(L"download_checkpoint_test.bin.checkpoint"), path, L"Checkpoint next to download", LINE_INFO());
+
+            {
+                visus::dataverse::detail::download_checkpoint checkpoint;
+                checkpoint.etag = "\"4711\"";
+                checkpoint.size = 1000;
+                checkpoint.add(0, 100);
+                checkpoint.add(500, 600);
+                checkpoint.save(path);
+            }
+
+            {
+                visus::dataverse::detail::download_checkpoint checkpoint;
+                Assert::IsTrue(checkpoint.load(path), L"Load saved checkpoint", LINE_INFO());
+                Assert::AreEqual(std::string("\"4711\""), checkpoint.etag, L"Entity tag restored", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(1000), checkpoint.size, L"Size restored", LINE_INFO());
+                Assert::AreEqual(std::size_t(2), checkpoint.ranges.size(), L"Ranges restored", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(100), checkpoint.resume_offset(), L"Resume offset restored", LINE_INFO());
+                Assert::IsFalse(checkpoint.complete(), L"Restored checkpoint is incomplete", LINE_INFO());
+            }
+
+            {
+                std::ofstream stream(path, std::ios::trunc);
+                stream << "{ \"etag\": ";
+            }
+
+            {
+                visus::dataverse::detail::download_checkpoint checkpoint;
+                checkpoint.add(0, 10);
+                Assert::IsFalse(checkpoint.load(path), L"Corrupted checkpoint is rejected", LINE_INFO());
+                Assert::IsTrue(checkpoint.ranges.empty(), L"Corrupted checkpoint is cleared", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(0), checkpoint.resume_offset(), L"Corrupted checkpoint resumes at zero", LINE_INFO());
+            }
+
+            visus::dataverse::detail::download_checkpoint::erase(path);
+
+            {
+                visus::dataverse::detail::download_checkpoint checkpoint;
+                Assert::IsFalse(checkpoint.load(path), L"Erased checkpoint cannot be loaded", LINE_INFO());
+            }
+        }
+
+    };
+
+} /* namespace test */
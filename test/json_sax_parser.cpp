@@ -0,0 +1,175 @@
+﻿// <copyright file="json_sax_parser.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "CppUnitTest.h"
+
+#include <string>
+#include <vector>
+
+#include "json_sax_parser.h"
+
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace test {
+
+    /// <summary>
+    /// Records all events of the parser as strings.
+    /// </summary>
+    class recording_sax_handler : public visus::dataverse::json_sax_handler {
+
+    public:
+
+        std::vector<std::string> events;
+        std::string stop_at;
+
+        bool boolean(_In_ const bool value) override {
+            return this->record(value ? "true" : "false");
+        }
+
+        bool end_array(void) override {
+            return this->record("]");
+        }
+
+        bool end_object(void) override {
+            return this->record("}");
+        }
+
+        bool key(_In_reads_(cnt) const char *name, _In_ const std::size_t cnt) override {
+            return this->record("key:" + std::string(name, cnt));
+        }
+
+        bool null(void) override {
+            return this->record("null");
+        }
+
+        bool number_float(_In_ const double value, _In_reads_(cnt) const char *raw, _In_ const std::size_t cnt) override {
+            return this->record("float:" + std::string(raw, cnt) + "=" + std::to_string(value));
+        }
+
+        bool number_integer(_In_ const std::int64_t value) override {
+            return this->record("int:" + std::to_string(value));
+        }
+
+        bool number_unsigned(_In_ const std::uint64_t value) override {
+            return this->record("uint:" + std::to_string(value));
+        }
+
+        bool start_array(void) override {
+            return this->record("[");
+        }
+
+        bool start_object(void) override {
+            return this->record("{");
+        }
+
+        bool string(_In_reads_(cnt) const char *value, _In_ const std::size_t cnt) override {
+            return this->record("string:" + std::string(value, cnt));
+        }
+
+    private:
+
+        bool record(const std::string& event) {
+            this->events.push_back(event);
+            return (event != this->stop_at);
+        }
+    };
+
+
+    TEST_CLASS(json_sax_parser) {
+
+    public:
+
+        TEST_METHOD(nested) {
+            const std::string json("{\"name\": \"a\\\"b\", \"values\": [1, -2, 1.5, true, false, null, {\"inner\": []}], \"empty\": {}}");
+            const std::vector<std::string> expected {
+                "{",
+                "key:name", "string:a\"b",
+                "key:values", "[",
+                "uint:1", "int:-2", "float:1.5=" + std::to_string(1.5), "true", "false", "null",
+                "{", "key:inner", "[", "]", "}",
+                "]",
+                "key:empty", "{", "}",
+                "}"
+            };
+
+            recording_sax_handler handler;
+            visus::dataverse::detail::json_sax_parser parser;
+            parser.reset(&handler);
+
+            Assert::IsTrue(parser.feed(json.data(), json.size()), L"Feed whole document", LINE_INFO());
+            Assert::IsTrue(parser.finish(), L"Finish whole document", LINE_INFO());
+            Assert::IsFalse(parser.failed(), L"Parser has not failed", LINE_INFO());
+            Assert::IsTrue(expected == handler.events, L"Events of whole document", LINE_INFO());
+
+            // Feeding the document byte by byte forces every token to cross a
+            // chunk boundary, which must not change the events.
+            handler.events.clear();
+            parser.reset(&handler);
+
+            for (auto& c : json) {
+                Assert::IsTrue(parser.feed(&c, 1), L"Feed single byte", LINE_INFO());
+            }
+
+            Assert::IsTrue(parser.finish(), L"Finish chunked document", LINE_INFO());
+            Assert::IsTrue(expected == handler.events, L"Events of chunked document", LINE_INFO());
+        }
+
+        TEST_METHOD(array) {
+            const std::string json("[\"x\", 18446744073709551615, -9223372036854775808, 2e3, [[]]]");
+            const std::vector<std::string> expected {
+                "[",
+                "string:x",
+                "uint:18446744073709551615",
+                "int:-9223372036854775808",
+                "float:2e3=" + std::to_string(2000.0),
+                "[", "[", "]", "]",
+                "]"
+            };
+
+            recording_sax_handler handler;
+            visus::dataverse::detail::json_sax_parser parser;
+            parser.reset(&handler);
+
+            Assert::IsTrue(parser.feed(json.data(), 7), L"Feed first chunk", LINE_INFO());
+            Assert::IsTrue(parser.feed(json.data() + 7, json.size() - 7), L"Feed second chunk", LINE_INFO());
+            Assert::IsTrue(parser.finish(), L"Finish array", LINE_INFO());
+            Assert::IsTrue(expected == handler.events, L"Events of array", LINE_INFO());
+        }
+
+        TEST_METHOD(malformed) {
+            recording_sax_handler handler;
+            visus::dataverse::detail::json_sax_parser parser;
+
+            {
+                const std::string json("{\"a\": [1, 2}");
+                parser.reset(&handler);
+                parser.feed(json.data(), json.size());
+                Assert::IsTrue(parser.failed(), L"Mismatched bracket", LINE_INFO());
+                Assert::IsNotNull(parser.error(), L"Error message for mismatched bracket", LINE_INFO());
+            }
+
+            {
+                const std::string json("{\"a\": 1");
+                parser.reset(&handler);
+                Assert::IsTrue(parser.feed(json.data(), json.size()), L"Feed truncated document", LINE_INFO());
+                Assert::IsFalse(parser.finish(), L"Truncated document", LINE_INFO());
+            }
+
+            {
+                const std::string json("[1, 2, 3]");
+                handler.events.clear();
+                handler.stop_at = "uint:2";
+                parser.reset(&handler);
+                Assert::IsFalse(parser.feed(json.data(), json.size()), L"Handler cancels", LINE_INFO());
+                Assert::IsTrue(parser.failed(), L"Cancellation is a failure", LINE_INFO());
+                Assert::AreEqual(std::size_t(3), handler.events.size(), L"No events after cancellation", LINE_INFO());
+            }
+        }
+
+    };
+
+} /* namespace test */
@@ -0,0 +1,87 @@
+﻿// <copyright file="json_view.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "CppUnitTest.h"
+
+#include <cstring>
+#include <string>
+#include <system_error>
+
+#include "dataverse/json_view.h"
+
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace test {
+
+    TEST_CLASS(json_view) {
+
+    public:
+
+        TEST_METHOD(invalid) {
+            visus::dataverse::json_view empty;
+            Assert::IsFalse(empty.valid(), L"Default is invalid", LINE_INFO());
+
+            visus::dataverse::json_view space("  ", 2);
+            Assert::IsFalse(space.valid(), L"Whitespace is invalid", LINE_INFO());
+
+            const auto truncated = "{\"a\": [1,";
+            visus::dataverse::json_view t(truncated, ::strlen(truncated));
+            Assert::IsTrue(t.valid(), L"Document is not validated", LINE_INFO());
+            Assert::IsFalse(t.at("/a").valid(), L"Truncated array", LINE_INFO());
+            Assert::IsFalse(t.at("/b").valid(), L"Missing member", LINE_INFO());
+        }
+
+        TEST_METHOD(pointer) {
+            const auto text = "{ \"status\": \"OK\", \"data\": { \"files\": [ { \"id\": 1 }, { \"id\": 2 } ], \"a/b\": 3, \"c~d\": 4 } }";
+            visus::dataverse::json_view json(text, ::strlen(text));
+
+            Assert::IsTrue(json.at("/status").equals("OK"), L"Status", LINE_INFO());
+            Assert::AreEqual(std::size_t(3), json.at("/data").size(), L"Members of data", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), json.at("/data/files").size(), L"Elements of files", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(1), json.at("/data/files/0/id").to_uint64(), L"First ID", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(2), json.at("/data/files/1/id").to_uint64(), L"Second ID", LINE_INFO());
+            Assert::IsFalse(json.at("/data/files/2").valid(), L"Index out of range", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(3), json.at("/data/a~1b").to_uint64(), L"Escaped slash", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(4), json.at("/data/c~0d").to_uint64(), L"Escaped tilde", LINE_INFO());
+            Assert::IsTrue(json.at("").data() == json.data(), L"Empty pointer", LINE_INFO());
+        }
+
+        TEST_METHOD(iterate) {
+            const auto text = "[ \"a,]\", { \"k\": null }, true, -42 ]";
+            visus::dataverse::json_view json(text, ::strlen(text));
+
+            auto e = json.first();
+            Assert::IsTrue(e.type() == visus::dataverse::json_view::value_type::string, L"String", LINE_INFO());
+            Assert::AreEqual(std::string("a,]"), e.to_string(), L"String content", LINE_INFO());
+
+            e = e.next();
+            Assert::IsTrue(e.type() == visus::dataverse::json_view::value_type::object, L"Object", LINE_INFO());
+            Assert::AreEqual(std::string("k"), e.first().key(), L"Key", LINE_INFO());
+            Assert::IsTrue(e.member("k").type() == visus::dataverse::json_view::value_type::null, L"Null", LINE_INFO());
+
+            e = e.next();
+            Assert::IsTrue(e.to_boolean(), L"Boolean", LINE_INFO());
+
+            e = e.next();
+            Assert::AreEqual(std::int64_t(-42), e.to_int64(), L"Integer", LINE_INFO());
+
+            Assert::IsFalse(e.next().valid(), L"End of array", LINE_INFO());
+        }
+
+        TEST_METHOD(strings) {
+            const auto text = "{ \"k\\\"q\": \"\\u00e4\\ud83d\\ude00\\n\" }";
+            visus::dataverse::json_view json(text, ::strlen(text));
+
+            const auto value = json.member("k\"q");
+            Assert::IsTrue(value.valid(), L"Escaped key", LINE_INFO());
+            Assert::AreEqual(std::string("\xc3\xa4\xf0\x9f\x98\x80\n"), value.to_string(), L"Unescaped value", LINE_INFO());
+            Assert::ExpectException<std::system_error>([&value](void) { value.to_uint64(); }, L"Type mismatch", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
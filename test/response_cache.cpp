@@ -0,0 +1,196 @@
+﻿// <copyright file="response_cache.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "CppUnitTest.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "response_cache.h"
+
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace test {
+
+    TEST_CLASS(response_cache) {
+
+    public:
+
+        typedef visus::dataverse::detail::response_cache cache_type;
+        typedef cache_type::lookup_result result_type;
+
+        static visus::dataverse::blob make_blob(const std::string& data) {
+            visus::dataverse::blob retval(data.size());
+            ::memcpy(retval.data(), data.data(), data.size());
+            return retval;
+        }
+
+        static std::string to_string(const cache_type::response_type& response) {
+            return std::string(response->as<char>(), response->size());
+        }
+
+        TEST_METHOD(disabled) {
+            cache_type cache;
+            Assert::IsFalse(cache.enabled(), L"New cache is disabled", LINE_INFO());
+
+            const std::vector<char> key;
+            cache_type::response_type response;
+            std::string etag, last_modified;
+            cache.store("a", key, make_blob("1"), "", "");
+            Assert::IsTrue(result_type::miss == cache.lookup("a", key, response, etag, last_modified), L"Disabled cache stores nothing", LINE_INFO());
+        }
+
+        TEST_METHOD(lru_eviction) {
+            cache_type cache;
+            cache.configure(10, std::chrono::minutes(1));
+            Assert::IsTrue(cache.enabled(), L"Cache is enabled", LINE_INFO());
+
+            const std::vector<char> key;
+            cache_type::response_type response;
+            std::string etag, last_modified;
+
+            cache.store("a", key, make_blob("aaaa"), "", "");
+            cache.store("b", key, make_blob("bbbb"), "", "");
+            Assert::AreEqual(std::size_t(2), cache.statistics().entries, L"Two entries", LINE_INFO());
+            Assert::AreEqual(std::size_t(8), cache.statistics().size, L"Size of two entries", LINE_INFO());
+
+            // Use "a", such that "b" is the least recently used one.
+            Assert::IsTrue(result_type::fresh == cache.lookup("a", key, response, etag, last_modified), L"Hit a", LINE_INFO());
+            Assert::AreEqual(std::string("aaaa"), to_string(response), L"Response of a", LINE_INFO());
+
+            cache.store("c", key, make_blob("cccc"), "", "");
+            auto s = cache.statistics();
+            Assert::AreEqual(std::size_t(2), s.entries, L"Still two entries", LINE_INFO());
+            Assert::AreEqual(std::size_t(8), s.size, L"Still size of two entries", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(1), s.evictions, L"One eviction", LINE_INFO());
+            Assert::IsTrue(result_type::miss == cache.lookup("b", key, response, etag, last_modified), L"b has been evicted", LINE_INFO());
+            Assert::IsTrue(result_type::fresh == cache.lookup("a", key, response, etag, last_modified), L"a has been kept", LINE_INFO());
+            Assert::IsTrue(result_type::fresh == cache.lookup("c", key, response, etag, last_modified), L"c has been stored", LINE_INFO());
+
+            cache.store("d", key, make_blob("ddddddddddd"), "", "");
+            Assert::IsTrue(result_type::miss == cache.lookup("d", key, response, etag, last_modified), L"Response larger than cache is not stored", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), cache.statistics().entries, L"Oversized response evicts nothing", LINE_INFO());
+
+            cache.store("a", key, make_blob("aaaaaaaaaaa"), "", "");
+            Assert::IsTrue(result_type::miss == cache.lookup("a", key, response, etag, last_modified), L"Oversized response removes outdated one", LINE_INFO());
+
+            cache.configure(3, std::chrono::minutes(1));
+            s = cache.statistics();
+            Assert::AreEqual(std::size_t(0), s.entries, L"Shrinking evicts everything that does not fit", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), s.size, L"Shrinking releases the memory", LINE_INFO());
+        }
+
+        TEST_METHOD(expiry) {
+            cache_type cache;
+            const std::vector<char> key;
+            cache_type::response_type response;
+            std::string etag, last_modified;
+
+            cache.configure(1024, std::chrono::milliseconds(50));
+            cache.store("plain", key, make_blob("p"), "", "");
+            cache.store("etag", key, make_blob("e"), "\"xyz\"", "");
+            cache.store("date", key, make_blob("d"), "", "Wed, 21 Oct 2015 07:28:00 GMT");
+
+            Assert::IsTrue(result_type::fresh == cache.lookup("plain", key, response, etag, last_modified), L"Fresh within TTL", LINE_INFO());
+            Assert::IsTrue(result_type::fresh == cache.lookup("etag", key, response, etag, last_modified), L"Fresh within TTL", LINE_INFO());
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            Assert::IsTrue(result_type::miss == cache.lookup("plain", key, response, etag, last_modified), L"Expired without validators", LINE_INFO());
+            Assert::IsFalse(bool(response), L"No response for miss", LINE_INFO());
+
+            etag.clear();
+            last_modified.clear();
+            Assert::IsTrue(result_type::stale == cache.lookup("etag", key, response, etag, last_modified), L"Expired with entity tag", LINE_INFO());
+            Assert::AreEqual(std::string("\"xyz\""), etag, L"Entity tag of stale response", LINE_INFO());
+            Assert::AreEqual(std::string("e"), to_string(response), L"Stale response", LINE_INFO());
+
+            etag.clear();
+            last_modified.clear();
+            Assert::IsTrue(result_type::stale == cache.lookup("date", key, response, etag, last_modified), L"Expired with modification date", LINE_INFO());
+            Assert::AreEqual(std::string("Wed, 21 Oct 2015 07:28:00 GMT"), last_modified, L"Modification date of stale response", LINE_INFO());
+
+            // Without TTL, only responses that can be revalidated are stored.
+            cache.configure(1024, std::chrono::milliseconds(0));
+            cache.store("never", key, make_blob("n"), "", "");
+            Assert::IsTrue(result_type::miss == cache.lookup("never", key, response, etag, last_modified), L"Unusable response is not stored", LINE_INFO());
+            cache.store("always", key, make_blob("a"), "\"abc\"", "");
+            Assert::IsTrue(result_type::stale == cache.lookup("always", key, response, etag, last_modified), L"Zero TTL revalidates every time", LINE_INFO());
+        }
+
+        TEST_METHOD(refresh) {
+            cache_type cache;
+            const std::vector<char> key;
+            cache_type::response_type response;
+            std::string etag, last_modified;
+
+            cache.configure(1024, std::chrono::milliseconds(50));
+            cache.store("a", key, make_blob("a"), "\"1\"", "");
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            Assert::IsTrue(result_type::stale == cache.lookup("a", key, response, etag, last_modified), L"Expired", LINE_INFO());
+
+            // The server answered 304 Not Modified.
+            cache.refresh("a", key);
+            Assert::IsTrue(result_type::fresh == cache.lookup("a", key, response, etag, last_modified), L"Fresh after refresh", LINE_INFO());
+            Assert::AreEqual(std::string("a"), to_string(response), L"Refreshed response", LINE_INFO());
+
+            const std::vector<char> other { 'x' };
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            cache.refresh("a", other);
+            Assert::IsTrue(result_type::stale == cache.lookup("a", key, response, etag, last_modified), L"Refresh with other API key has no effect", LINE_INFO());
+        }
+
+        TEST_METHOD(api_key_isolation) {
+            cache_type cache;
+            const std::vector<char> alice { 'a', 'l', 'i', 'c', 'e' };
+            const std::vector<char> bob { 'b', 'o', 'b' };
+            cache_type::response_type response;
+            std::string etag, last_modified;
+
+            cache.configure(1024, std::chrono::minutes(1));
+            cache.store("a", alice, make_blob("secret"), "", "");
+
+            Assert::IsTrue(result_type::miss == cache.lookup("a", bob, response, etag, last_modified), L"Other API key misses", LINE_INFO());
+            Assert::IsFalse(bool(response), L"No response for other API key", LINE_INFO());
+            Assert::IsTrue(result_type::miss == cache.lookup("a", std::vector<char>(), response, etag, last_modified), L"Anonymous request misses", LINE_INFO());
+            Assert::IsTrue(result_type::fresh == cache.lookup("a", alice, response, etag, last_modified), L"Same API key hits", LINE_INFO());
+
+            cache.store("a", bob, make_blob("other"), "", "");
+            Assert::IsTrue(result_type::miss == cache.lookup("a", alice, response, etag, last_modified), L"Response of other user replaced the entry", LINE_INFO());
+            Assert::IsTrue(result_type::fresh == cache.lookup("a", bob, response, etag, last_modified), L"Response of other user", LINE_INFO());
+            Assert::AreEqual(std::string("other"), to_string(response), L"Response of other user", LINE_INFO());
+        }
+
+        TEST_METHOD(statistics) {
+            cache_type cache;
+            const std::vector<char> key;
+            cache_type::response_type response;
+            std::string etag, last_modified;
+
+            cache.configure(1024, std::chrono::milliseconds(50));
+            cache.lookup("a", key, response, etag, last_modified);
+            cache.store("a", key, make_blob("abc"), "\"1\"", "");
+            cache.lookup("a", key, response, etag, last_modified);
+            cache.lookup("a", key, response, etag, last_modified);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            cache.lookup("a", key, response, etag, last_modified);
+            cache.refresh("a", key);
+
+            const auto s = cache.statistics();
+            Assert::AreEqual(std::uint64_t(2), s.hits, L"Hits", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(1), s.misses, L"Misses", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(1), s.revalidations, L"Revalidations", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), s.evictions, L"Evictions", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), s.entries, L"Entries", LINE_INFO());
+            Assert::AreEqual(std::size_t(3), s.size, L"Size", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
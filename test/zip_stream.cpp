@@ -0,0 +1,247 @@
+﻿// <copyright file="zip_stream.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "CppUnitTest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "zip_stream.h"
+
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace test {
+
+    TEST_CLASS(zip_stream) {
+
+    public:
+
+        TEST_METHOD(store) {
+            const auto small = L"zip_stream_small.txt";
+            const auto large = L"zip_stream_large.bin";
+            const auto small_data = write(small, std::string("123456789"));
+            const auto large_data = write(large, pattern(200000, 0));
+
+            visus::dataverse::detail::zip_stream archive(visus::dataverse::archive_compression::store);
+            archive.add(small, nullptr);
+            archive.add(large, L"\\runs\\1");
+            const auto zip = read_all(archive);
+
+            ::_wremove(small);
+            ::_wremove(large);
+
+            // The small file is read at once, the large one is read twice for
+            // its checksum, but both have their sizes in the local header.
+            Assert::AreEqual(std::uint32_t(0x04034b50), u32(zip, 0), L"Signature of first local header", LINE_INFO());
+            Assert::AreEqual(std::uint16_t(0x0800), u16(zip, 6), L"UTF-8 names without data descriptor", LINE_INFO());
+            Assert::AreEqual(std::uint16_t(0), u16(zip, 8), L"First entry is stored", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(0xCBF43926), u32(zip, 14), L"Check value of CRC-32", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(9), u32(zip, 18), L"Compressed size of first entry", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(9), u32(zip, 22), L"Size of first entry", LINE_INFO());
+            Assert::AreEqual(std::string("zip_stream_small.txt"), name(zip, 0), L"Name of first entry", LINE_INFO());
+            Assert::IsTrue(small_data == zip.substr(30 + 20, 9), L"Data of first entry", LINE_INFO());
+
+            const std::size_t second = 30 + 20 + 9;
+            Assert::AreEqual(std::uint32_t(0x04034b50), u32(zip, second), L"Signature of second local header", LINE_INFO());
+            Assert::AreEqual(crc32(large_data), u32(zip, second + 14), L"CRC-32 of second entry", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(200000), u32(zip, second + 18), L"Compressed size of second entry", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(200000), u32(zip, second + 22), L"Size of second entry", LINE_INFO());
+            Assert::AreEqual(std::string("runs/1/zip_stream_large.bin"), name(zip, second), L"Folder uses forward slashes", LINE_INFO());
+            Assert::IsTrue(large_data == zip.substr(second + 30 + 27, 200000), L"Data of second entry", LINE_INFO());
+
+            const auto directory = second + 30 + 27 + 200000;
+            check_directory(zip, directory, 0, { 0, second }, { small_data, large_data });
+        }
+
+        TEST_METHOD(deflate) {
+#if defined(DATAVERSE_WITH_ZLIB)
+            const auto first = L"zip_stream_first.txt";
+            const auto second = L"zip_stream_second.bin";
+            std::string repetitive;
+            for (int i = 0; i < 10000; ++i) {
+                repetitive += "The quick brown fox jumps over the lazy dog. ";
+            }
+            const auto first_data = write(first, repetitive);
+            const auto second_data = write(second, pattern(100000, 7));
+
+            visus::dataverse::detail::zip_stream archive(visus::dataverse::archive_compression::deflate);
+            archive.add(first, L"text");
+            archive.add(second, nullptr);
+            const auto zip = read_all(archive);
+
+            ::_wremove(first);
+            ::_wremove(second);
+
+            // The checksum and the sizes are not known when the local header
+            // is written, so they follow in the data descriptor.
+            Assert::AreEqual(std::uint32_t(0x04034b50), u32(zip, 0), L"Signature of first local header", LINE_INFO());
+            Assert::AreEqual(std::uint16_t(0x0808), u16(zip, 6), L"UTF-8 names with data descriptor", LINE_INFO());
+            Assert::AreEqual(std::uint16_t(8), u16(zip, 8), L"First entry is deflated", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(0), u32(zip, 14), L"No CRC-32 in local header", LINE_INFO());
+            Assert::AreEqual(std::string("text/zip_stream_first.txt"), name(zip, 0), L"Name of first entry", LINE_INFO());
+
+            const auto eocd = zip.size() - 22;
+            const auto directory = u32(zip, eocd + 16);
+            const auto compressed = u32(zip, directory + 20);
+            Assert::IsTrue(compressed < first_data.size(), L"Repetitive text is compressed", LINE_INFO());
+            Assert::AreEqual(first_data, inflate(zip.substr(30 + 25, compressed), first_data.size()), L"Deflated data of first entry", LINE_INFO());
+
+            const auto descriptor = 30 + 25 + compressed;
+            Assert::AreEqual(std::uint32_t(0x08074b50), u32(zip, descriptor), L"Signature of data descriptor", LINE_INFO());
+            Assert::AreEqual(crc32(first_data), u32(zip, descriptor + 4), L"CRC-32 in data descriptor", LINE_INFO());
+            Assert::AreEqual(compressed, u32(zip, descriptor + 8), L"Compressed size in data descriptor", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(first_data.size()), u32(zip, descriptor + 12), L"Size in data descriptor", LINE_INFO());
+
+            const std::size_t next = descriptor + 16;
+            Assert::AreEqual(std::uint32_t(0x04034b50), u32(zip, next), L"Signature of second local header", LINE_INFO());
+            Assert::AreEqual(std::string("zip_stream_second.bin"), name(zip, next), L"Name of second entry", LINE_INFO());
+
+            check_directory(zip, directory, 8, { 0, next }, { first_data, second_data });
+#else /* defined(DATAVERSE_WITH_ZLIB) */
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                visus::dataverse::detail::zip_stream archive(visus::dataverse::archive_compression::deflate);
+            }, L"Deflate requires zlib", LINE_INFO());
+#endif /* defined(DATAVERSE_WITH_ZLIB) */
+        }
+
+        TEST_METHOD(changed_file) {
+            const auto path = L"zip_stream_changed.bin";
+            write(path, pattern(200000, 0));
+
+            visus::dataverse::detail::zip_stream archive(visus::dataverse::archive_compression::store);
+            archive.add(path, nullptr);
+
+            // Large files are hashed for the header before their data are
+            // sent, so a change in between must be detected.
+            std::vector<char> buffer(4096);
+            Assert::IsTrue(archive.read(buffer.data(), buffer.size()) > 0, L"Header has been produced", LINE_INFO());
+            write(path, pattern(200000, 1));
+
+            Assert::ExpectException<std::runtime_error>([&archive, &buffer](void) {
+                while (archive.read(buffer.data(), buffer.size()) > 0);
+            }, L"File changed while archived", LINE_INFO());
+
+            ::_wremove(path);
+        }
+
+        TEST_METHOD(missing_file) {
+            visus::dataverse::detail::zip_stream archive(visus::dataverse::archive_compression::store);
+            Assert::ExpectException<std::invalid_argument>([&archive](void) {
+                archive.add(nullptr, nullptr);
+            }, L"Path must be valid", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&archive](void) {
+                archive.add(L"folder/", nullptr);
+            }, L"Path must designate a file", LINE_INFO());
+
+            archive.add(L"zip_stream_missing.bin", nullptr);
+            std::vector<char> buffer(4096);
+            Assert::ExpectException<std::system_error>([&archive, &buffer](void) {
+                archive.read(buffer.data(), buffer.size());
+            }, L"Missing file is reported on read", LINE_INFO());
+        }
+
+    private:
+
+        static void check_directory(const std::string& zip,
+                const std::size_t offset,
+                const std::uint16_t method,
+                const std::vector<std::size_t>& headers,
+                const std::vector<std::string>& data) {
+            const auto eocd = zip.size() - 22;
+            Assert::AreEqual(std::uint32_t(0x06054b50), u32(zip, eocd), L"Signature of end of central directory", LINE_INFO());
+            Assert::AreEqual(std::uint16_t(headers.size()), u16(zip, eocd + 8), L"Number of entries on disk", LINE_INFO());
+            Assert::AreEqual(std::uint16_t(headers.size()), u16(zip, eocd + 10), L"Number of entries", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(eocd - offset), u32(zip, eocd + 12), L"Size of central directory", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(offset), u32(zip, eocd + 16), L"Offset of central directory", LINE_INFO());
+
+            auto entry = offset;
+            for (std::size_t i = 0; i < headers.size(); ++i) {
+                Assert::AreEqual(std::uint32_t(0x02014b50), u32(zip, entry), L"Signature of directory entry", LINE_INFO());
+                Assert::AreEqual(method, u16(zip, entry + 10), L"Compression method", LINE_INFO());
+                Assert::AreEqual(crc32(data[i]), u32(zip, entry + 16), L"CRC-32 in directory", LINE_INFO());
+                Assert::AreEqual(std::uint32_t(data[i].size()), u32(zip, entry + 24), L"Size in directory", LINE_INFO());
+                Assert::AreEqual(std::uint32_t(headers[i]), u32(zip, entry + 42), L"Offset of local header", LINE_INFO());
+                Assert::AreEqual(name(zip, headers[i]), zip.substr(entry + 46, u16(zip, entry + 28)), L"Name in directory", LINE_INFO());
+                entry += 46 + u16(zip, entry + 28);
+            }
+
+            Assert::AreEqual(eocd, entry, L"Directory ends at its end record", LINE_INFO());
+        }
+
+        static std::uint32_t crc32(const std::string& data) {
+            std::uint32_t retval = 0xFFFFFFFF;
+            for (auto c : data) {
+                retval ^= static_cast<std::uint8_t>(c);
+                for (int k = 0; k < 8; ++k) {
+                    retval = (retval & 1) ? (0xEDB88320 ^ (retval >> 1)) : (retval >> 1);
+                }
+            }
+            return ~retval;
+        }
+
+#if defined(DATAVERSE_WITH_ZLIB)
+        static std::string inflate(const std::string& data, const std::size_t size) {
+            std::string retval(size, '\0');
+            z_stream stream;
+            std::memset(&stream, 0, sizeof(stream));
+            Assert::AreEqual(Z_OK, ::inflateInit2(&stream, -MAX_WBITS), L"Initialise raw inflate", LINE_INFO());
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+            stream.avail_in = static_cast<uInt>(data.size());
+            stream.next_out = reinterpret_cast<Bytef *>(&retval[0]);
+            stream.avail_out = static_cast<uInt>(retval.size());
+            Assert::AreEqual(Z_STREAM_END, ::inflate(&stream, Z_FINISH), L"Complete deflate stream", LINE_INFO());
+            retval.resize(stream.total_out);
+            ::inflateEnd(&stream);
+            return retval;
+        }
+#endif /* defined(DATAVERSE_WITH_ZLIB) */
+
+        static std::string name(const std::string& zip, const std::size_t header) {
+            return zip.substr(header + 30, u16(zip, header + 26));
+        }
+
+        static std::string pattern(const std::size_t size, const int seed) {
+            std::string retval(size, '\0');
+            for (std::size_t i = 0; i < size; ++i) {
+                retval[i] = static_cast<char>((i * 31 + seed) % 251);
+            }
+            return retval;
+        }
+
+        static std::string read_all(visus::dataverse::detail::zip_stream& archive) {
+            // Read in chunks that do not match the records, such that these
+            // are split across calls.
+            std::string retval;
+            std::vector<char> buffer(997);
+            std::size_t cnt = 0;
+            while ((cnt = archive.read(buffer.data(), buffer.size())) > 0) {
+                retval.append(buffer.data(), cnt);
+            }
+            return retval;
+        }
+
+        static std::uint16_t u16(const std::string& zip, const std::size_t offset) {
+            auto d = reinterpret_cast<const std::uint8_t *>(zip.data()) + offset;
+            return static_cast<std::uint16_t>(d[0] | (d[1] << 8));
+        }
+
+        static std::uint32_t u32(const std::string& zip, const std::size_t offset) {
+            return static_cast<std::uint32_t>(u16(zip, offset)) | (static_cast<std::uint32_t>(u16(zip, offset + 2)) << 16);
+        }
+
+        static std::string write(const wchar_t *path, const std::string& data) {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(data.data(), data.size());
+            return data;
+        }
+    };
+
+} /* namespace test */